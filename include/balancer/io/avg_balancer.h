@@ -2,6 +2,7 @@
 #include "balancer.h"
 #include "../../io/io_manager.h"
 
+#include <atomic>
 #include <random>
 
 namespace lon::io {
@@ -20,10 +21,12 @@ public:
 
     void schedule(coroutine::Executor::Ptr executor,const std::any& arg) override;
 
+    std::vector<std::shared_ptr<IOManager>> getIOManagers() const override {
+        return managers_;
+    }
 
 private:
     std::vector<std::shared_ptr<IOManager>> managers_;
-    size_t balance_thread_count_;
     std::vector<Thread> threads_;
 };
 
@@ -43,10 +46,14 @@ public:
 
     void schedule(coroutine::Executor::Ptr executor,const std::any& arg) override;
 
+    std::vector<std::shared_ptr<IOManager>> getIOManagers() const override {
+        return managers_;
+    }
+
 private:
     std::vector<std::shared_ptr<IOManager>> managers_;
-    size_t balance_thread_count_;
     std::vector<Thread> threads_;
+    std::atomic<size_t> next_{0};
 };
 
 }  // namespace lon::io
@@ -1,10 +1,15 @@
 ﻿#pragma once
 #include "../../base/nocopyable.h"
+#include "../../base/typedef.h"
 #include "../../coroutine/executor.h"
 #include <any>
 #include <iostream>
+#include <memory>
+#include <vector>
 
 namespace lon::io {
+class IOManager;
+
 class IOWorkBalancer
 {
 public:
@@ -18,5 +23,25 @@ public:
     */
     virtual void schedule(coroutine::Executor::Ptr executor,
                           [[maybe_unused]] const std::any& arg = std::any()) = 0;
+
+    /**
+     * @brief 均衡器调度的全部IOManager, 构造完成后不再变化, 用于在每个IOManager上各自执行任务(比如分片accept).
+    */
+    virtual std::vector<std::shared_ptr<IOManager>> getIOManagers() const = 0;
+
+    /**
+     * @brief 全部IOManager等待执行的任务数之和(see @IOManager::getQueuedTaskCount), 在不同线程中调用安全.
+    */
+    virtual size_t getQueuedTaskCount() const;
+
+protected:
+    /**
+     * @brief 启动count个线程各自运行IOManager, 等到全部线程的IOManager都创建以后才返回,
+     * 避免构造完成后立即schedule时访问到不完整的列表.
+     * @param threads 新建的线程, 由调用者join.
+     * @return 按线程启动顺序排列的IOManager.
+    */
+    static std::vector<std::shared_ptr<IOManager>> startIOThreads(
+        size_t count, std::vector<Thread>& threads);
 };
 }  // namespace lon::io
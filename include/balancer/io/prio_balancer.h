@@ -23,6 +23,8 @@ public:
      */
     void schedule(coroutine::Executor::Ptr executor,const std::any& arg) override;
 
+    std::vector<std::shared_ptr<IOManager>> getIOManagers() const override;
+
     ~PrioBlancer() override;
 
 private:
@@ -26,5 +26,12 @@ public:
     void schedule(coroutine::Executor::Ptr executor, const std::any& arg) override {
         IOManager::getThreadLocal()->addExecutor(executor);
     }
+
+    /**
+     * @brief 调用线程的IOManager.
+    */
+    std::vector<std::shared_ptr<IOManager>> getIOManagers() const override {
+        return {IOManager::getThreadLocal()};
+    }
 };
 }  // namespace lon::io
@@ -1,4 +1,12 @@
 #pragma once
+#include "macro.h"
+#include "typedef.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
 #include <string>
 
 namespace lon {
@@ -8,18 +16,198 @@ enum BUFFER_SIZE : uint32_t
     kLargeBufferSize = kSmallBufferSize * 1024
 };
 
+/**
+ * @brief 固定容量的buffer, 内存内嵌在对象中, 空间不足时append失败而不是扩容.
+ * LargeBuffer有4MiB, 不应该放在栈上.
+ */
 template <uint32_t SIZE>
 class FixedBuffer
-{};
+{
+public:
+    FixedBuffer() = default;
+
+    /**
+     * @brief 追加数据.
+     * @return 空间不足时不写入任何数据并返回false.
+     */
+    bool append(const void* data, size_t len) noexcept {
+        if (UNLIKELY(len > avail()))
+            return false;
+        std::memcpy(data_ + size_, data, len);
+        size_ += len;
+        return true;
+    }
+
+    bool append(StringPiece message) noexcept {
+        return append(message.data(), message.size());
+    }
+
+    LON_NODISCARD
+    const char* data() const noexcept { return data_; }
+
+    /**
+     * @brief 可写位置, 直接写入后需要调用add.
+     */
+    LON_NODISCARD
+    char* current() noexcept { return data_ + size_; }
+
+    void add(size_t len) noexcept { size_ += len; }
+
+    LON_NODISCARD
+    size_t size() const noexcept { return size_; }
+
+    LON_NODISCARD
+    size_t avail() const noexcept { return SIZE - size_; }
+
+    LON_NODISCARD
+    static constexpr size_t capacity() noexcept { return SIZE; }
+
+    LON_NODISCARD
+    bool empty() const noexcept { return size_ == 0; }
+
+    void reset() noexcept { size_ = 0; }
+
+    LON_NODISCARD
+    StringPiece toStringPiece() const noexcept { return {data_, size_}; }
+
+    LON_NODISCARD
+    String toString() const { return {data_, size_}; }
+
+private:
+    char data_[SIZE];
+    size_t size_ = 0;
+};
 
 using SmallBuffer = FixedBuffer<kSmallBufferSize>;
-using LargeBuffer = FixedBuffer<kSmallBufferSize>;
+using LargeBuffer = FixedBuffer<kLargeBufferSize>;
 
 
-// 实现一个和folly small vector类似的buffer类, 可以做到自动切换栈/堆内存
+/**
+ * @brief 和folly small vector类似的buffer, 数据不超过SIZE时使用内嵌的内存, 超过以后切换到堆内存并按倍数扩容.
+ */
 template <uint32_t SIZE>
 class AutoBuffer
-{};
+{
+public:
+    AutoBuffer() = default;
+
+    AutoBuffer(const AutoBuffer& _other) { append(_other.data(), _other.size()); }
+
+    AutoBuffer(AutoBuffer&& _other) noexcept { moveFrom(_other); }
+
+    auto operator=(const AutoBuffer& _other) -> AutoBuffer& {
+        if (this != &_other) {
+            clear();
+            append(_other.data(), _other.size());
+        }
+        return *this;
+    }
+
+    auto operator=(AutoBuffer&& _other) noexcept -> AutoBuffer& {
+        if (this != &_other) {
+            freeHeap();
+            moveFrom(_other);
+        }
+        return *this;
+    }
+
+    ~AutoBuffer() { freeHeap(); }
+
+    /**
+     * @brief 追加数据, 空间不足时扩容.
+     * @throw std::bad_alloc 申请内存失败.
+     */
+    void append(const void* data, size_t len) {
+        reserve(size_ + len);
+        std::memcpy(data_ + size_, data, len);
+        size_ += len;
+    }
+
+    void append(StringPiece message) { append(message.data(), message.size()); }
+
+    /**
+     * @brief 保证容量至少为new_capacity.
+     * @throw std::bad_alloc 申请内存失败.
+     */
+    void reserve(size_t new_capacity) {
+        if (new_capacity <= capacity_)
+            return;
+        new_capacity = std::max(new_capacity, capacity_ * 2);
+        auto new_data = static_cast<char*>(::malloc(new_capacity));
+        if (!new_data)
+            throw std::bad_alloc();
+        std::memcpy(new_data, data_, size_);
+        freeHeap();
+        data_     = new_data;
+        capacity_ = new_capacity;
+    }
+
+    /**
+     * @brief 调整大小, 新增部分的内容未初始化.
+     */
+    void resize(size_t new_size) {
+        reserve(new_size);
+        size_ = new_size;
+    }
+
+    LON_NODISCARD
+    char* data() noexcept { return data_; }
+
+    LON_NODISCARD
+    const char* data() const noexcept { return data_; }
+
+    LON_NODISCARD
+    size_t size() const noexcept { return size_; }
+
+    LON_NODISCARD
+    size_t capacity() const noexcept { return capacity_; }
+
+    LON_NODISCARD
+    bool empty() const noexcept { return size_ == 0; }
+
+    /**
+     * @brief 是否还在使用内嵌的内存.
+     */
+    LON_NODISCARD
+    bool isInline() const noexcept { return data_ == inline_data_; }
+
+    void clear() noexcept { size_ = 0; }
+
+    LON_NODISCARD
+    StringPiece toStringPiece() const noexcept { return {data_, size_}; }
+
+    LON_NODISCARD
+    String toString() const { return {data_, size_}; }
+
+private:
+    void freeHeap() noexcept {
+        if (!isInline())
+            ::free(data_);
+        data_     = inline_data_;
+        capacity_ = SIZE;
+    }
+
+    void moveFrom(AutoBuffer& _other) noexcept {
+        if (_other.isInline()) {
+            std::memcpy(inline_data_, _other.data_, _other.size_);
+            data_     = inline_data_;
+            capacity_ = SIZE;
+        } else {
+            // 直接接管堆内存.
+            data_            = _other.data_;
+            capacity_        = _other.capacity_;
+            _other.data_     = _other.inline_data_;
+            _other.capacity_ = SIZE;
+        }
+        size_        = _other.size_;
+        _other.size_ = 0;
+    }
+
+    char inline_data_[SIZE];
+    char* data_      = inline_data_;
+    size_t size_     = 0;
+    size_t capacity_ = SIZE;
+};
 
 using SmallAutoBuffer = AutoBuffer<kSmallBufferSize>;
 
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "macro.h"
+#include "nocopyable.h"
+#include "typedef.h"
+
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+namespace lon {
+/**
+ * @brief 固定大小内存块的缓存池, 释放的内存块会被缓存起来供下次使用.
+ * 非线程安全, 一般通过getThreadLocal按线程使用.
+ */
+class BufferPool : public Noncopyable
+{
+public:
+    static constexpr size_t kDefaultMaxCached = 1024;
+
+    explicit BufferPool(size_t block_size, size_t max_cached = kDefaultMaxCached)
+        : block_size_{block_size}, max_cached_{max_cached} {
+    }
+
+    ~BufferPool() {
+        for (auto block : free_blocks_) {
+            ::free(block);
+        }
+    }
+
+    /**
+     * @brief 获取一个block_size大小的内存块, 优先使用缓存.
+     * @throw std::bad_alloc 申请内存失败.
+     */
+    LON_NODISCARD
+    char* acquire() {
+        if (!free_blocks_.empty()) {
+            char* block = free_blocks_.back();
+            free_blocks_.pop_back();
+            return block;
+        }
+        auto block = static_cast<char*>(::malloc(block_size_));
+        if (!block)
+            throw std::bad_alloc();
+        return block;
+    }
+
+    /**
+     * @brief 归还内存块, 缓存数量超过max_cached时直接释放.
+     */
+    void release(char* block) noexcept {
+        if (!block)
+            return;
+        if (free_blocks_.size() < max_cached_) {
+            free_blocks_.push_back(block);
+        } else {
+            ::free(block);
+        }
+    }
+
+    LON_NODISCARD
+    size_t blockSize() const noexcept { return block_size_; }
+
+    LON_NODISCARD
+    size_t cachedCount() const noexcept { return free_blocks_.size(); }
+
+    /**
+     * @brief 当前线程中对应block_size的缓存池.
+     */
+    static BufferPool* getThreadLocal(size_t block_size) {
+        thread_local std::unordered_map<size_t, std::unique_ptr<BufferPool>> pools;
+        auto& pool = pools[block_size];
+        if (!pool)
+            pool = std::make_unique<BufferPool>(block_size);
+        return pool.get();
+    }
+
+private:
+    size_t block_size_;
+    size_t max_cached_;
+    std::vector<char*> free_blocks_;
+};
+
+}  // namespace lon
@@ -51,9 +51,29 @@ public:
         return WritableFile::write(write_data, write_len);
     }
 
+    /**
+     * @brief 将缓冲中的数据写入文件(不保证落盘).
+     */
+    bool flush() {
+        return pos_ == 0 || flushBuffer();
+    }
+
+    /**
+     * @brief 写出缓冲并且fdatasync, 保证数据落盘.
+     */
+    bool sync() {
+        return flush() && ::fdatasync(fd_) == 0;
+    }
+
+    LON_NODISCARD
+    const String& getFileName() const noexcept {
+        return file_name_;
+    }
+
     LON_NODISCARD bool closeFile() {
         bool result = flushBuffer();
         const int close_result = ::close(fd_);
+        fd_                    = -1;
         if(close_result < 0) {
             return false;
         }
@@ -83,6 +103,11 @@ public:
         file_name_=std::move(_other.file_name_);
     }
     auto operator=(WritableFile&& _other) noexcept -> WritableFile& {
+        if (this == &_other)
+            return *this;
+        // 写出并关闭原来的文件.
+        if (fd_ >= 0)
+            [[maybe_unused]] bool result = closeFile();
         memcpy(buf_, _other.buf_, G_FileBufferSize);
         pos_ = _other.pos_;
         fd_ = _other.fd_;
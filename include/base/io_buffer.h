@@ -0,0 +1,191 @@
+#pragma once
+#include "buffer.h"
+#include "macro.h"
+#include "typedef.h"
+
+#include <memory>
+#include <sys/uio.h>
+#include <vector>
+
+namespace lon {
+
+/**
+ * @brief 连接使用的链式buffer, 由若干个固定大小的block组成, block的内存来自线程局部的BufferPool.
+ * block通过shared_ptr在多个IOBuffer之间共享, slice/split不拷贝数据, 共享中的block只读,
+ * 追加数据时会使用新的block. 数据全部读完以后保留最后一个block供之后写入. 非线程安全.
+ */
+class IOBuffer
+{
+public:
+    static constexpr size_t kBlockSize   = kSmallBufferSize;
+    /**
+     * @brief 第一个block在头部预留的空间, prepend不超过这个长度时不需要新的block.
+     */
+    static constexpr size_t kPrependSize = 16;
+
+    IOBuffer() = default;
+
+    IOBuffer(const IOBuffer&)                    = delete;
+    auto operator=(const IOBuffer&) -> IOBuffer& = delete;
+
+    IOBuffer(IOBuffer&& _other) noexcept;
+    auto operator=(IOBuffer&& _other) noexcept -> IOBuffer&;
+
+    ~IOBuffer() = default;
+
+    /**
+     * @brief 可读的字节数.
+     */
+    LON_NODISCARD
+    size_t readableBytes() const noexcept { return size_; }
+
+    /**
+     * @brief 不申请新block时还可以写入的字节数.
+     */
+    LON_NODISCARD
+    size_t writableBytes() const noexcept;
+
+    LON_NODISCARD
+    bool empty() const noexcept { return size_ == 0; }
+
+    LON_NODISCARD
+    size_t blockCount() const noexcept { return segments_.size() - head_; }
+
+    void append(const void* data, size_t len);
+
+    void append(StringPiece message) { append(message.data(), message.size()); }
+
+    /**
+     * @brief 接管other中的所有block, 不拷贝数据.
+     */
+    void append(IOBuffer&& other);
+
+    /**
+     * @brief 在可读数据前插入数据, 用于在已经序列化好的消息前补充长度等头部.
+     */
+    void prepend(const void* data, size_t len);
+
+    /**
+     * @brief 从offset开始拷贝最多len字节到out, 不移动读位置.
+     * @return 实际拷贝的字节数.
+     */
+    size_t copyTo(void* out, size_t len, size_t offset = 0) const noexcept;
+
+    /**
+     * @brief 读取最多len字节到out, 并移动读位置.
+     * @return 实际读取的字节数.
+     */
+    size_t read(void* out, size_t len) noexcept;
+
+    /**
+     * @brief 丢弃前len字节, len超过readableBytes时清空.
+     */
+    void consume(size_t len) noexcept;
+
+    /**
+     * @brief 清空并释放所有block.
+     */
+    void clear() noexcept;
+
+    /**
+     * @brief 返回[offset, offset + len)的数据视图, 与当前buffer共享block.
+     */
+    LON_NODISCARD
+    IOBuffer slice(size_t offset, size_t len) const;
+
+    /**
+     * @brief 把前len字节切分出来, 当前buffer只保留剩余的数据. 不拷贝数据.
+     */
+    LON_NODISCARD
+    IOBuffer split(size_t len);
+
+    /**
+     * @brief 同split, 切分出来的数据追加到out, out可以重复使用以避免每次切分都申请内存.
+     */
+    void splitTo(size_t len, IOBuffer& out);
+
+    LON_NODISCARD
+    String toString() const;
+
+    /**
+     * @brief 第一个block中的可读数据, 可读数据只在一个block中时就是全部数据.
+     */
+    LON_NODISCARD
+    StringPiece front() const noexcept;
+
+    LON_NODISCARD
+    bool contiguous() const noexcept { return blockCount() <= 1; }
+
+    /**
+     * @brief 从from开始查找needle, 可以跨越block. 使用memchr查找needle的第一个字节.
+     * @return needle的位置, 没有找到返回-1.
+     */
+    LON_NODISCARD
+    ssize_t find(StringPiece needle, size_t from = 0) const noexcept;
+
+    /**
+     * @brief 用可读数据填充iovec, 用于writev/sendmsg.
+     * @return 使用的iovec个数.
+     */
+    size_t peekIovec(iovec* iov, size_t max_iov) const noexcept;
+
+    /**
+     * @brief 准备至少min_bytes的可写空间(不足时申请新的block)并填充iovec, 用于readv/recvmsg.
+     * 写入后必须调用commit.
+     * @return 使用的iovec个数.
+     */
+    size_t prepareIovec(iovec* iov, size_t max_iov, size_t min_bytes);
+
+    /**
+     * @brief 确认prepareIovec的空间中写入了len字节, 释放没有使用的block.
+     */
+    void commit(size_t len) noexcept;
+
+private:
+    struct Block;
+
+    struct Segment
+    {
+        std::shared_ptr<Block> block;
+        size_t begin;
+        size_t end;
+
+        LON_NODISCARD
+        size_t size() const noexcept { return end - begin; }
+    };
+
+    /**
+     * @brief 末尾block独占时可以继续写入.
+     */
+    LON_NODISCARD
+    bool tailWritable() const noexcept;
+
+    void pushBlock(size_t begin);
+
+    void popFront() noexcept;
+
+    /**
+     * @brief buffer为空时, 如果只剩一个独占的block那么从头开始重新使用, 否则释放所有block.
+     */
+    void rewindIfEmpty() noexcept;
+
+    /**
+     * @brief 释放commit之后没有写入数据的block.
+     */
+    void trimTail() noexcept;
+
+    /**
+     * @brief 第index个segment的offset处是否为needle.
+     */
+    LON_NODISCARD
+    bool matchAt(size_t index, size_t offset, StringPiece needle) const noexcept;
+
+    // [head_, segments_.size())是有效的segment, 读取时只移动head_, 避免每次都移动整个数组.
+    std::vector<Segment> segments_;
+    size_t head_           = 0;
+    size_t size_           = 0;
+    // prepareIovec开始写入的segment下标.
+    size_t prepared_index_ = 0;
+};
+
+}  // namespace lon
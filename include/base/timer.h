@@ -138,8 +138,14 @@ public:
         if (!timer)
             return;
         std::lock_guard<Mutex> locker(timer_mutex_);
-        auto iter = timers_.find(timer);
-        timers_.erase(iter);
+        // 相同时间戳的定时器比较结果相等, 需要找到指针相同的那一个, 已经过期取出的定时器不在集合中.
+        auto [begin, end] = timers_.equal_range(timer);
+        for (auto iter = begin; iter != end; ++iter) {
+            if (*iter == timer) {
+                timers_.erase(iter);
+                return;
+            }
+        }
     }
 
 private:
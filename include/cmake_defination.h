@@ -5,3 +5,5 @@
 
 #define LON_CONTEXT_TYPE COROUTINE_FCONTEXT
 
+
+#define LON_LOG_COMPRESSION 1
@@ -88,6 +88,13 @@ public:
         return ready_executors_.size();
     }
 
+    /**
+     * @brief 等待执行的任务数(运行队列+其它线程投递但还未取出的任务), 在不同线程中调用安全, 用于判断负载.
+    */
+    LON_NODISCARD auto getQueuedCount() const -> size_t {
+        return queued_count_.load(std::memory_order_relaxed);
+    }
+
     /**
      * @brief 应该只从Scheduler线程访问
     */
@@ -132,6 +139,7 @@ private:
             if(auto _head = head.exchange(nullptr); _head) {
                 while(_head) {
                     scheduler->addExecutor(_head->value);
+                    scheduler->queued_count_.fetch_sub(1, std::memory_order_relaxed);
                     auto temp = _head;
                     _head = _head->next;
                     delete temp;
@@ -156,6 +164,7 @@ private:
     Executor::Ptr scheduler_executor_ = nullptr;
 
     RemoteTaskList remote_tasks_;
+    std::atomic<size_t> queued_count_{0};
 };
 
 
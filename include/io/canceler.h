@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../base/nocopyable.h"
+
+#include <functional>
+
+namespace lon::io {
+/**
+ * @brief 取消挂起中的协程操作(比如connect), 只在发起操作的IOManager线程中使用.
+ * 取消以后再用于新的操作会立即失败, 需要reset.
+ */
+class Canceler : public Noncopyable
+{
+public:
+    /**
+     * @brief 取消当前挂起的操作, 没有挂起的操作时只标记为已取消.
+     */
+    void cancel() {
+        cancelled_ = true;
+        if (on_cancel_) {
+            auto on_cancel = std::move(on_cancel_);
+            on_cancel_     = nullptr;
+            on_cancel();
+        }
+    }
+
+    bool cancelled() const noexcept { return cancelled_; }
+
+    void reset() noexcept {
+        cancelled_ = false;
+        on_cancel_ = nullptr;
+    }
+
+    /**
+     * @brief 挂起操作时设置取消的回调, 由挂起的一方在恢复后clear.
+     */
+    void setOnCancel(std::function<void()> on_cancel) {
+        on_cancel_ = std::move(on_cancel);
+    }
+
+    void clearOnCancel() noexcept { on_cancel_ = nullptr; }
+
+private:
+    bool cancelled_ = false;
+    std::function<void()> on_cancel_;
+};
+
+}  // namespace lon::io
@@ -1,4 +1,6 @@
 #pragma once
+#include "canceler.h"
+
 #include <iostream>
 #include <sys/socket.h>
 #include <sys/uio.h>
@@ -23,17 +25,59 @@ int co_nanosleep(const struct timespec* req, struct timespec* rem);
 // socket
 
 /**
- * @brief socket call wrapper, 隐式设置non block.
+ * @brief socket call wrapper, 隐式设置non block, type中带有SOCK_NONBLOCK时io函数不会挂起而是直接返回EAGAIN.
 */
 int co_socket(int domain, int type, int protocol);
 
 
+/**
+ * @brief connect wrapper, 超时时间为SO_SNDTIMEO设置的时间(默认不超时).
+*/
 int co_connect(int sockfd, const struct sockaddr* addr, socklen_t addrlen);
 
 
+/**
+ * @brief 带超时以及取消的connect, 连接过程中挂起当前协程.
+ * @param timeout_ms 超时时间, -1表示不超时, 超时返回-1并设置errno为ETIMEDOUT.
+ * @param canceler 可为nullptr, 取消时返回-1并设置errno为ECANCELED.
+ * @return see @::connect
+*/
+int co_connectWithTimeout(int sockfd,
+                          const struct sockaddr* addr,
+                          socklen_t addrlen,
+                          size_t timeout_ms,
+                          Canceler* canceler = nullptr);
+
+
 int co_accept(int s, struct sockaddr* addr, socklen_t* addrlen);
 
+
+/**
+ * @brief accept4 wrapper, 新连接总是以SOCK_NONBLOCK创建(不需要额外的fcntl),
+ * flags中的SOCK_NONBLOCK表示用户自己处理EAGAIN.
+*/
+int co_accept4(int s, struct sockaddr* addr, socklen_t* addrlen, int flags);
+
+
+/**
+ * @brief 登记一个不是通过hook函数创建的socket(比如通过SCM_RIGHTS接收的fd), 隐式设置non block,
+ * 之后的io函数挂起协程而不是阻塞线程.
+ * @return 成功返回0, fd不是socket时返回-1并设置errno为ENOTSOCK.
+*/
+int co_adoptSocket(int fd);
+
+
+/**
+ * @brief 挂起当前协程直到fd可读(write为true时可写), 超时或者取消, 用于配合用户非阻塞的fd.
+ * @return 就绪返回0, 超时返回-1并设置errno为ETIMEDOUT, 取消返回-1并设置errno为ECANCELED.
+*/
+int co_waitEvent(int fd,
+                 bool write,
+                 size_t timeout_ms      = static_cast<size_t>(-1),
+                 Canceler* canceler     = nullptr);
+
 // read
+// recv*/send*在flags中带有MSG_DONTWAIT时直接调用系统函数, EAGAIN返回给调用者而不挂起协程.
 ssize_t co_read(int fd, void* buf, size_t count);
 
 
@@ -54,6 +98,16 @@ ssize_t co_recvfrom(int sockfd,
 ssize_t co_recvmsg(int sockfd, struct msghdr* msg, int flags);
 
 
+/**
+ * @brief 一次读取多个数据报, 没有任何数据报可读时挂起协程, 返回读到的数据报个数.
+ */
+int co_recvmmsg(int sockfd,
+                struct mmsghdr* msgvec,
+                unsigned int vlen,
+                int flags,
+                struct timespec* timeout);
+
+
 // write
 ssize_t co_write(int fd, const void* buf, size_t count);
 
@@ -75,6 +129,18 @@ ssize_t co_sendto(int s,
 ssize_t co_sendmsg(int s, const struct msghdr* msg, int flags);
 
 
+/**
+ * @brief 一次发送多个数据报, 发送缓冲区满时挂起协程, 返回发送出去的数据报个数(可能少于vlen).
+ */
+int co_sendmmsg(int sockfd, struct mmsghdr* msgvec, unsigned int vlen, int flags);
+
+
+/**
+ * @brief 在内核中把in_fd的数据发送到out_fd(socket), 发送缓冲区满时挂起协程.
+ */
+ssize_t co_sendfile(int out_fd, int in_fd, off_t* offset, size_t count);
+
+
 int co_close(int fd);
 
 /**
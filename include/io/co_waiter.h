@@ -0,0 +1,49 @@
+#pragma once
+
+#include "../coroutine/executor.h"
+#include "canceler.h"
+
+namespace lon::io {
+/**
+ * @brief 挂起当前协程直到被notify, 超时或者取消, 只在同一个IOManager线程中使用.
+ * 一次wait只会被恢复一次, notify与超时同时发生时以先执行的为准.
+ */
+class CoWaiter : public Noncopyable
+{
+public:
+    enum class Result
+    {
+        Notified,
+        Timeout,
+        Cancelled
+    };
+
+    /**
+     * @brief 挂起当前协程.
+     * @param timeout_ms 超时时间, -1表示不超时.
+     * @param canceler 可为nullptr, 已经取消时直接返回Cancelled.
+     */
+    Result wait(size_t timeout_ms = static_cast<size_t>(-1),
+                Canceler* canceler = nullptr);
+
+    /**
+     * @brief 恢复挂起的协程.
+     * @return 是否有协程被恢复.
+     */
+    bool notify();
+
+    LON_NODISCARD
+    bool waiting() const noexcept { return state_ && state_->waiting; }
+
+private:
+    struct State
+    {
+        coroutine::Executor::Ptr executor = nullptr;
+        bool waiting                      = false;
+        Result result                     = Result::Notified;
+    };
+
+    std::shared_ptr<State> state_ = nullptr;
+};
+
+}  // namespace lon::io
@@ -2,6 +2,7 @@
 #include "../base/macro.h"
 #include "../base/singleton.h"
 #include "../base/typedef.h"
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <vector>
@@ -42,8 +43,12 @@ public:
         const int len = static_cast<int>(contexts_.size());
         constexpr double resizeFactor = 1.5;
         if(fd >= len) {
-            contexts_.resize(static_cast<size_t>(fd * resizeFactor), nullptr);
+            contexts_.resize(std::max(static_cast<size_t>(fd) + 1,
+                                      static_cast<size_t>(fd * resizeFactor)),
+                             nullptr);
         }
+        // fd被系统复用时可能还残留着上一个context.
+        delete contexts_[fd];
         contexts_[fd] = new FdContext(context);
     }
 
@@ -4,13 +4,30 @@
  * 所有被hook的io api(X)更改为加_sys后缀(X_sys).
  */
 
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 #include <sys/uio.h>
 #include <unistd.h>
 
 namespace lon::io {
+    /**
+     * @brief 设置当前线程是否开启hook, 显式设置后IOManager不再改变本线程的设置.
+     */
 	void setHookEnabled(bool enable);
+
+    /**
+     * @brief 当前线程是否开启hook, 未开启的线程直接调用原始系统函数.
+     */
     bool isHookEnabled();
+
+    /**
+     * @brief 如果当前线程没有显式设置过hook, 那么开启hook, 由IOManager在所属线程运行时调用.
+     */
+    void enableThreadHookByDefault();
+
+    /**
+     * @brief 解析所有被hook的原始函数, 在静态初始化阶段调用一次.
+     */
 	void hook_init();
 }
 
@@ -36,6 +53,9 @@ extern "C" {
 	typedef int (*accept_fun)(int s, struct sockaddr* addr, socklen_t* addrlen);
 	extern accept_fun accept_sys;
 	
+	typedef int (*accept4_fun)(int s, struct sockaddr* addr, socklen_t* addrlen, int flags);
+	extern accept4_fun accept4_sys;
+	
 	//read
 	typedef ssize_t(*read_fun)(int fd, void* buf, size_t count);
 	extern read_fun read_sys;
@@ -52,6 +72,9 @@ extern "C" {
 	typedef ssize_t(*recvmsg_fun)(int sockfd, struct msghdr* msg, int flags);
 	extern recvmsg_fun recvmsg_sys;
 	
+	typedef int (*recvmmsg_fun)(int sockfd, struct mmsghdr* msgvec, unsigned int vlen, int flags, struct timespec* timeout);
+	extern recvmmsg_fun recvmmsg_sys;
+	
 	//write
 	typedef ssize_t(*write_fun)(int fd, const void* buf, size_t count);
 	extern write_fun write_sys;
@@ -68,6 +91,12 @@ extern "C" {
 	typedef ssize_t(*sendmsg_fun)(int s, const struct msghdr* msg, int flags);
 	extern sendmsg_fun sendmsg_sys;
 	
+	typedef int (*sendmmsg_fun)(int sockfd, struct mmsghdr* msgvec, unsigned int vlen, int flags);
+	extern sendmmsg_fun sendmmsg_sys;
+	
+	typedef ssize_t (*sendfile_fun)(int out_fd, int in_fd, off_t* offset, size_t count);
+	extern sendfile_fun sendfile_sys;
+	
 	typedef int (*close_fun)(int fd);
 	extern close_fun close_sys;
 	
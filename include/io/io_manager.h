@@ -2,6 +2,7 @@
 #include "../base/timer.h"
 #include "../coroutine/executor.h"
 #include "../coroutine/scheduler.h"
+#include "hook.h"
 #include <sys/epoll.h>
 
 namespace lon::io
@@ -57,6 +58,14 @@ public:
         wakeup();
     }
 
+    /**
+     * @brief see @Scheduler::getQueuedCount, 在另一线程是调用安全.
+    */
+    LON_NODISCARD
+    size_t getQueuedTaskCount() const {
+        return scheduler_.getQueuedCount();
+    }
+
     /**
      * @brief 注册定时器, 只在IOManager线程调用.
      * @param timer 定时器, 带回调, 注册回调应不为空.
@@ -67,7 +76,11 @@ public:
     void cancelTimer(Timer::Ptr timer);
 
     //TODO run and stop should be thread safe.
+    /**
+     * @brief 在当前线程运行IOManager, 如果当前线程未显式设置hook, 那么会开启hook.
+    */
     void run() {
+        enableThreadHookByDefault();
         scheduler_.run();
     }
 
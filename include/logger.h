@@ -7,15 +7,16 @@
 #include "logging/LogSStream.h"
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <assert.h>
+#include <csignal>
 #include <functional>
 #include <memory>
-#include <sstream>
 #include <string>
+#include <time.h>
 
 
-#define LON_LOG(logger, level)                                        \
-    if (logger->getLevel() <= level)                                  \
+#define LON_LOG_STREAM(logger, level, suppressed)                     \
     lon::LogWrapper(logger,                                           \
                     lon::LogEvent(__FILE__,                           \
                                   __LINE__,                           \
@@ -23,9 +24,36 @@
                                   lon::getThreadId(),                 \
                                   0,                                  \
                                   lon::getExecutorId(),               \
-                                  time(0) /*,lon::getThreadName()*/)) \
+                                  lon::log::coarseNow() /*,lon::getThreadName()*/), \
+                    suppressed)                                       \
         .stream
 
+/**
+ * @brief logger可以是Logger::ptr或者log::LoggerSlot, 后者的级别检查只有一次load和一次比较.
+ */
+#define LON_LOG(logger, level)                                                   \
+    if (lon::log::enabled(logger, level) && logger->acquire(level))              \
+    LON_LOG_STREAM(logger, level, 0)
+
+/**
+ * @brief 按调用处限制日志的输出, 计数器是调用处的静态变量, 被抑制时只有一次relaxed的原子自增
+ * (EVERY_MS另外读取一次coarse时钟). 输出的日志以"[suppressed N] "开头, N为上一次输出以后被抑制的条数.
+ * @code
+ * LON_LOG_EVERY_N(logger, lon::Level::WARN, 100) << "queue full";   // 第1, 101, 201...次
+ * LON_LOG_FIRST_N(logger, lon::Level::INFO, 10) << "first requests"; // 前10次
+ * LON_LOG_EVERY_MS(logger, lon::Level::WARN, 1000) << "accept failed"; // 每秒最多一次
+ * @endcode
+ */
+#define LON_LOG_SAMPLED(logger, level, should_log)                                          \
+    if (static lon::log::LogOccurrences lon_log_occurrences;                                \
+        lon::log::enabled(logger, level) && lon_log_occurrences.should_log &&               \
+        (logger->acquire(level) || lon_log_occurrences.rejectedByLogger()))                  \
+    LON_LOG_STREAM(logger, level, lon_log_occurrences.takeSuppressed())
+
+#define LON_LOG_EVERY_N(logger, level, n) LON_LOG_SAMPLED(logger, level, everyN(n))
+#define LON_LOG_FIRST_N(logger, level, n) LON_LOG_SAMPLED(logger, level, firstN(n))
+#define LON_LOG_EVERY_MS(logger, level, ms) LON_LOG_SAMPLED(logger, level, everyMs(ms))
+
 #define LON_LOG_DEBUG(logger) LON_LOG(logger, lon::Level::DEBUG)
 #define LON_LOG_INFO(logger) LON_LOG(logger, lon::Level::INFO)
 #define LON_LOG_WARN(logger) LON_LOG(logger, lon::Level::WARN)
@@ -33,21 +61,24 @@
 #define LON_LOG_FATAL(logger) LON_LOG(logger, lon::Level::FATAL)
 
 #define LON_LOG_DEFAULT_DEBUG() \
-    LON_LOG_DEBUG(LogManager::getInstance()->getDefault())
+    LON_LOG_DEBUG(lon::log::defaultSlot())
 #define LON_LOG_DEFAULT_INFO() \
-    LON_LOG_INFO(LogManager::getInstance()->getDefault())
+    LON_LOG_INFO(lon::log::defaultSlot())
 #define LON_LOG_DEFAULT_WARN() \
-    LON_LOG_WARN(LogManager::getInstance()->getDefault())
+    LON_LOG_WARN(lon::log::defaultSlot())
 #define LON_LOG_DEFAULT_ERROR() \
-    LON_LOG_ERROR(LogManager::getInstance()->getDefault())
+    LON_LOG_ERROR(lon::log::defaultSlot())
 #define LON_LOG_DEFAULT_FATAL() \
-    LON_LOG_FATAL(LogManager::getInstance()->getDefault())
+    LON_LOG_FATAL(lon::log::defaultSlot())
 
 namespace lon {
 constexpr int flusher_max = 10;
 class LogFlusher;
 class Logger;
 class _LogManager;
+namespace log {
+class LoggerSlot;
+}
 
 enum Level
 {
@@ -59,6 +90,85 @@ enum Level
     SIZE
 };
 
+namespace log {
+/**
+ * @brief 日志时间使用CLOCK_REALTIME_COARSE, 不需要读取时钟源, 精度为一个tick(通常1~4ms).
+ */
+inline timespec coarseNow() noexcept {
+    timespec now{};
+    ::clock_gettime(CLOCK_REALTIME_COARSE, &now);
+    return now;
+}
+
+/**
+ * @brief 限流使用的单调时间(纳秒), 同样只读取coarse时钟.
+ */
+inline int64_t coarseMonotonicNs() noexcept {
+    timespec now{};
+    ::clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+/**
+ * @brief LON_LOG_EVERY_N等宏在调用处的计数, 以静态变量存在.
+ */
+struct LogOccurrences : public Noncopyable
+{
+    /**
+     * @brief 第1, n+1, 2n+1...次返回true, n为0时与1相同, 每次都返回true.
+     */
+    LON_ALWAYS_INLINE bool everyN(uint64_t n) noexcept {
+        const uint64_t occurrence = count.fetch_add(1, std::memory_order_relaxed);
+        return n <= 1 || occurrence % n == 0;
+    }
+
+    /**
+     * @brief 前n次返回true.
+     */
+    LON_ALWAYS_INLINE bool firstN(uint64_t n) noexcept {
+        return count.fetch_add(1, std::memory_order_relaxed) < n;
+    }
+
+    /**
+     * @brief 距离上一次返回true至少ms毫秒时返回true, 精度为coarse时钟的一个tick.
+     */
+    LON_ALWAYS_INLINE bool everyMs(int64_t ms) noexcept {
+        count.fetch_add(1, std::memory_order_relaxed);
+        const int64_t now = coarseMonotonicNs();
+        int64_t next      = next_ns.load(std::memory_order_relaxed);
+        return now >= next &&
+               next_ns.compare_exchange_strong(next, now + ms * 1000000, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 通过了调用处的采样但被logger的令牌桶抑制, 这一次已经计入logger, 不再计入调用处.
+     * @return 总是false
+     */
+    bool rejectedByLogger() noexcept {
+        logged.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    /**
+     * @brief 输出时调用, 返回上一次输出以后被抑制的次数.
+     */
+    uint64_t takeSuppressed() noexcept {
+        const uint64_t current = count.load(std::memory_order_relaxed);
+        uint64_t last          = logged.load(std::memory_order_relaxed);
+        do {
+            if (current <= last)
+                return 0;
+        } while (!logged.compare_exchange_weak(last, current, std::memory_order_relaxed));
+        return current - last - 1;
+    }
+
+    std::atomic<uint64_t> count{0};
+    // 上一次输出时的count, 加上之后被logger抑制的次数.
+    std::atomic<uint64_t> logged{0};
+    std::atomic<int64_t> next_ns{0};
+};
+}  // namespace log
+
 struct LogEvent
 {
     using StringStream = log::LogSStream;
@@ -73,8 +183,9 @@ struct LogEvent
     // StringPiece thread_name;
     StringPiece logger_name{};       // set in logger //耦合Logger
     StringPiece datetime_pattern{};  // set in logger //耦合Logger
-    String content{};  // set in LoggerWrapper //耦合LoggerWrapper
+    StringPiece content{};  // set in LoggerWrapper, 指向线程局部缓冲中的消息体 //耦合LoggerWrapper
     time_t time;
+    uint32_t time_ns = 0;  // time秒内的纳秒部分
 
 
     LogEvent(const LogEvent& _other)     = default;
@@ -97,18 +208,38 @@ struct LogEvent
           elapsed_ms{_elapsed_ms},
           executor_id{_executor_id},
           time{_time} {}
+
+    LogEvent(const char* _file_name,
+             int _line,
+             Level _level,
+             uint32_t _thread_id,
+             uint32_t _elapsed_ms,
+             size_t _executor_id,
+             const timespec& _time)
+        : LogEvent(_file_name, _line, _level, _thread_id, _elapsed_ms, _executor_id, _time.tv_sec) {
+        time_ns = static_cast<uint32_t>(_time.tv_nsec);
+    }
 };
 
+/**
+ * @brief 构造时logger在线程局部的缓冲中输出消息体(%m)之前的部分, 用户的消息直接写在它后面,
+ * 析构时输出剩余的部分并写入flusher, 中间没有额外的String.
+ */
 struct LogWrapper
 {
 public:
-    using StringStream = std::stringstream;
+    using StringStream = log::LogSStream;
+    // 必须第一个构造.
     StringStream stream;
     std::shared_ptr<Logger> logger_ptr;
     LogEvent event;
+    size_t message_begin = 0;
 
 
-    LogWrapper(std::shared_ptr<Logger> _logger_ptr, LogEvent _event);
+    /**
+     * @param suppressed 调用处被限流抑制的条数, 与logger被抑制的条数一起在消息体开头输出.
+     */
+    LogWrapper(std::shared_ptr<Logger> _logger_ptr, LogEvent _event, uint64_t suppressed = 0);
 
     ~LogWrapper();
 };
@@ -122,9 +253,10 @@ public:
     using StringStream  = LogEvent::StringStream;
     using ptr           = std::shared_ptr<Logger>;
     using FormatterFunc = std::function<void(StringStream& stream, LogEvent*)>;
+    using CompiledFormatterFunc = void (*)(StringStream& stream, LogEvent*);
     // noexcept
 
-    Logger(const String& name) : name_{name} {}
+    Logger(const String& name);
 
     inline static const char* levelToString(Level level) noexcept {
         static const char* LogLevelName[Level::SIZE] = {
@@ -142,19 +274,82 @@ public:
     static Level levelFromString(StringPiece str) noexcept;
 
     Level getLevel() const noexcept {
-        return level_;
+        return level_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 进程内唯一的id.
+     */
+    uint64_t getId() const noexcept {
+        return id_;
     }
 
 
+    /**
+     * @brief 格式化event(content已经设置)并写入所有flusher.
+     */
     void log(LogEvent*) noexcept;
 
+    /**
+     * @brief 在stream中输出消息体之前的部分.
+     */
+    void beginLog(StringStream& stream, LogEvent* event) noexcept;
+
+    /**
+     * @brief 输出消息体之后的部分并写入所有flusher, 消息体从stream的message_begin开始.
+     */
+    void endLog(StringStream& stream, size_t message_begin, LogEvent* event) noexcept;
+
+    /**
+     * @brief 不经过formatters, 直接写入所有flusher(例如二进制日志的记录).
+     */
+    void write(StringPiece data) noexcept;
+
     void addOneFlusher(std::unique_ptr<log::Flusher> flusher) {
         if (LIKELY(flusher != nullptr))
             flushers_[flusher_count_++] = std::move(flusher);
     }
 
-    void setLevel(Level level) {
-        level_ = level;
+    /**
+     * @brief 可以在运行时调用, 由LogManager管理的logger同时更新引用它的LoggerSlot.
+     */
+    void setLevel(Level level);
+
+    /**
+     * @brief 设置logger的令牌桶, 在调用处的限流之后生效, FATAL不受限制.
+     * @param lines_per_second 每秒补充的条数, 不大于0时关闭限流
+     * @param burst 桶的容量, 即最多连续输出的条数
+     */
+    void setRateLimit(double lines_per_second, uint32_t burst) noexcept;
+
+    /**
+     * @brief 令牌桶是否允许输出一条level级别的日志, 没有设置限流时只有一次load.
+     */
+    LON_ALWAYS_INLINE bool acquire(Level level) noexcept {
+        if (LIKELY(rate_interval_ns_.load(std::memory_order_relaxed) == 0) || level >= Level::FATAL)
+            return true;
+        return acquireSlow();
+    }
+
+    /**
+     * @brief 令牌桶抑制的总条数.
+     */
+    LON_NODISCARD
+    uint64_t getSuppressed() const noexcept {
+        return suppressed_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 上一次调用以后令牌桶抑制的条数, 由下一条输出的日志报告.
+     */
+    uint64_t takeSuppressed() noexcept {
+        const uint64_t total = suppressed_.load(std::memory_order_relaxed);
+        uint64_t reported    = reported_.load(std::memory_order_relaxed);
+        do {
+            if (LIKELY(total <= reported))
+                return 0;
+        } while (!reported_.compare_exchange_weak(reported, total, std::memory_order_relaxed));
+        return total - reported;
     }
 
     /**
@@ -165,9 +360,21 @@ public:
      */
     void setFormatters(const String& formatter_pattern);
 
+    /**
+     * @brief 使用编译期展开的格式化函数代替formatters_, 一般通过log::setFormatters<Pattern>调用.
+     * @param prefix 输出消息体之前的部分
+     * @param suffix 输出消息体之后的部分
+     * @param has_message pattern中是否有%m, 没有时丢弃消息体
+     */
+    void setCompiledFormatters(CompiledFormatterFunc prefix,
+                               CompiledFormatterFunc suffix,
+                               bool has_message) noexcept;
+
 private:
     void registerUpdateFlusher() const;
 
+    bool acquireSlow() noexcept;
+
 
     void addOneFormatter(FormatterFunc formatter) {
         formatters_.emplace_back(std::move(formatter));
@@ -175,40 +382,174 @@ private:
 
 
 private:
-    Level level_       = DEBUG;
+    const uint64_t id_;
+    std::atomic<Level> level_{DEBUG};
+    // 由LogManager创建, 级别变化时需要更新LoggerSlot.
+    bool managed_      = false;
     int flusher_count_ = 0;
     std::string name_{};
     std::string datetime_pattern_{};
     std::array<std::unique_ptr<log::Flusher>, flusher_max> flushers_{nullptr};
     std::vector<FormatterFunc> formatters_{};
+    // 第一个%m在formatters_中的位置, 没有%m时等于formatters_.size().
+    size_t message_index_ = 0;
+    // 不为空时代替formatters_.
+    CompiledFormatterFunc compiled_prefix_ = nullptr;
+    CompiledFormatterFunc compiled_suffix_ = nullptr;
+    bool compiled_has_message_             = false;
+    // 令牌桶(GCRA): 每条日志的间隔, 允许超前的时间, 理论上下一条日志到达的时间, 为0时不限流.
+    std::atomic<int64_t> rate_interval_ns_{0};
+    std::atomic<int64_t> rate_tolerance_ns_{0};
+    std::atomic<int64_t> rate_tat_ns_{0};
+    std::atomic<uint64_t> suppressed_{0};
+    std::atomic<uint64_t> reported_{0};
 };
 
 
 class _LogManager : lon::Noncopyable
 {
+    friend Logger;
+    friend log::LoggerSlot;
+
 public:
     _LogManager();
 
-    Logger::ptr getLogger(const String& key) {
-        if (auto iter = loggers_.find(key); iter != loggers_.end())
-            return iter->second;
-        return nullptr;
-    }
+    ~_LogManager();
+
+    /**
+     * @brief 名字对应的logger, 不存在时返回默认logger, 不会返回nullptr.
+     */
+    Logger::ptr getLogger(const String& key);
 
     Logger::ptr getDefault() {
         return default_logger_;
     }
 
+    /**
+     * @brief 覆盖名字为module的LoggerSlot的级别, 优先于logger自身的级别.
+     */
+    void setModuleLevel(const String& module, Level level);
+
+    /**
+     * @brief 覆盖文件路径以file结尾(例如"net/stream_server.cpp")的LoggerSlot的级别, 优先于模块的覆盖.
+     */
+    void setFileLevel(const String& file, Level level);
+
+    void clearLevelOverrides();
+
+    /**
+     * @brief 从json配置文件重新读取级别: logs中各个logger的level, 以及
+     * "log_levels": {"modules": {name: level}, "files": {file: level}} 中的覆盖(替换之前所有的覆盖).
+     * 只修改级别, 不重新创建formatter和flusher.
+     * @return 文件无法读取或者解析失败时返回false, 级别保持不变.
+     */
+    bool reloadLevels(const String& filename = "conf/main.json");
+
+    /**
+     * @brief 收到signo以后在后台线程中调用reloadLevels(filename), 信号处理函数只写一个字节到pipe.
+     */
+    void installReloadSignal(int signo = SIGHUP, const String& filename = "conf/main.json");
+
 private:
     void initDefaultLogger();
     void initLoggerFromConfig();
 
+    void registerSlot(log::LoggerSlot* slot);
+    void unregisterSlot(log::LoggerSlot* slot);
+
+    /**
+     * @brief 重新计算所有LoggerSlot的级别, 需要持有mutex_.
+     */
+    void refreshLevelsLocked();
+
+    Level slotLevelLocked(const log::LoggerSlot& slot) const;
+
     Logger::ptr default_logger_ = nullptr;
     std::unordered_map<String, Logger::ptr> loggers_{};
+
+    // 保护下面的成员以及loggers_在初始化以后的修改.
+    mutable Mutex mutex_;
+    std::vector<log::LoggerSlot*> slots_{};
+    std::unordered_map<String, Level> module_levels_{};
+    std::vector<std::pair<String, Level>> file_levels_{};
+    String reload_filename_{};
+    Thread reload_thread_{};
 };
 
 
 using LogManager = Singleton<_LogManager>;
 
+namespace log {
+
+/**
+ * @brief 按名字取得的logger, 作为静态变量使用, 生存期内地址不变. 级别是文件/模块覆盖以后的结果,
+ * 保存在slot自身中, 禁用的日志只有一次load和一次比较, 不经过shared_ptr.
+ * @code
+ * static lon::log::LoggerSlot G_logger{"system"};
+ * LON_LOG_INFO(G_logger) << "...";
+ * @endcode
+ */
+class LoggerSlot : public Noncopyable
+{
+    friend _LogManager;
+
+public:
+    /**
+     * @param file 用于按文件覆盖级别, 默认为构造slot的源文件
+     */
+    explicit LoggerSlot(const String& name, const char* file = __builtin_FILE());
+
+    ~LoggerSlot();
+
+    Level getLevel() const noexcept {
+        return level_.load(std::memory_order_relaxed);
+    }
+
+    Logger* operator->() const noexcept {
+        return logger_;
+    }
+
+    Logger& operator*() const noexcept {
+        return *logger_;
+    }
+
+    operator Logger::ptr() const {
+        return logger_->shared_from_this();
+    }
+
+    const String& getName() const noexcept {
+        return name_;
+    }
+
+    const char* getFile() const noexcept {
+        return file_;
+    }
+
+private:
+    std::atomic<Level> level_{DEBUG};
+    // 由LogManager持有, 进程结束前不会释放.
+    Logger* logger_;
+    const String name_;
+    const char* file_;
+};
+
+/**
+ * @brief 默认logger(root)的slot, LON_LOG_DEFAULT_*使用, 不参与按文件的覆盖.
+ */
+inline LoggerSlot& defaultSlot() {
+    static LoggerSlot slot{"root", ""};
+    return slot;
+}
+
+LON_ALWAYS_INLINE bool enabled(const Logger::ptr& logger, Level level) noexcept {
+    return logger->getLevel() <= level;
+}
+
+LON_ALWAYS_INLINE bool enabled(const LoggerSlot& slot, Level level) noexcept {
+    return slot.getLevel() <= level;
+}
+
+}  // namespace log
+
 
 }  // namespace lon
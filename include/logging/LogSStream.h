@@ -6,7 +6,9 @@
 
 #include <cassert>
 #include <iostream>
+#include <sstream>
 #include <algorithm>
+#include <cstdint>
 #include <cstring>
 #include <type_traits>
 #include "../base/typedef.h"
@@ -15,6 +17,11 @@
 namespace lon {
     namespace log {
         constexpr int LogBufferMaxLen = lon::data::K * 5;
+        // 一条日志(包括其中嵌套的日志)最多扩展到的长度, 超过的部分被截断.
+        constexpr int LogBufferLimit = lon::data::M * 4;
+        // 截断时在末尾保留的空间, 用于截断标记以及%m之后的部分(例如换行).
+        constexpr int LogTruncateReserve = 64;
+        constexpr char LogTruncatedMarker[] = "...(truncated)";
 
 
         class LogBufAlloc {
@@ -30,6 +37,10 @@ namespace lon {
             }
         };
 
+        /**
+         * @brief 线程局部的日志缓冲, 默认LogBufferMaxLen字节, 写满时扩展为更大的缓冲(最多LogBufferLimit).
+         * 扩展以后旧的缓冲在最外层的LogSStream结束之前不会释放, 所以指向其中的StringPiece(例如LogEvent::content)一直有效.
+         */
         template<typename Alloc = LogBufAlloc, typename DataType = char>
         struct LogSStreamBuf final {
         public:
@@ -39,6 +50,7 @@ namespace lon {
             }
 
             ~LogSStreamBuf() {
+                release();
                 Alloc::dealloc(buf_);
             }
 
@@ -56,25 +68,172 @@ namespace lon {
                 return buf_ + pos_;
             }
 
+            /**
+             * @brief 保证可以在末尾连续写入size个字节.
+             * @return 写入的位置, 已经达到LogBufferLimit时返回nullptr.
+             */
+            LON_ALWAYS_INLINE
+            char *reserve(size_t size) noexcept {
+                if (LIKELY(static_cast<size_t>(end_ - pos_) >= size))
+                    return buf_ + pos_;
+                // 截断以后end_停在标记之后, 消息体剩余的部分被丢弃.
+                if (end_ != capacity_)
+                    return nullptr;
+                return grow(static_cast<size_t>(pos_) + size) ? buf_ + pos_ : nullptr;
+            }
+
             LON_ALWAYS_INLINE
             void append(char c) noexcept {
-                assert(pos_ < LogBufferMaxLen);
-                auto cur = buf_ + pos_++;
-                *cur = c;
+                append(&c, 1);
+            }
+
+            LON_ALWAYS_INLINE
+            void append(const char *buf, size_t size) noexcept {
+                if (char *tail = reserve(size)) {
+                    ::memcpy(tail, buf, size);
+                    pos_ += static_cast<int>(size);
+                } else {
+                    truncate(buf, size);
+                }
             }
 
+            /**
+             * @brief 消息体已经写完, 截断以后剩余的空间可以继续写入%m之后的部分.
+             */
             LON_ALWAYS_INLINE
-            void append(const char *buf, size_t size) {
-                ::memcpy(buf_ + pos_, buf, size);
-                pos_ += static_cast<int>(size);
+            void endMessage() noexcept {
+                end_ = capacity_;
+            }
+
+            /**
+             * @brief 外层消息的截断状态, end为-1表示没有截断.
+             */
+            struct MessageState {
+                int end = -1;
+                bool truncated = false;
+            };
+
+            /**
+             * @brief 嵌套的消息开始: 即使外层已经截断, 也在其后打开一段新的消息.
+             * @return 外层的截断状态, 嵌套的消息结束时交给restoreMessage.
+             */
+            MessageState beginMessage() noexcept {
+                const MessageState outer{end_ == capacity_ ? -1 : end_, truncated_};
+                end_ = capacity_;
+                truncated_ = false;
+                return outer;
+            }
+
+            /**
+             * @brief 嵌套的消息结束, 恢复外层的截断状态, 外层截断以后的写入仍然被丢弃.
+             */
+            void restoreMessage(const MessageState &outer) noexcept {
+                // 嵌套的消息可能扩展了缓冲, 没有截断时上限跟随新的capacity_.
+                end_ = outer.end < 0 ? capacity_ : outer.end;
+                truncated_ = outer.truncated;
+            }
+
+            /**
+             * @brief 最外层的LogSStream结束时调用, 释放扩展时留下的旧缓冲, 恢复为默认大小.
+             */
+            LON_ALWAYS_INLINE
+            void reset() noexcept {
+                if (UNLIKELY(retired_count_ > 0 || capacity_ != LogBufferMaxLen || truncated_))
+                    release();
             }
 
             char *buf_ = nullptr;
             int pos_ = 0;
+
+        private:
+            /**
+             * @brief 扩展到至少size个字节, 新缓冲从buf_拷贝已经写入的部分.
+             */
+            bool grow(size_t size) noexcept {
+                if (size <= static_cast<size_t>(capacity_))
+                    return true;
+                if (size > static_cast<size_t>(LogBufferLimit) || retired_count_ == kMaxRetired)
+                    return false;
+                size_t capacity = static_cast<size_t>(capacity_) * 2;
+                while (capacity < size) {
+                    capacity *= 2;
+                }
+                capacity = std::min(capacity, static_cast<size_t>(LogBufferLimit));
+                auto *buf = static_cast<char *>(Alloc::alloc(capacity));
+                if (buf == nullptr)
+                    return false;
+                ::memcpy(buf, buf_, static_cast<size_t>(pos_));
+                retired_[retired_count_++] = buf_;
+                buf_ = buf;
+                capacity_ = static_cast<int>(capacity);
+                end_ = capacity_;
+                return true;
+            }
+
+            /**
+             * @brief 写入放得下的部分并加上截断标记, 之后的写入被丢弃, 直到endMessage.
+             */
+            void truncate(const char *buf, size_t size) noexcept {
+                if (truncated_)
+                    return;
+                truncated_ = true;
+                grow(LogBufferLimit);
+                const int end = capacity_ - LogTruncateReserve;
+                if (pos_ < end) {
+                    const size_t n = std::min(size, static_cast<size_t>(end - pos_));
+                    ::memcpy(buf_ + pos_, buf, n);
+                    pos_ += static_cast<int>(n);
+                }
+                const size_t n = std::min(sizeof(LogTruncatedMarker) - 1, static_cast<size_t>(capacity_ - pos_));
+                ::memcpy(buf_ + pos_, LogTruncatedMarker, n);
+                pos_ += static_cast<int>(n);
+                end_ = pos_;
+            }
+
+            void release() noexcept {
+                for (int i = 0; i < retired_count_; ++i) {
+                    Alloc::dealloc(retired_[i]);
+                }
+                retired_count_ = 0;
+                truncated_ = false;
+                if (capacity_ != LogBufferMaxLen) {
+                    if (auto *buf = static_cast<char *>(Alloc::alloc(LogBufferMaxLen))) {
+                        Alloc::dealloc(buf_);
+                        buf_ = buf;
+                        capacity_ = LogBufferMaxLen;
+                    }
+                }
+                end_ = capacity_;
+            }
+
+            // 从LogBufferMaxLen每次翻倍到LogBufferLimit最多需要的次数.
+            static constexpr int kMaxRetired = 16;
+
+            int capacity_ = LogBufferMaxLen;
+            // 可以写入的位置上限, 截断以后小于capacity_.
+            int end_ = LogBufferMaxLen;
+            bool truncated_ = false;
+            int retired_count_ = 0;
+            char *retired_[kMaxRetired] = {};
+        };
+
+        /**
+         * @brief 十六进制输出(大写, 没有0x前缀), 例如 stream << Hex(255) 输出FF.
+         */
+        struct Hex {
+            explicit Hex(uint64_t _value) noexcept : value{_value} {}
+
+            uint64_t value;
         };
 
+        /**
+         * @brief 线程局部缓冲上的一段: 构造时从缓冲当前的末尾开始, 析构时释放这一段,
+         * 所以可以嵌套使用(例如在格式化日志参数时又输出了日志).
+         */
         class LogSStream final {
         public:
+            LogSStream() noexcept;
+
             ~LogSStream();
 
             LogSStream &operator<<(char c);
@@ -82,20 +241,69 @@ namespace lon {
             template<typename T, typename ISI= std::enable_if_t<std::is_integral_v<T>>>
             LogSStream &operator<<(const T &n);
 
+            /**
+             * @brief 最短的可以精确还原的十进制表示(std::to_chars).
+             */
             LogSStream &operator<<(double n);
 
+            LogSStream &operator<<(float n);
+
+            LogSStream &operator<<(Hex hex);
+
+            /**
+             * @brief 指针输出为0x加上十六进制的地址, char指针按照字符串输出.
+             */
+            template<typename T, std::enable_if_t<!std::is_same_v<std::remove_cv_t<T>, char>, int> = 0>
+            LogSStream &operator<<(T *ptr) {
+                return writePointer(reinterpret_cast<uintptr_t>(ptr));
+            }
+
             LogSStream &operator<<(const String &s);
 
             LogSStream &operator<<(StringPiece slice);
 
             LogSStream &operator<<(const char* str);
 
+            /**
+             * @brief 没有专门重载的类型(例如用户类型, 指针)通过std::ostream输出, 较慢.
+             */
+            template<typename T,
+                     std::enable_if_t<!std::is_arithmetic_v<T> && !std::is_pointer_v<T> &&
+                                      !std::is_convertible_v<const T &, StringPiece> &&
+                                      !std::is_convertible_v<const T &, const char *>, int> = 0>
+            LogSStream &operator<<(const T &value) {
+                std::ostringstream ss;
+                ss << value;
+                return *this << StringPiece(ss.str());
+            }
+
             String str();
 
             StringPiece getSlice();
 
+            /**
+             * @brief 这一段已经写入的字节数.
+             */
+            size_t size() const noexcept;
+
+            /**
+             * @brief 截断为size个字节.
+             */
+            void resize(size_t size) noexcept;
+
+            /**
+             * @brief 消息体已经写完: 截断以后被丢弃的写入恢复, 用于输出%m之后的部分.
+             */
+            void endMessage() noexcept;
+
         private:
             void append(char c) noexcept;
+
+            LogSStream &writePointer(uintptr_t ptr);
+
+            int begin_ = 0;
+            // 嵌套时外层消息的截断状态.
+            LogSStreamBuf<>::MessageState outer_;
         };
 
     }
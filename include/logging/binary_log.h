@@ -0,0 +1,223 @@
+#pragma once
+#include "../base/info.h"
+#include "../base/macro.h"
+#include "../base/nocopyable.h"
+#include "../base/typedef.h"
+#include "../logger.h"
+
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+#include <unordered_map>
+
+/**
+ * @brief 二进制日志: 调用处只记录格式串所在位置(LogSite)的id以及参数的原始字节,
+ * 不在调用线程中格式化, 由runner_log_decode(BinaryLogDecoder)离线还原为文本.
+ * format使用fmt的语法, 参数只能是算术类型或者字符串.
+ * @code
+ * LON_BLOG_INFO(logger, "request {} cost {:.3f} ms", id, cost);
+ * @endcode
+ */
+#define LON_BLOG(logger, level, format, ...)                                                \
+    do {                                                                                    \
+        if (lon::log::enabled(logger, level) && (logger)->acquire(level)) {                 \
+            static const lon::log::LogSite lon_log_site{__FILE__, __LINE__, level, format}; \
+            lon::log::logBinary(*(logger), lon_log_site, ##__VA_ARGS__);                    \
+        }                                                                                   \
+    } while (0)
+
+#define LON_BLOG_DEBUG(logger, ...) LON_BLOG(logger, lon::Level::DEBUG, __VA_ARGS__)
+#define LON_BLOG_INFO(logger, ...) LON_BLOG(logger, lon::Level::INFO, __VA_ARGS__)
+#define LON_BLOG_WARN(logger, ...) LON_BLOG(logger, lon::Level::WARN, __VA_ARGS__)
+#define LON_BLOG_ERROR(logger, ...) LON_BLOG(logger, lon::Level::ERROR, __VA_ARGS__)
+
+namespace lon {
+
+namespace log {
+
+/**
+ * @brief 记录的格式(本机字节序), 每条记录以 uint32 size(包括size本身), uint8 type 开头.
+ * Site:  uint64 site, int32 line, uint8 level, uint16 file长度, file, uint16 format长度, format
+ * Event: uint64 site, int64 秒, uint32 纳秒, uint32 thread_id, uint8 参数个数,
+ *        每个参数为 uint8 类型 + 值(String为 uint32 长度 + 字节)
+ * site的高32位是进程的epoch(由pid和启动时间得到), 低32位是进程内的序号. 日志文件以O_APPEND打开,
+ * 多次运行写入同一个文件时各自的site不会冲突, 并且不依赖记录在文件中的顺序(不同线程的记录可能乱序).
+ */
+enum class BinaryRecordType : uint8_t
+{
+    Site,
+    Event,
+};
+
+enum class BinaryArgType : uint8_t
+{
+    Int,
+    Uint,
+    Double,
+    Bool,
+    Char,
+    String,
+};
+
+/**
+ * @brief 一个LON_BLOG调用处, 以函数内的静态变量存在, 第一次执行时分配id.
+ */
+struct LogSite : public Noncopyable
+{
+    LogSite(const char* _file, int _line, Level _level, StringPiece _format) noexcept;
+
+    const char* file;
+    int line;
+    Level level;
+    StringPiece format;
+    uint64_t id;
+    // 最后一次写出Site记录的logger, 变化时重新写出, 保证每个logger的输出中都有定义.
+    mutable std::atomic<uint64_t> announced{0};
+};
+
+namespace binary {
+
+constexpr size_t kRecordHeaderSize = sizeof(uint32_t) + sizeof(uint8_t);
+constexpr size_t kEventHeaderSize =
+    kRecordHeaderSize + sizeof(uint64_t) + sizeof(int64_t) + sizeof(uint32_t) * 2 + sizeof(uint8_t);
+
+template<class T>
+LON_ALWAYS_INLINE void put(char*& buf, T value) noexcept {
+    std::memcpy(buf, &value, sizeof(value));
+    buf += sizeof(value);
+}
+
+template<class T>
+constexpr bool isStringArg() {
+    return std::is_convertible_v<const T&, StringPiece> || std::is_convertible_v<const T&, const char*>;
+}
+
+template<class T>
+LON_ALWAYS_INLINE size_t argSize(const T& value) noexcept {
+    static_assert(std::is_arithmetic_v<T> || isStringArg<T>(),
+                  "binary log only supports arithmetic and string arguments");
+    if constexpr (std::is_same_v<T, bool> || std::is_same_v<T, char>) {
+        return 2;
+    } else if constexpr (std::is_arithmetic_v<T>) {
+        return 1 + 8;
+    } else {
+        return 1 + sizeof(uint32_t) + StringPiece(value).size();
+    }
+}
+
+template<class T>
+LON_ALWAYS_INLINE void putArg(char*& buf, const T& value) noexcept {
+    if constexpr (std::is_same_v<T, bool>) {
+        put(buf, BinaryArgType::Bool);
+        put(buf, static_cast<uint8_t>(value));
+    } else if constexpr (std::is_same_v<T, char>) {
+        put(buf, BinaryArgType::Char);
+        put(buf, value);
+    } else if constexpr (std::is_floating_point_v<T>) {
+        put(buf, BinaryArgType::Double);
+        put(buf, static_cast<double>(value));
+    } else if constexpr (std::is_signed_v<T>) {
+        put(buf, BinaryArgType::Int);
+        put(buf, static_cast<int64_t>(value));
+    } else if constexpr (std::is_unsigned_v<T>) {
+        put(buf, BinaryArgType::Uint);
+        put(buf, static_cast<uint64_t>(value));
+    } else {
+        const StringPiece str(value);
+        put(buf, BinaryArgType::String);
+        put(buf, static_cast<uint32_t>(str.size()));
+        std::memcpy(buf, str.data(), str.size());
+        buf += str.size();
+    }
+}
+
+/**
+ * @brief 写出site的Site记录.
+ */
+void announceSite(Logger& logger, const LogSite& site);
+
+}  // namespace binary
+
+/**
+ * @brief 编码一条Event记录并直接写入logger的所有flusher, 不经过formatters.
+ * 记录较小时在栈上编码, 没有内存分配.
+ */
+template<class... Args>
+void logBinary(Logger& logger, const LogSite& site, const Args&... args) {
+    static_assert(sizeof...(Args) < 256, "too many binary log arguments");
+    if (UNLIKELY(site.announced.load(std::memory_order_relaxed) != logger.getId()))
+        binary::announceSite(logger, site);
+
+    const timespec now = coarseNow();
+    const size_t size  = (binary::kEventHeaderSize + ... + binary::argSize(args));
+    char stack_buffer[256];
+    String heap_buffer;
+    char* begin = stack_buffer;
+    if (UNLIKELY(size > sizeof(stack_buffer))) {
+        heap_buffer.resize(size);
+        begin = heap_buffer.data();
+    }
+    char* buf = begin;
+    binary::put(buf, static_cast<uint32_t>(size));
+    binary::put(buf, BinaryRecordType::Event);
+    binary::put(buf, site.id);
+    binary::put(buf, static_cast<int64_t>(now.tv_sec));
+    binary::put(buf, static_cast<uint32_t>(now.tv_nsec));
+    binary::put(buf, getThreadId());
+    binary::put(buf, static_cast<uint8_t>(sizeof...(Args)));
+    (binary::putArg(buf, args), ...);
+    assert(static_cast<size_t>(buf - begin) == size);
+    logger.write(StringPiece(begin, size));
+}
+
+/**
+ * @brief 把二进制日志还原为文本: 每条Event按照site的format格式化为消息体,
+ * 然后交给output(使用它自己的pattern和flusher)输出.
+ */
+class BinaryLogDecoder : public Noncopyable
+{
+public:
+    explicit BinaryLogDecoder(Logger::ptr output) : output_{std::move(output)} {}
+
+    /**
+     * @brief 解码data中的所有完整记录. 不同线程的记录可能早于它引用的Site记录写出,
+     * 所以先收集所有Site记录再输出Event. 多个切换出的文件需要按顺序拼接以后一起解码.
+     * @return 输出的日志条数.
+     */
+    size_t decode(StringPiece data);
+
+    /**
+     * @brief 格式错误, 末尾不完整, 引用了未知site或者以不同内容重新定义site的记录数.
+     */
+    LON_NODISCARD
+    size_t getErrors() const noexcept {
+        return errors_;
+    }
+
+private:
+    struct Site
+    {
+        String file;
+        int line;
+        Level level;
+        String format;
+    };
+
+    /**
+     * @brief 以(type, 去掉记录头的内容)遍历data中的完整记录.
+     * @return 遇到不完整或者长度错误的记录时停止并返回false.
+     */
+    template<class Func>
+    bool forEachRecord(StringPiece data, Func&& func);
+
+    bool decodeSite(StringPiece record);
+
+    bool decodeEvent(StringPiece record);
+
+    Logger::ptr output_;
+    std::unordered_map<uint64_t, Site> sites_;
+    size_t errors_ = 0;
+};
+
+}  // namespace log
+}  // namespace lon
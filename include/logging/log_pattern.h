@@ -0,0 +1,208 @@
+#pragma once
+#include "../base/macro.h"
+#include "../base/typedef.h"
+#include "../logger.h"
+#include "loger_formatters.h"
+
+#include <stdexcept>
+
+namespace lon {
+
+namespace log {
+
+/**
+ * @brief 编译期展开的格式化pattern, 语法与Logger::setFormatters(const String&)相同.
+ * pattern由一个带有 static constexpr StringPiece value 的类型给出:
+ * @code
+ * struct MyPattern {
+ *     static constexpr StringPiece value = "%d{%Y-%m-%d %H:%M:%S} [%p] %m%n";
+ * };
+ * lon::log::setFormatters<MyPattern>(*logger);
+ * @endcode
+ * pattern在编译期解析, 以第一个%m为界展开成两个函数, 每个token直接内联,
+ * 没有std::function的间接调用. 未知的key或者没有闭合的{会导致编译错误.
+ */
+namespace pattern {
+
+enum class TokenType
+{
+    End,
+    Literal,
+    Key,
+};
+
+struct Token
+{
+    TokenType type = TokenType::End;
+    // Literal: 文本在pattern中的位置; Key: {}中的参数.
+    size_t begin = 0;
+    size_t size  = 0;
+    char key     = 0;
+    // 下一个token的开始位置.
+    size_t end = 0;
+};
+
+constexpr bool isAlpha(char c) noexcept {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+constexpr bool isKey(char c) noexcept {
+    for (char key : StringPiece("mprctndflET")) {
+        if (c == key)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief 解析从pos开始的一个token, 在常量表达式中抛出异常即为编译错误.
+ */
+constexpr Token parseToken(StringPiece pattern, size_t pos) {
+    Token token;
+    if (pos >= pattern.size()) {
+        token.begin = token.end = pos;
+        return token;
+    }
+    if (pattern[pos] != '%') {
+        size_t n = pos;
+        while (n < pattern.size() && pattern[n] != '%') {
+            ++n;
+        }
+        token.type  = TokenType::Literal;
+        token.begin = pos;
+        token.size  = n - pos;
+        token.end   = n;
+        return token;
+    }
+    if (pos + 1 < pattern.size() && pattern[pos + 1] == '%') {
+        token.type  = TokenType::Literal;
+        token.begin = pos + 1;
+        token.size  = 1;
+        token.end   = pos + 2;
+        return token;
+    }
+    if (pos + 1 >= pattern.size() || !isKey(pattern[pos + 1]))
+        throw std::invalid_argument("unknown log pattern key");
+    token.type = TokenType::Key;
+    token.key  = pattern[pos + 1];
+    // 与运行时的解析相同, key之后连续的字母被忽略.
+    size_t n = pos + 2;
+    while (n < pattern.size() && isAlpha(pattern[n])) {
+        ++n;
+    }
+    if (n < pattern.size() && pattern[n] == '{') {
+        const size_t close = pattern.find('}', n);
+        if (close == StringPiece::npos)
+            throw std::invalid_argument("unclosed '{' in log pattern");
+        token.begin = n + 1;
+        token.size  = close - n - 1;
+        n           = close + 1;
+    }
+    token.end = n;
+    return token;
+}
+
+/**
+ * @brief 第一个%m所在token的位置, 没有%m时返回pattern.size().
+ */
+constexpr size_t findMessage(StringPiece pattern) {
+    for (size_t pos = 0; pos < pattern.size();) {
+        const Token token = parseToken(pattern, pos);
+        if (token.type == TokenType::Key && token.key == 'm')
+            return pos;
+        pos = token.end;
+    }
+    return pattern.size();
+}
+
+/**
+ * @brief %d{pattern}, 每个token对应一个DateTimeLogFormatter.
+ */
+template<class Pattern, size_t Begin, size_t Size>
+const DateTimeLogFormatter& dateTimeFormatter() {
+    static const DateTimeLogFormatter formatter(
+        Size == 0 ? String("%Y-%m-%d %H:%M:%S") : String(Pattern::value.substr(Begin, Size)));
+    return formatter;
+}
+
+/**
+ * @brief pattern中[Pos, End)部分展开成的格式化函数.
+ */
+template<class Pattern, size_t Pos, size_t End>
+struct Formatter
+{
+    static constexpr Token token = parseToken(Pattern::value, Pos);
+
+    LON_ALWAYS_INLINE static void format(Logger::StringStream& stream, LogEvent* event) noexcept {
+        if constexpr (Pos < End) {
+            formatToken(stream, event);
+            Formatter<Pattern, token.end, End>::format(stream, event);
+        }
+    }
+
+    LON_ALWAYS_INLINE static void formatToken(Logger::StringStream& stream, LogEvent* event) noexcept {
+        if constexpr (token.type == TokenType::Literal) {
+            stream << Pattern::value.substr(token.begin, token.size);
+        } else if constexpr (token.key == 'm') {
+            stream << event->content;
+        } else if constexpr (token.key == 'p') {
+            stream << Logger::levelToString(event->level);
+        } else if constexpr (token.key == 'r') {
+            stream << event->elapsed_ms;
+        } else if constexpr (token.key == 'c') {
+            stream << event->logger_name;
+        } else if constexpr (token.key == 't') {
+            stream << event->thread_id;
+        } else if constexpr (token.key == 'n') {
+            stream << StringPiece("\r\n");
+        } else if constexpr (token.key == 'd') {
+            dateTimeFormatter<Pattern, token.begin, token.size>()(stream, event);
+        } else if constexpr (token.key == 'f') {
+            stream << event->file_name;
+        } else if constexpr (token.key == 'l') {
+            stream << event->line;
+        } else if constexpr (token.key == 'E') {
+            stream << event->executor_id;
+        } else if constexpr (token.key == 'T') {
+            stream << '\t';
+        }
+    }
+};
+
+template<class Pattern>
+struct CompiledPattern
+{
+    static constexpr size_t size          = Pattern::value.size();
+    static constexpr size_t message_begin = findMessage(Pattern::value);
+    static constexpr bool has_message     = message_begin < size;
+    static constexpr size_t message_end =
+        has_message ? parseToken(Pattern::value, message_begin).end : size;
+
+    /**
+     * @brief 消息体之前的部分, 没有%m时为整个pattern.
+     */
+    static void prefix(Logger::StringStream& stream, LogEvent* event) noexcept {
+        Formatter<Pattern, 0, message_begin>::format(stream, event);
+    }
+
+    /**
+     * @brief 消息体之后的部分.
+     */
+    static void suffix(Logger::StringStream& stream, LogEvent* event) noexcept {
+        Formatter<Pattern, message_end, size>::format(stream, event);
+    }
+};
+
+}  // namespace pattern
+
+/**
+ * @brief 使用编译期pattern设置logger的格式化, 之后调用setFormatters(const String&)会恢复运行时的格式化.
+ */
+template<class Pattern>
+void setFormatters(Logger& logger) noexcept {
+    using Compiled = pattern::CompiledPattern<Pattern>;
+    logger.setCompiledFormatters(&Compiled::prefix, &Compiled::suffix, Compiled::has_message);
+}
+
+}  // namespace log
+}  // namespace lon
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "../base/nocopyable.h"
+#include "../base/typedef.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+namespace lon {
+
+namespace log {
+
+/**
+ * @brief 单生产者单消费者的字节环形缓冲, 无锁.
+ * 生产者每次写入一条完整的日志(要么全部写入, 要么不写入), 消费者一次取出所有已经写入的部分.
+ */
+class LogRing : public Noncopyable
+{
+public:
+    /**
+     * @param capacity 容量, 向上取整为2的幂.
+     */
+    explicit LogRing(size_t capacity) {
+        capacity_ = 64;
+        while (capacity_ < capacity) {
+            capacity_ <<= 1;
+        }
+        mask_   = capacity_ - 1;
+        buffer_ = static_cast<char*>(std::malloc(capacity_));
+    }
+
+    ~LogRing() {
+        std::free(buffer_);
+    }
+
+    /**
+     * @brief 只能在生产者线程调用.
+     * @return 剩余空间不足时返回false, 不写入任何内容.
+     */
+    bool tryWrite(StringPiece data) noexcept {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (capacity_ - (head - cached_tail_) < data.size()) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (capacity_ - (head - cached_tail_) < data.size())
+                return false;
+        }
+        const size_t offset = head & mask_;
+        const size_t first  = std::min(data.size(), capacity_ - offset);
+        std::memcpy(buffer_ + offset, data.data(), first);
+        std::memcpy(buffer_, data.data() + first, data.size() - first);
+        head_.store(head + data.size(), std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 只能在消费者线程调用, 以最多两段连续内存调用func(const char*, size_t), 之后释放这部分空间.
+     * @return 取出的字节数.
+     */
+    template<class Func>
+    size_t consume(Func&& func) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t head = head_.load(std::memory_order_acquire);
+        if (head == tail)
+            return 0;
+        const size_t offset = tail & mask_;
+        const size_t first  = std::min(head - tail, capacity_ - offset);
+        func(buffer_ + offset, first);
+        if (head - tail > first)
+            func(buffer_, head - tail - first);
+        tail_.store(head, std::memory_order_release);
+        return head - tail;
+    }
+
+    LON_NODISCARD
+    bool empty() const noexcept {
+        return head_.load(std::memory_order_acquire) ==
+               tail_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief 已经写入但是还没有取出的字节数, 在其它线程调用时只是近似值.
+     */
+    LON_NODISCARD
+    size_t size() const noexcept {
+        return head_.load(std::memory_order_acquire) -
+               tail_.load(std::memory_order_acquire);
+    }
+
+    LON_NODISCARD
+    size_t capacity() const noexcept { return capacity_; }
+
+private:
+    char* buffer_     = nullptr;
+    size_t capacity_  = 0;
+    size_t mask_      = 0;
+    // head_与生产者的cached_tail_在同一个cache line, tail_单独一个, 避免伪共享.
+    alignas(64) std::atomic<size_t> head_{0};
+    size_t cached_tail_ = 0;
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+}  // namespace log
+}  // namespace lon
@@ -0,0 +1,119 @@
+#pragma once
+#include "../base/file.h"
+#include "../base/nocopyable.h"
+#include "../base/typedef.h"
+#include "logger_filename.h"
+
+
+#include <ctime>
+#include <deque>
+#include <limits>
+#include <memory>
+
+namespace lon {
+
+namespace log {
+
+/**
+ * @brief 按照时间切换日志文件的周期, 以本地时间的整点/零点/周一/每月一日为边界.
+ */
+enum class FlushFrequency
+{
+    Never,
+    Month,
+    Week,
+    Day,
+    HalfDay,
+    Hour
+};
+
+struct LogRotationOptions
+{
+    // 按时间切换的周期.
+    FlushFrequency frequency = FlushFrequency::Never;
+    // 单个文件的最大字节数(在写入批次之间切换, 单个批次不会被拆开), 0表示不按大小切换.
+    size_t max_file_size = 0;
+    // 最多保留的已切换文件数(只统计本次运行中切换出的文件), 0表示全部保留.
+    size_t max_files = 0;
+    // 在后台线程中把已切换的文件压缩为.gz, 没有开启EnableLogCompression时忽略.
+    bool compress = false;
+};
+
+class LogCompressor;
+
+/**
+ * @brief 日志文件的切换, 只在flusher的写线程中使用:
+ * 写线程在写入每个批次之前调用shouldRotate, 需要切换时在rotate中打开新文件并替换WritableFile,
+ * 生产者线程不会等待open/rename.
+ * 文件名不随时间变化(pattern中没有%d, 或者按大小切换)时, 旧文件被重命名为 name.YYYYmmdd-HHMMSS.N,
+ * 否则旧文件保留原来的名字, 新文件使用新的时间生成文件名.
+ */
+class LogRotator : public Noncopyable
+{
+public:
+    LogRotator(LogFilenameData filename, const LogRotationOptions& options);
+
+    /**
+     * @brief 等待后台线程压缩完所有已切换的文件.
+     */
+    ~LogRotator();
+
+    LON_NODISCARD
+    bool enabled() const noexcept {
+        return options_.frequency != FlushFrequency::Never || options_.max_file_size > 0;
+    }
+
+    /**
+     * @brief 关联写线程当前打开的文件, 在写线程开始写入之前调用.
+     */
+    void attach(const WritableFile& file, time_t now = ::time(nullptr));
+
+    /**
+     * @brief 写入bytes字节之前是否需要切换文件.
+     */
+    LON_NODISCARD
+    bool shouldRotate(size_t bytes, time_t now) const noexcept {
+        return now >= next_rotate_time_ ||
+               (options_.max_file_size > 0 && file_size_ > 0 &&
+                file_size_ + bytes > options_.max_file_size);
+    }
+
+    void written(size_t bytes) noexcept {
+        file_size_ += bytes;
+    }
+
+    /**
+     * @brief 关闭(重命名)当前文件并打开新文件, 打开失败时继续写入原来的文件.
+     */
+    void rotate(WritableFile& file, time_t now);
+
+    /**
+     * @brief 已经切换的次数.
+     */
+    LON_NODISCARD
+    size_t getRotations() const noexcept {
+        return rotations_;
+    }
+
+    /**
+     * @brief now之后下一个切换的时间点, Never时返回time_t的最大值.
+     */
+    static time_t nextRotateTime(time_t now, FlushFrequency frequency);
+
+private:
+    String archiveName(const String& filename, time_t now);
+
+    void retain(const String& archived);
+
+    const LogFilenameData filename_;
+    const LogRotationOptions options_;
+    String current_;
+    size_t file_size_       = 0;
+    time_t next_rotate_time_ = std::numeric_limits<time_t>::max();
+    size_t rotations_       = 0;
+    std::deque<String> archived_;
+    std::unique_ptr<LogCompressor> compressor_;
+};
+
+}  // namespace log
+}  // namespace lon
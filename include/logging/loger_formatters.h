@@ -32,6 +32,28 @@ private:
     String str_;
 };
 
+/**
+ * @brief %d{pattern}: 格式化的日期按照线程缓存, 只在秒变化时重新调用localtime_r/strftime.
+ * pattern相同的formatter共享缓存项, 线程交替使用多个logger时不会每次重新格式化.
+ * pattern中可以包含一个%3N(毫秒)或者%6N(微秒), 由整数格式化填充.
+ */
+class DateTimeLogFormatter
+{
+public:
+    explicit DateTimeLogFormatter(const String& pattern);
+
+    void operator()(Logger::StringStream& stream, LogEvent* event) const;
+
+private:
+    // 秒内部分之前/之后的strftime格式.
+    String before_;
+    String after_;
+    // 秒内部分的位数, 0表示没有.
+    int digits_ = 0;
+    // 线程缓存的键, 由pattern决定.
+    uint64_t id_;
+};
+
 //using LogFormatterFactory = Singleton<_LogFormatterFactory>;
 
 }
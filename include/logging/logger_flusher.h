@@ -4,10 +4,17 @@
 #include "../base/singleton.h"
 #include "../base/typedef.h"
 #include "logger_filename.h"
+#include "log_ring.h"
+#include "log_rotator.h"
 
 
+#include <atomic>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <queue>
+#include <unordered_map>
+#include <vector>
 
 #define LON_USING_C_FILE 0
 
@@ -16,16 +23,6 @@ namespace lon {
 
 namespace log {
 
-// TODO 完成定时器之后, 添加按照时间刷新输出文件功能(包括文件名)
-enum class FlushFrequency
-{
-    Mouth,
-    Week,
-    Day,
-    HalfDay,
-    Hour
-};
-
 class Flusher : public Noncopyable
 {
 public:
@@ -116,7 +113,7 @@ protected:
 #else
 {
 public:
-    FileFlusher(const char* filename) : file_{} {
+    FileFlusher(const char* filename) : file_{}, filename_{filename, {}, {}} {
         createDir(filename);
         file_ = WritableFile(filename);
     }
@@ -260,11 +257,13 @@ public:
             while (!stop_) {
                 {
                     std::unique_lock<Mutex> locker{mutex_};
-                    condition_var_.wait(locker);
+                    condition_var_.wait(locker, [this]() { return stop_ || !log_pool_.empty(); });
                 }
 
                 doFlush();
             }
+            // 析构之前写入, 但是后台线程还没有取走的日志.
+            doFlush();
         });
     }
 
@@ -303,7 +302,9 @@ public:
         initThread();
     }
 
-    AsyncFileLogFlusher(const String& pattern) : FileFlusher{pattern} {}
+    AsyncFileLogFlusher(const String& pattern) : FileFlusher{pattern} {
+        initThread();
+    }
 
 
     void flush(StringPiece str) override {
@@ -360,15 +361,182 @@ private:
             while (!stop_) {
                 {
                     std::unique_lock<Mutex> locker{mutex_};
-                    condition_var_.wait(locker);
+                    condition_var_.wait(locker, [this]() { return stop_ || !log_pool_.empty(); });
                 }
 
                 doFlush();
             }
+            // 析构之前写入, 但是后台线程还没有取走的日志.
+            doFlush();
         });
     }
 };
 
+/**
+ * @brief RingFileFlusher的日志环满时的处理方式.
+ */
+enum class RingOverflowPolicy
+{
+    Block,  // 等待后台线程写出, 不丢失日志.
+    Drop,   // 丢弃当前日志, 只计入getDropped.
+    Count,  // 丢弃当前日志, 后台线程在文件中写入一行丢弃的条数.
+};
+
+/**
+ * \brief 异步输出至指定文件, 每个生产者线程写入自己的无锁SPSC环(LogRing),
+ * 一个后台线程批量取出所有环中的日志写入文件, 生产者之间以及生产者与文件IO之间都没有锁竞争.
+ * 同一个线程的日志保持顺序, 不同线程之间的日志按照取出的批次交错.
+ */
+class RingFileFlusher
+    : public FileFlusher
+    , public AsyncFlusher
+{
+public:
+    static constexpr size_t kDefaultRingSize = 1024 * 1024;
+
+    RingFileFlusher(const char* filename,
+                    size_t ring_size                   = kDefaultRingSize,
+                    RingOverflowPolicy policy          = RingOverflowPolicy::Block,
+                    const LogRotationOptions& rotation = {});
+
+    RingFileFlusher(const String& pattern,
+                    size_t ring_size                   = kDefaultRingSize,
+                    RingOverflowPolicy policy          = RingOverflowPolicy::Block,
+                    const LogRotationOptions& rotation = {});
+
+    /**
+     * @brief 等待后台线程写出所有环中剩余的日志.
+     */
+    ~RingFileFlusher() override;
+
+    void flush(StringPiece str) override;
+
+    /**
+     * @brief 环中尚未写出的字节数.
+     */
+    size_t size() override;
+
+    /**
+     * @brief 因为环满(或者单条日志超过环的容量)被丢弃的日志条数.
+     */
+    LON_NODISCARD
+    size_t getDropped() const noexcept {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    struct Producer;
+
+private:
+    void doFlush() override;
+
+    Producer* localProducer();
+
+    void writerLoop();
+
+    /**
+     * @brief 取出所有环中的日志写入文件.
+     * @return 写入的字节数.
+     */
+    size_t drain(std::vector<std::shared_ptr<Producer>>& producers);
+
+    const uint64_t id_;
+    const size_t ring_size_;
+    const RingOverflowPolicy policy_;
+    // 只在后台线程中使用.
+    LogRotator rotator_;
+    std::atomic<bool> writer_sleeping_{false};
+    std::atomic<size_t> dropped_{0};
+    std::atomic<size_t> producers_version_{0};
+    // 由mutex_保护, 后台线程在版本变化时拷贝一份.
+    std::vector<std::shared_ptr<Producer>> producers_;
+};
+
+struct DoubleBufferFlusherOptions
+{
+    // 单个缓冲的大小, 写满时立即通知后台线程.
+    size_t buffer_size = 4 * 1024 * 1024;
+    // 没有写满的缓冲最多等待多久被写出.
+    size_t flush_interval_ms = 1000;
+    // 每次写出以后fdatasync, 保证日志落盘.
+    bool fdatasync = false;
+    // 后台线程来不及写出时最多积压的缓冲数(至少为2), 超过的部分被丢弃.
+    size_t max_pending_buffers = 25;
+    // 日志文件的切换, 在后台线程中进行.
+    LogRotationOptions rotation{};
+};
+
+/**
+ * \brief 异步输出至指定文件, 双缓冲(同muduo的AsyncLogging):
+ * 生产者在锁内把日志追加到预先分配的当前缓冲, 写满以后与备用缓冲交换;
+ * 后台线程每flush_interval_ms或者有缓冲写满时, 在短暂的锁内取走所有写满的缓冲以及当前缓冲,
+ * 换上自己预先分配的两块空缓冲, 然后在锁外写文件. 生产者不会等待文件IO.
+ */
+class DoubleBufferFileFlusher
+    : public FileFlusher
+    , public AsyncFlusher
+{
+public:
+    using Options = DoubleBufferFlusherOptions;
+
+    DoubleBufferFileFlusher(const char* filename, Options options = {});
+
+    DoubleBufferFileFlusher(const String& pattern, Options options = {});
+
+    /**
+     * @brief 写出所有缓冲中剩余的日志.
+     */
+    ~DoubleBufferFileFlusher() override;
+
+    void flush(StringPiece str) override;
+
+    /**
+     * @brief 等待写出的缓冲数(包括当前缓冲).
+     */
+    size_t size() override;
+
+    /**
+     * @brief 因为积压超过max_pending_buffers被丢弃的缓冲数.
+     */
+    LON_NODISCARD
+    size_t getDroppedBuffers() const noexcept {
+        return dropped_buffers_.load(std::memory_order_relaxed);
+    }
+
+    struct Buffer
+    {
+        std::unique_ptr<char[]> data;
+        size_t size     = 0;
+        size_t capacity = 0;
+
+        explicit Buffer(size_t _capacity)
+            : data{new char[_capacity]}, capacity{_capacity} {}
+
+        size_t available() const noexcept { return capacity - size; }
+
+        void append(StringPiece str) noexcept {
+            memcpy(data.get() + size, str.data(), str.size());
+            size += str.size();
+        }
+    };
+    using BufferPtr = std::unique_ptr<Buffer>;
+
+private:
+    void doFlush() override;
+
+    void initThread();
+
+    const Options options_;
+    // 由mutex_保护.
+    BufferPtr current_;
+    BufferPtr next_;
+    std::vector<BufferPtr> buffers_;
+    // 只在后台线程中使用, 预先分配的空缓冲以及写出以后可以复用的缓冲.
+    BufferPtr writer_buffer1_;
+    BufferPtr writer_buffer2_;
+    LogRotator rotator_;
+    std::atomic<size_t> dropped_buffers_{0};
+};
+
 struct StringFlusher
     : public DirectFlusher
     , public Flusher
@@ -401,6 +569,8 @@ public:
         LON_XX(SimpleFileFlusher)
         LON_XX(ProtectedFileFlusher)
         LON_XX(AsyncFileLogFlusher)
+        LON_XX(RingFileFlusher)
+        LON_XX(DoubleBufferFileFlusher)
 #undef LON_XX
 #define LON_XX(name)                                                       \
     rigisterFlushMaker(#name, []([[maybe_unused]] const String& pattern) { \
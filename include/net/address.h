@@ -4,7 +4,12 @@
 #include "../base/lstring.h"
 #include "../base/macro.h"
 
+#include <algorithm>
+#include <cstring>
+#include <functional>
 #include <iosfwd>
+#include <memory>
+#include <vector>
 #include <netinet/in.h>
 #include <sys/un.h>
 
@@ -44,6 +49,11 @@ public:
     LON_NODISCARD
     virtual String toString() const = 0;
 
+    /**
+     * @brief 在getAddrMutable被写入以后(比如recvfrom)更新变长地址的长度, 定长地址忽略.
+    */
+    virtual void setAddrLen(socklen_t len) noexcept { (void)len; }
+
     bool operator<(const SockAddress& rhs) const;
     bool operator==(const SockAddress& rhs) const;
     bool operator!=(const SockAddress& rhs) const;
@@ -64,6 +74,12 @@ public:
 
     static IPAddressUniquePtr create(StringArg host_and_port);
 
+    /**
+     * @brief 解析host对应的所有地址, 顺序同getaddrinfo(已按照RFC 6724排序).
+     * @throw invalid_argument 如果解析失败.
+    */
+    static std::vector<IPAddressUniquePtr> createAll(StringArg host, uint16_t port);
+
     virtual String getAddressStr() const = 0;
 
     virtual void setPort(uint16_t port) = 0;
@@ -199,20 +215,153 @@ private:
 class UnixAddress : public SockAddress
 {
 public:
+    /**
+     * @brief 未初始化的地址, 长度为sizeof(sockaddr_un), 用于接收accept/recvfrom的对端地址.
+    */
     UnixAddress() noexcept;
 
+    /**
+     * @brief 构造unix socket地址.
+     * @param path 文件系统路径; 以'@'开头时表示linux的抽象命名空间, '@'之后为名字(不以'\0'结尾, 不在文件系统中创建文件).
+     * @throw invalid_argument 如果path为空或者超过sun_path的长度.
+    */
+    explicit UnixAddress(StringPiece path);
+
+    /**
+     * @brief 直接以原生sockaddr初始化地址.
+     * @param len 地址的实际长度, 同accept/getsockname返回的长度.
+    */
+    UnixAddress(const sockaddr_un& src, socklen_t len) noexcept;
+
     const sockaddr* getAddr() const noexcept override;
     sockaddr* getAddrMutable() override;
+
+    /**
+     * @brief 路径地址返回路径, 抽象地址返回"@name", 未命名或者未初始化的地址(比如connect的一端)返回"unnamed".
+    */
     String toString() const override;
 
+    void setAddrLen(socklen_t len) noexcept override { len_ = len; }
+
+    LON_NODISCARD
+    bool isAbstract() const noexcept;
+
+    /**
+     * @brief 文件系统路径, 抽象地址或者未命名的地址返回空.
+    */
+    LON_NODISCARD
+    StringPiece getPath() const noexcept;
 
     socklen_t getAddrLen() const noexcept override;
 private:
     
     sockaddr_un addr_;
+    socklen_t len_;
 };
 
-}
+/**
+ * @brief 以sockaddr_storage保存的地址值类型, 可以存放任意地址族(ipv4/ipv6/unix), 拷贝不分配堆内存.
+ * 用于accept/connect/udp收发路径上传递地址, 类为final, 以InetAddress调用时没有虚函数调用.
+ * 可以作为std::map(operator<)以及std::unordered_map(std::hash)的key.
+*/
+class InetAddress final : public SockAddress
+{
+public:
+    /**
+     * @brief 未初始化的地址, 地址族为AF_UNSPEC, 长度为sizeof(sockaddr_storage), 用于接收accept/recvfrom的对端地址.
+    */
+    InetAddress() noexcept;
+
+    /**
+     * @brief 拷贝原生sockaddr, 超过sockaddr_storage的部分被截断.
+    */
+    InetAddress(const sockaddr* addr, socklen_t len) noexcept;
+
+    /**
+     * @brief 拷贝任意SockAddress.
+    */
+    explicit InetAddress(const SockAddress& other) noexcept
+        : InetAddress(other.getAddr(), other.getAddrLen()) {
+    }
+
+    /**
+     * @brief 构造ipv4或者ipv6地址.
+     * @param host 数字形式的地址, 不做域名解析.
+     * @throw invalid_argument 如果host既不是ipv4也不是ipv6地址.
+    */
+    InetAddress(StringArg host, uint16_t port);
+
+    /**
+     * @brief 构造ipv4或者ipv6地址.
+     * @param host_and_port "host:port"或者"[ipv6]:port".
+     * @throw invalid_argument 同上, 以及port不合法.
+    */
+    explicit InetAddress(StringArg host_and_port);
+
+    const sockaddr* getAddr() const noexcept override {
+        return reinterpret_cast<const sockaddr*>(&storage_);
+    }
+    sockaddr* getAddrMutable() noexcept override {
+        return reinterpret_cast<sockaddr*>(&storage_);
+    }
+    socklen_t getAddrLen() const noexcept override { return len_; }
+    void setAddrLen(socklen_t len) noexcept override {
+        len_ = std::min<socklen_t>(len, sizeof(sockaddr_storage));
+    }
+
+    LON_NODISCARD
+    sa_family_t getFamily() const noexcept { return storage_.ss_family; }
+
+    LON_NODISCARD
+    bool isInetFamily() const noexcept {
+        return storage_.ss_family == AF_INET || storage_.ss_family == AF_INET6;
+    }
+
+    /**
+     * @brief 同对应地址族的IPV4Address/IPV6Address/UnixAddress::toString.
+    */
+    String toString() const override;
+
+    /**
+     * @brief 不带端口的地址, 只对ipv4/ipv6有效, 其它地址族返回空.
+    */
+    LON_NODISCARD
+    String getAddressStr() const;
 
+    /**
+     * @brief 只对ipv4/ipv6有效, 其它地址族返回0/忽略.
+    */
+    LON_NODISCARD
+    uint16_t getPort() const noexcept;
+    void setPort(uint16_t port) noexcept;
+
+    LON_NODISCARD
+    size_t hash() const noexcept;
+
+    using SockAddress::operator<;
+    using SockAddress::operator==;
+    using SockAddress::operator!=;
+
+    bool operator<(const InetAddress& rhs) const noexcept;
+    bool operator==(const InetAddress& rhs) const noexcept {
+        return len_ == rhs.len_ && memcmp(&storage_, &rhs.storage_, len_) == 0;
+    }
+    bool operator!=(const InetAddress& rhs) const noexcept { return !(*this == rhs); }
+private:
+    sockaddr_storage storage_;
+    socklen_t len_;
+};
 
 std::ostream& operator<<(std::ostream& os, lon::net::SockAddress const& address);
+
+}
+
+namespace std {
+template<>
+struct hash<lon::net::InetAddress>
+{
+    size_t operator()(const lon::net::InetAddress& address) const noexcept {
+        return address.hash();
+    }
+};
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../../base/io_buffer.h"
+
+namespace lon::net {
+
+/**
+ * @brief 增量的chunked body解码器, 请求和响应共用. 解码后的数据与读缓冲共享block, 不拷贝.
+ */
+class HttpChunkedDecoder
+{
+public:
+    enum class Result
+    {
+        Complete,  // 最后一个chunk和trailer已经读完, 已经从读缓冲中移除.
+        NeedMore,  // 数据不足.
+        Error      // 格式错误或者超过限制, 错误码见errorStatus.
+    };
+
+    // chunk-size行的长度上限.
+    static constexpr size_t kMaxChunkLineLength = 1024;
+
+    /**
+     * @param max_body_bytes 解码后body的长度上限, 超过时返回413.
+     * @param max_trailer_bytes trailer的长度上限, 超过时返回431.
+     */
+    HttpChunkedDecoder(size_t max_body_bytes, size_t max_trailer_bytes) noexcept
+        : max_body_bytes_{max_body_bytes},
+          max_trailer_bytes_{max_trailer_bytes} {}
+
+    /**
+     * @brief 从buffer的头部解码, 数据追加到body.
+     */
+    Result decode(IOBuffer& buffer, IOBuffer& body);
+
+    /**
+     * @brief 出错时对应的状态码: 400, 413或者431.
+     */
+    LON_NODISCARD
+    int errorStatus() const noexcept { return error_status_; }
+
+    void reset() noexcept;
+
+private:
+    enum class State
+    {
+        ChunkSize,
+        ChunkData,
+        ChunkDataEnd,
+        Trailer
+    };
+
+    Result fail(int status) noexcept;
+
+    size_t max_body_bytes_;
+    size_t max_trailer_bytes_;
+    State state_ = State::ChunkSize;
+    // 当前chunk剩余的长度.
+    size_t remaining_   = 0;
+    size_t trailer_len_ = 0;
+    int error_status_   = 0;
+};
+
+}  // namespace lon::net
@@ -0,0 +1,252 @@
+#pragma once
+
+#include "../../base/nocopyable.h"
+#include "../tcp/connection_pool.h"
+#include "http_request.h"
+
+#include <utility>
+#include <vector>
+
+namespace lon::net {
+
+/**
+ * @brief 发出的http请求. Host由HttpClient根据目的地址生成(已经有Host时不生成),
+ * body不为空或者方法为POST/PUT/PATCH时生成Content-Length, 不要在headers中重复设置.
+ */
+struct HttpClientRequest
+{
+    HttpMethod method = HttpMethod::Get;
+    String target     = "/";
+    std::vector<std::pair<String, String>> headers;
+    IOBuffer body;
+
+    HttpClientRequest() = default;
+
+    HttpClientRequest(HttpMethod _method, String _target)
+        : method{_method},
+          target{std::move(_target)} {}
+
+    HttpClientRequest& addHeader(String name, String value) {
+        headers.emplace_back(std::move(name), std::move(value));
+        return *this;
+    }
+};
+
+/**
+ * @brief 收到的http响应, 状态行和header都是指向响应头数据的StringPiece, 不拷贝, reset之前一直有效.
+ * 可以移动(在开始解析之前, 比如vector扩容), 不可以拷贝.
+ */
+class HttpClientResponse
+{
+public:
+    using Header = std::pair<StringPiece, StringPiece>;
+
+    HttpClientResponse() = default;
+
+    HttpClientResponse(HttpClientResponse&&) noexcept                    = default;
+    auto operator=(HttpClientResponse&&) noexcept -> HttpClientResponse& = default;
+
+    LON_NODISCARD
+    int status() const noexcept { return status_; }
+
+    LON_NODISCARD
+    StringPiece reason() const noexcept { return reason_; }
+
+    LON_NODISCARD
+    int versionMinor() const noexcept { return version_minor_; }
+
+    LON_NODISCARD
+    const std::vector<Header>& headers() const noexcept { return headers_; }
+
+    /**
+     * @brief 第一个名字为name(大小写无关)的header的值, 不存在时返回空.
+     */
+    LON_NODISCARD
+    StringPiece header(StringPiece name) const noexcept;
+
+    LON_NODISCARD
+    bool hasHeader(StringPiece name) const noexcept;
+
+    /**
+     * @brief 响应body, chunked编码已经解码(不处理Content-Encoding), 与读缓冲共享block.
+     */
+    LON_NODISCARD
+    IOBuffer& body() noexcept { return body_; }
+
+    LON_NODISCARD
+    const IOBuffer& body() const noexcept { return body_; }
+
+    /**
+     * @brief 响应之后连接是否可以继续使用.
+     */
+    LON_NODISCARD
+    bool keepAlive() const noexcept { return keep_alive_; }
+
+    LON_NODISCARD
+    bool chunked() const noexcept { return chunked_; }
+
+    void reset() noexcept;
+
+private:
+    friend class HttpResponseParser;
+
+    int status_ = 0;
+    StringPiece reason_;
+    int version_minor_ = 1;
+    std::vector<Header> headers_;
+    IOBuffer body_;
+    bool keep_alive_         = true;
+    bool chunked_            = false;
+    bool has_content_length_ = false;
+    size_t content_length_   = 0;
+    IOBuffer raw_header_;
+    String gathered_header_;
+};
+
+/**
+ * @brief 增量的HTTP/1.x响应解析器, 与HttpRequestParser对应. 跳过100 Continue等中间响应.
+ * 既没有Content-Length也不是chunked的响应以连接关闭作为结尾, 对端关闭时调用finish.
+ */
+class HttpResponseParser
+{
+public:
+    enum class Result
+    {
+        Complete,  // 解析出一个完整的响应, 已经从读缓冲中移除.
+        NeedMore,  // 数据不足.
+        Error      // 响应不合法或者超过限制, 错误见error.
+    };
+
+    HttpResponseParser(size_t max_header_bytes, size_t max_body_bytes) noexcept
+        : max_header_bytes_{max_header_bytes},
+          max_body_bytes_{max_body_bytes},
+          chunked_{max_body_bytes, max_header_bytes} {}
+
+    /**
+     * @param head_request 对应的请求是否为HEAD, HEAD的响应没有body.
+     */
+    Result parse(IOBuffer& buffer, HttpClientResponse& response, bool head_request);
+
+    /**
+     * @brief 对端关闭时调用, 以连接关闭作为结尾的响应此时完整, 其它情况下返回Error(ECONNRESET).
+     */
+    Result finish(IOBuffer& buffer, HttpClientResponse& response);
+
+    /**
+     * @brief 出错时的errno: EPROTO(格式错误), EMSGSIZE(超过限制)或者ECONNRESET.
+     */
+    LON_NODISCARD
+    int error() const noexcept { return error_; }
+
+    /**
+     * @brief 没有正在解析的响应.
+     */
+    LON_NODISCARD
+    bool idle() const noexcept { return state_ == State::Header && scanned_ == 0; }
+
+    void reset() noexcept;
+
+private:
+    enum class State
+    {
+        Header,
+        Body,
+        Chunked,
+        UntilClose
+    };
+
+    Result parseHeader(IOBuffer& buffer, HttpClientResponse& response);
+
+    /**
+     * @brief 解析状态行和header, 成功返回0, 否则返回errno.
+     */
+    int parseHeaderSection(StringPiece section, HttpClientResponse& response) const;
+
+    Result complete() noexcept;
+    Result fail(int error) noexcept;
+
+    size_t max_header_bytes_;
+    size_t max_body_bytes_;
+    State state_      = State::Header;
+    size_t scanned_   = 0;
+    size_t remaining_ = 0;
+    HttpChunkedDecoder chunked_;
+    int error_ = 0;
+};
+
+/**
+ * @brief http client的限制和超时, 单位为字节和毫秒.
+ */
+struct HttpClientOptions
+{
+    size_t max_header_bytes = 64 * 1024;
+    size_t max_body_bytes   = 64 * 1024 * 1024;
+    size_t timeout_ms       = 30 * 1000;  // 一次调用(获取连接, 发送请求, 读完全部响应)的时限.
+
+    /**
+     * @brief 从主配置文件(conf/main.json)的prefix节读取, 不存在的项使用默认值, 比如:
+     *  "http_client": {"timeout_ms": 5000}
+     */
+    static HttpClientOptions fromConfig(const String& prefix = "http_client");
+};
+
+/**
+ * @brief 协程HTTP/1.1 client, 连接来自按目的地址复用的TcpConnectionPool, 响应读完并且可以keep-alive时归还连接.
+ * 与连接池一样非线程安全, 需要在开启hook的IOManager线程中使用, 每个线程使用各自的实例.
+ */
+class HttpClient : Noncopyable
+{
+public:
+    explicit HttpClient(HttpClientOptions options = HttpClientOptions::fromConfig(),
+                        TcpConnectionPool::Ptr pool = std::make_shared<TcpConnectionPool>());
+
+    /**
+     * @brief 发送一个请求并读取完整的响应.
+     * 复用的空闲连接在收到任何响应数据之前失败时(对端已经关闭了keep-alive连接), 幂等的请求换新连接重试一次.
+     * @return 成功返回0, 失败返回-1, errno为失败原因(超时为ETIMEDOUT, 响应不合法为EPROTO).
+     */
+    int request(StringArg host, uint16_t port, const HttpClientRequest& request, HttpClientResponse& response);
+
+    int get(StringArg host, uint16_t port, StringPiece target, HttpClientResponse& response);
+
+    /**
+     * @brief pipelining: 在同一个连接上一次发出全部请求, 再依次读取响应, responses会被resize为requests的大小.
+     * @return 按顺序完整读取的响应数, 小于requests.size()时errno为失败原因, 之后的响应无效.
+     */
+    size_t pipeline(StringArg host,
+                    uint16_t port,
+                    const std::vector<HttpClientRequest>& requests,
+                    std::vector<HttpClientResponse>& responses);
+
+    LON_NODISCARD
+    TcpConnectionPool& getPool() noexcept { return *pool_; }
+
+    LON_NODISCARD
+    const HttpClientOptions& getOptions() const noexcept { return options_; }
+
+private:
+    size_t exchange(StringArg host,
+                    uint16_t port,
+                    const HttpClientRequest* requests,
+                    HttpClientResponse* responses,
+                    size_t count);
+
+    /**
+     * @brief 在一个连接上完成一次请求/响应交换.
+     * @param received 返回是否收到了任何响应数据.
+     * @return 完整读取的响应数.
+     */
+    size_t roundTrip(TcpConnectionPool::Handle& handle,
+                     StringArg host,
+                     uint16_t port,
+                     const HttpClientRequest* requests,
+                     HttpClientResponse* responses,
+                     size_t count,
+                     size_t deadline_ms,
+                     bool* received);
+
+    HttpClientOptions options_;
+    TcpConnectionPool::Ptr pool_;
+};
+
+}  // namespace lon::net
@@ -0,0 +1,233 @@
+#pragma once
+
+#include "http_chunked.h"
+
+#include <utility>
+#include <vector>
+
+namespace lon::net {
+
+enum class HttpMethod : uint8_t
+{
+    Get,
+    Head,
+    Post,
+    Put,
+    Delete,
+    Options,
+    Patch,
+    Connect,
+    Trace,
+    Unknown
+};
+
+constexpr size_t kHttpMethodCount = static_cast<size_t>(HttpMethod::Unknown);
+
+LON_NODISCARD
+StringPiece toString(HttpMethod method) noexcept;
+
+LON_NODISCARD
+HttpMethod parseHttpMethod(StringPiece method) noexcept;
+
+/**
+ * @brief ascii大小写无关的比较, 用于header名字以及Connection等token.
+ */
+LON_NODISCARD
+bool equalsIgnoreCase(StringPiece lhs, StringPiece rhs) noexcept;
+
+/**
+ * @brief 去掉两端的空格和tab(OWS).
+ */
+LON_NODISCARD
+StringPiece trimHttpSpace(StringPiece value) noexcept;
+
+/**
+ * @brief 逗号分隔的token列表中是否有token(大小写无关), 比如Connection: keep-alive, Upgrade.
+ */
+LON_NODISCARD
+bool hasHttpToken(StringPiece list, StringPiece token) noexcept;
+
+/**
+ * @brief 解析Content-Length的值, 只允许十进制数字(不超过18位).
+ * @return 不合法时返回false.
+ */
+bool parseContentLength(StringPiece value, size_t* length) noexcept;
+
+/**
+ * @brief 解析出的http请求, 请求行和header都是指向请求头数据的StringPiece, 不拷贝.
+ * 请求头数据(与读缓冲共享block)以及body由请求持有, 所以这些StringPiece在reset之前一直有效.
+ */
+class HttpRequest
+{
+public:
+    using Header = std::pair<StringPiece, StringPiece>;
+
+    HttpRequest() = default;
+
+    HttpRequest(const HttpRequest&)                    = delete;
+    auto operator=(const HttpRequest&) -> HttpRequest& = delete;
+
+    LON_NODISCARD
+    HttpMethod method() const noexcept { return method_; }
+
+    LON_NODISCARD
+    StringPiece methodName() const noexcept { return method_name_; }
+
+    /**
+     * @brief 请求行中的原始target, 包括query.
+     */
+    LON_NODISCARD
+    StringPiece target() const noexcept { return target_; }
+
+    /**
+     * @brief target中'?'之前的部分, 没有做百分号解码.
+     */
+    LON_NODISCARD
+    StringPiece path() const noexcept { return path_; }
+
+    LON_NODISCARD
+    StringPiece query() const noexcept { return query_; }
+
+    /**
+     * @brief HTTP/1.x中的x.
+     */
+    LON_NODISCARD
+    int versionMinor() const noexcept { return version_minor_; }
+
+    LON_NODISCARD
+    const std::vector<Header>& headers() const noexcept { return headers_; }
+
+    /**
+     * @brief 第一个名字为name(大小写无关)的header的值, 不存在时返回空.
+     */
+    LON_NODISCARD
+    StringPiece header(StringPiece name) const noexcept;
+
+    LON_NODISCARD
+    bool hasHeader(StringPiece name) const noexcept;
+
+    /**
+     * @brief 请求body, chunked编码的body已经解码, 与读缓冲共享block.
+     */
+    LON_NODISCARD
+    IOBuffer& body() noexcept { return body_; }
+
+    LON_NODISCARD
+    const IOBuffer& body() const noexcept { return body_; }
+
+    /**
+     * @brief HTTP/1.1默认keep-alive(除非Connection: close), HTTP/1.0需要显式的Connection: keep-alive.
+     */
+    LON_NODISCARD
+    bool keepAlive() const noexcept { return keep_alive_; }
+
+    LON_NODISCARD
+    bool chunked() const noexcept { return chunked_; }
+
+    /**
+     * @brief 路由匹配出的参数(see @HttpRouter::add), 不存在时返回空.
+     */
+    LON_NODISCARD
+    StringPiece param(StringPiece name) const noexcept;
+
+    LON_NODISCARD
+    const std::vector<Header>& params() const noexcept { return params_; }
+
+    /**
+     * @brief 释放持有的请求头数据和body, 保留vector的容量供下一个请求使用.
+     */
+    void reset() noexcept;
+
+private:
+    friend class HttpRequestParser;
+    friend class HttpRouter;
+
+    HttpMethod method_ = HttpMethod::Unknown;
+    StringPiece method_name_;
+    StringPiece target_;
+    StringPiece path_;
+    StringPiece query_;
+    int version_minor_ = 1;
+    std::vector<Header> headers_;
+    std::vector<Header> params_;
+    IOBuffer body_;
+    bool keep_alive_       = true;
+    bool chunked_          = false;
+    size_t content_length_ = 0;
+    // 请求头数据, 只在一个block中时与读缓冲共享, 跨越block时拷贝到gathered_header_.
+    IOBuffer raw_header_;
+    String gathered_header_;
+};
+
+/**
+ * @brief 增量的HTTP/1.x请求解析器, 每次从读缓冲的头部解析一个请求, 数据不足时保存进度, 下次继续.
+ * 同一个读缓冲中可以有多个请求(pipelining), 一次parse只取出一个.
+ */
+class HttpRequestParser
+{
+public:
+    enum class Result
+    {
+        Complete,  // 解析出一个完整的请求, 已经从读缓冲中移除.
+        NeedMore,  // 数据不足.
+        Error      // 请求不合法或者超过限制, 错误码见errorStatus, 连接应当被关闭.
+    };
+
+    HttpRequestParser(size_t max_header_bytes, size_t max_body_bytes) noexcept
+        : max_header_bytes_{max_header_bytes},
+          max_body_bytes_{max_body_bytes},
+          chunked_{max_body_bytes, max_header_bytes} {}
+
+    Result parse(IOBuffer& buffer, HttpRequest& request);
+
+    /**
+     * @brief 解析出错时对应的响应状态码: 400, 413, 431, 501或者505.
+     */
+    LON_NODISCARD
+    int errorStatus() const noexcept { return error_status_; }
+
+    /**
+     * @brief 请求头已经解析完成, 正在等待body.
+     */
+    LON_NODISCARD
+    bool awaitingBody() const noexcept { return state_ != State::Header; }
+
+    /**
+     * @brief 没有正在解析的请求.
+     */
+    LON_NODISCARD
+    bool idle() const noexcept { return state_ == State::Header && scanned_ == 0; }
+
+    void reset() noexcept;
+
+private:
+    enum class State
+    {
+        Header,
+        Body,
+        Chunked
+    };
+
+    Result parseHeader(IOBuffer& buffer, HttpRequest& request);
+
+    /**
+     * @brief 解析请求行和header, 成功返回0, 否则返回错误状态码.
+     */
+    int parseHeaderSection(StringPiece section, HttpRequest& request) const;
+
+    Result complete() noexcept;
+    Result fail(int status) noexcept;
+
+    size_t max_header_bytes_;
+    size_t max_body_bytes_;
+    State state_ = State::Header;
+    // 上一次已经查找过的长度, 数据不足时下次从这里继续查找.
+    size_t scanned_ = 0;
+    // body剩余的长度.
+    size_t remaining_ = 0;
+    // trailer与请求头使用同一个长度限制.
+    HttpChunkedDecoder chunked_;
+    int error_status_ = 0;
+};
+
+}  // namespace lon::net
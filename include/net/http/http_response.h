@@ -0,0 +1,106 @@
+#pragma once
+
+#include "../../base/io_buffer.h"
+#include "../../base/nocopyable.h"
+#include "../tcp/connection.h"
+
+namespace lon::net {
+
+/**
+ * @brief 状态码对应的reason phrase, 未知状态码返回"Unknown".
+ */
+LON_NODISCARD
+StringPiece httpStatusReason(int status) noexcept;
+
+/**
+ * @brief http响应, 直接编码进连接的写队列(see @TcpConnection::write), 由server在读取下一批请求之前合并发送.
+ * 默认在finish时按照Content-Length一次写入, 也可以使用writeChunk以chunked编码分块发送.
+ */
+class HttpResponse : Noncopyable
+{
+public:
+    /**
+     * @param head_request HEAD请求只发送响应头.
+     * @param version_minor 请求的HTTP/1.x版本, HTTP/1.0不支持chunked, 分块的数据会合并发送.
+     */
+    HttpResponse(TcpConnection& connection, bool head_request, bool keep_alive, int version_minor) noexcept
+        : connection_{connection},
+          head_request_{head_request},
+          keep_alive_{keep_alive},
+          version_minor_{version_minor} {}
+
+    void setStatus(int status) noexcept { status_ = status; }
+
+    LON_NODISCARD
+    int status() const noexcept { return status_; }
+
+    /**
+     * @brief 添加一个header, 不检查重复, Content-Length, Transfer-Encoding以及Connection由响应自己生成.
+     */
+    void addHeader(StringPiece name, StringPiece value);
+
+    void setContentType(StringPiece content_type) { addHeader("Content-Type", content_type); }
+
+    void setBody(StringPiece body) {
+        body_.clear();
+        body_.append(body);
+    }
+
+    void setBody(IOBuffer&& body) {
+        body_.clear();
+        body_.append(std::move(body));
+    }
+
+    LON_NODISCARD
+    IOBuffer& body() noexcept { return body_; }
+
+    /**
+     * @brief 设置为false时发送Connection: close, 发送完这个响应以后server关闭连接.
+     */
+    void setKeepAlive(bool keep_alive) noexcept { keep_alive_ = keep_alive; }
+
+    LON_NODISCARD
+    bool keepAlive() const noexcept { return keep_alive_; }
+
+    /**
+     * @brief 以chunked编码发送一块数据, 第一次调用时先发送响应头, 之后body中的数据作为第一个chunk.
+     * @return 同TcpConnection::write.
+     */
+    int writeChunk(StringPiece data);
+
+    /**
+     * @brief 完成响应: 没有使用chunked时发送响应头和body, 否则发送最后一个chunk. 只有第一次调用生效, server在handler返回以后调用.
+     * @return 同TcpConnection::write.
+     */
+    int finish();
+
+    LON_NODISCARD
+    bool finished() const noexcept { return finished_; }
+
+    /**
+     * @brief 响应头是否已经发送(chunked).
+     */
+    LON_NODISCARD
+    bool headerSent() const noexcept { return header_sent_; }
+
+private:
+    /**
+     * @brief 把响应头写入写队列, content_length为-1时使用chunked编码.
+     */
+    void writeHeader(size_t content_length);
+
+    bool chunkedAllowed() const noexcept { return version_minor_ >= 1; }
+
+    TcpConnection& connection_;
+    bool head_request_;
+    bool keep_alive_;
+    int version_minor_;
+    int status_ = 200;
+    // 已经编码好的"name: value\r\n".
+    String headers_;
+    IOBuffer body_;
+    bool header_sent_ = false;
+    bool finished_    = false;
+};
+
+}  // namespace lon::net
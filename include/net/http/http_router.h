@@ -0,0 +1,67 @@
+#pragma once
+
+#include "http_request.h"
+#include "http_response.h"
+
+#include <functional>
+#include <memory>
+
+namespace lon::net {
+
+/**
+ * @brief 按照路径段组织的前缀树路由, 匹配时不申请内存.
+ * 路径模式由'/'分隔: 普通段精确匹配, ":name"匹配任意一个非空段, 最后一段"*name"匹配剩余的全部路径(可以为空).
+ * 同一位置普通段优先于参数段, 参数段优先于通配段, 匹配失败时回溯.
+ */
+class HttpRouter
+{
+public:
+    using Handler = std::function<void(HttpRequest& request, HttpResponse& response)>;
+
+    HttpRouter();
+    ~HttpRouter();
+
+    HttpRouter(HttpRouter&&) noexcept;
+    auto operator=(HttpRouter&&) noexcept -> HttpRouter&;
+
+    /**
+     * @brief 添加路由, 需要在开始服务之前完成, 服务期间路由只读.
+     * @return 模式不合法(不以'/'开头, 通配段不是最后一段), 同一位置参数名不同或者重复添加时返回false.
+     */
+    bool add(HttpMethod method, StringPiece pattern, Handler handler);
+
+    bool get(StringPiece pattern, Handler handler) { return add(HttpMethod::Get, pattern, std::move(handler)); }
+    bool post(StringPiece pattern, Handler handler) { return add(HttpMethod::Post, pattern, std::move(handler)); }
+    bool put(StringPiece pattern, Handler handler) { return add(HttpMethod::Put, pattern, std::move(handler)); }
+    bool del(StringPiece pattern, Handler handler) { return add(HttpMethod::Delete, pattern, std::move(handler)); }
+
+    /**
+     * @brief 没有匹配的路径时调用, 默认返回404.
+     */
+    void setNotFoundHandler(Handler handler) { not_found_ = std::move(handler); }
+
+    /**
+     * @brief 查找request的处理函数, 匹配出的参数写入request.params(). HEAD没有单独的路由时使用GET的路由.
+     * @param path_matched 不为null时返回路径是否匹配(方法可能不匹配).
+     * @return 没有匹配时返回null.
+     */
+    const Handler* match(HttpRequest& request, bool* path_matched = nullptr) const;
+
+    /**
+     * @brief 路由并调用处理函数, 没有匹配的路径时调用not found handler, 路径匹配但方法不匹配时返回405以及Allow.
+     */
+    void dispatch(HttpRequest& request, HttpResponse& response) const;
+
+private:
+    struct Node;
+
+    const Node* find(const Node* node,
+                     StringPiece remaining,
+                     bool at_end,
+                     std::vector<HttpRequest::Header>& params) const;
+
+    std::unique_ptr<Node> root_;
+    Handler not_found_;
+};
+
+}  // namespace lon::net
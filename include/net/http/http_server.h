@@ -0,0 +1,72 @@
+#pragma once
+
+#include "../../balancer/io/simple_balancer.h"
+#include "../../base/nocopyable.h"
+#include "../tcp/tcp_server.h"
+#include "http_router.h"
+
+namespace lon::net {
+
+/**
+ * @brief http server的限制和超时, 单位为字节和毫秒.
+ */
+struct HttpServerOptions
+{
+    size_t max_header_bytes            = 8 * 1024;     // 请求行加上header的长度上限, 超过时返回431.
+    size_t max_body_bytes              = 1024 * 1024;  // body(chunked时为解码后)的长度上限, 超过时返回413.
+    size_t header_timeout_ms           = 10 * 1000;    // 从收到请求的第一个字节到读完整个请求的时限, 超时返回408.
+    size_t keepalive_timeout_ms        = 60 * 1000;    // 两个请求之间的最长空闲时间, 超时直接关闭连接.
+    size_t write_timeout_ms            = 30 * 1000;    // 发送缓冲区满时等待EPOLLOUT的时限.
+    size_t max_requests_per_connection = 0;            // 一个连接最多处理的请求数, 0表示不限制.
+
+    /**
+     * @brief 从主配置文件(conf/main.json)的prefix节读取, 不存在的项使用默认值, 比如:
+     *  "http": {"max_header_bytes": 16384, "keepalive_timeout_ms": 5000}
+     */
+    static HttpServerOptions fromConfig(const String& prefix = "http");
+};
+
+/**
+ * @brief 基于TcpServer的HTTP/1.1 server, 支持keep-alive, pipelining(同一批请求的响应合并为一次发送)以及chunked.
+ */
+class HttpServer : Noncopyable
+{
+public:
+    explicit HttpServer(HttpRouter router,
+                        HttpServerOptions options = HttpServerOptions::fromConfig(),
+                        std::unique_ptr<io::IOWorkBalancer> balancer =
+                            std::make_unique<io::SimpleIOBalancer>());
+
+    LON_NODISCARD
+    TcpServer& getTcpServer() noexcept { return *server_; }
+
+    LON_NODISCARD
+    const HttpServerOptions& getOptions() const noexcept { return shared_->options; }
+
+    bool bind(SockAddress::SharedPtr local_address) { return server_->bind(std::move(local_address)); }
+
+    bool startServe() { return server_->startServe(); }
+
+    bool stopServe() { return server_->stopServe(); }
+
+    /**
+     * @brief 在当前协程中处理一个连接, 直到对端关闭, 出错, 超时或者响应不再keep-alive, 不关闭socket.
+     * 需要在开启hook的IOManager线程中调用.
+     */
+    static void serveConnection(TcpConnection& connection,
+                                const HttpRouter& router,
+                                const HttpServerOptions& options);
+
+private:
+    struct Shared
+    {
+        HttpRouter router;
+        HttpServerOptions options;
+    };
+
+    // 连接的协程可能比server活得更久.
+    std::shared_ptr<const Shared> shared_;
+    TcpServer::Ptr server_;
+};
+
+}  // namespace lon::net
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "../../base/nocopyable.h"
+#include "../tcp/connection.h"
+#include "rpc_protocol.h"
+
+#include <memory>
+
+namespace lon::net {
+
+struct RpcClientOptions
+{
+    size_t timeout_ms         = 5000;  // 默认的调用超时.
+    size_t connect_timeout_ms = 3000;
+    size_t max_frame_length   = 16 * 1024 * 1024;
+};
+
+/**
+ * @brief rpc client, 一个连接上同时进行任意多个调用, 响应按请求id匹配.
+ * 调用挂起当前协程直到收到响应, 超时或者连接断开. 同一轮调度中发起的调用在一个写协程中合并为一次发送.
+ * 非线程安全, 需要在开启hook的IOManager线程中创建和使用.
+ */
+class RpcClient : Noncopyable
+{
+public:
+    using Options = RpcClientOptions;
+
+    struct Stats
+    {
+        size_t calls   = 0;  // 发出的调用数.
+        size_t flushes = 0;  // 写协程发送的批次, calls / flushes即平均每次发送合并的调用数.
+        size_t late    = 0;  // 超时以后才到达的响应.
+    };
+
+    /**
+     * @brief 连接到host:port.
+     * @return 失败时返回nullptr, errno为失败原因.
+     */
+    static std::unique_ptr<RpcClient> connect(StringArg host, uint16_t port, Options options = {});
+
+    explicit RpcClient(std::unique_ptr<TcpConnection> connection, Options options = {});
+
+    /**
+     * @brief 关闭连接, 挂起中的调用返回Disconnected.
+     */
+    ~RpcClient();
+
+    /**
+     * @brief 调用Method, 挂起当前协程直到完成.
+     * @param timeout_ms -1表示使用Options::timeout_ms.
+     */
+    template <typename Method>
+    RpcStatus call(const typename Method::Request& request,
+                   typename Method::Response& response,
+                   size_t timeout_ms = static_cast<size_t>(-1)) {
+        IOBuffer request_body;
+        RpcSerializer<typename Method::Request>::encode(request, request_body);
+        IOBuffer response_body;
+        const RpcStatus status = callRaw(Method::kId, std::move(request_body), response_body, timeout_ms);
+        if (status != RpcStatus::Ok)
+            return status;
+        return RpcSerializer<typename Method::Response>::decode(response_body, response) ? RpcStatus::Ok
+                                                                                        : RpcStatus::BadResponse;
+    }
+
+    /**
+     * @brief 以序列化后的body调用, see above.
+     */
+    RpcStatus callRaw(uint32_t method_id, IOBuffer&& request, IOBuffer& response, size_t timeout_ms);
+
+    /**
+     * @brief 关闭连接, 挂起中的调用返回Disconnected, 可以重复调用.
+     */
+    void close();
+
+    LON_NODISCARD
+    bool connected() const noexcept;
+
+    /**
+     * @brief 等待响应中的调用数.
+     */
+    LON_NODISCARD
+    size_t pendingCalls() const noexcept;
+
+    LON_NODISCARD
+    const Stats& getStats() const noexcept;
+
+private:
+    struct Channel;
+
+    std::shared_ptr<Channel> channel_;
+};
+
+}  // namespace lon::net
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "../../base/io_buffer.h"
+
+#include <cstring>
+#include <type_traits>
+
+namespace lon::net {
+
+/**
+ * @brief 调用结果, Ok到HandlerError由服务端返回, 其余为客户端本地的结果.
+ */
+enum class RpcStatus : uint8_t
+{
+    Ok,
+    NoMethod,          // 服务端没有注册该方法.
+    BadRequest,        // 请求无法反序列化.
+    HandlerError,      // 处理函数返回的错误.
+    BadResponse,       // 响应无法反序列化.
+    DeadlineExceeded,  // 超时之前没有收到响应.
+    Disconnected       // 连接已经关闭或者在等待响应时断开.
+};
+
+LON_NODISCARD
+StringPiece toString(RpcStatus status) noexcept;
+
+/**
+ * @brief 可以出现在响应帧中的状态, HandlerError之后的状态只由客户端本地产生.
+ */
+constexpr bool isWireStatus(RpcStatus status) noexcept {
+    return static_cast<uint8_t>(status) <= static_cast<uint8_t>(RpcStatus::HandlerError);
+}
+
+/**
+ * @brief 编译期由方法名计算的方法id(32位FNV-1a), 调用时只传递id, 不查找字符串.
+ */
+constexpr uint32_t rpcMethodId(const char* name) noexcept {
+    uint32_t hash = 2166136261u;
+    for (; *name; ++name) {
+        hash = (hash ^ static_cast<uint8_t>(*name)) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief 方法的描述, 比如:
+ *  using EchoMethod = RpcMethod<rpcMethodId("bench.Echo"), String, String>;
+ * 请求和响应类型需要有RpcSerializer.
+ */
+template <uint32_t Id, typename RequestType, typename ResponseType>
+struct RpcMethod
+{
+    static constexpr uint32_t kId = Id;
+    using Request                 = RequestType;
+    using Response                = ResponseType;
+};
+
+/**
+ * @brief 帧格式: u32(大端)长度头 + 16字节的RpcHeader + 序列化后的body, 长度头不包括自身.
+ */
+struct RpcHeader
+{
+    enum class Type : uint8_t
+    {
+        Request,
+        Response
+    };
+
+    static constexpr size_t kSize        = 16;
+    static constexpr size_t kLengthField = 4;
+
+    Type type          = Type::Request;
+    RpcStatus status   = RpcStatus::Ok;
+    uint32_t method_id = 0;
+    uint64_t request_id = 0;
+
+    /**
+     * @brief 从frame(不包括长度头)的头部取出header.
+     * @return frame不足kSize或者type不合法时返回false.
+     */
+    bool decode(IOBuffer& frame) noexcept;
+};
+
+/**
+ * @brief 把header和body编码为一个完整的帧追加到out, 小的body拷贝到out的末尾, 大的body直接移动.
+ */
+void encodeRpcFrame(const RpcHeader& header, IOBuffer&& body, IOBuffer& out);
+
+/**
+ * @brief 请求/响应类型的序列化, 需要特化encode和decode:
+ *  static void encode(const T& value, IOBuffer& out);
+ *  static bool decode(IOBuffer& in, T& value);  // in为整个body, 可以直接移动走.
+ * 内置了String, IOBuffer(不拷贝)以及trivially copyable的类型(按内存布局, 只用于同构的机器之间).
+ */
+template <typename T, typename Enable = void>
+struct RpcSerializer;
+
+template <>
+struct RpcSerializer<String>
+{
+    static void encode(const String& value, IOBuffer& out) { out.append(value); }
+
+    static bool decode(IOBuffer& in, String& value) {
+        value = in.toString();
+        return true;
+    }
+};
+
+template <>
+struct RpcSerializer<IOBuffer>
+{
+    static void encode(const IOBuffer& value, IOBuffer& out) {
+        out.append(value.slice(0, value.readableBytes()));
+    }
+
+    static bool decode(IOBuffer& in, IOBuffer& value) {
+        value = std::move(in);
+        return true;
+    }
+};
+
+template <typename T>
+struct RpcSerializer<T, std::enable_if_t<std::is_trivially_copyable_v<T> && !std::is_pointer_v<T>>>
+{
+    static void encode(const T& value, IOBuffer& out) { out.append(&value, sizeof(T)); }
+
+    static bool decode(IOBuffer& in, T& value) {
+        return in.readableBytes() == sizeof(T) && in.copyTo(&value, sizeof(T)) == sizeof(T);
+    }
+};
+
+}  // namespace lon::net
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "../../balancer/io/simple_balancer.h"
+#include "../../base/nocopyable.h"
+#include "../tcp/tcp_server.h"
+#include "rpc_protocol.h"
+
+#include <functional>
+#include <tuple>
+
+namespace lon::net {
+
+/**
+ * @brief 方法与处理函数的绑定, 由rpcHandler创建.
+ * 处理函数的签名为 RpcStatus(Request& request, Response& response) 或者 void(Request&, Response&).
+ */
+template <typename Method, typename Handler>
+struct RpcBinding
+{
+    using MethodType = Method;
+    Handler handler;
+
+    RpcStatus call(IOBuffer& request_body, IOBuffer& response_body) const {
+        typename Method::Request request{};
+        if (!RpcSerializer<typename Method::Request>::decode(request_body, request))
+            return RpcStatus::BadRequest;
+        typename Method::Response response{};
+        RpcStatus status = RpcStatus::Ok;
+        if constexpr (std::is_void_v<std::invoke_result_t<const Handler&,
+                                                           typename Method::Request&,
+                                                           typename Method::Response&>>) {
+            handler(request, response);
+        } else {
+            status = handler(request, response);
+        }
+        if (status == RpcStatus::Ok)
+            RpcSerializer<typename Method::Response>::encode(response, response_body);
+        return status;
+    }
+};
+
+template <typename Method, typename Handler>
+RpcBinding<Method, Handler> rpcHandler(Handler handler) {
+    return RpcBinding<Method, Handler>{std::move(handler)};
+}
+
+/**
+ * @brief 按方法id分发请求, 返回的状态码写入响应头, 只有Ok时才有body.
+ */
+using RpcDispatcher = std::function<RpcStatus(uint32_t method_id, IOBuffer& request, IOBuffer& response)>;
+
+namespace detail {
+template <typename... Bindings>
+constexpr bool uniqueRpcIds() noexcept {
+    constexpr uint32_t ids[] = {Bindings::MethodType::kId...};
+    for (size_t i = 0; i < sizeof...(Bindings); ++i) {
+        for (size_t j = i + 1; j < sizeof...(Bindings); ++j) {
+            if (ids[i] == ids[j])
+                return false;
+        }
+    }
+    return true;
+}
+}  // namespace detail
+
+/**
+ * @brief 把一组绑定编译为分发函数: 方法id是编译期常量, 分发展开为依次比较整数后直接调用处理函数,
+ * 不需要字符串或者hash表查找. 方法id冲突(包括重复注册)在编译期报错.
+ */
+template <typename... Bindings>
+RpcDispatcher makeRpcDispatcher(Bindings... bindings) {
+    static_assert(sizeof...(Bindings) > 0, "no rpc handler");
+    static_assert(detail::uniqueRpcIds<Bindings...>(), "duplicate rpc method id");
+    return [table = std::make_tuple(std::move(bindings)...)](
+               uint32_t method_id, IOBuffer& request, IOBuffer& response) {
+        RpcStatus status = RpcStatus::NoMethod;
+        std::apply(
+            [&](const auto&... binding) {
+                (void)((std::decay_t<decltype(binding)>::MethodType::kId == method_id &&
+                        (status = binding.call(request, response), true)) ||
+                       ...);
+            },
+            table);
+        return status;
+    };
+}
+
+/**
+ * @brief 基于TcpServer的rpc server, 每个连接上的请求在连接的协程中依次处理, 同一批请求的响应合并发送.
+ * 处理函数不应长时间挂起, 否则会阻塞同一个连接上的其它请求.
+ */
+class RpcServer : Noncopyable
+{
+public:
+    static constexpr size_t kDefaultMaxFrameLength = 16 * 1024 * 1024;
+
+    explicit RpcServer(RpcDispatcher dispatcher,
+                       std::unique_ptr<io::IOWorkBalancer> balancer = std::make_unique<io::SimpleIOBalancer>(),
+                       size_t max_frame_length = kDefaultMaxFrameLength);
+
+    LON_NODISCARD
+    TcpServer& getTcpServer() noexcept { return *server_; }
+
+    bool bind(SockAddress::SharedPtr local_address) { return server_->bind(std::move(local_address)); }
+
+    bool startServe() { return server_->startServe(); }
+
+    bool stopServe() { return server_->stopServe(); }
+
+    /**
+     * @brief 在当前协程中处理一个连接直到对端关闭或者出错(帧格式错误时errno为EPROTO), 不关闭socket.
+     */
+    static void serveConnection(TcpConnection& connection,
+                                const RpcDispatcher& dispatcher,
+                                size_t max_frame_length = kDefaultMaxFrameLength);
+
+private:
+    // 连接的协程可能比server活得更久.
+    std::shared_ptr<const RpcDispatcher> dispatcher_;
+    TcpServer::Ptr server_;
+};
+
+}  // namespace lon::net
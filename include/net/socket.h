@@ -44,11 +44,26 @@ namespace lon::net {
         int bind(SockAddress::SharedPtr local_addr);
 
         /**
-         * @brief ::accept wrapper.
+         * @brief ::accept wrapper, 同样用于AF_UNIX的流式socket.
          * @return accept 成功返回TcpConnection指针, 其中包含本地地址和远端地址, 失败返回null.
         */
         LON_NODISCARD
-        std::unique_ptr<TcpConnection> accept() const; //TODO 流式的不止TCP, UnixAddress应该也有.
+        std::unique_ptr<TcpConnection> accept() const;
+
+        /**
+         * @brief ::accept4 wrapper, 非阻塞的listen socket上没有连接时返回null并且errno为EAGAIN, 用于一次取完backlog.
+         * @param flags see @::accept4.
+         * @return 同accept, 失败返回null, errno同::accept4.
+        */
+        LON_NODISCARD
+        std::unique_ptr<TcpConnection> accept4(int flags) const;
+
+        /**
+         * @brief 同accept4, 只取出连接而不创建TcpConnection, 对端地址写入peer_addr, 不分配堆内存.
+         * @return 新连接的socket, 共享listen socket的本地地址, 失败时fd为-1, errno同::accept4.
+        */
+        LON_NODISCARD
+        Socket accept4(InetAddress& peer_addr, int flags) const;
 
         /**
          * @brief ::listen wrapper
@@ -59,11 +74,30 @@ namespace lon::net {
 
         /**
          * @brief ::connect wrapper.
-         * @return connect 成功返回TcpConnection指针, 其中包含本地地址(如果未bind则为null)和远端地址, 失败返回null.
+         * @return connect 成功返回TcpConnection指针, 其中包含本地地址(如果未bind则为null)和远端地址, 失败返回null(errno同::connect).
         */
         LON_NODISCARD
         std::unique_ptr<TcpConnection> connect(SockAddress::UniquePtr peer_addr) const;
 
+        /**
+         * @brief 带超时以及取消的connect, see @sockopt::connect.
+         * @param timeout_ms 超时时间, -1表示不超时.
+         * @param canceler 可为nullptr, 只在hook开启的线程中生效.
+         * @return 同connect, 超时errno为ETIMEDOUT, 取消errno为ECANCELED.
+        */
+        LON_NODISCARD
+        std::unique_ptr<TcpConnection> connect(SockAddress::UniquePtr peer_addr,
+                                               size_t timeout_ms,
+                                               io::Canceler* canceler = nullptr) const;
+
+        /**
+         * @brief 同上, 对端地址按值保存在TcpConnection中.
+        */
+        LON_NODISCARD
+        std::unique_ptr<TcpConnection> connect(const InetAddress& peer_addr,
+                                               size_t timeout_ms = static_cast<size_t>(-1),
+                                               io::Canceler* canceler = nullptr) const;
+
         LON_NODISCARD LON_ALWAYS_INLINE
         int fd() const noexcept {return fd_;}
 
@@ -76,6 +110,20 @@ namespace lon::net {
         void setReusePort(bool on) const;
         void setKeepAlive(bool on) const;
 
+        /**
+         * @brief 通过AF_UNIX socket传递fd, see @sockopt::sendFds.
+        */
+        ssize_t sendFds(StringPiece message, const int* fds, size_t count) const {
+            return sockopt::sendFds(fd_, message, fds, count);
+        }
+
+        /**
+         * @brief 接收数据以及随数据传递的fd, see @sockopt::recvFds.
+        */
+        ssize_t recvFds(void* buffer, size_t length, std::vector<int>& fds) const {
+            return sockopt::recvFds(fd_, buffer, length, fds);
+        }
+
         void stopRead() const;
         void stopWrite() const;
         void close();
@@ -1,15 +1,42 @@
 #pragma once
 
+#include "../io/canceler.h"
 #include "address.h"
 
 #include <optional>
+#include <vector>
 
 namespace lon::sockopt {
     int connect(int sock_fd, const lon::net::SockAddress& sock_address);
 
+    /**
+     * @brief 带超时以及取消的connect, hook开启的线程中挂起当前协程(see @io::co_connectWithTimeout),
+     * 否则使用poll等待, 此时canceler不生效.
+     * @param timeout_ms 超时时间, -1表示不超时, 超时返回-1并设置errno为ETIMEDOUT.
+     * @return see @::connect
+     */
+    int connect(int sock_fd,
+                const lon::net::SockAddress& sock_address,
+                size_t timeout_ms,
+                lon::io::Canceler* canceler = nullptr);
+
     std::pair<lon::net::SockAddress::UniquePtr, int> accept(int sock_fd);
     std::pair<lon::net::SockAddress::UniquePtr, int> accept(int sock_fd, sa_family_t family);
 
+    /**
+     * @brief ::accept4 wrapper, 与accept不同, 失败时不断言, 由调用者根据errno处理(比如非阻塞socket的EAGAIN).
+     * @param flags SOCK_NONBLOCK, SOCK_CLOEXEC, see @::accept4.
+     * @return 新连接的对端地址以及fd, 失败时fd为-1.
+     */
+    std::pair<lon::net::SockAddress::UniquePtr, int> accept4(int sock_fd, sa_family_t family, int flags);
+
+    /**
+     * @brief 同上, 对端地址写入peer_addr(任意地址族), 不分配堆内存.
+     * @param peer_addr 可为nullptr.
+     * @return 新连接的fd, 失败返回-1.
+     */
+    int accept4(int sock_fd, lon::net::InetAddress* peer_addr, int flags);
+
     void shutdownWrite(int sock_fd);
     void setTcpNoDelay(int sock_fd, bool on);
     void setReuseAddr(int sock_fd, bool on);
@@ -66,4 +93,22 @@ namespace lon::sockopt {
      * @return see @::recvfrom
     */
     ssize_t recvFrom(int sock_fd, iovec* buffers, size_t length, lon::net::SockAddress* peer_addr, int flags);
+
+    // 一次最多传递的fd个数.
+    constexpr size_t kMaxPassedFds = 16;
+
+    /**
+     * @brief 通过AF_UNIX socket传递fd(SCM_RIGHTS), 接收方得到指向同一个打开文件的新fd, 发送方仍需关闭自己的fd.
+     * @param message 随fd一起发送的数据, 不能为空(流式socket上没有数据时fd不会送达).
+     * @param count 不超过kMaxPassedFds.
+     * @return see @::sendmsg, 参数不合法时返回-1并设置errno为EINVAL.
+    */
+    ssize_t sendFds(int sock_fd, StringPiece message, const int* fds, size_t count, int flags = 0);
+
+    /**
+     * @brief 接收数据以及随数据传递的fd, fd设置了close-on-exec, 在hook开启的线程中socket类型的fd已经登记(see @io::co_adoptSocket).
+     * @param fds 接收到的fd追加到末尾, 由调用者负责关闭.
+     * @return see @::recvmsg, 控制消息被截断时关闭已经收到的fd, 返回-1并设置errno为EMSGSIZE.
+    */
+    ssize_t recvFds(int sock_fd, void* buffer, size_t length, std::vector<int>& fds, int flags = 0);
 }
\ No newline at end of file
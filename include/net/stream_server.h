@@ -0,0 +1,230 @@
+﻿#pragma once
+#include "../balancer/io/simple_balancer.h"
+#include "../base/nocopyable.h"
+#include "../io/io_manager.h"
+#include "socket.h"
+#include "tcp/connection.h"
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+namespace lon::net {
+
+/**
+ * @brief 面向连接的流式server, 监听AF_INET/AF_INET6(即tcp server)或者AF_UNIX地址, 连接统一用TcpConnection表示.
+ * unix socket的路径地址在bind时删除残留的socket文件, 在stopServe或者析构时删除.
+*/
+class StreamServer
+    : public std::enable_shared_from_this<StreamServer>
+      , Noncopyable
+{
+public:
+    using OnConnectionCallbackType =
+    std::function<void(std::shared_ptr<TcpConnection> connection)>;
+
+    using SocketInitCallbackType = std::function<void(Socket& socket)>;
+
+    using Ptr = std::shared_ptr<StreamServer>;
+
+    enum class AcceptMode
+    {
+        // 调用startServe的线程accept, 连接交给均衡器调度.
+        Single,
+        // 均衡器的每个IOManager各自持有一个SO_REUSEPORT的listen socket, 由内核分配连接,
+        // 连接留在accept的线程处理, 没有跨线程的任务投递(不经过onAccept).
+        // unix socket不支持SO_REUSEPORT, 只能使用Single.
+        Sharded
+    };
+
+    /**
+     * @brief 过载保护, 达到限制时暂停accept(连接留在backlog中), 过载表现为accept变慢而不是fd耗尽或者内存失控.
+    */
+    struct AcceptLimits
+    {
+        size_t max_connections            = static_cast<size_t>(-1);  // 整个server同时存在的连接数上限.
+        size_t max_connections_per_thread = static_cast<size_t>(-1);  // 每个处理连接的IOManager同时存在的连接数上限(see @dispatchToWorker).
+        size_t max_queued_tasks           = static_cast<size_t>(-1);  // 处理连接的IOManager(们)等待执行的任务数超过该值时暂停accept.
+        bool reserve_fd                   = true;                     // 预留一个fd, EMFILE时用它accept并立即关闭连接, 避免忙等.
+    };
+
+    struct Stats
+    {
+        size_t active_connections = 0;  // 还未析构的TcpConnection数量.
+        size_t accepted           = 0;
+        size_t rejected           = 0;  // fd耗尽时accept后直接关闭的连接.
+        size_t accept_paused      = 0;  // 因为达到限制而暂停accept的次数.
+    };
+
+public:
+    StreamServer(OnConnectionCallbackType _on_connection,
+              std::unique_ptr<io::IOWorkBalancer> _balancer =
+                  std::make_unique<io::SimpleIOBalancer>());
+
+    virtual ~StreamServer();
+
+    /**
+     * @brief 设置listen socket.
+     * @param _socket_initer listen socket 初始化器.
+    */
+    auto setSocketIniter(SocketInitCallbackType _socket_initer) -> void;
+
+    /**
+     * @brief 设置accept模式, 需要在bind之前设置, Sharded模式下绑定的端口不能为0.
+    */
+    auto setAcceptMode(AcceptMode _accept_mode) -> void {
+        accept_mode_ = _accept_mode;
+    }
+
+    LON_NODISCARD
+    AcceptMode getAcceptMode() const noexcept { return accept_mode_; }
+
+    /**
+     * @brief 设置过载保护, 需要在startServe之前设置.
+    */
+    auto setAcceptLimits(AcceptLimits _accept_limits) -> void {
+        accept_limits_ = _accept_limits;
+    }
+
+    LON_NODISCARD
+    const AcceptLimits& getAcceptLimits() const noexcept { return accept_limits_; }
+
+    /**
+     * @brief 连接统计, 在不同线程中调用安全.
+     * 连接数按照TcpConnection的生命周期计算, 即on_connection收到的shared_ptr全部释放以后才算关闭.
+    */
+    LON_NODISCARD
+    Stats getStats() const noexcept;
+
+
+    /**
+     * @brief 绑定地址到server.
+     * @param local_address 需要绑定的本地地址.
+     * @return 绑定是否成功.
+    */
+    bool bind(SockAddress::SharedPtr local_address);
+
+    /**
+     * @brief 绑定地址到server.
+     * @param local_addresses 需要绑定的本地地址列表.
+     * @return 绑定成功返回nullopt, 否则返回绑定失败列表.
+    */
+    std::optional<std::vector<SockAddress::SharedPtr>> bind(
+        const std::vector<SockAddress::SharedPtr>& local_addresses);
+
+    /**
+     * @brief 添加绑定地址到server.
+     * @param local_address 需要绑定的本地地址.
+     * @return 绑定是否成功.
+    */
+    bool addBindAddr(SockAddress::SharedPtr local_address);
+
+    /**
+     * @brief 开启服务.
+     * @return 开启服务是否成功.
+    */
+    bool startServe();
+
+    /**
+     * @brief 关闭服务.
+     * @return 关闭服务是否成功.
+    */
+    bool stopServe();
+
+    LON_NODISCARD LON_ALWAYS_INLINE
+    bool serving() const noexcept {
+        return serving_;
+    }
+
+    LON_NODISCARD
+    io::IOWorkBalancer& getBalancer() const noexcept { return *balancer_; }
+
+    /**
+     * @brief accept成功时分配动作;
+     *  默认动作是交给均衡器来调度, 对于优先级调度器需要的优先级参数需要动态配置, 所以默认动作对于优先级均衡器无效.
+     *  设置了max_connections_per_thread时不经过均衡器的schedule, see @dispatchToWorker.
+    */
+    virtual void onAccept(std::shared_ptr<TcpConnection> connection) {
+        auto executor = std::make_shared<coroutine::Executor>(
+            [on_connection = this->on_connection_, connection]() {
+                on_connection(connection);
+        });
+        if (!dispatchToWorker(connection, executor))
+            balancer_->schedule(std::move(executor), 0);
+    }
+
+protected:
+    /**
+     * @brief 把处理connection的executor投递给均衡器中连接数最少的IOManager, 并计入该IOManager的连接数直到连接析构.
+     *  只在设置了max_connections_per_thread时生效, 否则返回false, 由调用者自行调度.
+     *  重写onAccept时需要通过它投递才能保持每个IOManager的连接数限制.
+     * @param connection 必须是accept循环交给onAccept的连接.
+    */
+    bool dispatchToWorker(const std::shared_ptr<TcpConnection>& connection,
+                          coroutine::Executor::Ptr executor);
+
+private:
+    bool bindOne(SockAddress::SharedPtr local_address);
+
+    /**
+     * @brief 创建非阻塞的listen socket并绑定, 失败时返回fd为-1的socket.
+    */
+    Socket createListenSocket(const SockAddress::SharedPtr& local_address) const;
+
+    /**
+     * @brief 在当前IOManager中运行accept循环: accept4取完backlog直到EAGAIN, 然后挂起等待下一次可读.
+     * @param dispatch_local true时连接在当前线程处理, 否则交给onAccept.
+    */
+    void startAcceptLoop(Socket socket, bool dispatch_local);
+
+    struct Counters;
+
+    /**
+     * @brief 均衡器中的一个IOManager以及它正在处理的连接数.
+    */
+    struct Worker
+    {
+        std::shared_ptr<io::IOManager> manager;
+        // 连接可能在server析构以后才释放, 所以由shared_ptr持有.
+        std::shared_ptr<std::atomic<size_t>> connections;
+    };
+
+    const Worker* findWorker(const io::IOManager* manager) const noexcept;
+
+    const Worker* leastLoadedWorker() const noexcept;
+
+    /**
+     * @brief 是否达到AcceptLimits的限制.
+     * @param local_worker dispatch_local时为当前线程的worker.
+    */
+    bool overloaded(const Worker* local_worker, bool dispatch_local) const;
+
+    /**
+     * @brief 创建连接, 析构时更新连接数, 连接与计数在同一次分配中.
+    */
+    std::shared_ptr<TcpConnection> trackConnection(Socket socket,
+                                                   const InetAddress& peer_addr) const;
+
+    /**
+     * @brief 在manager线程中创建分片的listen socket并开始accept.
+    */
+    void startShard(const std::shared_ptr<io::IOManager>& manager);
+
+    OnConnectionCallbackType on_connection_ = nullptr;
+    SocketInitCallbackType socket_initer_ = nullptr;
+    AcceptMode accept_mode_ = AcceptMode::Single;
+    AcceptLimits accept_limits_{};
+    // 连接可能在server析构以后才释放, 所以计数单独由shared_ptr持有.
+    std::shared_ptr<Counters> counters_;
+    // startServe时由均衡器的IOManager(们)创建, 之后不再变化.
+    std::vector<Worker> workers_{};
+
+    std::mutex shard_mutex_;
+    // 分片线程中创建的listen socket, 关闭时需要投递回对应的线程.
+    std::vector<std::pair<std::shared_ptr<io::IOManager>, Socket>> shard_sockets_{};
+
+protected:
+    std::atomic<bool> serving_{false};
+    std::vector<Socket> listen_sockets_{};
+    std::unique_ptr<io::IOWorkBalancer> balancer_ = nullptr;
+};
+} // namespace lon::net
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "../../base/io_buffer.h"
+#include "connection.h"
+
+#include <functional>
+
+namespace lon::net {
+
+/**
+ * @brief TCP字节流的分帧, decode从buffer头部切出完整的帧, 帧与buffer共享block, 不拷贝数据.
+ */
+class FrameCodec
+{
+public:
+    enum class DecodeResult
+    {
+        Frame,     // 切出了一个完整的帧.
+        NeedMore,  // 数据不足一个帧.
+        Error      // 数据不符合帧格式, 连接应当被关闭.
+    };
+
+    virtual ~FrameCodec() = default;
+
+    /**
+     * @brief 从buffer头部切出一个完整的帧到frame(不包括长度头以及分隔符), frame原有的数据会被清空.
+     */
+    virtual DecodeResult decode(IOBuffer& buffer, IOBuffer& frame) = 0;
+
+    /**
+     * @brief 按照帧格式把payload追加到out.
+     * @return payload不符合帧格式(比如超过长度上限)时返回false, 此时out不变.
+     */
+    virtual bool encode(IOBuffer&& payload, IOBuffer& out) const = 0;
+
+    /**
+     * @brief 同上, 各个codec直接把payload写入out, 不经过中间的buffer.
+     */
+    virtual bool encode(StringPiece payload, IOBuffer& out) const = 0;
+};
+
+/**
+ * @brief 固定长度的帧.
+ */
+class FixedLengthCodec : public FrameCodec
+{
+public:
+    explicit FixedLengthCodec(size_t length) : length_{length} {}
+
+    DecodeResult decode(IOBuffer& buffer, IOBuffer& frame) override;
+
+    bool encode(IOBuffer&& payload, IOBuffer& out) const override;
+    bool encode(StringPiece payload, IOBuffer& out) const override;
+
+private:
+    size_t length_;
+};
+
+/**
+ * @brief 长度头 + payload的帧, 长度头只记录payload的长度.
+ */
+class LengthFieldCodec : public FrameCodec
+{
+public:
+    enum class FieldSize
+    {
+        U16 = 2,
+        U32 = 4
+    };
+
+    enum class Endian
+    {
+        Big,
+        Little
+    };
+
+    static constexpr size_t kDefaultMaxFrameLength = 64 * 1024 * 1024;
+
+    explicit LengthFieldCodec(FieldSize field_size    = FieldSize::U32,
+                              Endian endian           = Endian::Big,
+                              size_t max_frame_length = kDefaultMaxFrameLength);
+
+    DecodeResult decode(IOBuffer& buffer, IOBuffer& frame) override;
+
+    bool encode(IOBuffer&& payload, IOBuffer& out) const override;
+    bool encode(StringPiece payload, IOBuffer& out) const override;
+
+    LON_NODISCARD
+    size_t headerLength() const noexcept { return static_cast<size_t>(field_size_); }
+
+private:
+    void encodeHeader(size_t length, char* header) const noexcept;
+
+    FieldSize field_size_;
+    Endian endian_;
+    size_t max_frame_length_;
+};
+
+/**
+ * @brief 以分隔符(比如"\r\n")结尾的帧, 超过max_frame_length仍然没有找到分隔符时视为错误.
+ * 数据不足时会记住已经查找过的位置, 所以一个实例只用于一条连接的读缓冲,
+ * 并且两次decode之间只能向该buffer追加数据(readFrames即是如此); 传入其它buffer时从头查找.
+ */
+class DelimiterCodec : public FrameCodec
+{
+public:
+    static constexpr size_t kDefaultMaxFrameLength = 64 * 1024;
+
+    explicit DelimiterCodec(String delimiter        = "\r\n",
+                            size_t max_frame_length = kDefaultMaxFrameLength);
+
+    DecodeResult decode(IOBuffer& buffer, IOBuffer& frame) override;
+
+    bool encode(IOBuffer&& payload, IOBuffer& out) const override;
+    bool encode(StringPiece payload, IOBuffer& out) const override;
+
+private:
+    String delimiter_;
+    size_t max_frame_length_;
+    // 上一次decode已经查找过的长度, 数据不足时下次从这里继续查找, 只对scanned_buffer_有效.
+    size_t scanned_                 = 0;
+    const IOBuffer* scanned_buffer_ = nullptr;
+};
+
+/**
+ * @brief 读取connection上的数据并使用codec分帧, 每个完整的帧调用一次handler, handler返回false时停止读取.
+ * handler中write的响应在下一次读取之前合并发送, handler停止读取时写队列中可能还有数据, 需要调用者flush.
+ * @param buffer 读缓冲, 停止时保存着还没有处理的数据.
+ * @return handler停止读取时返回1, 对端关闭返回0, 出错返回-1并设置errno, 帧格式错误时errno为EPROTO.
+ */
+int readFrames(TcpConnection& connection,
+               FrameCodec& codec,
+               IOBuffer& buffer,
+               const std::function<bool(IOBuffer& frame)>& handler);
+
+/**
+ * @brief 把payload编码后放入connection的写队列(see @TcpConnection::write).
+ * @return 成功返回0, payload不符合帧格式时返回-1并设置errno为EMSGSIZE, 超过高水位后发送失败返回-1.
+ */
+int writeFrame(TcpConnection& connection, const FrameCodec& codec, StringPiece payload);
+
+}  // namespace lon::net
@@ -1,7 +1,10 @@
 #pragma once
 
+#include "../../base/io_buffer.h"
 #include "../socket.h"
 
+#include <deque>
+
 namespace lon::net {
 	class TcpConnection
 	{
@@ -13,14 +16,22 @@ namespace lon::net {
         TcpConnection(TcpConnection&& _other) noexcept = default;
         auto operator=(TcpConnection&& _other) noexcept -> TcpConnection& = default;
 
-        explicit TcpConnection(Socket _sock,
-                               SockAddressPtr _peer_addr)
+        explicit TcpConnection(Socket _sock, const InetAddress& _peer_addr)
+            : connected_{true},
+              socket_{_sock},
+              peer_addr_{_peer_addr} {
+        }
+
+        explicit TcpConnection(Socket _sock, const SockAddressPtr& _peer_addr)
             : connected_{true},
               socket_{_sock},
-              peer_addr_{std::move(_peer_addr)} {
+              peer_addr_{_peer_addr ? InetAddress(*_peer_addr) : InetAddress()} {
         }
 
-        ~TcpConnection() = default;
+        /**
+         * @brief 写队列中还有数据时做一次非阻塞的发送(不挂起协程), 发送不完或者socket已经关闭时丢弃剩余的数据并输出日志.
+         */
+        ~TcpConnection();
 
 		LON_NODISCARD
 	    bool connected() const { return connected_; }
@@ -29,7 +40,9 @@ namespace lon::net {
 		const SockAddress* getLocalAddr() const {return socket_.getLocalAddress().get();}
 
 		LON_NODISCARD
-		const SockAddress* getPeerAddr() const {return  peer_addr_.get();}
+		const InetAddress* getPeerAddr() const {
+			return peer_addr_.getFamily() == AF_UNSPEC ? nullptr : &peer_addr_;
+		}
 
 		LON_NODISCARD
 		Socket& getSocket() {return socket_;}
@@ -40,10 +53,162 @@ namespace lon::net {
         ssize_t recv(void* buffer, size_t length, int flags = 0) const;
         ssize_t recv(iovec* buffers, size_t length, int flags = 0) const;
 
+        /**
+         * @brief 读取数据追加到buffer, 只有第一次读取可能挂起协程, 之后持续读取直到EAGAIN或者读满max_bytes.
+         * 读取之前先flush写队列(cork时除外), 这样处理一次读取到的所有请求产生的响应只需要一次writev.
+         * @param flags 为MSG_DONTWAIT时第一次读取也不挂起, 由调用者自己等待(比如使用不同的超时).
+         * @return 读取的字节数, 对端关闭且没有读到数据返回0, 没有读到数据时出错返回-1(包括用户非阻塞socket的EAGAIN).
+         */
+        ssize_t readInto(IOBuffer& buffer, size_t max_bytes = kMaxReadBytes, int flags = 0);
+
+        /**
+         * @brief 发送buffer中的数据, 并从buffer中移除已发送的部分. 直到全部发送或者EAGAIN(用户非阻塞socket)以及出错.
+         * @return 发送的字节数, 没有发送任何数据时出错返回-1.
+         */
+        ssize_t writeFrom(IOBuffer& buffer, int flags = 0) const;
+
+        // readInto单次调用最多读取的字节数, 避免一个连接长时间占用executor.
+        static constexpr size_t kMaxReadBytes = 1024 * 1024;
+
+        static constexpr size_t kDefaultLowWatermark  = 64 * 1024;
+        static constexpr size_t kDefaultHighWatermark = 4 * 1024 * 1024;
+        // 小于这个长度时MSG_ZEROCOPY的页面锁定以及完成通知的开销超过拷贝本身.
+        static constexpr size_t kDefaultZeroCopyThreshold = 16 * 1024;
+
+        struct WriteStats
+        {
+            size_t bytes           = 0;  // 写队列发送的字节数.
+            size_t syscalls        = 0;  // 写队列发送时的系统调用次数.
+            size_t waits           = 0;  // 发送缓冲区满, 挂起等待EPOLLOUT的次数.
+            size_t zerocopy_sends  = 0;  // 使用MSG_ZEROCOPY发送的次数.
+            size_t zerocopy_copied = 0;  // 完成通知表明内核仍然拷贝了数据的发送次数(比如loopback).
+        };
+
+        /**
+         * @brief 把数据放入写队列, 不产生系统调用. 数据在readInto之前, flush或者uncork时合并发送.
+         * 写队列超过高水位时立刻发送, 直到低于低水位(挂起当前协程), 以此限制慢连接占用的内存.
+         * 与send混用时需要先flush, 否则数据会乱序.
+         * 连接析构时只会尽力发送一次剩余的数据(see @~TcpConnection), 在关闭socket之前需要flush.
+         * @return 成功返回0, 超过高水位后发送失败返回-1.
+         */
+        int write(const void* data, size_t length);
+        int write(StringPiece message) { return write(message.data(), message.size()); }
+        int write(IOBuffer&& data);
+
+        /**
+         * @brief 写队列本身, codec等可以直接把数据编码进来, 之后调用commitOutput检查水位.
+         */
+        LON_NODISCARD
+        IOBuffer& outputBuffer() { return output_; }
+
+        /**
+         * @brief 直接向outputBuffer写入数据后调用, 超过高水位时发送到低水位以下.
+         * @return 同write.
+         */
+        int commitOutput();
+
+        /**
+         * @brief 发送写队列中的所有数据, 部分写入时挂起当前协程等待EPOLLOUT(hook关闭时阻塞在send中).
+         * 对端关闭时返回EPIPE而不是触发SIGPIPE.
+         * @return 发送的字节数, 出错返回-1, 没有发送的数据保留在写队列中.
+         */
+        ssize_t flush();
+
+        /**
+         * @brief cork期间readInto不会flush写队列, 用于把多次读取的响应合并发送. 可以嵌套, 最后一次uncork时flush.
+         * 高水位仍然生效.
+         */
+        void cork() { ++cork_depth_; }
+
+        /**
+         * @brief see @cork
+         * @return 同flush, 仍然处于cork状态时返回0.
+         */
+        ssize_t uncork();
+
+        LON_NODISCARD
+        bool corked() const { return cork_depth_ > 0; }
+
+        void setWriteWatermarks(size_t low, size_t high) {
+            low_watermark_  = low;
+            high_watermark_ = high;
+        }
+
+        LON_NODISCARD
+        size_t pendingWriteBytes() const { return output_.readableBytes(); }
+
+        /**
+         * @brief 写队列低于高水位, 可以继续写入.
+         */
+        LON_NODISCARD
+        bool writable() const { return output_.readableBytes() < high_watermark_; }
+
+        LON_NODISCARD
+        const WriteStats& getWriteStats() const { return write_stats_; }
+
+        /**
+         * @brief 在内核中把文件从offset开始的len字节发送出去(sendfile), 数据不经过用户空间.
+         * 先flush写队列保证顺序, 发送缓冲区满时挂起当前协程等待EPOLLOUT(hook关闭时阻塞).
+         * sendfile不支持MSG_NOSIGNAL, 对端关闭时会触发SIGPIPE, 服务端应当忽略SIGPIPE.
+         * @param len 为-1时发送到文件末尾.
+         * @return 发送的字节数, 文件提前结束时少于len, 没有发送任何数据时出错返回-1.
+         */
+        ssize_t sendFile(int fd, off_t offset, size_t len = static_cast<size_t>(-1));
+
+        /**
+         * @brief 把管道中的len字节splice到socket, 用于发送其它fd(比如子进程的输出)经过管道的数据.
+         * 先flush写队列, 管道为空时等待管道可读, 发送缓冲区满时等待EPOLLOUT.
+         * @return 发送的字节数, 管道写端关闭时少于len, 没有发送任何数据时出错返回-1.
+         */
+        ssize_t splice(int pipe_fd, size_t len);
+
+        /**
+         * @brief 开启SO_ZEROCOPY, 之后写队列一次发送超过threshold字节时使用MSG_ZEROCOPY, 内核直接引用block中的页面.
+         * 写队列持有这些block直到从错误队列收到完成通知, 所以调用者不需要等待. 完成通知在flush时回收.
+         * @return 内核不支持时返回false, errno同::setsockopt.
+         */
+        bool enableZeroCopy(size_t threshold = kDefaultZeroCopyThreshold);
+
+        LON_NODISCARD
+        bool zeroCopyEnabled() const { return zerocopy_threshold_ > 0; }
+
+        /**
+         * @brief 从错误队列读取MSG_ZEROCOPY的完成通知, 释放已经完成发送的block, 不会挂起.
+         * @return 本次完成的发送次数.
+         */
+        size_t reapZeroCopy();
+
+        /**
+         * @brief 已经用MSG_ZEROCOPY发送但是还没有收到完成通知的字节数.
+         */
+        LON_NODISCARD
+        size_t pendingZeroCopyBytes() const;
+
 	private:
+        /**
+         * @brief 发送写队列直到剩余数据不超过target.
+         */
+        ssize_t flushTo(size_t target);
+
 		bool connected_ = false;
 		Socket socket_{};
-		SockAddressPtr peer_addr_ = nullptr;
+		InetAddress peer_addr_{};
+
+        IOBuffer output_;
+        size_t low_watermark_  = kDefaultLowWatermark;
+        size_t high_watermark_ = kDefaultHighWatermark;
+        int cork_depth_        = 0;
+        WriteStats write_stats_{};
+
+        struct ZeroCopyPending
+        {
+            uint32_t id;    // 内核为每次成功的MSG_ZEROCOPY发送分配的递增序号.
+            IOBuffer data;  // 与写队列共享block, 完成前block不会被复用.
+        };
+        // tcp的完成通知按照序号顺序到达.
+        std::deque<ZeroCopyPending> zerocopy_pending_;
+        uint32_t zerocopy_next_id_ = 0;
+        size_t zerocopy_threshold_ = 0;  // 0表示没有开启.
 	};
 
 }
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "../../base/nocopyable.h"
+#include "../../io/co_waiter.h"
+#include "connection.h"
+
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+namespace lon::net {
+/**
+ * @brief 按目的地址(host:port)缓存的tcp连接池, 复用空闲的连接以避免每次请求都进行握手.
+ * 非线程安全, 每个IOManager线程使用各自的实例, 并且需要由shared_ptr持有.
+ */
+class TcpConnectionPool
+    : public std::enable_shared_from_this<TcpConnectionPool>
+      , Noncopyable
+{
+public:
+    using Ptr = std::shared_ptr<TcpConnectionPool>;
+
+    struct Options
+    {
+        size_t max_per_host       = 64;    // 每个目的地址的连接数上限(使用中+空闲).
+        size_t max_idle_per_host  = 16;    // 每个目的地址最多保留的空闲连接.
+        size_t idle_timeout_ms    = 60000; // 空闲超过该时间的连接会被关闭.
+        size_t connect_timeout_ms = 3000;
+        size_t acquire_timeout_ms = 3000;  // 达到max_per_host时等待其它连接归还的时间.
+        bool tcp_keep_alive       = true;
+        bool tcp_no_delay         = true;
+    };
+
+    /**
+     * @brief 借出的连接, 析构时归还到连接池.
+     */
+    class Handle
+    {
+    public:
+        Handle() = default;
+        Handle(Handle&& _other) noexcept;
+        auto operator=(Handle&& _other) noexcept -> Handle&;
+        ~Handle() { release(); }
+
+        explicit operator bool() const noexcept { return !!connection_; }
+
+        TcpConnection* operator->() const noexcept { return connection_.get(); }
+        TcpConnection& operator*() const noexcept { return *connection_; }
+
+        /**
+         * @brief 是否为复用的空闲连接, 复用连接上的请求失败时可以换新连接重试.
+         */
+        LON_NODISCARD
+        bool reused() const noexcept { return reused_; }
+
+        /**
+         * @brief 标记连接不可复用(对端关闭, 协议错误等), 归还时直接关闭.
+         */
+        void markBroken() noexcept { broken_ = true; }
+
+        /**
+         * @brief 提前归还连接.
+         */
+        void release();
+
+    private:
+        friend class TcpConnectionPool;
+
+        std::weak_ptr<TcpConnectionPool> pool_;
+        String key_;
+        std::unique_ptr<TcpConnection> connection_ = nullptr;
+        bool reused_                               = false;
+        bool broken_                               = false;
+    };
+
+    TcpConnectionPool() = default;
+    explicit TcpConnectionPool(Options _options) : options_{_options} {}
+
+    ~TcpConnectionPool();
+
+    /**
+     * @brief 获取到host:port的连接, 优先使用空闲连接, 没有时新建连接(see @TcpConnector::connect),
+     * 连接数达到上限时挂起当前协程等待其它连接归还.
+     * @return 失败时handle为空, errno为失败原因(等待超时为ETIMEDOUT).
+     */
+    Handle acquire(StringArg host, uint16_t port);
+
+    /**
+     * @brief 关闭全部空闲连接.
+     */
+    void closeIdle();
+
+    LON_NODISCARD
+    size_t idleCount() const noexcept;
+
+    LON_NODISCARD
+    size_t activeCount() const noexcept;
+
+    LON_NODISCARD
+    const Options& getOptions() const noexcept { return options_; }
+
+private:
+    struct IdleConnection
+    {
+        std::unique_ptr<TcpConnection> connection;
+        size_t idle_since_ms;
+    };
+
+    struct HostPool
+    {
+        std::vector<IdleConnection> idle;  // 栈, 优先复用最近归还的连接.
+        std::deque<std::shared_ptr<io::CoWaiter>> waiters;
+        size_t active = 0;
+    };
+
+    Handle makeHandle(const String& key,
+                      std::unique_ptr<TcpConnection> connection,
+                      bool reused);
+
+    void release(const String& key,
+                 std::unique_ptr<TcpConnection> connection,
+                 bool reusable);
+
+    /**
+     * @brief 空闲连接是否仍然可用(对端未关闭并且没有残留数据).
+     */
+    static bool isAlive(TcpConnection& connection);
+
+    void purgeExpired(HostPool& host_pool, size_t now_ms);
+
+    static void wakeWaiter(HostPool& host_pool);
+
+    /**
+     * @brief 有空闲连接时定期清理过期的连接.
+     */
+    void armSweepTimer();
+
+    Options options_{};
+    std::unordered_map<String, HostPool> hosts_;
+    bool sweep_armed_ = false;
+};
+
+}  // namespace lon::net
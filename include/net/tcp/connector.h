@@ -0,0 +1,44 @@
+#pragma once
+
+#include "connection.h"
+
+#include <vector>
+
+namespace lon::net {
+/**
+ * @brief tcp主动连接, 在hook开启的IOManager线程中并发尝试多个地址, 可以超时以及取消.
+ * 非hook线程中退化为依次阻塞尝试.
+ */
+class TcpConnector
+{
+public:
+    // RFC 8305 推荐的相邻两次连接尝试的间隔.
+    static constexpr size_t kDefaultAttemptDelayMs = 250;
+
+    /**
+     * @brief happy eyeballs: 候选地址按地址族交替排序后依次发起连接, 前面的连接在attempt_delay_ms内
+     * 没有完成就并发发起下一个(失败则立即发起下一个), 返回第一个成功的连接并取消其余的连接.
+     * @param peer_addrs 候选地址, 一般来自IPAddress::createAll.
+     * @param timeout_ms 整体超时时间, -1表示不超时.
+     * @param canceler 可为nullptr, 用于取消整个连接过程.
+     * @return 成功返回连接, 否则返回nullptr, errno为最后一次失败的原因(超时为ETIMEDOUT, 取消为ECANCELED).
+     */
+    static std::unique_ptr<TcpConnection> connect(
+        std::vector<SockAddress::UniquePtr> peer_addrs,
+        size_t timeout_ms        = static_cast<size_t>(-1),
+        size_t attempt_delay_ms  = kDefaultAttemptDelayMs,
+        io::Canceler* canceler   = nullptr);
+
+    /**
+     * @brief 解析host的全部地址后连接, see above.
+     * @throw invalid_argument 如果host解析失败.
+     */
+    static std::unique_ptr<TcpConnection> connect(
+        StringArg host,
+        uint16_t port,
+        size_t timeout_ms        = static_cast<size_t>(-1),
+        size_t attempt_delay_ms  = kDefaultAttemptDelayMs,
+        io::Canceler* canceler   = nullptr);
+};
+
+}  // namespace lon::net
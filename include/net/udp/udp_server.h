@@ -0,0 +1,173 @@
+#pragma once
+
+#include "../../balancer/io/simple_balancer.h"
+#include "../../base/nocopyable.h"
+#include "../../io/canceler.h"
+#include "../../io/io_manager.h"
+#include "udp_socket.h"
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+namespace lon::net {
+
+/**
+ * @brief 在处理函数中回复数据报, 回复先放入批量发送的缓冲, 在处理完一批接收的数据报(或者缓冲已满)时用一次sendmmsg发出.
+ */
+class UdpReplier : public Noncopyable
+{
+public:
+    UdpReplier(UdpSocket& socket, size_t capacity, size_t datagram_size)
+        : socket_{socket}, batch_{capacity, datagram_size} {}
+
+    /**
+     * @brief 发送message到peer_addr, 内容会被拷贝.
+     * @return message超过数据报槽位大小时返回false.
+     */
+    bool send(StringPiece message, const SockAddress& peer_addr);
+
+    /**
+     * @brief 发送缓冲中的全部回复, 发送缓冲区满(EAGAIN)时剩余的回复被丢弃, 与内核丢弃数据报的行为一致.
+     */
+    void flush();
+
+    LON_NODISCARD
+    size_t sent() const noexcept { return sent_; }
+
+    LON_NODISCARD
+    size_t dropped() const noexcept { return dropped_; }
+
+private:
+    UdpSocket& socket_;
+    DatagramBatch batch_;
+    size_t sent_    = 0;
+    size_t dropped_ = 0;
+};
+
+/**
+ * @brief udp server, 均衡器的每个IOManager各自持有一个绑定到同一地址的SO_REUSEPORT socket, 由内核按照四元组分配数据报,
+ * 每个socket在所属的线程中用recvmmsg批量接收, 处理函数的回复用sendmmsg批量发送, 没有跨线程的任务投递.
+ * 处理函数在各个IOManager线程中并发调用.
+ */
+class UdpServer
+    : public std::enable_shared_from_this<UdpServer>
+      , Noncopyable
+{
+public:
+    /**
+     * @brief 数据报处理函数.
+     * @param message 数据报内容, 指向接收缓冲, 只在本次调用期间有效.
+     * @param peer_addr 对端地址, 引用接收缓冲, 只在本次调用期间有效, 需要保存时直接拷贝(不分配堆内存).
+     * @param replier 用于回复, 回复在本批数据报处理完以后发送.
+     */
+    using OnDatagramCallbackType =
+        std::function<void(StringPiece message, const InetAddress& peer_addr, UdpReplier& replier)>;
+
+    using SocketInitCallbackType = std::function<void(Socket& socket)>;
+
+    using Ptr = std::shared_ptr<UdpServer>;
+
+    struct Options
+    {
+        size_t batch_size    = 64;                                   // 一次recvmmsg/sendmmsg最多处理的数据报个数.
+        size_t datagram_size = DatagramBatch::kDefaultDatagramSize;  // 超过的数据报在接收时被截断并丢弃.
+        int recv_buffer_size = 0;                                    // SO_RCVBUF, 0表示使用系统默认值.
+    };
+
+    struct Stats
+    {
+        size_t received  = 0;  // 交给处理函数的数据报.
+        size_t truncated = 0;  // 超过datagram_size被丢弃的数据报.
+        size_t sent      = 0;  // 发送成功的回复.
+        size_t dropped   = 0;  // 发送缓冲区满时丢弃的回复.
+    };
+
+public:
+    UdpServer(OnDatagramCallbackType _on_datagram,
+              std::unique_ptr<io::IOWorkBalancer> _balancer =
+                  std::make_unique<io::SimpleIOBalancer>());
+
+    ~UdpServer();
+
+    /**
+     * @brief 设置socket初始化器, 在每个socket bind之前调用.
+     */
+    auto setSocketIniter(SocketInitCallbackType _socket_initer) -> void {
+        socket_initer_ = std::move(_socket_initer);
+    }
+
+    /**
+     * @brief 需要在bind之前设置.
+     */
+    auto setOptions(Options _options) -> void { options_ = _options; }
+
+    LON_NODISCARD
+    const Options& getOptions() const noexcept { return options_; }
+
+    /**
+     * @brief 绑定地址, 均衡器中有多个IOManager时端口不能为0, 否则各个socket会绑定到不同的端口.
+     * @return 绑定是否成功.
+     */
+    bool bind(SockAddress::SharedPtr local_address);
+
+    /**
+     * @brief 在均衡器的每个IOManager中开始接收.
+     * @return 没有绑定地址时返回false.
+     */
+    bool startServe();
+
+    /**
+     * @brief 停止接收并关闭所有socket, 正在处理的一批数据报处理完以后结束.
+     */
+    bool stopServe();
+
+    LON_NODISCARD LON_ALWAYS_INLINE
+    bool serving() const noexcept {
+        return serving_;
+    }
+
+    /**
+     * @brief 数据报统计, 在不同线程中调用安全.
+     */
+    LON_NODISCARD
+    Stats getStats() const noexcept;
+
+    LON_NODISCARD
+    io::IOWorkBalancer& getBalancer() const noexcept { return *balancer_; }
+
+private:
+    struct Counters;
+    struct Shard;
+
+    /**
+     * @brief 创建非阻塞的SO_REUSEPORT udp socket并绑定, 失败时返回fd为-1的socket.
+     */
+    UdpSocket createSocket(const SockAddress::SharedPtr& local_address) const;
+
+    /**
+     * @brief 在当前IOManager中运行接收循环, 直到shard被取消.
+     */
+    void startReceiveLoop(std::shared_ptr<Shard> shard);
+
+    /**
+     * @brief 在manager线程中创建socket并开始接收.
+     */
+    void startShard(const std::shared_ptr<io::IOManager>& manager);
+
+    OnDatagramCallbackType on_datagram_   = nullptr;
+    SocketInitCallbackType socket_initer_ = nullptr;
+    Options options_{};
+    std::shared_ptr<Counters> counters_;
+    SockAddress::SharedPtr local_address_ = nullptr;
+    // bind时创建的socket, 在调用startServe的线程中接收.
+    UdpSocket bound_socket_{Socket()};
+
+    std::mutex shard_mutex_;
+    std::vector<std::shared_ptr<Shard>> shards_{};
+
+    std::atomic<bool> serving_{false};
+    std::unique_ptr<io::IOWorkBalancer> balancer_ = nullptr;
+};
+
+}  // namespace lon::net
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "../../base/buffer_pool.h"
+#include "../socket.h"
+
+#include <vector>
+
+namespace lon::net {
+/**
+ * @brief 一批数据报, 每个数据报占用一个固定大小的槽位, 槽位内存来自线程局部的BufferPool.
+ * 同一个batch可以反复用于UdpSocket::recvBatch/sendBatch.
+ */
+class DatagramBatch : public Noncopyable
+{
+public:
+    // 以太网mtu(1500)下的数据报都可以放下.
+    static constexpr size_t kDefaultDatagramSize = 2048;
+
+    /**
+     * @param capacity 一次最多收发的数据报个数.
+     * @param datagram_size 单个数据报槽位的大小, 超过的部分在接收时会被截断.
+     */
+    explicit DatagramBatch(size_t capacity,
+                           size_t datagram_size = kDefaultDatagramSize);
+
+    ~DatagramBatch();
+
+    /**
+     * @brief 添加一个待发送的数据报, 内容会被拷贝到槽位中.
+     * @param peer_addr 目标地址, 对于已经connect的socket可以为nullptr.
+     * @return batch已满或者数据报超过槽位大小时返回false.
+     */
+    bool push(StringPiece message, const SockAddress* peer_addr = nullptr);
+
+    /**
+     * @brief 第index个数据报的内容, 指向槽位内存, 在下一次收发或clear之前有效.
+     */
+    LON_NODISCARD
+    StringPiece get(size_t index) const noexcept {
+        return {buffers_[index], iovecs_[index].iov_len};
+    }
+
+    LON_NODISCARD
+    const sockaddr* getPeerAddr(size_t index) const noexcept {
+        return addresses_[index].getAddr();
+    }
+
+    LON_NODISCARD
+    socklen_t getPeerAddrLen(size_t index) const noexcept {
+        return addresses_[index].getAddrLen();
+    }
+
+    /**
+     * @brief 第index个数据报的对端地址, 引用batch中的地址, 有效期同get, 需要保存时直接拷贝.
+     */
+    LON_NODISCARD
+    const InetAddress& getPeer(size_t index) const noexcept {
+        return addresses_[index];
+    }
+
+    /**
+     * @brief 第index个数据报在接收时是否因为超过槽位大小被截断.
+     */
+    LON_NODISCARD
+    bool truncated(size_t index) const noexcept {
+        return msgs_[index].msg_hdr.msg_flags & MSG_TRUNC;
+    }
+
+    LON_NODISCARD
+    size_t size() const noexcept { return size_; }
+
+    LON_NODISCARD
+    size_t capacity() const noexcept { return buffers_.size(); }
+
+    LON_NODISCARD
+    size_t datagramSize() const noexcept { return datagram_size_; }
+
+    LON_NODISCARD
+    bool empty() const noexcept { return size_ == 0; }
+
+    LON_NODISCARD
+    bool full() const noexcept { return size_ == buffers_.size(); }
+
+    void clear() noexcept { size_ = 0; }
+
+private:
+    friend class UdpSocket;
+
+    /**
+     * @brief 将所有槽位重置为接收状态.
+     */
+    void prepareRecv() noexcept;
+
+    /**
+     * @brief 接收完成后记录数据报个数以及长度.
+     */
+    void finishRecv(size_t count) noexcept;
+
+    size_t datagram_size_;
+    size_t size_ = 0;
+    std::vector<char*> buffers_;
+    std::vector<iovec> iovecs_;
+    std::vector<InetAddress> addresses_;
+    std::vector<mmsghdr> msgs_;
+};
+
+/**
+ * @brief udp socket, 除了单个数据报的收发, 提供基于recvmmsg/sendmmsg的批量收发,
+ * 在hook开启的线程中数据未就绪时挂起当前协程.
+ */
+class UdpSocket
+{
+public:
+    /**
+     * @brief 创建udp socket.
+     * @param family AF_INET/AF_INET6.
+     * @throw ExecFailed 如果::socket返回-1.
+     */
+    explicit UdpSocket(sa_family_t family = AF_INET);
+
+    explicit UdpSocket(Socket socket) : socket_{socket} {}
+
+    /**
+     * @brief see @Socket::bind.
+     */
+    int bind(SockAddress::SharedPtr local_addr) {
+        return socket_.bind(std::move(local_addr));
+    }
+
+    /**
+     * @brief 设置默认的目标地址, 之后发送时peer_addr可以为nullptr.
+     * @return see @::connect
+     */
+    int connect(const SockAddress& peer_addr) const;
+
+    /**
+     * @brief wrap to ::sendto, peer_addr为nullptr时发送到connect的地址.
+     * @return see @::sendto
+     */
+    ssize_t sendTo(StringPiece message,
+                   const SockAddress* peer_addr,
+                   int flags = 0) const;
+
+    /**
+     * @brief wrap to ::recvfrom, peer_addr可以为nullptr.
+     * @return see @::recvfrom
+     */
+    ssize_t recvFrom(void* buffer,
+                     size_t length,
+                     SockAddress* peer_addr,
+                     int flags = 0) const;
+
+    /**
+     * @brief 发送batch中的全部数据报, 一次sendmmsg没有发完时继续发送剩余部分.
+     * @return 发送成功的数据报个数, 一个都没有发送成功时返回-1(errno同::sendmmsg).
+     */
+    int sendBatch(DatagramBatch& batch, int flags = 0) const;
+
+    /**
+     * @brief 接收数据报到batch中(会覆盖batch原本的内容), 至少有一个数据报时返回.
+     * @return 接收到的数据报个数, 失败返回-1(errno同::recvmmsg).
+     */
+    int recvBatch(DatagramBatch& batch, int flags = 0) const;
+
+    LON_NODISCARD
+    Socket& getSocket() noexcept { return socket_; }
+
+    LON_NODISCARD
+    int fd() const noexcept { return socket_.fd(); }
+
+    void close() { socket_.close(); }
+
+private:
+    Socket socket_{};
+};
+
+}  // namespace lon::net
@@ -0,0 +1,136 @@
+#include "base/print_helper.h"
+#include "coroutine/executor.h"
+#include "io/hook.h"
+#include "io/io_manager.h"
+#include "net/tcp/connection_pool.h"
+#include "net/tcp/connector.h"
+
+#include <fmt/core.h>
+
+constexpr uint16_t port = 22225;
+
+// 本地echo server, 用于连接池测试.
+void echoServer() {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    lon::net::Socket socket(fd);
+    socket.setReuseAddr(true);
+    socket.bind(std::make_shared<lon::net::IPV4Address>("127.0.0.1", port));
+    socket.listen();
+    while (true) {
+        std::shared_ptr<lon::net::TcpConnection> connection = socket.accept();
+        lon::io::IOManager::getThreadLocal()->addExecutor(
+            std::make_shared<lon::coroutine::Executor>([connection]() {
+                lon::IOBuffer buffer;
+                while (connection->readInto(buffer) > 0) {
+                    if (connection->writeFrom(buffer) == -1)
+                        break;
+                }
+                connection->getSocket().close();
+            }));
+    }
+}
+
+void connectTimeout() {
+    printDividing("connect timeout");
+    // 不可路由的地址, 没有网络时会直接失败(ENETUNREACH).
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    lon::net::Socket socket(fd);
+    auto begin      = lon::currentMs();
+    auto connection = socket.connect(
+        std::make_unique<lon::net::IPV4Address>("10.255.255.1", 80), 200);
+    fmt::print("connection:{}, errno:{}({}), cost {} ms\n",
+               !!connection,
+               errno,
+               std::strerror(errno),
+               lon::currentMs() - begin);
+    socket.close();
+}
+
+void connectCancel() {
+    printDividing("connect cancel");
+    auto canceler = std::make_shared<lon::io::Canceler>();
+    lon::io::IOManager::getThreadLocal()->addExecutor(
+        std::make_shared<lon::coroutine::Executor>([canceler]() {
+            ::usleep(50 * 1000);
+            canceler->cancel();
+        }));
+    std::vector<lon::net::SockAddress::UniquePtr> addrs;
+    addrs.push_back(std::make_unique<lon::net::IPV4Address>("10.255.255.1", 80));
+    addrs.push_back(std::make_unique<lon::net::IPV4Address>("10.255.255.2", 80));
+    auto begin      = lon::currentMs();
+    auto connection = lon::net::TcpConnector::connect(
+        std::move(addrs), 1000, 20, canceler.get());
+    fmt::print("connection:{}, errno:{}({}), cost {} ms\n",
+               !!connection,
+               errno,
+               std::strerror(errno),
+               lon::currentMs() - begin);
+}
+
+void happyEyeballs() {
+    printDividing("happy eyeballs");
+    std::vector<lon::net::SockAddress::UniquePtr> addrs;
+    addrs.push_back(std::make_unique<lon::net::IPV6Address>("::1", port));  // 未监听
+    addrs.push_back(std::make_unique<lon::net::IPV4Address>("127.0.0.1", port));
+    auto connection = lon::net::TcpConnector::connect(std::move(addrs), 1000);
+    fmt::print("connection:{}, peer:{}\n",
+               !!connection,
+               connection ? connection->getPeerAddr()->toString() : "");
+    if (connection)
+        connection->getSocket().close();
+}
+
+void pool() {
+    printDividing("connection pool");
+    lon::net::TcpConnectionPool::Options options;
+    options.max_per_host = 1;
+    auto connection_pool =
+        std::make_shared<lon::net::TcpConnectionPool>(options);
+
+    for (int i = 0; i < 3; ++i) {
+        auto handle = connection_pool->acquire("127.0.0.1", port);
+        if (!handle) {
+            fmt::print("acquire failed:{}\n", std::strerror(errno));
+            return;
+        }
+        char buf[32];
+        handle->send(lon::StringPiece("ping"));
+        ssize_t n = handle->recv(buf, sizeof(buf));
+        fmt::print("round {}: reused:{}, echo:{}\n",
+                   i,
+                   handle.reused() ? "true" : "false",
+                   lon::StringPiece(buf, n > 0 ? static_cast<size_t>(n) : 0));
+    }
+
+    // max_per_host为1, 第二个协程需要等第一个归还.
+    auto first = std::make_shared<lon::net::TcpConnectionPool::Handle>(
+        connection_pool->acquire("127.0.0.1", port));
+    lon::io::IOManager::getThreadLocal()->addExecutor(
+        std::make_shared<lon::coroutine::Executor>([first]() {
+            ::usleep(50 * 1000);
+            fmt::print("first released\n");
+            first->release();
+        }));
+    auto begin  = lon::currentMs();
+    auto second = connection_pool->acquire("127.0.0.1", port);
+    fmt::print("second acquired:{}, reused:{}, waited {} ms, idle:{}, active:{}\n",
+               !!second,
+               second.reused(),
+               lon::currentMs() - begin,
+               connection_pool->idleCount(),
+               connection_pool->activeCount());
+}
+
+int main() {
+    lon::io::IOManager::getThreadLocal()->addExecutor(
+        std::make_shared<lon::coroutine::Executor>(echoServer));
+    lon::io::IOManager::getThreadLocal()->addExecutor(
+        std::make_shared<lon::coroutine::Executor>([]() {
+            connectTimeout();
+            connectCancel();
+            happyEyeballs();
+            pool();
+            lon::io::IOManager::getThreadLocal()->stop();
+        }));
+    lon::io::IOManager::getThreadLocal()->run();
+}
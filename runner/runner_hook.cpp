@@ -47,7 +47,8 @@ void run_sleep() {
 }
 
 void run_server() {
-    int socket = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    // hook会把socket设置为非阻塞, 这里按阻塞语义使用, accept没有连接时挂起协程.
+    int socket = ::socket(AF_INET, SOCK_STREAM, 0);
     sockaddr_in addr;
     bzero(&addr, sizeof(sockaddr_in));
     addr.sin_port   = ntohs(port);
@@ -0,0 +1,47 @@
+#include "logger.h"
+#include "logging/binary_log.h"
+
+#include <fmt/core.h>
+#include <fstream>
+#include <iterator>
+#include <unistd.h>
+
+// 把LON_BLOG写出的二进制日志还原为文本, 输出到stdout.
+// 用法: runner_log_decode [-p pattern] file...
+// 切换出的多个文件按时间顺序给出, 拼接以后一起解码.
+
+int main(int argc, char* argv[]) {
+    using namespace lon;
+    String pattern = "%d{%Y-%m-%d %H:%M:%S.%6N}%T%t%T[%p]%T<%f:%l>%T%m%n";
+    int option     = 0;
+    while ((option = ::getopt(argc, argv, "p:")) != -1) {
+        if (option == 'p') {
+            pattern = optarg;
+        } else {
+            fmt::print(stderr, "usage: {} [-p pattern] file...\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind >= argc) {
+        fmt::print(stderr, "usage: {} [-p pattern] file...\n", argv[0]);
+        return 1;
+    }
+
+    String data;
+    for (int i = optind; i < argc; ++i) {
+        std::ifstream file(argv[i], std::ios::binary);
+        if (!file) {
+            fmt::print(stderr, "open {} failed\n", argv[i]);
+            return 1;
+        }
+        data.append(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    auto output = std::make_shared<Logger>("binary");
+    output->setFormatters(pattern);
+    output->addOneFlusher(std::make_unique<log::SimpleStdoutFlusher>());
+    log::BinaryLogDecoder decoder(output);
+    const size_t decoded = decoder.decode(data);
+    fmt::print(stderr, "decoded {} records, {} errors\n", decoded, decoder.getErrors());
+    return decoder.getErrors() == 0 ? 0 : 2;
+}
@@ -1,5 +1,6 @@
 #include "net/tcp/tcp_server.h"
 #include "base/print_helper.h"
+#include "io/co_waiter.h"
 #include "io/hook.h"
 
 using namespace lon::io;
@@ -30,6 +31,49 @@ void runServer() {
     IOManager::getThreadLocal()->stop();
 }
 
+void runServerLimits() {
+    printDividing("tcp server limits");
+    // 同时最多2个连接, 每个连接处理100ms, 后面的连接需要等待前面的释放.
+    TcpServer::Ptr server = std::make_shared<TcpServer>([](std::shared_ptr<TcpConnection> connection)
+    {
+        connection->send(lon::StringPiece("hi"));
+        usleep(100 * 1000);
+        connection->getSocket().close();
+    }, nullptr);
+    TcpServer::AcceptLimits limits;
+    limits.max_connections = 2;
+    server->setAcceptLimits(limits);
+    server->setSocketIniter([](Socket& socket) { socket.setReuseAddr(true); });
+    server->bind(std::make_shared<IPV4Address>("127.0.0.1", 22226));
+    server->startServe();
+
+    constexpr size_t client_count = 5;
+    size_t done = 0;
+    lon::io::CoWaiter waiter;
+    auto begin = lon::currentMs();
+    for (size_t i = 0; i < client_count; ++i) {
+        IOManager::getThreadLocal()->addExecutor(std::make_shared<lon::coroutine::Executor>([&, i]()
+        {
+            Socket socket(AF_INET, SOCK_STREAM, 0);
+            auto connection = socket.connect(std::make_unique<IPV4Address>("127.0.0.1", 22226));
+            char buf[8];
+            connection->recv(buf, sizeof(buf), 0);
+            fmt::print("client {} served after {} ms\n", i, lon::currentMs() - begin);
+            socket.close();
+            if (++done == client_count)
+                waiter.notify();
+        }));
+    }
+    waiter.wait();
+    auto stats = server->getStats();
+    fmt::print("accepted:{}, active:{}, rejected:{}, accept paused:{}\n",
+               stats.accepted,
+               stats.active_connections,
+               stats.rejected,
+               stats.accept_paused);
+    server->stopServe();
+}
+
 void runServerBinds() {
     printDividing("tcp server bind");
     TcpServer server([](std::shared_ptr<TcpConnection>){}, nullptr);
@@ -47,7 +91,11 @@ void runServerBinds() {
 int main() {
     lon::io::setHookEnabled(true);
     IOManager::getThreadLocal()->addExecutor(std::make_shared<lon::coroutine::Executor>(runServerBinds));
-    IOManager::getThreadLocal()->addExecutor(std::make_shared<lon::coroutine::Executor>(runServer));
+    IOManager::getThreadLocal()->addExecutor(std::make_shared<lon::coroutine::Executor>([]()
+    {
+        runServerLimits();
+        runServer();
+    }));
 
     IOManager::getThreadLocal()->run();
 }
\ No newline at end of file
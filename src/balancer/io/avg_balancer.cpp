@@ -4,15 +4,7 @@ namespace lon::io {
 
 RandomIOBalancer::RandomIOBalancer(size_t threads_count,
                                    bool use_current_thread) {
-    managers_.reserve(threads_count);
-    threads_.reserve(threads_count);
-    for (size_t i = 0; i < threads_count; ++i) {
-        threads_.emplace_back([&]() {
-            auto manager = IOManager::getThreadLocal();
-            managers_.emplace_back(manager);
-            manager->run();
-        });
-    }
+    managers_ = startIOThreads(threads_count, threads_);
     if (use_current_thread) {
         managers_.emplace_back(IOManager::getThreadLocal());
     }
@@ -27,20 +19,12 @@ RandomIOBalancer::~RandomIOBalancer() {
 void RandomIOBalancer::schedule(coroutine::Executor::Ptr executor,
                                 const std::any& arg) {
 
-    managers_[mt19937RandomGen<size_t>(0, threads_.size() -1)]->addRemoteTask(executor);
+    managers_[mt19937RandomGen<size_t>(0, managers_.size() -1)]->addRemoteTask(executor);
 }
 
 SequenceIOBalancer::SequenceIOBalancer(size_t threads_count,
                                        bool use_current_thread) {
-    managers_.reserve(threads_count);
-    threads_.reserve(threads_count);
-    for (size_t i = 0; i < threads_count; ++i) {
-        threads_.emplace_back([&]() {
-            auto manager = IOManager::getThreadLocal();
-            managers_.emplace_back(manager);
-            manager->run();
-        });
-    }
+    managers_ = startIOThreads(threads_count, threads_);
     if (use_current_thread) {
         managers_.emplace_back(IOManager::getThreadLocal());
     }
@@ -54,7 +38,8 @@ SequenceIOBalancer::~SequenceIOBalancer() {
 
 void SequenceIOBalancer::schedule(coroutine::Executor::Ptr executor,
                                   const std::any& arg) {
-    static size_t count = 0;
-    managers_[count++ % threads_.size()]->addRemoteTask(executor);
+    // 每个均衡器各自计数, 多个TcpServer之间互不影响.
+    size_t index = next_.fetch_add(1, std::memory_order_relaxed);
+    managers_[index % managers_.size()]->addRemoteTask(executor);
 }
 }  // namespace lon::io
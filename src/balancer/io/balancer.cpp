@@ -0,0 +1,44 @@
+#include "balancer/io/balancer.h"
+
+#include "io/io_manager.h"
+
+#include <condition_variable>
+#include <mutex>
+
+namespace lon::io {
+
+size_t IOWorkBalancer::getQueuedTaskCount() const {
+    size_t count = 0;
+    for (auto& manager : getIOManagers()) {
+        count += manager->getQueuedTaskCount();
+    }
+    return count;
+}
+
+std::vector<std::shared_ptr<IOManager>> IOWorkBalancer::startIOThreads(
+    size_t count, std::vector<Thread>& threads) {
+    std::vector<std::shared_ptr<IOManager>> managers(count);
+    std::mutex mutex;
+    std::condition_variable cond;
+    size_t started = 0;
+
+    threads.reserve(threads.size() + count);
+    for (size_t i = 0; i < count; ++i) {
+        threads.emplace_back([&, i]() {
+            auto manager = IOManager::getThreadLocal();
+            {
+                // 持有锁通知, 构造函数返回后栈上的变量就失效了.
+                std::lock_guard<std::mutex> lock(mutex);
+                managers[i] = manager;
+                ++started;
+                cond.notify_one();
+            }
+            manager->run();
+        });
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [&]() { return started == count; });
+    return managers;
+}
+}  // namespace lon::io
@@ -7,13 +7,7 @@ namespace lon::io {
 PrioBlancer::PrioBlancer(std::vector<uint8_t> prio_threads_count) {
     prio_workers.resize(prio_threads_count.size());
     for (size_t i = 0; i < prio_threads_count.size(); ++i) {
-        for (size_t count = 0; count < prio_threads_count[i]; ++count) {
-            threads_.emplace_back([this, i]() {
-                    auto manager = IOManager::getThreadLocal();
-                    prio_workers[i].push_back(manager);
-                    manager->run();
-                });
-        }
+        prio_workers[i] = startIOThreads(prio_threads_count[i], threads_);
     }
 }
 
@@ -46,6 +40,14 @@ void PrioBlancer::schedule(coroutine::Executor::Ptr executor, const std::any& ar
     }
 }
 
+std::vector<std::shared_ptr<IOManager>> PrioBlancer::getIOManagers() const {
+    std::vector<std::shared_ptr<IOManager>> managers;
+    for (auto& workers : prio_workers) {
+        managers.insert(managers.end(), workers.begin(), workers.end());
+    }
+    return managers;
+}
+
 PrioBlancer::~PrioBlancer() {
     for (auto& thread : threads_) {
         thread.join();
@@ -7,6 +7,7 @@
 #include <stdlib.h>
 #include <cstring>
 #include <fmt/core.h>
+#include <vector>
 #include "coroutine/executor.h"
 
 namespace lon {
@@ -36,10 +37,9 @@ String getHostWithoutBuffer() {
 }
 
 bool backtraceStacks(std::vector<String>& stacks, int depth, int skip) {
-    std::unique_ptr<void*> frame(
-        static_cast<void**>(::malloc(sizeof(void*) * depth)));
-    int s          = ::backtrace(frame.get(), depth);
-    char** strings = ::backtrace_symbols(frame.get(), s);
+    std::vector<void*> frame(static_cast<size_t>(depth));
+    int s          = ::backtrace(frame.data(), depth);
+    char** strings = ::backtrace_symbols(frame.data(), s);
     if (strings) {
         for (int i = skip; i < s; ++i) {
             stacks.push_back(strings[i]);
@@ -51,10 +51,9 @@ bool backtraceStacks(std::vector<String>& stacks, int depth, int skip) {
 }
 
 String backtraceString(int depth, int skip) {
-    std::unique_ptr<void*> frame(
-        static_cast<void**>(::malloc(sizeof(void*) * depth)));
-    const int count      = ::backtrace(frame.get(), depth);
-    char** strings = ::backtrace_symbols(frame.get(), count);
+    std::vector<void*> frame(static_cast<size_t>(depth));
+    const int count      = ::backtrace(frame.data(), depth);
+    char** strings = ::backtrace_symbols(frame.data(), count);
 
     std::string stack_string;
 
@@ -0,0 +1,400 @@
+#include "base/io_buffer.h"
+
+#include "base/buffer_pool.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace lon {
+
+namespace {
+// 当前线程的block缓存池, 指针本身没有析构函数, 缓存池析构以后被置空.
+thread_local BufferPool* t_block_pool    = nullptr;
+thread_local bool t_block_pool_destroyed = false;
+
+struct BlockPoolHolder
+{
+    BufferPool pool{IOBuffer::kBlockSize};
+
+    ~BlockPoolHolder() {
+        t_block_pool           = nullptr;
+        t_block_pool_destroyed = true;
+    }
+};
+
+/**
+ * @brief 线程退出时缓存池可能先于IOBuffer析构(比如静态的IOBuffer, 或者在其它thread_local的析构中释放),
+ * 之后返回nullptr, block直接malloc/free.
+ */
+BufferPool* blockPool() {
+    if (LIKELY(t_block_pool != nullptr))
+        return t_block_pool;
+    if (t_block_pool_destroyed)
+        return nullptr;
+    thread_local BlockPoolHolder holder;
+    t_block_pool = &holder.pool;
+    return t_block_pool;
+}
+
+char* allocateBlock() {
+    if (auto pool = blockPool())
+        return pool->acquire();
+    auto block = static_cast<char*>(::malloc(IOBuffer::kBlockSize));
+    if (!block)
+        throw std::bad_alloc();
+    return block;
+}
+}  // namespace
+
+struct IOBuffer::Block
+{
+    char* data;
+
+    Block() : data{allocateBlock()} {}
+
+    // block可能在其它线程释放, 此时归还给释放线程的缓存池.
+    ~Block() {
+        if (auto pool = blockPool())
+            pool->release(data);
+        else
+            ::free(data);
+    }
+
+    Block(const Block&)                    = delete;
+    auto operator=(const Block&) -> Block& = delete;
+};
+
+namespace {
+// 已经读完的segment超过这个数量并且超过一半时才移动数组.
+constexpr size_t kCompactThreshold = 16;
+}  // namespace
+
+IOBuffer::IOBuffer(IOBuffer&& _other) noexcept
+    : segments_{std::move(_other.segments_)},
+      head_{_other.head_},
+      size_{_other.size_},
+      prepared_index_{_other.prepared_index_} {
+    _other.segments_.clear();
+    _other.head_           = 0;
+    _other.size_           = 0;
+    _other.prepared_index_ = 0;
+}
+
+auto IOBuffer::operator=(IOBuffer&& _other) noexcept -> IOBuffer& {
+    if (this != &_other) {
+        segments_        = std::move(_other.segments_);
+        head_            = _other.head_;
+        size_            = _other.size_;
+        prepared_index_  = _other.prepared_index_;
+        _other.segments_.clear();
+        _other.head_           = 0;
+        _other.size_           = 0;
+        _other.prepared_index_ = 0;
+    }
+    return *this;
+}
+
+bool IOBuffer::tailWritable() const noexcept {
+    return segments_.size() > head_ && segments_.back().block.use_count() == 1 &&
+           segments_.back().end < kBlockSize;
+}
+
+size_t IOBuffer::writableBytes() const noexcept {
+    return tailWritable() ? kBlockSize - segments_.back().end : 0;
+}
+
+void IOBuffer::pushBlock(size_t begin) {
+    segments_.push_back(Segment{std::make_shared<Block>(), begin, begin});
+}
+
+void IOBuffer::popFront() noexcept {
+    segments_[head_++].block.reset();
+    if (head_ == segments_.size()) {
+        segments_.clear();
+        head_ = 0;
+    } else if (head_ >= kCompactThreshold && head_ * 2 >= segments_.size()) {
+        segments_.erase(segments_.begin(),
+                        segments_.begin() + static_cast<ptrdiff_t>(head_));
+        head_ = 0;
+    }
+}
+
+void IOBuffer::rewindIfEmpty() noexcept {
+    if (size_ != 0 || blockCount() == 0)
+        return;
+    if (blockCount() == 1 && segments_.back().block.use_count() == 1) {
+        segments_.back().begin = kPrependSize;
+        segments_.back().end   = kPrependSize;
+    } else {
+        // 保留的block还在被切分出去的数据使用.
+        clear();
+    }
+}
+
+void IOBuffer::append(const void* data, size_t len) {
+    rewindIfEmpty();
+    auto src = static_cast<const char*>(data);
+    while (len > 0) {
+        if (!tailWritable())
+            pushBlock(blockCount() == 0 ? kPrependSize : 0);
+        auto& tail = segments_.back();
+        const size_t n = std::min(len, kBlockSize - tail.end);
+        std::memcpy(tail.block->data + tail.end, src, n);
+        tail.end += n;
+        size_ += n;
+        src += n;
+        len -= n;
+    }
+}
+
+void IOBuffer::append(IOBuffer&& other) {
+    if (this == &other)
+        return;
+    if (size_ == 0)
+        clear();
+    for (size_t i = other.head_; i < other.segments_.size(); ++i) {
+        segments_.push_back(std::move(other.segments_[i]));
+    }
+    size_ += other.size_;
+    other.clear();
+}
+
+void IOBuffer::prepend(const void* data, size_t len) {
+    rewindIfEmpty();
+    auto src = static_cast<const char*>(data);
+    // 从后往前填充, 保证数据顺序.
+    while (len > 0) {
+        if (blockCount() == 0 || segments_[head_].begin == 0 ||
+            segments_[head_].block.use_count() != 1) {
+            Segment segment{std::make_shared<Block>(), kBlockSize, kBlockSize};
+            if (head_ > 0) {
+                segments_[--head_] = std::move(segment);
+            } else {
+                segments_.insert(segments_.begin(), std::move(segment));
+                ++prepared_index_;
+            }
+        }
+        auto& head = segments_[head_];
+        const size_t n = std::min(len, head.begin);
+        head.begin -= n;
+        std::memcpy(head.block->data + head.begin, src + len - n, n);
+        size_ += n;
+        len -= n;
+    }
+}
+
+size_t IOBuffer::copyTo(void* out, size_t len, size_t offset) const noexcept {
+    auto dst      = static_cast<char*>(out);
+    size_t copied = 0;
+    for (size_t i = head_; i < segments_.size() && copied < len; ++i) {
+        const auto& segment   = segments_[i];
+        const size_t seg_size = segment.size();
+        if (offset >= seg_size) {
+            offset -= seg_size;
+            continue;
+        }
+        const size_t n = std::min(len - copied, seg_size - offset);
+        std::memcpy(dst + copied, segment.block->data + segment.begin + offset, n);
+        copied += n;
+        offset = 0;
+    }
+    return copied;
+}
+
+size_t IOBuffer::read(void* out, size_t len) noexcept {
+    const size_t n = copyTo(out, len);
+    consume(n);
+    return n;
+}
+
+void IOBuffer::consume(size_t len) noexcept {
+    len = std::min(len, size_);
+    size_ -= len;
+    while (blockCount() > 0) {
+        auto& head = segments_[head_];
+        if (len < head.size()) {
+            head.begin += len;
+            return;
+        }
+        len -= head.size();
+        if (blockCount() == 1) {
+            // 保留最后一个block.
+            head.begin = head.end;
+            return;
+        }
+        popFront();
+    }
+}
+
+void IOBuffer::clear() noexcept {
+    segments_.clear();
+    head_           = 0;
+    size_           = 0;
+    prepared_index_ = 0;
+}
+
+IOBuffer IOBuffer::slice(size_t offset, size_t len) const {
+    IOBuffer result;
+    for (size_t i = head_; i < segments_.size() && len > 0; ++i) {
+        const auto& segment   = segments_[i];
+        const size_t seg_size = segment.size();
+        if (offset >= seg_size) {
+            offset -= seg_size;
+            continue;
+        }
+        const size_t n = std::min(len, seg_size - offset);
+        result.segments_.push_back(Segment{segment.block,
+                                           segment.begin + offset,
+                                           segment.begin + offset + n});
+        result.size_ += n;
+        len -= n;
+        offset = 0;
+    }
+    return result;
+}
+
+IOBuffer IOBuffer::split(size_t len) {
+    IOBuffer result;
+    splitTo(len, result);
+    return result;
+}
+
+void IOBuffer::splitTo(size_t len, IOBuffer& out) {
+    len = std::min(len, size_);
+    size_ -= len;
+    out.size_ += len;
+    while (len > 0) {
+        auto& head = segments_[head_];
+        if (len < head.size() || blockCount() == 1) {
+            // 切分点落在block中间, 或者是最后一个block时两边共享这个block.
+            const size_t n = std::min(len, head.size());
+            out.segments_.push_back(Segment{head.block, head.begin, head.begin + n});
+            head.begin += n;
+            break;
+        }
+        len -= head.size();
+        out.segments_.push_back(std::move(head));
+        popFront();
+    }
+}
+
+String IOBuffer::toString() const {
+    String result(size_, '\0');
+    copyTo(result.data(), size_);
+    return result;
+}
+
+StringPiece IOBuffer::front() const noexcept {
+    if (blockCount() == 0)
+        return {};
+    const auto& head = segments_[head_];
+    return {head.block->data + head.begin, head.size()};
+}
+
+bool IOBuffer::matchAt(size_t index, size_t offset, StringPiece needle) const noexcept {
+    size_t matched = 0;
+    for (; index < segments_.size() && matched < needle.size(); ++index) {
+        const auto& segment = segments_[index];
+        const size_t n = std::min(needle.size() - matched, segment.size() - offset);
+        if (std::memcmp(segment.block->data + segment.begin + offset,
+                        needle.data() + matched,
+                        n) != 0)
+            return false;
+        matched += n;
+        offset = 0;
+    }
+    return matched == needle.size();
+}
+
+ssize_t IOBuffer::find(StringPiece needle, size_t from) const noexcept {
+    if (needle.size() > size_ || from > size_ - needle.size())
+        return -1;
+    if (needle.empty())
+        return static_cast<ssize_t>(from);
+    size_t base = 0;  // 当前segment在buffer中的偏移.
+    for (size_t i = head_; i < segments_.size(); ++i) {
+        const auto& segment   = segments_[i];
+        const size_t seg_size = segment.size();
+        if (from >= base + seg_size) {
+            base += seg_size;
+            continue;
+        }
+        const char* data = segment.block->data + segment.begin;
+        size_t pos       = from > base ? from - base : 0;
+        while (pos < seg_size) {
+            auto hit = static_cast<const char*>(
+                std::memchr(data + pos, needle[0], seg_size - pos));
+            if (!hit)
+                break;
+            pos = static_cast<size_t>(hit - data);
+            if (base + pos + needle.size() > size_)
+                return -1;
+            if (matchAt(i, pos, needle))
+                return static_cast<ssize_t>(base + pos);
+            ++pos;
+        }
+        base += seg_size;
+    }
+    return -1;
+}
+
+size_t IOBuffer::peekIovec(iovec* iov, size_t max_iov) const noexcept {
+    size_t count = 0;
+    for (size_t i = head_; i < segments_.size() && count < max_iov; ++i) {
+        const auto& segment = segments_[i];
+        if (segment.size() == 0)
+            continue;
+        iov[count].iov_base = segment.block->data + segment.begin;
+        iov[count].iov_len  = segment.size();
+        ++count;
+    }
+    return count;
+}
+
+size_t IOBuffer::prepareIovec(iovec* iov, size_t max_iov, size_t min_bytes) {
+    if (max_iov == 0)
+        return 0;
+    rewindIfEmpty();
+    size_t count     = 0;
+    size_t available = 0;
+    if (tailWritable()) {
+        auto& tail      = segments_.back();
+        prepared_index_ = segments_.size() - 1;
+        iov[count].iov_base = tail.block->data + tail.end;
+        iov[count].iov_len  = kBlockSize - tail.end;
+        available += iov[count].iov_len;
+        ++count;
+    } else {
+        prepared_index_ = segments_.size();
+    }
+    while (available < min_bytes && count < max_iov) {
+        pushBlock(blockCount() == 0 ? kPrependSize : 0);
+        auto& tail          = segments_.back();
+        iov[count].iov_base = tail.block->data + tail.end;
+        iov[count].iov_len  = kBlockSize - tail.end;
+        available += iov[count].iov_len;
+        ++count;
+    }
+    return count;
+}
+
+void IOBuffer::commit(size_t len) noexcept {
+    size_ += len;
+    for (size_t i = prepared_index_; i < segments_.size() && len > 0; ++i) {
+        auto& segment  = segments_[i];
+        const size_t n = std::min(len, kBlockSize - segment.end);
+        segment.end += n;
+        len -= n;
+    }
+    trimTail();
+}
+
+void IOBuffer::trimTail() noexcept {
+    // buffer为空时保留一个block.
+    while (blockCount() > 1 && segments_.back().size() == 0) {
+        segments_.pop_back();
+    }
+    prepared_index_ = 0;
+}
+
+}  // namespace lon
@@ -24,6 +24,7 @@ namespace lon {
             if ((i + 1) < size) {
                 if (formatter_pattern[i + 1] == '%') {
                     nstr.append(1, '%');
+                    ++i;
                     continue;
                 }
             }
@@ -6,7 +6,7 @@
 #include <fmt/format.h>
 
 
-static auto G_logger = lon::LogManager::getInstance() -> getLogger("system");
+static lon::log::LoggerSlot G_logger{"system"};
 
 namespace lon {
 namespace coroutine {
@@ -1,6 +1,6 @@
 ﻿#include "coroutine/scheduler.h"
 
-static auto G_logger = lon::LogManager::getInstance()->getLogger("system");
+static lon::log::LoggerSlot G_logger{"system"};
 
 namespace lon::coroutine {
 thread_local std::shared_ptr<Scheduler> t_scheduler = nullptr;
@@ -31,16 +31,20 @@ bool Scheduler::addExecutor(Executor::Ptr executor) {
         return false; //拒绝继续添加任务.
 
     ready_executors_.push_back(executor);
+    queued_count_.fetch_add(1, std::memory_order_relaxed);
     return true;
 }
 
 void Scheduler::removeExecutor(Executor::Ptr executor) {
     auto iter = std::find(ready_executors_.begin(), ready_executors_.end(), executor);
-    if (iter != ready_executors_.end())
+    if (iter != ready_executors_.end()) {
         ready_executors_.erase(iter);
+        queued_count_.fetch_sub(1, std::memory_order_relaxed);
+    }
 }
 
 bool Scheduler::addRemoteExecutor(Executor::Ptr executor) {
+    queued_count_.fetch_add(1, std::memory_order_relaxed);
     return remote_tasks_.insertFront(executor);
 }
 
@@ -67,6 +71,7 @@ void Scheduler::threadScheduleFunc() {
             //尝试从当前线程的(就绪)任务队列中取出任务
             executor = ready_executors_.front();
             ready_executors_.pop_front();
+            queued_count_.fetch_sub(1, std::memory_order_relaxed);
         }
         if (executor == nullptr) {
             // 当前没有任务.
@@ -3,9 +3,10 @@
 namespace lon{
     struct GlobalIniter {
         GlobalIniter() {
-            void hook_init();
+            io::hook_init();
         }
     };
 
-    static GlobalIniter initer;
+    // 优先于其它编译单元的静态对象初始化, 保证hook的原始函数在任何调用前已经解析完成.
+    static GlobalIniter initer __attribute__((init_priority(101)));
 }
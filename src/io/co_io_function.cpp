@@ -6,10 +6,11 @@
 #include "io/io_manager.h"
 #include <fcntl.h>
 #include <sys/ioctl.h>
+#include <sys/stat.h>
 #include <typeinfo>
 
 namespace lon::io {
-static Logger::ptr G_Logger = LogManager::getInstance()->getLogger("system");
+static log::LoggerSlot G_Logger{"system"};
 
 void sleepInner(unsigned ms) {
     auto current    = coroutine::Executor::getCurrent();
@@ -19,7 +20,62 @@ void sleepInner(unsigned ms) {
     current->yield();
 }
 
-// TODO timeout.
+enum class WaitResult
+{
+    Ready,
+    Timeout,
+    Cancelled
+};
+
+/**
+ * @brief 挂起当前协程直到fd事件就绪, 超时或者被取消.
+ * 事件触发时IOManager已经移除了注册, 所以超时/取消只在事件仍然注册时生效, 保证协程只被恢复一次.
+ */
+static WaitResult waitEvent(int fd,
+                            IOManager::EventType event_type,
+                            size_t time_out_ms,
+                            Canceler* canceler) {
+    if (canceler && canceler->cancelled())
+        return WaitResult::Cancelled;
+
+    auto io_manager  = IOManager::getThreadLocal();
+    auto current     = coroutine::Executor::getCurrent();
+    auto result      = std::make_shared<WaitResult>(WaitResult::Ready);
+    std::weak_ptr<WaitResult> weak_result = result;
+
+    auto resume = [io_manager, fd, event_type, weak_result, current](
+                      WaitResult wait_result) {
+        auto locked_result = weak_result.lock();
+        if (!locked_result || !io_manager->hasEvent(fd, event_type))
+            return;
+        io_manager->removeEvent(fd, event_type);
+        *locked_result = wait_result;
+        // go back to waitEvent(return error)
+        io_manager->addExecutor(current);
+    };
+
+    //注册定时器, 超时执行
+    Timer::Ptr timer = nullptr;
+    if (time_out_ms != static_cast<size_t>(-1)) {
+        timer = std::make_shared<Timer>(
+            time_out_ms, [resume]() { resume(WaitResult::Timeout); });
+        io_manager->registerTimer(timer);
+    }
+    if (canceler) {
+        canceler->setOnCancel([resume]() { resume(WaitResult::Cancelled); });
+    }
+    io_manager->registerEvent(fd, event_type, current);
+
+    // 挂起协程
+    current->yield();
+
+    if (canceler)
+        canceler->clearOnCancel();
+    if (timer && *result != WaitResult::Timeout)
+        io_manager->cancelTimer(timer);
+    return *result;
+}
+
 template <typename FuncType, typename... Args>
 ssize_t ioInner(int fd,
                 IOManager::EventType event_type,
@@ -29,8 +85,6 @@ ssize_t ioInner(int fd,
     if (!context || !context->is_socket || context->is_user_non_block) {
         return func(fd, std::forward<Args>(args)...);
     } else {
-        auto io_manager = IOManager::getThreadLocal();
-
         size_t time_out_ms = 0;
         if (event_type == IOManager::Read) {
             time_out_ms = context->readTimeout;
@@ -46,38 +100,14 @@ ssize_t ioInner(int fd,
             }
             if (n_bytes == -1 && errno == EAGAIN) {
                 // exec failed.
-                auto time_out_ptr = std::make_shared<bool>(false);
-                std::weak_ptr<bool> time_out_weak_ptr = time_out_ptr;
-                auto current = coroutine::Executor::getCurrent();
-
-                //注册定时器, 超时执行
-                Timer::Ptr timer = std::make_shared<Timer>(
-                    time_out_ms,
-                    [io_manager, fd, event_type, time_out_weak_ptr, current]() {
-                        auto is_time_out = time_out_weak_ptr.lock();
-                        if (is_time_out && !*is_time_out) {
-                            io_manager->removeEvent(fd, event_type);
-                            *is_time_out = true;
-                        }
-                        
-                        // go back to ioInner(return error)
-                        io_manager->addExecutor(current);
-                    });
-                io_manager->registerTimer(timer);
-                io_manager->registerEvent(
-                    fd, event_type, current);
-
-                // 挂起协程
-                current->yield();
-
-                if (*time_out_ptr) {
+                if (waitEvent(fd, event_type, time_out_ms, nullptr) ==
+                    WaitResult::Timeout) {
                     LON_LOG_WARN(G_Logger)
                         << fmt::format("{} invoke timeout with fd:{}",
                                        typeid(func).name(),
                                        fd);
+                    errno = ETIMEDOUT;
                     return -1;
-                } else {
-                    io_manager->cancelTimer(timer);
                 }
             } else {
                 // 函数执行成功, (nonblock状态的阻塞函数的errno!=EAGAIN).
@@ -89,51 +119,83 @@ ssize_t ioInner(int fd,
 }
 
 unsigned co_sleep(unsigned seconds) {
-    hook_init();
     sleepInner(seconds * 1000);
     return 0;
 }
 
 int co_usleep(useconds_t usec) {
-    hook_init();
     sleepInner(usec / 1000);
     return 0;
 }
 
 int co_nanosleep(const timespec* req, [[maybe_unused]] timespec* rem) {
-    hook_init();
     unsigned ms =
         static_cast<unsigned>(req->tv_sec * 1000 + req->tv_nsec / 1000 / 1000);
     sleepInner(ms);
     return 0;
 }
 
+/**
+ * @brief 记录hook管理的socket, 用户在type/flags中指定的SOCK_NONBLOCK视为用户非阻塞.
+ */
+static void setSocketContext(int fd, bool user_non_block) {
+    FdContext context(true);
+    context.is_sys_non_block  = true;
+    context.is_user_non_block = user_non_block;
+    FdManager::getInstance()->setContext(fd, context);
+}
+
 int co_socket(int domain, int type, int protocol) {
-    hook_init();
-    int fd = socket_sys(domain, type, protocol);
+    // 直接在创建时设置O_NONBLOCK, 省去两次fcntl.
+    int fd = socket_sys(domain, type | SOCK_NONBLOCK, protocol);
     if (fd == -1)
         return fd;
-    int flags = fcntl_sys(fd, F_GETFL, 0);
-    if (!(flags & O_NONBLOCK)) {
-        fcntl_sys(fd, F_SETFL, flags | O_NONBLOCK);
-    }
-    FdContext context(true);
-    context.is_sys_non_block = true;
-    FdManager::getInstance()->setContext(fd, context);
+    setSocketContext(fd, type & SOCK_NONBLOCK);
     return fd;
 }
 
-int co_connect(int sockfd, const sockaddr* addr, socklen_t addrlen) {
-    hook_init();
-    auto context = FdManager::getInstance()->getContext(sockfd);
-    if (!context) {
-        errno = EBADF;
+int co_adoptSocket(int fd) {
+    struct stat file_stat {};
+    if (::fstat(fd, &file_stat) == -1)
+        return -1;
+    if (!S_ISSOCK(file_stat.st_mode)) {
+        errno = ENOTSOCK;
         return -1;
     }
+    // O_NONBLOCK属于打开的文件, 可能已经由发送方设置, 对于接收方来说仍然是阻塞语义.
+    const int flags = fcntl_sys(fd, F_GETFL);
+    if (flags == -1)
+        return -1;
+    if (!(flags & O_NONBLOCK) && fcntl_sys(fd, F_SETFL, flags | O_NONBLOCK) == -1)
+        return -1;
+    setSocketContext(fd, false);
+    return 0;
+}
 
-    if (!context->is_socket || context->is_user_non_block) {
+int co_connect(int sockfd, const sockaddr* addr, socklen_t addrlen) {
+    auto context = FdManager::getInstance()->getContext(sockfd);
+    // 与阻塞socket一致, connect的超时时间为SO_SNDTIMEO.
+    return co_connectWithTimeout(sockfd,
+                                 addr,
+                                 addrlen,
+                                 context ? context->writeTimeout
+                                         : static_cast<size_t>(-1));
+}
+
+int co_connectWithTimeout(int sockfd,
+                          const sockaddr* addr,
+                          socklen_t addrlen,
+                          size_t timeout_ms,
+                          Canceler* canceler) {
+    auto context = FdManager::getInstance()->getContext(sockfd);
+    // 非hook线程中创建的socket没有context, 保持原有的行为.
+    if (!context || !context->is_socket || context->is_user_non_block) {
         return connect_sys(sockfd, addr, addrlen);
     }
+    if (canceler && canceler->cancelled()) {
+        errno = ECANCELED;
+        return -1;
+    }
 
     {
         int ret = connect_sys(sockfd, addr, addrlen);
@@ -142,16 +204,22 @@ int co_connect(int sockfd, const sockaddr* addr, socklen_t addrlen) {
         }
     }
     // 下面意味着sockfd是非阻塞的, 并且没有成功连接,
-    // 那么协程主动让出执行权限(直到epoll触发).
-    auto io_manager = IOManager::getThreadLocal();
-    io_manager->registerEvent(
-        sockfd, IOManager::Write, coroutine::Executor::getCurrent());
-    coroutine::Executor::getCurrent()->yield();
+    // 那么协程主动让出执行权限(直到epoll触发, 超时或者取消).
+    switch (waitEvent(sockfd, IOManager::Write, timeout_ms, canceler)) {
+        case WaitResult::Timeout:
+            errno = ETIMEDOUT;
+            return -1;
+        case WaitResult::Cancelled:
+            errno = ECANCELED;
+            return -1;
+        case WaitResult::Ready:
+            break;
+    }
 
-    // yield返回的时候, 说明connect执行完成(失败).
+    // 可写说明connect执行完成(成功或者失败).
     int error     = 0;
     socklen_t len = sizeof(int);
-    if (-1 == getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &error, &len)) {
+    if (-1 == getsockopt_sys(sockfd, SOL_SOCKET, SO_ERROR, &error, &len)) {
         return -1;
     }
     if (!error) {
@@ -163,33 +231,46 @@ int co_connect(int sockfd, const sockaddr* addr, socklen_t addrlen) {
 }
 
 int co_accept(int s, sockaddr* addr, socklen_t* addrlen) {
-    hook_init();
-    int fd = static_cast<int>(
-        ioInner(s, IOManager::Read, accept_sys, addr, addrlen));
+    return co_accept4(s, addr, addrlen, 0);
+}
+
+int co_accept4(int s, sockaddr* addr, socklen_t* addrlen, int flags) {
+    int fd = static_cast<int>(ioInner(
+        s, IOManager::Read, accept4_sys, addr, addrlen, flags | SOCK_NONBLOCK));
     if (fd >= 0) {
-        int flags = fcntl_sys(fd, F_GETFL, 0);
-        if (!(flags & O_NONBLOCK)) {
-            fcntl_sys(fd, F_SETFL, flags | O_NONBLOCK);
-        }
-        FdContext context(true);
-        context.is_sys_non_block = true;
-        FdManager::getInstance()->setContext(fd, context);
+        setSocketContext(fd, flags & SOCK_NONBLOCK);
     }
     return fd;
 }
 
+int co_waitEvent(int fd, bool write, size_t timeout_ms, Canceler* canceler) {
+    switch (waitEvent(fd,
+                      write ? IOManager::Write : IOManager::Read,
+                      timeout_ms,
+                      canceler)) {
+        case WaitResult::Timeout:
+            errno = ETIMEDOUT;
+            return -1;
+        case WaitResult::Cancelled:
+            errno = ECANCELED;
+            return -1;
+        case WaitResult::Ready:
+            break;
+    }
+    return 0;
+}
+
 ssize_t co_read(int fd, void* buf, size_t count) {
-    hook_init();
     return ioInner(fd, IOManager::Read, read_sys, buf, count);
 }
 
 ssize_t co_readv(int fd, const iovec* iov, int iovcnt) {
-    hook_init();
     return ioInner(fd, IOManager::Read, readv_sys, iov, iovcnt);
 }
 
 ssize_t co_recv(int sockfd, void* buf, size_t len, int flags) {
-    hook_init();
+    if (flags & MSG_DONTWAIT)
+        return recv_sys(sockfd, buf, len, flags);
     return ioInner(sockfd, IOManager::Read, recv_sys, buf, len, flags);
 }
 
@@ -199,7 +280,8 @@ ssize_t co_recvfrom(int sockfd,
                     int flags,
                     sockaddr* src_addr,
                     socklen_t* addrlen) {
-    hook_init();
+    if (flags & MSG_DONTWAIT)
+        return recvfrom_sys(sockfd, buf, len, flags, src_addr, addrlen);
     return ioInner(sockfd,
                    IOManager::Read,
                    recvfrom_sys,
@@ -211,22 +293,31 @@ ssize_t co_recvfrom(int sockfd,
 }
 
 ssize_t co_recvmsg(int sockfd, msghdr* msg, int flags) {
-    hook_init();
+    if (flags & MSG_DONTWAIT)
+        return recvmsg_sys(sockfd, msg, flags);
     return ioInner(sockfd, IOManager::Read, recvmsg_sys, msg, flags);
 }
 
+int co_recvmmsg(int sockfd,
+                mmsghdr* msgvec,
+                unsigned int vlen,
+                int flags,
+                timespec* timeout) {
+    return static_cast<int>(ioInner(
+        sockfd, IOManager::Read, recvmmsg_sys, msgvec, vlen, flags, timeout));
+}
+
 ssize_t co_write(int fd, const void* buf, size_t count) {
-    hook_init();
     return ioInner(fd, IOManager::Write, write_sys, buf, count);
 }
 
 ssize_t co_writev(int fd, const iovec* iov, int iovcnt) {
-    hook_init();
     return ioInner(fd, IOManager::Write, writev_sys, iov, iovcnt);
 }
 
 ssize_t co_send(int s, const void* msg, size_t len, int flags) {
-    hook_init();
+    if (flags & MSG_DONTWAIT)
+        return send_sys(s, msg, len, flags);
     return ioInner(s, IOManager::Write, send_sys, msg, len, flags);
 }
 
@@ -236,17 +327,27 @@ ssize_t co_sendto(int s,
                   int flags,
                   const sockaddr* to,
                   socklen_t tolen) {
-    hook_init();
+    if (flags & MSG_DONTWAIT)
+        return sendto_sys(s, msg, len, flags, to, tolen);
     return ioInner(s, IOManager::Write, sendto_sys, msg, len, flags, to, tolen);
 }
 
 ssize_t co_sendmsg(int s, const msghdr* msg, int flags) {
-    hook_init();
+    if (flags & MSG_DONTWAIT)
+        return sendmsg_sys(s, msg, flags);
     return ioInner(s, IOManager::Write, sendmsg_sys, msg, flags);
 }
 
+int co_sendmmsg(int sockfd, mmsghdr* msgvec, unsigned int vlen, int flags) {
+    return static_cast<int>(
+        ioInner(sockfd, IOManager::Write, sendmmsg_sys, msgvec, vlen, flags));
+}
+
+ssize_t co_sendfile(int out_fd, int in_fd, off_t* offset, size_t count) {
+    return ioInner(out_fd, IOManager::Write, sendfile_sys, in_fd, offset, count);
+}
+
 int co_close(int fd) {
-    hook_init();
     if (FdManager::getInstance()->hasFd(fd)) {
         IOManager::getThreadLocal()->removeEvent(
             fd, IOManager::Read | IOManager::Write);
@@ -256,7 +357,6 @@ int co_close(int fd) {
 }
 
 int co_fcntl(int fd, int cmd, ...) {
-    hook_init();
     va_list vas;
     va_start(vas, cmd);
     switch (cmd) {
@@ -264,7 +364,7 @@ int co_fcntl(int fd, int cmd, ...) {
             int arg1 = va_arg(vas, int);
             va_end(vas);
             auto context = FdManager::getInstance()->getContext(fd);
-            if (!context || context->is_socket) {
+            if (!context || !context->is_socket) {
                 return fcntl_sys(fd, F_SETFL, arg1);
             }
             // 对于socket类型, 用户自己如果需要O_NONBLOCK,
@@ -281,7 +381,7 @@ int co_fcntl(int fd, int cmd, ...) {
             va_end(vas);
             int raw_result = fcntl_sys(fd, F_GETFL);
             auto context   = FdManager::getInstance()->getContext(fd);
-            if (!context || context->is_socket) {
+            if (!context || !context->is_socket) {
                 return raw_result;
             }
             if (context->is_user_non_block) {
@@ -349,7 +449,6 @@ int co_fcntl(int fd, int cmd, ...) {
 }
 
 int co_ioctl(int d, unsigned long request, ...) {
-    hook_init();
     va_list va;
     va_start(va, request);
     void* arg = va_arg(va, void*);
@@ -368,13 +467,11 @@ int co_ioctl(int d, unsigned long request, ...) {
 
 int co_getsockopt(
     int sockfd, int level, int optname, void* optval, socklen_t* optlen) {
-    hook_init();
     return getsockopt_sys(sockfd, level, optname, optval, optlen);
 }
 
 int co_setsockopt(
     int sockfd, int level, int optname, const void* optval, socklen_t optlen) {
-    hook_init();
     if (level == SOL_SOCKET) {
         if (optname == SO_RCVTIMEO || optname == SO_SNDTIMEO) {
             auto context = FdManager::getInstance()->getContext(sockfd);
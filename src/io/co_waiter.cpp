@@ -0,0 +1,57 @@
+#include "io/co_waiter.h"
+
+#include "io/io_manager.h"
+
+namespace lon::io {
+
+CoWaiter::Result CoWaiter::wait(size_t timeout_ms, Canceler* canceler) {
+    if (canceler && canceler->cancelled())
+        return Result::Cancelled;
+
+    auto io_manager = IOManager::getThreadLocal();
+    auto state      = std::make_shared<State>();
+    state->executor = coroutine::Executor::getCurrent();
+    state->waiting  = true;
+    state_          = state;
+
+    // 超时, 取消, notify三者只有第一个生效.
+    std::weak_ptr<State> weak_state = state;
+    auto resume                     = [io_manager, weak_state](Result result) {
+        auto locked_state = weak_state.lock();
+        if (!locked_state || !locked_state->waiting)
+            return;
+        locked_state->waiting = false;
+        locked_state->result  = result;
+        io_manager->addExecutor(locked_state->executor);
+    };
+
+    Timer::Ptr timer = nullptr;
+    if (timeout_ms != static_cast<size_t>(-1)) {
+        timer = std::make_shared<Timer>(timeout_ms,
+                                        [resume]() { resume(Result::Timeout); });
+        io_manager->registerTimer(timer);
+    }
+    if (canceler) {
+        canceler->setOnCancel([resume]() { resume(Result::Cancelled); });
+    }
+
+    state->executor->yield();
+
+    if (canceler)
+        canceler->clearOnCancel();
+    if (timer && state->result != Result::Timeout)
+        io_manager->cancelTimer(timer);
+    state_ = nullptr;
+    return state->result;
+}
+
+bool CoWaiter::notify() {
+    if (!state_ || !state_->waiting)
+        return false;
+    state_->waiting = false;
+    state_->result  = Result::Notified;
+    IOManager::getThreadLocal()->addExecutor(state_->executor);
+    return true;
+}
+
+}  // namespace lon::io
@@ -7,15 +7,34 @@
 #include <iostream>
 #include <stdarg.h>
 
-bool G_hookEnabled = true;
-bool G_hookInited  = false;
+bool G_hookInited = false;
+
+// hook以线程为单位开启, 非IOManager线程(比如日志的异步flush线程)默认直接走系统调用.
+static thread_local bool t_hook_enabled  = false;
+// 用户是否显式设置过本线程的hook, 显式设置优先于IOManager的默认开启.
+static thread_local bool t_hook_user_set = false;
 
 void lon::io::setHookEnabled(bool enable) {
-    G_hookEnabled = enable;
+    t_hook_enabled  = enable;
+    t_hook_user_set = true;
 }
 
 bool lon::io::isHookEnabled() {
-    return G_hookEnabled;
+    return t_hook_enabled;
+}
+
+void lon::io::enableThreadHookByDefault() {
+    if (!t_hook_user_set)
+        t_hook_enabled = true;
+}
+
+
+/**
+ * @brief 初始化完成以后只是一个可预测的分支.
+ */
+static inline void ensureHookInited() {
+    if (UNLIKELY(!G_hookInited))
+        lon::io::hook_init();
 }
 
 
@@ -26,16 +45,20 @@ bool lon::io::isHookEnabled() {
     OP(socket)       \
     OP(connect)      \
     OP(accept)       \
+    OP(accept4)      \
     OP(read)         \
     OP(readv)        \
     OP(recv)         \
     OP(recvfrom)     \
     OP(recvmsg)      \
+    OP(recvmmsg)     \
     OP(write)        \
     OP(writev)       \
     OP(send)         \
     OP(sendto)       \
     OP(sendmsg)      \
+    OP(sendmmsg)     \
+    OP(sendfile)     \
     OP(close)        \
     OP(fcntl)        \
     OP(ioctl)        \
@@ -45,6 +68,8 @@ bool lon::io::isHookEnabled() {
 void lon::io::hook_init() {
     if (LIKELY(G_hookInited))
         return;
+    // 正常情况下在静态初始化阶段已经完成(see initer.cpp), 每个hook函数开头的ensureHookInited
+    // 是其它so的构造函数或者更早的静态初始化中调用被hook函数时的兜底.
 
 #define HOOK(name) \
     name##_sys = reinterpret_cast<name##_fun>(dlsym(RTLD_NEXT, #name));
@@ -61,22 +86,24 @@ HOOK_FUN(FUNC_INIT)
 
 // sleep
 unsigned int sleep(unsigned int seconds) {
-    lon::io::hook_init();
-    if (!lon::io::isHookEnabled())
+    ensureHookInited();
+    if (!t_hook_enabled)
         return sleep_sys(seconds);
     return lon::io::co_sleep(seconds);
 }
 
 
 int usleep(useconds_t usec) {
-    lon::io::hook_init();
+    ensureHookInited();
+    if (!t_hook_enabled)
+        return usleep_sys(usec);
     return lon::io::co_usleep(usec);
 }
 
 
 int nanosleep(const struct timespec* req, struct timespec* rem) {
-    lon::io::hook_init();
-    if (!lon::io::isHookEnabled())
+    ensureHookInited();
+    if (!t_hook_enabled)
         return nanosleep_sys(req, rem);
     return lon::io::co_nanosleep(req, rem);
 }
@@ -84,49 +111,57 @@ int nanosleep(const struct timespec* req, struct timespec* rem) {
 
 // socket
 int socket(int domain, int type, int protocol) {
-    lon::io::hook_init();
-    if (!lon::io::isHookEnabled())
+    ensureHookInited();
+    if (!t_hook_enabled)
         return socket_sys(domain, type, protocol);
     return lon::io::co_socket(domain, type, protocol);
 }
 
 
 int connect(int sockfd, const struct sockaddr* addr, socklen_t addrlen) {
-    lon::io::hook_init();
-    if (!lon::io::isHookEnabled())
+    ensureHookInited();
+    if (!t_hook_enabled)
         return connect_sys(sockfd, addr, addrlen);
     return lon::io::co_connect(sockfd, addr, addrlen);
 }
 
 
 int accept(int s, struct sockaddr* addr, socklen_t* addrlen) {
-    lon::io::hook_init();
-    if (!lon::io::isHookEnabled())
+    ensureHookInited();
+    if (!t_hook_enabled)
         return accept_sys(s, addr, addrlen);
     return lon::io::co_accept(s, addr, addrlen);
 }
 
 
+int accept4(int s, struct sockaddr* addr, socklen_t* addrlen, int flags) {
+    ensureHookInited();
+    if (!t_hook_enabled)
+        return accept4_sys(s, addr, addrlen, flags);
+    return lon::io::co_accept4(s, addr, addrlen, flags);
+}
+
+
 // read
 ssize_t read(int fd, void* buf, size_t count) {
-    lon::io::hook_init();
-    if (!lon::io::isHookEnabled())
+    ensureHookInited();
+    if (!t_hook_enabled)
         return read_sys(fd, buf, count);
     return lon::io::co_read(fd, buf, count);
 }
 
 
 ssize_t readv(int fd, const struct iovec* iov, int iovcnt) {
-    lon::io::hook_init();
-    if (!lon::io::isHookEnabled())
+    ensureHookInited();
+    if (!t_hook_enabled)
         return readv_sys(fd, iov, iovcnt);
     return lon::io::co_readv(fd, iov, iovcnt);
 }
 
 
 ssize_t recv(int sockfd, void* buf, size_t len, int flags) {
-    lon::io::hook_init();
-    if (!lon::io::isHookEnabled())
+    ensureHookInited();
+    if (!t_hook_enabled)
         return recv_sys(sockfd, buf, len, flags);
     return lon::io::co_recv(sockfd, buf, len, flags);
 }
@@ -138,40 +173,54 @@ ssize_t recvfrom(int sockfd,
                  int flags,
                  struct sockaddr* src_addr,
                  socklen_t* addrlen) {
-    lon::io::hook_init();
-    if (!lon::io::isHookEnabled())
+    ensureHookInited();
+    if (!t_hook_enabled)
         return recvfrom_sys(sockfd, buf, len, flags, src_addr, addrlen);
     return lon::io::co_recvfrom(sockfd, buf, len, flags, src_addr, addrlen);
 }
 
 
 ssize_t recvmsg(int sockfd, struct msghdr* msg, int flags) {
-    lon::io::hook_init();
-    if (!lon::io::isHookEnabled())
+    ensureHookInited();
+    if (!t_hook_enabled)
         return recvmsg_sys(sockfd, msg, flags);
     return lon::io::co_recvmsg(sockfd, msg, flags);
 }
 
 
+int recvmmsg(int sockfd,
+             struct mmsghdr* msgvec,
+             unsigned int vlen,
+             int flags,
+             struct timespec* timeout) {
+    ensureHookInited();
+    if (!t_hook_enabled)
+        return recvmmsg_sys(sockfd, msgvec, vlen, flags, timeout);
+    return lon::io::co_recvmmsg(sockfd, msgvec, vlen, flags, timeout);
+}
+
+
 // write
 ssize_t write(int fd, const void* buf, size_t count) {
-    lon::io::hook_init();
-    if (!lon::io::isHookEnabled())
+    ensureHookInited();
+    if (!t_hook_enabled)
         return write_sys(fd, buf, count);
     return lon::io::co_write(fd, buf, count);
 }
 
 
 ssize_t writev(int fd, const struct iovec* iov, int iovcnt) {
-    lon::io::hook_init();
-    if (!lon::io::isHookEnabled())
+    ensureHookInited();
+    if (!t_hook_enabled)
         return writev_sys(fd, iov, iovcnt);
     return lon::io::co_writev(fd, iov, iovcnt);
 }
 
 
 ssize_t send(int s, const void* msg, size_t len, int flags) {
-    lon::io::hook_init();
+    ensureHookInited();
+    if (!t_hook_enabled)
+        return send_sys(s, msg, len, flags);
     return lon::io::co_send(s, msg, len, flags);
 }
 
@@ -182,55 +231,74 @@ ssize_t sendto(int s,
                int flags,
                const struct sockaddr* to,
                socklen_t tolen) {
-    lon::io::hook_init();
-    if (!lon::io::isHookEnabled())
+    ensureHookInited();
+    if (!t_hook_enabled)
         return sendto_sys(s, msg, len, flags, to, tolen);
     return lon::io::co_sendto(s, msg, len, flags, to, tolen);
 }
 
 
 ssize_t sendmsg(int s, const struct msghdr* msg, int flags) {
-    lon::io::hook_init();
-    if (!lon::io::isHookEnabled())
+    ensureHookInited();
+    if (!t_hook_enabled)
         return sendmsg_sys(s, msg, flags);
     return lon::io::co_sendmsg(s, msg, flags);
 }
 
 
+int sendmmsg(int sockfd, struct mmsghdr* msgvec, unsigned int vlen, int flags) {
+    ensureHookInited();
+    if (!t_hook_enabled)
+        return sendmmsg_sys(sockfd, msgvec, vlen, flags);
+    return lon::io::co_sendmmsg(sockfd, msgvec, vlen, flags);
+}
+
+
+ssize_t sendfile(int out_fd, int in_fd, off_t* offset, size_t count) {
+    ensureHookInited();
+    if (!t_hook_enabled)
+        return sendfile_sys(out_fd, in_fd, offset, count);
+    return lon::io::co_sendfile(out_fd, in_fd, offset, count);
+}
+
+
 int close(int fd) {
-    lon::io::hook_init();
-    if (!lon::io::isHookEnabled())
+    ensureHookInited();
+    if (!t_hook_enabled)
         return close_sys(fd);
     return lon::io::co_close(fd);
 }
 
 
 int fcntl(int fd, int cmd, ... /* arg */) {
-    lon::io::hook_init();
-    int ret = 0;
     va_list args;
     va_start(args, cmd);
-    ret = lon::io::co_fcntl(fd, cmd, args);
+    // fcntl的第三个参数只有int或者指针两种, 以指针宽度取出转发即可.
+    void* arg = va_arg(args, void*);
     va_end(args);
-    return ret;
+    ensureHookInited();
+    if (!t_hook_enabled)
+        return fcntl_sys(fd, cmd, arg);
+    return lon::io::co_fcntl(fd, cmd, arg);
 }
 
 
 int ioctl(int d, unsigned long int request, ...) {
-    lon::io::hook_init();
-    int ret = 0;
     va_list args;
     va_start(args, request);
-    ret = lon::io::co_ioctl(d, request, args);
+    void* arg = va_arg(args, void*);
     va_end(args);
-    return ret;
+    ensureHookInited();
+    if (!t_hook_enabled)
+        return ioctl_sys(d, request, arg);
+    return lon::io::co_ioctl(d, request, arg);
 }
 
 
 int getsockopt(
     int sockfd, int level, int optname, void* optval, socklen_t* optlen) {
-    lon::io::hook_init();
-    if (!lon::io::isHookEnabled())
+    ensureHookInited();
+    if (!t_hook_enabled)
         return getsockopt_sys(sockfd, level, optname, optval, optlen);
     return lon::io::co_getsockopt(sockfd, level, optname, optval, optlen);
 }
@@ -238,8 +306,8 @@ int getsockopt(
 
 int setsockopt(
     int sockfd, int level, int optname, const void* optval, socklen_t optlen) {
-    lon::io::hook_init();
-    if (!lon::io::isHookEnabled())
+    ensureHookInited();
+    if (!t_hook_enabled)
         return setsockopt_sys(sockfd, level, optname, optval, optlen);
     return lon::io::co_setsockopt(sockfd, level, optname, optval, optlen);
 }
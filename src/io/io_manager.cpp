@@ -14,7 +14,7 @@ thread_local std::shared_ptr<IOManager> t_io_manager = nullptr;
 
 constexpr int epoll_create_size   = 1000;
 constexpr int epoll_wait_max_size = 64;
-static Logger::ptr G_Logger = LogManager::getInstance()->getLogger("system");
+static log::LoggerSlot G_Logger{"system"};
 
 IOManager::IOManager() : scheduler_{} {
     scheduler_.setExitWithTasksProcessed(true);
@@ -31,9 +31,8 @@ bool IOManager::registerEvent(int fd,
     if (UNLIKELY(stopped))
         return false;
     if (static_cast<size_t>(fd) >= fd_events_.size()) {
-        // fd_events_.resize(static_cast<size_t>(fd));
-
-        fd_events_.resize(static_cast<size_t>(fd * 1.5));
+        fd_events_.resize(std::max(static_cast<size_t>(fd) + 1,
+                                   static_cast<size_t>(fd * 1.5)));
     }
 
     auto epAdd = [fd, type, this]() {
@@ -74,7 +73,7 @@ void IOManager::removeEvent(int fd, uint32_t events) {
     if (static_cast<size_t>(fd) >= fd_events_.size() || !(fd_events_[fd].registered_events & events)) {
         return;
     }
-    const uint32_t events_dst = ~fd_events_[fd].registered_events & events;
+    const uint32_t events_dst = fd_events_[fd].registered_events & ~events;
 
 
     if (events_dst) {
@@ -82,6 +81,7 @@ void IOManager::removeEvent(int fd, uint32_t events) {
     } else {
         epollDel(fd);
     }
+    fd_events_[fd].registered_events = events_dst;
     if (!(events_dst & Read)) {
         fd_events_[fd].read_executor = nullptr;
     }
@@ -188,54 +188,63 @@ void IOManager::blockPending() {
             while (read(wakeup_pipe_fd_[0], dummy, sizeof(dummy)) > 0);
             continue;
         } else {
+            FdEvents& fd_events = fd_events_[ep_event.data.fd];
+            // EPOLLERR/EPOLLHUP 视为读写事件同时触发, 只处理已注册的一方.
+            const bool read_triggered =
+                (ep_event.events & (EPOLLIN | EPOLLERR | EPOLLHUP)) &&
+                (fd_events.registered_events & EPOLLIN);
+            const bool write_triggered =
+                (ep_event.events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) &&
+                (fd_events.registered_events & EPOLLOUT);
+
             {// 删除事件.
-                uint32_t left_events = fd_events_[ep_event.data.fd].registered_events;
+                uint32_t left_events = fd_events.registered_events;
 
-                if (ep_event.events & EPOLLIN) {
-                    if (fd_events_[epoll_events->data.fd].read_call_once) {
+                if (read_triggered) {
+                    if (fd_events.read_call_once) {
                         left_events &= ~EPOLLIN;
                     }
                     else {
-                        fd_events_[epoll_events->data.fd].read_executor->reuse();
+                        fd_events.read_executor->reuse();
                     }
                 }
-                if (ep_event.events & EPOLLOUT) {
-                    if (fd_events_[epoll_events->data.fd].write_call_once) {
+                if (write_triggered) {
+                    if (fd_events.write_call_once) {
                         left_events &= ~EPOLLOUT;
                     }
                     else {
-                        fd_events_[epoll_events->data.fd].write_executor->reuse();
+                        fd_events.write_executor->reuse();
                     }
                 }
 
-                if(left_events != fd_events_[ep_event.data.fd].registered_events) {
+                if(left_events != fd_events.registered_events) {
                     if (left_events) {
                         epollMod(ep_event.data.fd, left_events);
                     }
                     else {
                         epollDel(ep_event.data.fd);
                     }
-                    fd_events_[ep_event.data.fd].registered_events = left_events;
+                    fd_events.registered_events = left_events;
                 }
                 
             }
             // enqueue executor.
             // addExecutor 必定成功.
-            if (ep_event.events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+            if (read_triggered && fd_events.read_executor) {
                 [[maybe_unused]] bool add_ret = scheduler_.addExecutor(
-                    fd_events_[ep_event.data.fd].read_executor);
+                    fd_events.read_executor);
 
-                if (fd_events_[ep_event.data.fd].read_call_once) {
-                    fd_events_[ep_event.data.fd].read_executor = nullptr;
+                if (fd_events.read_call_once) {
+                    fd_events.read_executor = nullptr;
                 }
                 assert(add_ret);
             }
-            if (ep_event.events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+            if (write_triggered && fd_events.write_executor) {
                 [[maybe_unused]] bool add_ret = scheduler_.addExecutor(
-                    fd_events_[ep_event.data.fd].write_executor);
+                    fd_events.write_executor);
 
-                if (fd_events_[ep_event.data.fd].write_call_once) {
-                    fd_events_[ep_event.data.fd].write_executor = nullptr;
+                if (fd_events.write_call_once) {
+                    fd_events.write_executor = nullptr;
                 }
                 assert(add_ret);
             }
@@ -7,11 +7,73 @@
 
 #include "base.h"
 #include "logging/logger_data_convert.h"
+#include <atomic>
+#include <fcntl.h>
+#include <sys/syscall.h>
 #include <fmt/core.h>
 #include <iostream>
 
 namespace lon {
 
+namespace {
+std::atomic<uint64_t> G_logger_id{0};
+
+// 级别重新加载的pipe, 信号处理函数只能使用async-signal-safe的write.
+int G_reload_pipe[2] = {-1, -1};
+
+void onReloadSignal(int) {
+    const int saved_errno = errno;
+    const char c          = 0;
+    // 直接发起系统调用: hook的write在IOManager线程中会获取FdManager的锁, 在信号处理函数中可能死锁.
+    [[maybe_unused]] const long n = ::syscall(SYS_write, G_reload_pipe[1], &c, 1);
+    errno = saved_errno;
+}
+
+/**
+ * @brief file以suffix结尾, 并且suffix从路径的一个分量开始.
+ */
+bool matchFile(StringPiece file, StringPiece suffix) noexcept {
+    if (suffix.empty() || file.size() < suffix.size() ||
+        file.substr(file.size() - suffix.size()) != suffix)
+        return false;
+    return file.size() == suffix.size() || file[file.size() - suffix.size() - 1] == '/';
+}
+
+struct LevelOverrides
+{
+    std::unordered_map<String, Level> modules;
+    std::vector<std::pair<String, Level>> files;
+};
+
+/**
+ * @brief 读取配置中的"log_levels": {"modules": {name: level}, "files": {file: level}}, 忽略未知的级别.
+ */
+LevelOverrides readLevelOverrides(JsonConfig& config, const String& source) {
+    LevelOverrides overrides;
+    auto parse = [&source](const String& key, const String& value, Level& level) {
+        level = Logger::levelFromString(value);
+        if (level != Level::SIZE)
+            return true;
+        std::cerr << fmt::format("unknown log level {}:{} in {}\n", key, value, source);
+        return false;
+    };
+    Level level;
+    for (auto& [module, value] :
+         config.getIfExists<std::unordered_map<String, String>>("log_levels.modules", {})) {
+        if (parse(module, value, level))
+            overrides.modules[module] = level;
+    }
+    for (auto& [file, value] :
+         config.getIfExists<std::unordered_map<String, String>>("log_levels.files", {})) {
+        if (parse(file, value, level))
+            overrides.files.emplace_back(file, level);
+    }
+    return overrides;
+}
+}  // namespace
+
+Logger::Logger(const String& name) : id_{++G_logger_id}, name_{name} {}
+
 
 Level Logger::levelFromString(StringPiece str) noexcept {
     std::string str_upper;
@@ -34,13 +96,18 @@ Level Logger::levelFromString(StringPiece str) noexcept {
 }
 
 
-LogWrapper::LogWrapper(std::shared_ptr<Logger> _logger_ptr, LogEvent _event)
-    : stream{}, logger_ptr{_logger_ptr}, event{std::move(_event)} {}
+LogWrapper::LogWrapper(std::shared_ptr<Logger> _logger_ptr, LogEvent _event, uint64_t suppressed)
+    : stream{}, logger_ptr{std::move(_logger_ptr)}, event{std::move(_event)} {
+    logger_ptr->beginLog(stream, &event);
+    message_begin = stream.size();
+    suppressed += logger_ptr->takeSuppressed();
+    if (UNLIKELY(suppressed > 0))
+        stream << "[suppressed " << suppressed << "] ";
+}
 
 LogWrapper::~LogWrapper() {
-    event.content = stream.str();
-    Level level   = event.level;
-    logger_ptr->log(&event);
+    Level level = event.level;
+    logger_ptr->endLog(stream, message_begin, &event);
     if (level == Level::FATAL) {
         abort();
     }
@@ -50,19 +117,117 @@ void Logger::log(LogEvent* event) noexcept {
     StringStream ss;
     event->logger_name      = name_;
     event->datetime_pattern = datetime_pattern_;
-    for (auto& i : formatters_) {
-        i(ss, event);
+    if (compiled_prefix_ != nullptr) {
+        compiled_prefix_(ss, event);
+        if (compiled_has_message_) {
+            ss << event->content;
+            compiled_suffix_(ss, event);
+        }
+    } else {
+        for (auto& i : formatters_) {
+            i(ss, event);
+        }
     }
     for (int i = 0; i < flusher_count_; ++i) {
         flushers_[static_cast<unsigned long>(i)]->flush(ss.getSlice());
     }
 }
 
+void Logger::write(StringPiece data) noexcept {
+    for (int i = 0; i < flusher_count_; ++i) {
+        flushers_[static_cast<unsigned long>(i)]->flush(data);
+    }
+}
+
+void Logger::beginLog(StringStream& stream, LogEvent* event) noexcept {
+    event->logger_name      = name_;
+    event->datetime_pattern = datetime_pattern_;
+    if (compiled_prefix_ != nullptr) {
+        compiled_prefix_(stream, event);
+        return;
+    }
+    for (size_t i = 0; i < message_index_; ++i) {
+        formatters_[i](stream, event);
+    }
+}
+
+void Logger::endLog(StringStream& stream, size_t message_begin, LogEvent* event) noexcept {
+    stream.endMessage();
+    event->content = stream.getSlice().substr(message_begin);
+    if (compiled_prefix_ != nullptr) {
+        if (compiled_has_message_)
+            compiled_suffix_(stream, event);
+        else
+            stream.resize(message_begin);
+    } else {
+        if (message_index_ == formatters_.size()) {
+            // pattern中没有%m, 丢弃消息体.
+            stream.resize(message_begin);
+        }
+        // 之后的%m从缓冲中前面的消息体拷贝, 缓冲扩展时旧的缓冲保留到日志结束, content一直有效.
+        for (size_t i = message_index_ + 1; i < formatters_.size(); ++i) {
+            formatters_[i](stream, event);
+        }
+    }
+    for (int i = 0; i < flusher_count_; ++i) {
+        flushers_[static_cast<unsigned long>(i)]->flush(stream.getSlice());
+    }
+}
+
 void Logger::registerUpdateFlusher() const {}
 
+void Logger::setLevel(Level level) {
+    level_.store(level, std::memory_order_relaxed);
+    if (managed_) {
+        auto* manager = LogManager::getInstance();
+        std::lock_guard<Mutex> locker{manager->mutex_};
+        manager->refreshLevelsLocked();
+    }
+}
+
+void Logger::setRateLimit(double lines_per_second, uint32_t burst) noexcept {
+    if (lines_per_second <= 0) {
+        rate_interval_ns_.store(0, std::memory_order_relaxed);
+        return;
+    }
+    const auto interval = std::max<int64_t>(1, static_cast<int64_t>(1e9 / lines_per_second));
+    rate_tolerance_ns_.store(interval * (std::max<uint32_t>(burst, 1) - 1), std::memory_order_relaxed);
+    rate_tat_ns_.store(0, std::memory_order_relaxed);
+    rate_interval_ns_.store(interval, std::memory_order_relaxed);
+}
+
+bool Logger::acquireSlow() noexcept {
+    const int64_t interval  = rate_interval_ns_.load(std::memory_order_relaxed);
+    const int64_t tolerance = rate_tolerance_ns_.load(std::memory_order_relaxed);
+    const int64_t now       = log::coarseMonotonicNs();
+    int64_t tat             = rate_tat_ns_.load(std::memory_order_relaxed);
+    do {
+        // 令牌用完: 理论到达时间超前当前时间超过burst条.
+        if (tat - now > tolerance) {
+            suppressed_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!rate_tat_ns_.compare_exchange_weak(
+        tat, std::max(tat, now) + interval, std::memory_order_relaxed));
+    return true;
+}
+
+void Logger::setCompiledFormatters(CompiledFormatterFunc prefix,
+                                   CompiledFormatterFunc suffix,
+                                   bool has_message) noexcept {
+    formatters_.clear();
+    message_index_        = 0;
+    compiled_prefix_      = prefix;
+    compiled_suffix_      = suffix;
+    compiled_has_message_ = has_message;
+}
+
 void Logger::setFormatters(const String& formatter_pattern) {
+    compiled_prefix_ = nullptr;
+    compiled_suffix_ = nullptr;
     if (!formatters_.empty())
         formatters_.clear();
+    message_index_ = static_cast<size_t>(-1);
 
     auto vec = logPatternParse(formatter_pattern);
 
@@ -72,7 +237,7 @@ void Logger::setFormatters(const String& formatter_pattern) {
     //%c 日志名称
     //%t 线程id
     //%n 回车换行
-    //%d 时间
+    //%d 时间, %d{pattern}中可以使用%3N(毫秒)/%6N(微秒)
     //%f 文件名
     //%l 行号
 
@@ -88,6 +253,11 @@ void Logger::setFormatters(const String& formatter_pattern) {
                 datetime_pattern_ = std::get<1>(i).empty()
                     ? "%Y-%m-%d %H:%M:%S"
                     : std::move(std::get<1>(i));
+                addOneFormatter(DateTimeLogFormatter(datetime_pattern_));
+                continue;
+            }
+            if (key == 'm' && message_index_ == static_cast<size_t>(-1)) {
+                message_index_ = formatters_.size();
             }
             auto formatter = LogFormatterFactory::getFormatter(key);
             if (formatter == nullptr) {
@@ -99,13 +269,163 @@ void Logger::setFormatters(const String& formatter_pattern) {
             }
         }
     }
+    if (message_index_ == static_cast<size_t>(-1))
+        message_index_ = formatters_.size();
 }
 
 _LogManager::_LogManager() {
     initDefaultLogger();
     initLoggerFromConfig();
+    // 构造期间调用setLevel时LogManager还不可用.
+    for (auto& [name, logger] : loggers_) {
+        logger->managed_ = true;
+    }
+}
+
+_LogManager::~_LogManager() {
+    if (reload_thread_.joinable()) {
+        // 关闭写端, 重新加载的线程读到EOF后退出.
+        const int fd      = G_reload_pipe[1];
+        G_reload_pipe[1] = -1;
+        ::close(fd);
+        reload_thread_.join();
+        ::close(G_reload_pipe[0]);
+    }
 }
 
+Logger::ptr _LogManager::getLogger(const String& key) {
+    // loggers_只在构造时修改.
+    if (auto iter = loggers_.find(key); iter != loggers_.end())
+        return iter->second;
+    return default_logger_;
+}
+
+void _LogManager::setModuleLevel(const String& module, Level level) {
+    std::lock_guard<Mutex> locker{mutex_};
+    module_levels_[module] = level;
+    refreshLevelsLocked();
+}
+
+void _LogManager::setFileLevel(const String& file, Level level) {
+    std::lock_guard<Mutex> locker{mutex_};
+    auto iter = std::find_if(file_levels_.begin(), file_levels_.end(), [&file](const auto& item) {
+        return item.first == file;
+    });
+    if (iter != file_levels_.end())
+        iter->second = level;
+    else
+        file_levels_.emplace_back(file, level);
+    refreshLevelsLocked();
+}
+
+void _LogManager::clearLevelOverrides() {
+    std::lock_guard<Mutex> locker{mutex_};
+    module_levels_.clear();
+    file_levels_.clear();
+    refreshLevelsLocked();
+}
+
+bool _LogManager::reloadLevels(const String& filename) {
+    std::vector<detail::LogConfigData> log_data;
+    LevelOverrides overrides;
+    try {
+        JsonConfig config(filename.c_str());
+        log_data = config.getIfExists<std::vector<detail::LogConfigData>>(
+            "logs", std::vector<detail::LogConfigData>{});
+        overrides = readLevelOverrides(config, filename);
+    } catch (const std::exception& e) {
+        std::cerr << fmt::format("reload log levels from {} failed: {}\n", filename, e.what());
+        return false;
+    }
+
+    std::lock_guard<Mutex> locker{mutex_};
+    for (auto& item : log_data) {
+        if (auto iter = loggers_.find(item.name); iter != loggers_.end() && item.level < Level::SIZE)
+            iter->second->level_.store(item.level, std::memory_order_relaxed);
+    }
+    module_levels_ = std::move(overrides.modules);
+    file_levels_   = std::move(overrides.files);
+    refreshLevelsLocked();
+    return true;
+}
+
+void _LogManager::installReloadSignal(int signo, const String& filename) {
+    {
+        std::lock_guard<Mutex> locker{mutex_};
+        reload_filename_ = filename;
+        if (!reload_thread_.joinable()) {
+            if (::pipe2(G_reload_pipe, O_CLOEXEC) != 0) {
+                std::cerr << fmt::format("create log reload pipe failed: {}\n", std::strerror(errno));
+                return;
+            }
+            // 信号过多时丢弃, 不阻塞信号处理函数.
+            ::fcntl(G_reload_pipe[1], F_SETFL, O_NONBLOCK);
+            reload_thread_ = Thread([this]() {
+                char buffer[64];
+                while (true) {
+                    const ssize_t n = ::read(G_reload_pipe[0], buffer, sizeof(buffer));
+                    if (n < 0 && errno == EINTR)
+                        continue;
+                    if (n <= 0)
+                        return;
+                    String reload_filename;
+                    {
+                        std::lock_guard<Mutex> reload_locker{mutex_};
+                        reload_filename = reload_filename_;
+                    }
+                    reloadLevels(reload_filename);
+                }
+            });
+        }
+    }
+    struct sigaction action {};
+    action.sa_handler = onReloadSignal;
+    ::sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    ::sigaction(signo, &action, nullptr);
+}
+
+void _LogManager::registerSlot(log::LoggerSlot* slot) {
+    std::lock_guard<Mutex> locker{mutex_};
+    slot->logger_ = getLogger(slot->name_).get();
+    slot->level_.store(slotLevelLocked(*slot), std::memory_order_relaxed);
+    slots_.push_back(slot);
+}
+
+void _LogManager::unregisterSlot(log::LoggerSlot* slot) {
+    std::lock_guard<Mutex> locker{mutex_};
+    slots_.erase(std::remove(slots_.begin(), slots_.end(), slot), slots_.end());
+}
+
+void _LogManager::refreshLevelsLocked() {
+    for (auto* slot : slots_) {
+        slot->level_.store(slotLevelLocked(*slot), std::memory_order_relaxed);
+    }
+}
+
+Level _LogManager::slotLevelLocked(const log::LoggerSlot& slot) const {
+    // 后设置的文件覆盖优先.
+    for (auto iter = file_levels_.rbegin(); iter != file_levels_.rend(); ++iter) {
+        if (matchFile(slot.file_, iter->first))
+            return iter->second;
+    }
+    if (auto iter = module_levels_.find(slot.name_); iter != module_levels_.end())
+        return iter->second;
+    return slot.logger_->getLevel();
+}
+
+namespace log {
+
+LoggerSlot::LoggerSlot(const String& name, const char* file) : logger_{nullptr}, name_{name}, file_{file} {
+    LogManager::getInstance()->registerSlot(this);
+}
+
+LoggerSlot::~LoggerSlot() {
+    LogManager::getInstance()->unregisterSlot(this);
+}
+
+}  // namespace log
+
 void _LogManager::initDefaultLogger() {
     auto ptr = std::make_shared<Logger>("root");
     ptr->setFormatters(
@@ -137,6 +457,8 @@ void _LogManager::initLoggerFromConfig() {
                 std::cerr << "flusher type error, type name:" << flusher.type;
             }
         }
+        if (item.level < Level::SIZE)
+            ptr->setLevel(item.level);
         loggers_[item.name] = ptr;
         if (item.name == "root") {
             // root logger in config will replace
@@ -144,6 +466,9 @@ void _LogManager::initLoggerFromConfig() {
             default_logger_ = ptr;
         }
     }
+    LevelOverrides overrides = readLevelOverrides(*BaseMainConfig::getInstance(), "conf/main.json");
+    module_levels_           = std::move(overrides.modules);
+    file_levels_             = std::move(overrides.files);
 }
 
 }  // namespace lon
@@ -4,58 +4,114 @@
 
 #include "logging/LogSStream.h"
 
+#include <charconv>
+
 namespace lon::log {
     thread_local LogSStreamBuf T_log_sstream;
 
 
-    const char digits[] = "9876543210123456789";
-    const char *zero = digits + 9;
-    static_assert(sizeof(digits) == 20, "wrong number of digits");
-
-    const char digitsHex[] = "0123456789ABCDEF";
-    static_assert(sizeof digitsHex == 17, "wrong number of digitsHex");
-
-// Efficient Integer to String Conversions, by Matthew Wilson.
-    template<typename T>
-    size_t convert(char buf[], T value) {
-        T i = value;
-        char *p = buf;
-
-        do {
-            int lsd = static_cast<int>(i % 10);
-            i /= 10;
-            *p++ = zero[lsd];
-        } while (i != 0);
+    namespace {
+        // 整数/浮点数/指针格式化以后的最大长度.
+        constexpr size_t kMaxNumericSize = 32;
+
+        const char digitPairs[] =
+            "0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+            "5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+        static_assert(sizeof(digitPairs) == 201, "wrong number of digitPairs");
+
+        const char digitsHex[] = "0123456789ABCDEF";
+        static_assert(sizeof digitsHex == 17, "wrong number of digitsHex");
+
+        inline size_t countDigits(uint64_t n) noexcept {
+            size_t count = 1;
+            while (true) {
+                if (n < 10) return count;
+                if (n < 100) return count + 1;
+                if (n < 1000) return count + 2;
+                if (n < 10000) return count + 3;
+                n /= 10000;
+                count += 4;
+            }
+        }
 
-        if (value < 0) {
-            *p++ = '-';
+        // 先计算位数, 然后从低位开始每次写入两位, 不需要reverse.
+        template<typename T>
+        size_t convert(char buf[], T value) {
+            if constexpr (std::is_same_v<T, bool>) {
+                buf[0] = value ? '1' : '0';
+                return 1;
+            } else {
+                uint64_t n = static_cast<uint64_t>(value);
+                size_t sign = 0;
+                if constexpr (std::is_signed_v<T>) {
+                    if (value < 0) {
+                        buf[0] = '-';
+                        n = 0 - n;
+                        sign = 1;
+                    }
+                }
+                const size_t length = sign + countDigits(n);
+                char *p = buf + length;
+                while (n >= 100) {
+                    const size_t i = static_cast<size_t>(n % 100) * 2;
+                    n /= 100;
+                    *--p = digitPairs[i + 1];
+                    *--p = digitPairs[i];
+                }
+                if (n < 10) {
+                    *--p = static_cast<char>('0' + n);
+                } else {
+                    const size_t i = static_cast<size_t>(n) * 2;
+                    *--p = digitPairs[i + 1];
+                    *--p = digitPairs[i];
+                }
+                return length;
+            }
         }
-        *p = '\0';
-        std::reverse(buf, p);
 
-        return static_cast<size_t>(p - buf);
-    }
+        size_t convertHex(char buf[], uint64_t value) {
+            size_t length = 1;
+            for (uint64_t i = value >> 4; i != 0; i >>= 4) {
+                ++length;
+            }
+            for (size_t i = length; i > 0; --i) {
+                buf[i - 1] = digitsHex[value & 0xF];
+                value >>= 4;
+            }
+            return length;
+        }
 
-    size_t convertHex(char buf[], uintptr_t value) {
-        uintptr_t i = value;
-        char *p = buf;
+        /**
+         * @brief 缓冲中有足够空间时直接格式化到末尾, 否则格式化到栈上再按照截断的规则写入.
+         */
+        template<typename Format>
+        LON_ALWAYS_INLINE void appendNumeric(Format &&format) {
+            if (char *tail = T_log_sstream.reserve(kMaxNumericSize)) {
+                T_log_sstream.pos_ += static_cast<int>(format(tail));
+            } else {
+                char buf[kMaxNumericSize];
+                T_log_sstream.append(buf, format(buf));
+            }
+        }
 
-        do {
-            int lsd = static_cast<int>(i % 16);
-            i /= 16;
-            *p++ = digitsHex[lsd];
-        } while (i != 0);
+        template<typename T>
+        size_t convertFloat(char buf[], T value) {
+            return static_cast<size_t>(std::to_chars(buf, buf + kMaxNumericSize, value).ptr - buf);
+        }
+    }  // namespace
 
-        *p = '\0';
-        std::reverse(buf, p);
 
-        return static_cast<size_t>(p - buf);
+    LogSStream::LogSStream() noexcept : begin_{T_log_sstream.pos_} {
+        if (begin_ != 0)
+            outer_ = T_log_sstream.beginMessage();
     }
 
-
-
     LogSStream::~LogSStream() {
-        T_log_sstream.free();
+        T_log_sstream.pos_ = begin_;
+        if (begin_ == 0)
+            T_log_sstream.reset();
+        else
+            T_log_sstream.restoreMessage(outer_);
     }
 
     void LogSStream::append(char c) noexcept {
@@ -64,7 +120,7 @@ namespace lon::log {
 
     template<typename T, typename>
     LogSStream &LogSStream::operator<<(const T &n) {
-        T_log_sstream.pos_ += static_cast<int>(convert(T_log_sstream.getTail(), n));
+        appendNumeric([n](char *buf) { return convert(buf, n); });
         return *this;
     }
 
@@ -79,15 +135,47 @@ namespace lon::log {
     }
 
     String LogSStream::str() {
-        return lon::String(T_log_sstream.buf_, static_cast<unsigned long>(T_log_sstream.pos_));
+        return lon::String(T_log_sstream.buf_ + begin_, size());
     }
 
     StringPiece LogSStream::getSlice() {
-        return lon::StringPiece(T_log_sstream.buf_, static_cast<unsigned long>(T_log_sstream.pos_));
+        return lon::StringPiece(T_log_sstream.buf_ + begin_, size());
+    }
+
+    size_t LogSStream::size() const noexcept {
+        return static_cast<size_t>(T_log_sstream.pos_ - begin_);
+    }
+
+    void LogSStream::resize(size_t size) noexcept {
+        assert(size <= this->size());
+        T_log_sstream.pos_ = begin_ + static_cast<int>(size);
+    }
+
+    void LogSStream::endMessage() noexcept {
+        T_log_sstream.endMessage();
     }
 
     LogSStream &LogSStream::operator<<(double n) {
-        T_log_sstream.pos_ += sprintf(T_log_sstream.getTail(), "%f", n);
+        appendNumeric([n](char *buf) { return convertFloat(buf, n); });
+        return *this;
+    }
+
+    LogSStream &LogSStream::operator<<(float n) {
+        appendNumeric([n](char *buf) { return convertFloat(buf, n); });
+        return *this;
+    }
+
+    LogSStream &LogSStream::operator<<(Hex hex) {
+        appendNumeric([hex](char *buf) { return convertHex(buf, hex.value); });
+        return *this;
+    }
+
+    LogSStream &LogSStream::writePointer(uintptr_t ptr) {
+        appendNumeric([ptr](char *buf) {
+            buf[0] = '0';
+            buf[1] = 'x';
+            return 2 + convertHex(buf + 2, ptr);
+        });
         return *this;
     }
 
@@ -109,6 +197,9 @@ namespace lon::log {
     template LogSStream& LogSStream::operator<<(const int32_t&);
     template LogSStream& LogSStream::operator<<(const uint64_t&);
     template LogSStream& LogSStream::operator<<(const int64_t&);
+    template LogSStream& LogSStream::operator<<(const long long&);
+    template LogSStream& LogSStream::operator<<(const unsigned long long&);
+    template LogSStream& LogSStream::operator<<(const bool&);
 
 }
 
@@ -0,0 +1,229 @@
+#include "logging/binary_log.h"
+
+#include <algorithm>
+#include <fmt/args.h>
+#include <fmt/format.h>
+
+namespace lon::log {
+
+namespace {
+std::atomic<uint32_t> G_log_site_id{0};
+
+/**
+ * @brief site id的高32位, 由pid和第一次使用的时间混合得到, 同一个进程内不变.
+ */
+uint64_t processEpoch() noexcept {
+    static const uint64_t epoch = []() {
+        timespec now{};
+        ::clock_gettime(CLOCK_REALTIME, &now);
+        // splitmix64
+        uint64_t x = (static_cast<uint64_t>(::getpid()) << 32) ^
+                     (static_cast<uint64_t>(now.tv_sec) * 1000000000 + static_cast<uint64_t>(now.tv_nsec));
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        x ^= x >> 31;
+        return x & 0xFFFFFFFF00000000ULL;
+    }();
+    return epoch;
+}
+
+/**
+ * @brief 顺序读取一条记录中的字段, 越界时返回false.
+ */
+class RecordReader
+{
+public:
+    explicit RecordReader(StringPiece data) : data_{data} {}
+
+    template<class T>
+    bool get(T& value) noexcept {
+        if (data_.size() < sizeof(T))
+            return false;
+        std::memcpy(&value, data_.data(), sizeof(T));
+        data_.remove_prefix(sizeof(T));
+        return true;
+    }
+
+    bool getString(size_t size, StringPiece& value) noexcept {
+        if (data_.size() < size)
+            return false;
+        value = data_.substr(0, size);
+        data_.remove_prefix(size);
+        return true;
+    }
+
+private:
+    StringPiece data_;
+};
+}  // namespace
+
+LogSite::LogSite(const char* _file, int _line, Level _level, StringPiece _format) noexcept
+    : file{_file}, line{_line}, level{_level}, format{_format}, id{processEpoch() | ++G_log_site_id} {}
+
+namespace binary {
+
+void announceSite(Logger& logger, const LogSite& site) {
+    site.announced.store(logger.getId(), std::memory_order_relaxed);
+    const StringPiece file   = StringPiece(site.file).substr(0, UINT16_MAX);
+    const StringPiece format = site.format.substr(0, UINT16_MAX);
+    const size_t size        = kRecordHeaderSize + sizeof(uint64_t) + sizeof(int32_t) + sizeof(uint8_t) +
+                        sizeof(uint16_t) + file.size() + sizeof(uint16_t) + format.size();
+    String record(size, '\0');
+    char* buf = record.data();
+    put(buf, static_cast<uint32_t>(size));
+    put(buf, BinaryRecordType::Site);
+    put(buf, site.id);
+    put(buf, static_cast<int32_t>(site.line));
+    put(buf, static_cast<uint8_t>(site.level));
+    put(buf, static_cast<uint16_t>(file.size()));
+    std::memcpy(buf, file.data(), file.size());
+    buf += file.size();
+    put(buf, static_cast<uint16_t>(format.size()));
+    std::memcpy(buf, format.data(), format.size());
+    logger.write(record);
+}
+
+}  // namespace binary
+
+template<class Func>
+bool BinaryLogDecoder::forEachRecord(StringPiece data, Func&& func) {
+    while (!data.empty()) {
+        RecordReader reader(data);
+        uint32_t size = 0;
+        BinaryRecordType type{};
+        // 末尾不完整(例如进程崩溃时没有写完)或者数据损坏, 之后的记录无法定位.
+        if (!reader.get(size) || !reader.get(type) || size < binary::kRecordHeaderSize ||
+            size > data.size())
+            return false;
+        func(type, data.substr(binary::kRecordHeaderSize, size - binary::kRecordHeaderSize));
+        data.remove_prefix(size);
+    }
+    return true;
+}
+
+size_t BinaryLogDecoder::decode(StringPiece data) {
+    forEachRecord(data, [this](BinaryRecordType type, StringPiece record) {
+        if (type == BinaryRecordType::Site && !decodeSite(record))
+            ++errors_;
+    });
+    size_t decoded = 0;
+    const bool complete = forEachRecord(data, [this, &decoded](BinaryRecordType type, StringPiece record) {
+        if (type != BinaryRecordType::Event)
+            return;
+        if (decodeEvent(record))
+            ++decoded;
+        else
+            ++errors_;
+    });
+    if (!complete)
+        ++errors_;
+    return decoded;
+}
+
+bool BinaryLogDecoder::decodeSite(StringPiece record) {
+    RecordReader reader(record);
+    uint64_t id          = 0;
+    int32_t line         = 0;
+    uint8_t level        = 0;
+    uint16_t file_size   = 0;
+    uint16_t format_size = 0;
+    StringPiece file;
+    StringPiece format;
+    if (!reader.get(id) || !reader.get(line) || !reader.get(level) || !reader.get(file_size) ||
+        !reader.getString(file_size, file) || !reader.get(format_size) ||
+        !reader.getString(format_size, format) || level >= Level::SIZE)
+        return false;
+    Site site{String(file), line, static_cast<Level>(level), String(format)};
+    auto [iter, inserted] = sites_.try_emplace(id, site);
+    // 同一个site会被多个logger或者线程重复写出, 内容不同说明id冲突, 保留第一次的定义并计为错误.
+    return inserted || (iter->second.file == site.file && iter->second.line == site.line &&
+                        iter->second.level == site.level && iter->second.format == site.format);
+}
+
+bool BinaryLogDecoder::decodeEvent(StringPiece record) {
+    RecordReader reader(record);
+    uint64_t id        = 0;
+    int64_t second     = 0;
+    uint32_t nanosecond = 0;
+    uint32_t thread_id = 0;
+    uint8_t count      = 0;
+    if (!reader.get(id) || !reader.get(second) || !reader.get(nanosecond) || !reader.get(thread_id) ||
+        !reader.get(count))
+        return false;
+    auto iter = sites_.find(id);
+    if (iter == sites_.end())
+        return false;
+    const Site& site = iter->second;
+
+    fmt::dynamic_format_arg_store<fmt::format_context> args;
+    for (uint8_t i = 0; i < count; ++i) {
+        BinaryArgType type{};
+        if (!reader.get(type))
+            return false;
+        bool ok = true;
+        switch (type) {
+        case BinaryArgType::Int: {
+            int64_t value = 0;
+            ok            = reader.get(value);
+            args.push_back(value);
+            break;
+        }
+        case BinaryArgType::Uint: {
+            uint64_t value = 0;
+            ok             = reader.get(value);
+            args.push_back(value);
+            break;
+        }
+        case BinaryArgType::Double: {
+            double value = 0;
+            ok           = reader.get(value);
+            args.push_back(value);
+            break;
+        }
+        case BinaryArgType::Bool: {
+            uint8_t value = 0;
+            ok            = reader.get(value);
+            args.push_back(value != 0);
+            break;
+        }
+        case BinaryArgType::Char: {
+            char value = 0;
+            ok         = reader.get(value);
+            args.push_back(value);
+            break;
+        }
+        case BinaryArgType::String: {
+            uint32_t size = 0;
+            StringPiece value;
+            ok = reader.get(size) && reader.getString(size, value);
+            args.push_back(String(value));
+            break;
+        }
+        default:
+            return false;
+        }
+        if (!ok)
+            return false;
+    }
+
+    String message;
+    try {
+        message = fmt::vformat(site.format, args);
+    } catch (const fmt::format_error& e) {
+        // 参数与format不匹配, 仍然输出这一条, 不丢失信息.
+        message = fmt::format("<<format error: {}>> {}", e.what(), site.format);
+    }
+    LogEvent event(site.file.c_str(),
+                   site.line,
+                   site.level,
+                   thread_id,
+                   0,
+                   0,
+                   timespec{static_cast<time_t>(second), static_cast<long>(nanosecond)});
+    event.content = message;
+    output_->log(&event);
+    return true;
+}
+
+}  // namespace lon::log
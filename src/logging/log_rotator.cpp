@@ -0,0 +1,215 @@
+#include "logging/log_rotator.h"
+
+#include "cmake_defination.h"
+
+#include <condition_variable>
+#include <fmt/core.h>
+#include <iostream>
+#include <sys/stat.h>
+#if LON_LOG_COMPRESSION
+#include <zlib.h>
+#endif
+
+namespace lon::log {
+
+namespace {
+/**
+ * @brief 删除最早的文件, 只保留最后max_files个, max_files为0时全部保留.
+ */
+void retainFiles(std::deque<String>& files, size_t max_files) {
+    while (max_files > 0 && files.size() > max_files) {
+        ::unlink(files.front().c_str());
+        files.pop_front();
+    }
+}
+}  // namespace
+
+/**
+ * @brief 在后台线程中依次把已切换的文件压缩为.gz, 然后删除原文件.
+ * 开启压缩时保留策略也在这个线程中执行, 避免删除正在压缩的文件.
+ */
+class LogCompressor : public Noncopyable
+{
+public:
+    explicit LogCompressor(size_t max_files) : max_files_{max_files} {
+        thread_ = Thread([this]() { run(); });
+    }
+
+    ~LogCompressor() {
+        {
+            std::lock_guard<Mutex> locker{mutex_};
+            stop_ = true;
+        }
+        condition_var_.notify_one();
+        thread_.join();
+    }
+
+    void add(String filename) {
+        {
+            std::lock_guard<Mutex> locker{mutex_};
+            files_.push_back(std::move(filename));
+        }
+        condition_var_.notify_one();
+    }
+
+private:
+    void run() {
+        while (true) {
+            String filename;
+            {
+                std::unique_lock<Mutex> locker{mutex_};
+                condition_var_.wait(locker, [this]() { return stop_ || !files_.empty(); });
+                if (files_.empty())
+                    return;
+                filename = std::move(files_.front());
+                files_.pop_front();
+            }
+            compressed_.push_back(compress(filename));
+            retainFiles(compressed_, max_files_);
+        }
+    }
+
+    /**
+     * @return 压缩以后的文件名, 失败时返回原文件名.
+     */
+    static String compress(const String& filename) {
+#if LON_LOG_COMPRESSION
+        const int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return filename;
+        const String gz_filename = filename + ".gz";
+        gzFile gz                = ::gzopen(gz_filename.c_str(), "wb");
+        bool ok                  = gz != nullptr;
+        char buffer[64 * 1024];
+        ssize_t n = 0;
+        while (ok && (n = ::read(fd, buffer, sizeof(buffer))) > 0) {
+            ok = ::gzwrite(gz, buffer, static_cast<unsigned>(n)) == n;
+        }
+        ok = ok && n == 0;
+        if (gz != nullptr && ::gzclose(gz) != Z_OK)
+            ok = false;
+        ::close(fd);
+        if (ok) {
+            ::unlink(filename.c_str());
+            return gz_filename;
+        }
+        std::cerr << fmt::format("compress log file failed: {}\n", filename);
+        ::unlink(gz_filename.c_str());
+#endif
+        return filename;
+    }
+
+    const size_t max_files_;
+    // 只在压缩线程中使用.
+    std::deque<String> compressed_;
+    bool stop_ = false;
+    Mutex mutex_;
+    ConditionVar condition_var_;
+    std::deque<String> files_;
+    Thread thread_;
+};
+
+LogRotator::LogRotator(LogFilenameData filename, const LogRotationOptions& options)
+    : filename_{std::move(filename)}, options_{options} {
+#if LON_LOG_COMPRESSION
+    if (options_.compress && enabled())
+        compressor_ = std::make_unique<LogCompressor>(options_.max_files);
+#endif
+}
+
+LogRotator::~LogRotator() = default;
+
+void LogRotator::attach(const WritableFile& file, time_t now) {
+    current_ = file.getFileName();
+    struct stat file_stat {};
+    file_size_        = ::stat(current_.c_str(), &file_stat) == 0 ? static_cast<size_t>(file_stat.st_size) : 0;
+    next_rotate_time_ = nextRotateTime(now, options_.frequency);
+}
+
+void LogRotator::rotate(WritableFile& file, time_t now) {
+    next_rotate_time_ = nextRotateTime(now, options_.frequency);
+    String filename   = logFileNameGenerate(filename_);
+    String archived   = current_;
+    if (filename == current_) {
+        // 文件名不变, 先把旧文件重命名, 写线程持有的fd仍然指向它.
+        archived = archiveName(current_, now);
+        if (::rename(current_.c_str(), archived.c_str()) != 0) {
+            std::cerr << fmt::format("rename log file {} failed: {}\n", current_, std::strerror(errno));
+            file_size_ = 0;
+            return;
+        }
+    }
+    try {
+        // 移动赋值写出并关闭旧文件.
+        file = WritableFile{filename};
+    } catch (const ExecFailed& e) {
+        std::cerr << e.what() << '\n';
+        file_size_ = 0;
+        return;
+    }
+    current_   = std::move(filename);
+    file_size_ = 0;
+    ++rotations_;
+    retain(archived);
+}
+
+time_t LogRotator::nextRotateTime(time_t now, FlushFrequency frequency) {
+    if (frequency == FlushFrequency::Never)
+        return std::numeric_limits<time_t>::max();
+    struct tm tm {};
+    ::localtime_r(&now, &tm);
+    tm.tm_sec = 0;
+    tm.tm_min = 0;
+    switch (frequency) {
+    case FlushFrequency::Hour:
+        tm.tm_hour += 1;
+        break;
+    case FlushFrequency::HalfDay:
+        tm.tm_hour = tm.tm_hour < 12 ? 12 : 24;
+        break;
+    case FlushFrequency::Day:
+        tm.tm_hour = 24;
+        break;
+    case FlushFrequency::Week:
+        // 下一个周一.
+        tm.tm_hour = 0;
+        tm.tm_mday += 7 - (tm.tm_wday + 6) % 7;
+        break;
+    case FlushFrequency::Month:
+        tm.tm_hour = 0;
+        tm.tm_mday = 1;
+        tm.tm_mon += 1;
+        break;
+    case FlushFrequency::Never:
+        break;
+    }
+    tm.tm_isdst = -1;
+    return ::mktime(&tm);
+}
+
+String LogRotator::archiveName(const String& filename, time_t now) {
+    char timebuf[32];
+    struct tm tm {};
+    ::localtime_r(&now, &tm);
+    ::strftime(timebuf, sizeof(timebuf), "%Y%m%d-%H%M%S", &tm);
+    // 同一秒内多次切换, 或者与上一次运行切换出的文件重名.
+    String archived;
+    struct stat file_stat {};
+    size_t index = rotations_;
+    do {
+        archived = fmt::format("{}.{}.{}", filename, timebuf, index++);
+    } while (::stat(archived.c_str(), &file_stat) == 0 ||
+             ::stat((archived + ".gz").c_str(), &file_stat) == 0);
+    return archived;
+}
+
+void LogRotator::retain(const String& archived) {
+    if (compressor_) {
+        compressor_->add(archived);
+        return;
+    }
+    archived_.push_back(archived);
+    retainFiles(archived_, options_.max_files);
+}
+
+}  // namespace lon::log
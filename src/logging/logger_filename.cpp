@@ -54,13 +54,15 @@ String logFileNameGenerate(const LogFilenameData& filename_data) {
     String filename;
     filename.reserve(filename_data.prefix.size() + filename_data.postfix.size() + 15);
 
-    char timebuf[32];
-    struct tm tm;
-    time_t now = time(NULL);
-    localtime_r(&now, &tm);
-    strftime(timebuf, sizeof timebuf, filename_data.dateTime.data(), &tm);
     filename += filename_data.prefix;
-    filename += timebuf;
+    if (!filename_data.dateTime.empty()) {
+        char timebuf[32];
+        struct tm tm;
+        time_t now = time(NULL);
+        localtime_r(&now, &tm);
+        strftime(timebuf, sizeof timebuf, filename_data.dateTime.data(), &tm);
+        filename += timebuf;
+    }
     filename += filename_data.postfix;
     return filename;
 }
@@ -0,0 +1,363 @@
+#include "logging/logger_flusher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace lon::log {
+
+namespace {
+// 后台线程没有日志可写时的最长等待时间, 生产者只在后台线程等待时才唤醒它.
+constexpr auto kWriterIdleWait = std::chrono::milliseconds(10);
+
+std::atomic<uint64_t> G_ring_flusher_id{0};
+}  // namespace
+
+/**
+ * @brief 一个生产者线程在一个RingFileFlusher中的环, 由flusher和线程局部的缓存共同持有.
+ */
+struct RingFileFlusher::Producer
+{
+    explicit Producer(size_t ring_size) : ring{ring_size} {}
+
+    LogRing ring;
+    // Count策略下该环被丢弃的条数, 后台线程在reported之后写入提示.
+    std::atomic<size_t> dropped{0};
+    size_t reported = 0;
+    // 生产者线程已经退出, 环取空以后从flusher中移除.
+    std::atomic<bool> orphaned{false};
+    // flusher已经析构, 线程局部的缓存可以移除.
+    std::atomic<bool> closed{false};
+};
+
+namespace {
+/**
+ * @brief 当前线程在各个RingFileFlusher中的环, 线程退出时通知后台线程回收.
+ */
+struct LocalProducers
+{
+    uint64_t last_id                     = 0;
+    RingFileFlusher::Producer* last      = nullptr;
+    std::vector<std::pair<uint64_t, std::shared_ptr<RingFileFlusher::Producer>>> producers;
+
+    ~LocalProducers() {
+        for (auto& item : producers) {
+            item.second->orphaned.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local LocalProducers t_producers;
+}  // namespace
+
+RingFileFlusher::RingFileFlusher(const char* filename,
+                                 size_t ring_size,
+                                 RingOverflowPolicy policy,
+                                 const LogRotationOptions& rotation)
+    : FileFlusher{filename},
+      id_{++G_ring_flusher_id},
+      ring_size_{ring_size},
+      policy_{policy},
+      rotator_{filename_, rotation} {
+    rotator_.attach(file_);
+    thread_ = Thread([this]() { writerLoop(); });
+}
+
+RingFileFlusher::RingFileFlusher(const String& pattern,
+                                 size_t ring_size,
+                                 RingOverflowPolicy policy,
+                                 const LogRotationOptions& rotation)
+    : FileFlusher{pattern},
+      id_{++G_ring_flusher_id},
+      ring_size_{ring_size},
+      policy_{policy},
+      rotator_{filename_, rotation} {
+    rotator_.attach(file_);
+    thread_ = Thread([this]() { writerLoop(); });
+}
+
+RingFileFlusher::~RingFileFlusher() {
+    {
+        std::lock_guard<Mutex> locker{mutex_};
+        stop_ = true;
+    }
+    condition_var_.notify_one();
+    thread_.join();
+
+    std::lock_guard<Mutex> locker{mutex_};
+    for (auto& producer : producers_) {
+        producer->closed.store(true, std::memory_order_release);
+    }
+}
+
+void RingFileFlusher::flush(StringPiece str) {
+    Producer* producer = localProducer();
+    if (UNLIKELY(!producer->ring.tryWrite(str))) {
+        bool written = false;
+        if (policy_ == RingOverflowPolicy::Block && str.size() <= producer->ring.capacity()) {
+            // 后台线程在环非空时不会等待, 这里只需要让出cpu.
+            do {
+                std::this_thread::yield();
+                written = producer->ring.tryWrite(str);
+            } while (!written);
+        }
+        if (!written) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            if (policy_ == RingOverflowPolicy::Count)
+                producer->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    // 只有第一个发现后台线程在等待的生产者唤醒它, 避免每一行都进行一次futex调用.
+    // 与后台线程的检查之间没有完整的屏障, 错过的唤醒最多延迟kWriterIdleWait.
+    if (writer_sleeping_.load(std::memory_order_relaxed) &&
+        writer_sleeping_.exchange(false, std::memory_order_acq_rel))
+        condition_var_.notify_one();
+}
+
+size_t RingFileFlusher::size() {
+    std::lock_guard<Mutex> locker{mutex_};
+    size_t total = 0;
+    for (auto& producer : producers_) {
+        total += producer->ring.size();
+    }
+    return total;
+}
+
+void RingFileFlusher::doFlush() {
+    file_.flush();
+}
+
+RingFileFlusher::Producer* RingFileFlusher::localProducer() {
+    auto& local = t_producers;
+    if (LIKELY(local.last_id == id_))
+        return local.last;
+    auto iter = std::find_if(local.producers.begin(), local.producers.end(), [this](const auto& item) {
+        return item.first == id_;
+    });
+    if (iter == local.producers.end()) {
+        // 顺便移除已经析构的flusher的环.
+        local.producers.erase(std::remove_if(local.producers.begin(),
+                                             local.producers.end(),
+                                             [](const auto& item) {
+                                                 return item.second->closed.load(std::memory_order_acquire);
+                                             }),
+                              local.producers.end());
+        auto producer = std::make_shared<Producer>(ring_size_);
+        {
+            std::lock_guard<Mutex> locker{mutex_};
+            producers_.push_back(producer);
+            producers_version_.fetch_add(1, std::memory_order_release);
+        }
+        local.producers.emplace_back(id_, std::move(producer));
+        iter = local.producers.end() - 1;
+    }
+    local.last_id = id_;
+    local.last    = iter->second.get();
+    return local.last;
+}
+
+void RingFileFlusher::writerLoop() {
+    std::vector<std::shared_ptr<Producer>> producers;
+    size_t version = static_cast<size_t>(-1);
+    while (true) {
+        if (producers_version_.load(std::memory_order_acquire) != version) {
+            std::lock_guard<Mutex> locker{mutex_};
+            version   = producers_version_.load(std::memory_order_relaxed);
+            producers = producers_;
+        }
+        if (drain(producers) > 0)
+            continue;
+
+        // 没有日志可写: 写出文件缓冲, 然后等待.
+        doFlush();
+        std::unique_lock<Mutex> locker{mutex_};
+        if (stop_)
+            break;
+        writer_sleeping_.store(true, std::memory_order_seq_cst);
+        const bool pending = std::any_of(producers.begin(), producers.end(), [](const auto& producer) {
+            return !producer->ring.empty();
+        });
+        if (!pending)
+            condition_var_.wait_for(locker, kWriterIdleWait);
+        writer_sleeping_.store(false, std::memory_order_relaxed);
+    }
+    // stop_之前写入的日志.
+    {
+        std::lock_guard<Mutex> locker{mutex_};
+        producers = producers_;
+    }
+    drain(producers);
+    doFlush();
+}
+
+size_t RingFileFlusher::drain(std::vector<std::shared_ptr<Producer>>& producers) {
+    size_t total       = 0;
+    bool remove_orphan = false;
+    const time_t now   = rotator_.enabled() ? ::time(nullptr) : 0;
+    for (auto& producer : producers) {
+        // 在环的批次之间切换文件, 一条日志不会被拆到两个文件中.
+        const size_t pending = producer->ring.size();
+        if (pending > 0 && rotator_.shouldRotate(pending, now))
+            rotator_.rotate(file_, now);
+        const size_t written = producer->ring.consume([this](const char* data, size_t length) {
+            file_.append(StringPiece(data, length));
+        });
+        rotator_.written(written);
+        total += written;
+        const size_t dropped = producer->dropped.load(std::memory_order_relaxed);
+        if (dropped != producer->reported) {
+            const String notice = fmt::format("[ring flusher] {} log lines dropped\n", dropped - producer->reported);
+            file_.append(notice);
+            rotator_.written(notice.size());
+            producer->reported = dropped;
+        }
+        if (producer->orphaned.load(std::memory_order_acquire) && producer->ring.empty())
+            remove_orphan = true;
+    }
+    if (remove_orphan) {
+        // 生产者线程已经退出, 之后不会再写入.
+        std::lock_guard<Mutex> locker{mutex_};
+        auto is_done = [](const std::shared_ptr<Producer>& producer) {
+            return producer->orphaned.load(std::memory_order_acquire) && producer->ring.empty();
+        };
+        producers_.erase(std::remove_if(producers_.begin(), producers_.end(), is_done), producers_.end());
+        producers.erase(std::remove_if(producers.begin(), producers.end(), is_done), producers.end());
+        producers_version_.fetch_add(1, std::memory_order_release);
+    }
+    return total;
+}
+
+DoubleBufferFileFlusher::DoubleBufferFileFlusher(const char* filename, Options options)
+    : FileFlusher{filename},
+      options_{options},
+      current_{std::make_unique<Buffer>(options.buffer_size)},
+      next_{std::make_unique<Buffer>(options.buffer_size)},
+      rotator_{filename_, options.rotation} {
+    rotator_.attach(file_);
+    initThread();
+}
+
+DoubleBufferFileFlusher::DoubleBufferFileFlusher(const String& pattern, Options options)
+    : FileFlusher{pattern},
+      options_{options},
+      current_{std::make_unique<Buffer>(options.buffer_size)},
+      next_{std::make_unique<Buffer>(options.buffer_size)},
+      rotator_{filename_, options.rotation} {
+    rotator_.attach(file_);
+    initThread();
+}
+
+DoubleBufferFileFlusher::~DoubleBufferFileFlusher() {
+    {
+        std::lock_guard<Mutex> locker{mutex_};
+        stop_ = true;
+    }
+    condition_var_.notify_one();
+    thread_.join();
+}
+
+void DoubleBufferFileFlusher::flush(StringPiece str) {
+    std::lock_guard<Mutex> locker{mutex_};
+    if (LIKELY(current_->available() >= str.size())) {
+        current_->append(str);
+        return;
+    }
+    buffers_.push_back(std::move(current_));
+    if (next_) {
+        current_ = std::move(next_);
+    } else {
+        // 后台线程来不及归还备用缓冲, 极少发生.
+        current_ = std::make_unique<Buffer>(options_.buffer_size);
+    }
+    if (UNLIKELY(str.size() > current_->capacity)) {
+        // 单条超过缓冲大小的日志独占一个缓冲.
+        auto large = std::make_unique<Buffer>(str.size());
+        large->append(str);
+        buffers_.push_back(std::move(large));
+    } else {
+        current_->append(str);
+    }
+    condition_var_.notify_one();
+}
+
+size_t DoubleBufferFileFlusher::size() {
+    std::lock_guard<Mutex> locker{mutex_};
+    return buffers_.size() + (current_->size > 0 ? 1 : 0);
+}
+
+void DoubleBufferFileFlusher::initThread() {
+    thread_ = Thread([this]() {
+        bool stop = false;
+        while (!stop) {
+            {
+                std::lock_guard<Mutex> locker{mutex_};
+                stop = stop_;
+            }
+            // stop_以后最后一次写出剩余的日志.
+            doFlush();
+        }
+    });
+}
+
+void DoubleBufferFileFlusher::doFlush() {
+    auto& new_buffer1 = writer_buffer1_;
+    auto& new_buffer2 = writer_buffer2_;
+    if (!new_buffer1)
+        new_buffer1 = std::make_unique<Buffer>(options_.buffer_size);
+    if (!new_buffer2)
+        new_buffer2 = std::make_unique<Buffer>(options_.buffer_size);
+
+    std::vector<BufferPtr> buffers_to_write;
+    {
+        std::unique_lock<Mutex> locker{mutex_};
+        if (buffers_.empty() && !stop_) {
+            condition_var_.wait_for(locker, std::chrono::milliseconds(options_.flush_interval_ms));
+        }
+        if (buffers_.empty() && current_->size == 0)
+            return;
+        buffers_.push_back(std::move(current_));
+        current_ = std::move(new_buffer1);
+        buffers_to_write.swap(buffers_);
+        if (!next_)
+            next_ = std::move(new_buffer2);
+    }
+
+    // 至少保留两个缓冲, 避免max_pending_buffers为0或1时计算丢弃数量溢出.
+    if (buffers_to_write.size() > std::max<size_t>(options_.max_pending_buffers, 2)) {
+        // 生产速度远超写文件的速度, 只保留最早的两个缓冲, 避免内存无限增长.
+        const size_t dropped = buffers_to_write.size() - 2;
+        const String notice  = fmt::format("[double buffer flusher] {} log buffers dropped\n", dropped);
+        file_.append(notice);
+        rotator_.written(notice.size());
+        dropped_buffers_.fetch_add(dropped, std::memory_order_relaxed);
+        buffers_to_write.resize(2);
+    }
+    const time_t now = rotator_.enabled() ? ::time(nullptr) : 0;
+    for (auto& buffer : buffers_to_write) {
+        // 缓冲中都是完整的日志, 在缓冲之间切换文件.
+        if (buffer->size > 0 && rotator_.shouldRotate(buffer->size, now))
+            rotator_.rotate(file_, now);
+        file_.append(StringPiece(buffer->data.get(), buffer->size));
+        rotator_.written(buffer->size);
+    }
+    if (options_.fdatasync) {
+        file_.sync();
+    } else {
+        file_.flush();
+    }
+
+    // 复用写出的缓冲(单条大日志独占的缓冲除外).
+    for (auto& buffer : buffers_to_write) {
+        if (buffer->capacity != options_.buffer_size)
+            continue;
+        buffer->size = 0;
+        if (!new_buffer1) {
+            new_buffer1 = std::move(buffer);
+        } else if (!new_buffer2) {
+            new_buffer2 = std::move(buffer);
+        }
+    }
+}
+
+}  // namespace lon::log
@@ -1,5 +1,9 @@
 #include "logging/loger_formatters.h"
 
+#include <fmt/core.h>
+#include <mutex>
+#include <unordered_map>
+
 namespace lon {
 
 void messageFormatter(Logger::StringStream& stream, LogEvent* event) noexcept {
@@ -35,6 +39,74 @@ void dateTimeFormatter(Logger::StringStream& stream, LogEvent* event) noexcept {
     stream << buf;
 }
 
+namespace {
+struct DateTimeCache
+{
+    uint64_t id   = 0;
+    time_t second = 0;
+    char before[64];
+    size_t before_size = 0;
+    char after[64];
+    size_t after_size = 0;
+};
+
+// 按id取模选择缓存项, 前kDateTimeCacheSize个不同的pattern不会互相冲突.
+constexpr size_t kDateTimeCacheSize = 4;
+
+thread_local DateTimeCache t_date_time_caches[kDateTimeCacheSize];
+
+/**
+ * @brief pattern相同的formatter共用同一个id, 各个logger的%d{pattern}通常相同, 可以共享线程缓存.
+ */
+uint64_t dateTimePatternId(const String& pattern) {
+    static std::mutex mutex;
+    static std::unordered_map<String, uint64_t> ids;
+    std::lock_guard<std::mutex> lock(mutex);
+    return ids.try_emplace(pattern, ids.size() + 1).first->second;
+}
+
+size_t formatTime(char* buf, size_t size, const String& pattern, const struct tm& tm) noexcept {
+    return pattern.empty() ? 0 : strftime(buf, size, pattern.c_str(), &tm);
+}
+}  // namespace
+
+DateTimeLogFormatter::DateTimeLogFormatter(const String& pattern)
+    : before_{pattern}, id_{dateTimePatternId(pattern)} {
+    for (int digits : {3, 6}) {
+        const String token = fmt::format("%{}N", digits);
+        if (auto pos = pattern.find(token); pos != String::npos) {
+            before_ = pattern.substr(0, pos);
+            after_  = pattern.substr(pos + token.size());
+            digits_ = digits;
+            break;
+        }
+    }
+}
+
+void DateTimeLogFormatter::operator()(Logger::StringStream& stream, LogEvent* event) const {
+    auto& cache = t_date_time_caches[id_ % kDateTimeCacheSize];
+    if (UNLIKELY(cache.id != id_ || cache.second != event->time)) {
+        struct tm tm;
+        localtime_r(&event->time, &tm);
+        cache.id          = id_;
+        cache.second      = event->time;
+        cache.before_size = formatTime(cache.before, sizeof(cache.before), before_, tm);
+        cache.after_size  = formatTime(cache.after, sizeof(cache.after), after_, tm);
+    }
+    stream << StringPiece(cache.before, cache.before_size);
+    if (digits_ > 0) {
+        // 定宽, 高位补0.
+        uint32_t fraction = event->time_ns / (digits_ == 3 ? 1000000 : 1000);
+        char buf[6];
+        for (int i = digits_ - 1; i >= 0; --i) {
+            buf[i] = static_cast<char>('0' + fraction % 10);
+            fraction /= 10;
+        }
+        stream << StringPiece(buf, static_cast<size_t>(digits_));
+    }
+    stream << StringPiece(cache.after, cache.after_size);
+}
+
 void filenameFormatter(Logger::StringStream& stream, LogEvent* event) noexcept {
     stream << event->file_name;
 }
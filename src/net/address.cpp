@@ -4,9 +4,12 @@
 
 
 #include <cassert>
+#include <cstddef>
+#include <cstring>
 #include <netdb.h>
 #include <cinttypes>
 #include <stdexcept>
+#include <string_view>
 #include <arpa/inet.h>
 #include <net/if.h>
 #include <fmt/core.h>
@@ -176,6 +179,27 @@ IPAddress::IPAddressUniquePtr IPAddress::create(StringArg host_and_port) {
     return create(host_and_port_parser.host, host_and_port_parser.port);
 }
 
+std::vector<IPAddress::IPAddressUniquePtr> IPAddress::createAll(StringArg host,
+                                                              uint16_t port) {
+    char port_str[sizeof("65535")];
+    snprintf(port_str, sizeof(port_str), "%" PRIu16, port);
+
+    std::vector<IPAddressUniquePtr> result;
+    ScopedAddrInfo addr_info(getAddrInfo(host, port_str, 0));
+    for (auto info = addr_info.info; info; info = info->ai_next) {
+        if (info->ai_family == AF_INET &&
+            info->ai_addrlen >= sizeof(sockaddr_in)) {
+            result.push_back(std::make_unique<IPV4Address>(
+                *reinterpret_cast<sockaddr_in*>(info->ai_addr)));
+        } else if (info->ai_family == AF_INET6 &&
+                   info->ai_addrlen >= sizeof(sockaddr_in6)) {
+            result.push_back(std::make_unique<IPV6Address>(
+                *reinterpret_cast<sockaddr_in6*>(info->ai_addr)));
+        }
+    }
+    return result;
+}
+
 IPV4Address::IPV4Address(StringArg host_and_port)
     : IPV4Address() {
     setByHostAndPort(host_and_port);
@@ -342,10 +366,29 @@ socklen_t IPV6Address::getAddrLen() const noexcept {
     return sizeof(addr_);
 }
 
-UnixAddress::UnixAddress() noexcept {
+UnixAddress::UnixAddress() noexcept : len_{sizeof(sockaddr_un)} {
     bzero(&addr_, sizeof(sockaddr_un));
 }
 
+UnixAddress::UnixAddress(StringPiece path) : UnixAddress() {
+    // 路径需要以'\0'结尾, 抽象地址的'@'替换为'\0', 两者占用的长度相同.
+    if (path.empty() || path.size() >= sizeof(addr_.sun_path)) {
+        throw std::invalid_argument(fmt::format("invalid unix socket path:{}", path));
+    }
+    addr_.sun_family = AF_UNIX;
+    memcpy(addr_.sun_path, path.data(), path.size());
+    if (path[0] == '@') {
+        addr_.sun_path[0] = '\0';
+        len_ = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size());
+    } else {
+        len_ = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size() + 1);
+    }
+}
+
+UnixAddress::UnixAddress(const sockaddr_un& src, socklen_t len) noexcept
+    : addr_{src}, len_{std::min<socklen_t>(len, sizeof(sockaddr_un))} {
+}
+
 const sockaddr* UnixAddress::getAddr() const noexcept {
     return reinterpret_cast<const sockaddr*>(&addr_);
 }
@@ -355,17 +398,121 @@ sockaddr* UnixAddress::getAddrMutable() {
 }
 
 String UnixAddress::toString() const {
-    return fmt::format("\\0{}",addr_.sun_path);
+    if (addr_.sun_family != AF_UNIX || len_ <= offsetof(sockaddr_un, sun_path))
+        return "unnamed";
+    if (isAbstract()) {
+        return fmt::format("@{}", StringPiece(addr_.sun_path + 1, len_ - offsetof(sockaddr_un, sun_path) - 1));
+    }
+    return String(getPath());
+}
+
+bool UnixAddress::isAbstract() const noexcept {
+    return len_ > offsetof(sockaddr_un, sun_path) && addr_.sun_path[0] == '\0';
+}
+
+StringPiece UnixAddress::getPath() const noexcept {
+    if (len_ <= offsetof(sockaddr_un, sun_path) || isAbstract())
+        return {};
+    return {addr_.sun_path, ::strnlen(addr_.sun_path, len_ - offsetof(sockaddr_un, sun_path))};
 }
 
 socklen_t UnixAddress::getAddrLen() const noexcept {
-    return sizeof(addr_);
+    return len_;
+}
+
+InetAddress::InetAddress() noexcept : len_{sizeof(sockaddr_storage)} {
+    bzero(&storage_, sizeof(sockaddr_storage));
 }
 
+InetAddress::InetAddress(const sockaddr* addr, socklen_t len) noexcept
+    : len_{std::min<socklen_t>(len, sizeof(sockaddr_storage))} {
+    // 只拷贝有效长度, 比较和hash同样只使用这部分.
+    memcpy(&storage_, addr, len_);
+}
+
+InetAddress::InetAddress(StringArg host, uint16_t port) : InetAddress() {
+    auto inet4 = reinterpret_cast<sockaddr_in*>(&storage_);
+    auto inet6 = reinterpret_cast<sockaddr_in6*>(&storage_);
+    if (::inet_pton(AF_INET, host.str, &inet4->sin_addr) == 1) {
+        inet4->sin_family = AF_INET;
+        inet4->sin_port   = ::htons(port);
+        len_              = sizeof(sockaddr_in);
+    } else if (::inet_pton(AF_INET6, host.str, &inet6->sin6_addr) == 1) {
+        inet6->sin6_family = AF_INET6;
+        inet6->sin6_port   = ::htons(port);
+        len_               = sizeof(sockaddr_in6);
+    } else {
+        throw std::invalid_argument(fmt::format(
+            "host:{} is neither a valid ipv4 nor a valid ipv6 address", host.str));
+    }
+}
+
+InetAddress::InetAddress(StringArg host_and_port) : InetAddress() {
+    HostAndPortParser host_and_port_parser(host_and_port.str);
+    *this = InetAddress(host_and_port_parser.host, getPortFromString(host_and_port_parser.port));
+}
+
+String InetAddress::toString() const {
+    switch (storage_.ss_family) {
+        case AF_INET:
+            return IPV4Address(*reinterpret_cast<const sockaddr_in*>(&storage_)).toString();
+        case AF_INET6:
+            return IPV6Address(*reinterpret_cast<const sockaddr_in6*>(&storage_)).toString();
+        case AF_UNIX:
+            return UnixAddress(*reinterpret_cast<const sockaddr_un*>(&storage_), len_).toString();
+        default:
+            return fmt::format("unknown address family {}", storage_.ss_family);
+    }
+}
+
+String InetAddress::getAddressStr() const {
+    switch (storage_.ss_family) {
+        case AF_INET:
+            return IPV4Address(*reinterpret_cast<const sockaddr_in*>(&storage_)).getAddressStr();
+        case AF_INET6:
+            return IPV6Address(*reinterpret_cast<const sockaddr_in6*>(&storage_)).getAddressStr();
+        default:
+            return {};
+    }
+}
+
+uint16_t InetAddress::getPort() const noexcept {
+    switch (storage_.ss_family) {
+        case AF_INET:
+            return ::ntohs(reinterpret_cast<const sockaddr_in*>(&storage_)->sin_port);
+        case AF_INET6:
+            return ::ntohs(reinterpret_cast<const sockaddr_in6*>(&storage_)->sin6_port);
+        default:
+            return 0;
+    }
+}
 
+void InetAddress::setPort(uint16_t port) noexcept {
+    switch (storage_.ss_family) {
+        case AF_INET:
+            reinterpret_cast<sockaddr_in*>(&storage_)->sin_port = ::htons(port);
+            break;
+        case AF_INET6:
+            reinterpret_cast<sockaddr_in6*>(&storage_)->sin6_port = ::htons(port);
+            break;
+        default:
+            break;
+    }
+}
+
+size_t InetAddress::hash() const noexcept {
+    return std::hash<std::string_view>{}(
+        std::string_view(reinterpret_cast<const char*>(&storage_), len_));
+}
+
+bool InetAddress::operator<(const InetAddress& rhs) const noexcept {
+    // 同SockAddress::operator<.
+    const int result = memcmp(&storage_, &rhs.storage_, std::min(len_, rhs.len_));
+    return result < 0 || (result == 0 && len_ < rhs.len_);
 }
 
 std::ostream& operator<<(std::ostream& os, lon::net::SockAddress const& address) {
     os << address.toString();
     return os;
-}
\ No newline at end of file
+}
+}
@@ -0,0 +1,108 @@
+#include "net/http/http_chunked.h"
+
+#include <algorithm>
+
+namespace lon::net {
+
+namespace {
+int hexValue(char c) noexcept {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+constexpr StringPiece kCrlf = "\r\n";
+}  // namespace
+
+void HttpChunkedDecoder::reset() noexcept {
+    state_        = State::ChunkSize;
+    remaining_    = 0;
+    trailer_len_  = 0;
+    error_status_ = 0;
+}
+
+HttpChunkedDecoder::Result HttpChunkedDecoder::fail(int status) noexcept {
+    error_status_ = status;
+    return Result::Error;
+}
+
+HttpChunkedDecoder::Result HttpChunkedDecoder::decode(IOBuffer& buffer, IOBuffer& body) {
+    while (true) {
+        switch (state_) {
+            case State::ChunkSize: {
+                const ssize_t pos = buffer.find(kCrlf);
+                if (pos == -1)
+                    return buffer.readableBytes() > kMaxChunkLineLength ? fail(400) : Result::NeedMore;
+                const auto line_len = static_cast<size_t>(pos);
+                if (line_len > kMaxChunkLineLength)
+                    return fail(400);
+                char line[kMaxChunkLineLength];
+                buffer.copyTo(line, line_len);
+                buffer.consume(line_len + kCrlf.size());
+                size_t size = 0;
+                size_t i    = 0;
+                for (; i < line_len && hexValue(line[i]) != -1; ++i) {
+                    if (size > (max_body_bytes_ >> 4))
+                        return fail(413);
+                    size = size * 16 + static_cast<size_t>(hexValue(line[i]));
+                }
+                // chunk扩展直接忽略.
+                if (i == 0 || (i < line_len && line[i] != ';' && line[i] != ' ' && line[i] != '\t'))
+                    return fail(400);
+                if (size > max_body_bytes_ - std::min(max_body_bytes_, body.readableBytes()))
+                    return fail(413);
+                if (size == 0) {
+                    state_ = State::Trailer;
+                } else {
+                    remaining_ = size;
+                    state_     = State::ChunkData;
+                }
+                break;
+            }
+            case State::ChunkData: {
+                const size_t n = std::min(remaining_, buffer.readableBytes());
+                if (n == 0)
+                    return Result::NeedMore;
+                buffer.splitTo(n, body);
+                remaining_ -= n;
+                if (remaining_ > 0)
+                    return Result::NeedMore;
+                state_ = State::ChunkDataEnd;
+                break;
+            }
+            case State::ChunkDataEnd: {
+                char crlf[2];
+                if (buffer.copyTo(crlf, 2) < 2)
+                    return Result::NeedMore;
+                if (crlf[0] != '\r' || crlf[1] != '\n')
+                    return fail(400);
+                buffer.consume(2);
+                state_ = State::ChunkSize;
+                break;
+            }
+            case State::Trailer: {
+                // trailer header不会被使用, 只检查长度.
+                const ssize_t pos = buffer.find(kCrlf);
+                if (pos == -1)
+                    return trailer_len_ + buffer.readableBytes() > max_trailer_bytes_
+                               ? fail(431)
+                               : Result::NeedMore;
+                buffer.consume(static_cast<size_t>(pos) + kCrlf.size());
+                if (pos == 0) {
+                    reset();
+                    return Result::Complete;
+                }
+                trailer_len_ += static_cast<size_t>(pos) + kCrlf.size();
+                if (trailer_len_ > max_trailer_bytes_)
+                    return fail(431);
+                break;
+            }
+        }
+    }
+}
+
+}  // namespace lon::net
@@ -0,0 +1,431 @@
+#include "net/http/http_client.h"
+
+#include "base.h"
+#include "base/info.h"
+#include "io/co_io_function.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fmt/format.h>
+
+static lon::log::LoggerSlot G_logger{"system"};
+
+namespace lon::net {
+
+namespace {
+constexpr StringPiece kCrlf = "\r\n";
+
+// 发送阻塞时每隔这么久检查一次是否有响应需要读取, 避免双方都在等待对方读取(请求和响应都很大时).
+constexpr size_t kWritePollMs = 10;
+
+bool isIdempotent(HttpMethod method) noexcept {
+    return method != HttpMethod::Post && method != HttpMethod::Patch && method != HttpMethod::Connect;
+}
+
+/**
+ * @brief 挂起直到fd就绪, 不超过deadline_ms和max_wait_ms.
+ * @return 就绪返回0, 等待max_wait_ms超时也返回0, 到达deadline返回-1并设置errno为ETIMEDOUT.
+ */
+int waitUntil(int fd, bool write, size_t deadline_ms, size_t max_wait_ms = static_cast<size_t>(-1)) {
+    const size_t now = currentMs();
+    if (now >= deadline_ms) {
+        errno = ETIMEDOUT;
+        return -1;
+    }
+    const size_t wait_ms = std::min(deadline_ms - now, max_wait_ms);
+    if (io::co_waitEvent(fd, write, wait_ms) == 0)
+        return 0;
+    if (errno == ETIMEDOUT && wait_ms < deadline_ms - now)
+        return 0;
+    return -1;
+}
+
+void encodeRequest(StringArg host, uint16_t port, const HttpClientRequest& request, IOBuffer& out) {
+    fmt::memory_buffer header;
+    const StringPiece method = toString(request.method);
+    const StringPiece target = request.target.empty() ? StringPiece("/") : StringPiece(request.target);
+    header.append(method.begin(), method.end());
+    fmt::format_to(std::back_inserter(header), " ");
+    header.append(target.begin(), target.end());
+    fmt::format_to(std::back_inserter(header), " HTTP/1.1\r\n");
+
+    const bool has_host = std::any_of(request.headers.begin(), request.headers.end(), [](const auto& item) {
+        return equalsIgnoreCase(item.first, "host");
+    });
+    if (!has_host) {
+        // ipv6地址需要加上方括号.
+        const bool ipv6 = ::strchr(host.str, ':') != nullptr;
+        fmt::format_to(std::back_inserter(header), ipv6 ? "Host: [{}]" : "Host: {}", host.str);
+        if (port != 80)
+            fmt::format_to(std::back_inserter(header), ":{}", port);
+        fmt::format_to(std::back_inserter(header), "\r\n");
+    }
+    for (const auto& [name, value] : request.headers) {
+        fmt::format_to(std::back_inserter(header), "{}: {}\r\n", name, value);
+    }
+    const size_t body_size = request.body.readableBytes();
+    if (body_size > 0 || request.method == HttpMethod::Post || request.method == HttpMethod::Put ||
+        request.method == HttpMethod::Patch)
+        fmt::format_to(std::back_inserter(header), "Content-Length: {}\r\n", body_size);
+    fmt::format_to(std::back_inserter(header), "\r\n");
+
+    out.append(header.data(), header.size());
+    if (body_size > 0)
+        out.append(request.body.slice(0, body_size));
+}
+}  // namespace
+
+StringPiece HttpClientResponse::header(StringPiece name) const noexcept {
+    for (const auto& header : headers_) {
+        if (equalsIgnoreCase(header.first, name))
+            return header.second;
+    }
+    return {};
+}
+
+bool HttpClientResponse::hasHeader(StringPiece name) const noexcept {
+    return std::any_of(headers_.begin(), headers_.end(), [name](const Header& header) {
+        return equalsIgnoreCase(header.first, name);
+    });
+}
+
+void HttpClientResponse::reset() noexcept {
+    status_        = 0;
+    reason_        = {};
+    version_minor_ = 1;
+    headers_.clear();
+    body_.clear();
+    keep_alive_         = true;
+    chunked_            = false;
+    has_content_length_ = false;
+    content_length_     = 0;
+    raw_header_.clear();
+    gathered_header_.clear();
+}
+
+void HttpResponseParser::reset() noexcept {
+    state_     = State::Header;
+    scanned_   = 0;
+    remaining_ = 0;
+    error_     = 0;
+    chunked_.reset();
+}
+
+HttpResponseParser::Result HttpResponseParser::complete() noexcept {
+    state_     = State::Header;
+    scanned_   = 0;
+    remaining_ = 0;
+    return Result::Complete;
+}
+
+HttpResponseParser::Result HttpResponseParser::fail(int error) noexcept {
+    error_ = error;
+    return Result::Error;
+}
+
+HttpResponseParser::Result HttpResponseParser::parse(IOBuffer& buffer,
+                                                     HttpClientResponse& response,
+                                                     bool head_request) {
+    while (state_ == State::Header) {
+        const Result result = parseHeader(buffer, response);
+        if (result != Result::Complete)
+            return result;
+        const int status = response.status_;
+        // 中间响应之后还有最终的响应, 101之后连接不再是http.
+        if (status >= 100 && status < 200 && status != 101)
+            continue;
+        if (status == 101)
+            response.keep_alive_ = false;
+        if (head_request || status < 200 || status == 204 || status == 304)
+            return complete();
+        if (response.chunked_) {
+            state_ = State::Chunked;
+        } else if (response.has_content_length_) {
+            if (response.content_length_ == 0)
+                return complete();
+            state_     = State::Body;
+            remaining_ = response.content_length_;
+        } else {
+            state_               = State::UntilClose;
+            response.keep_alive_ = false;
+        }
+    }
+    switch (state_) {
+        case State::Body:
+            if (buffer.readableBytes() < remaining_)
+                return Result::NeedMore;
+            buffer.splitTo(remaining_, response.body_);
+            return complete();
+        case State::Chunked:
+            switch (chunked_.decode(buffer, response.body_)) {
+                case HttpChunkedDecoder::Result::Complete:
+                    return complete();
+                case HttpChunkedDecoder::Result::NeedMore:
+                    return Result::NeedMore;
+                case HttpChunkedDecoder::Result::Error:
+                    break;
+            }
+            return fail(chunked_.errorStatus() == 400 ? EPROTO : EMSGSIZE);
+        case State::UntilClose:
+            if (buffer.readableBytes() > max_body_bytes_ - response.body_.readableBytes())
+                return fail(EMSGSIZE);
+            response.body_.append(std::move(buffer));
+            buffer.clear();
+            return Result::NeedMore;
+        default:
+            return fail(EPROTO);
+    }
+}
+
+HttpResponseParser::Result HttpResponseParser::finish(IOBuffer& buffer, HttpClientResponse& response) {
+    if (state_ != State::UntilClose)
+        return fail(ECONNRESET);
+    if (buffer.readableBytes() > max_body_bytes_ - response.body_.readableBytes())
+        return fail(EMSGSIZE);
+    response.body_.append(std::move(buffer));
+    buffer.clear();
+    return complete();
+}
+
+HttpResponseParser::Result HttpResponseParser::parseHeader(IOBuffer& buffer, HttpClientResponse& response) {
+    const ssize_t pos = buffer.find("\r\n\r\n", scanned_);
+    if (pos == -1) {
+        const size_t readable = buffer.readableBytes();
+        if (readable > max_header_bytes_)
+            return fail(EMSGSIZE);
+        // 空行可能只收到了一部分.
+        scanned_ = readable >= 3 ? readable - 3 : 0;
+        return Result::NeedMore;
+    }
+    scanned_ = 0;
+    const size_t header_len = static_cast<size_t>(pos) + 4;
+    if (header_len > max_header_bytes_)
+        return fail(EMSGSIZE);
+
+    response.reset();
+    StringPiece section;
+    if (buffer.front().size() >= header_len) {
+        buffer.splitTo(header_len, response.raw_header_);
+        section = response.raw_header_.front();
+    } else {
+        response.gathered_header_.resize(header_len);
+        buffer.copyTo(response.gathered_header_.data(), header_len);
+        buffer.consume(header_len);
+        section = response.gathered_header_;
+    }
+    if (const int error = parseHeaderSection(section, response); error != 0)
+        return fail(error);
+    return Result::Complete;
+}
+
+int HttpResponseParser::parseHeaderSection(StringPiece section, HttpClientResponse& response) const {
+    // 状态行: HTTP/1.x SP status SP reason
+    const size_t line_end  = section.find(kCrlf);
+    const StringPiece line = section.substr(0, line_end);
+    if (line.size() < 12 || line.substr(0, 7) != "HTTP/1." || line[7] < '0' || line[7] > '9' ||
+        line[8] != ' ')
+        return EPROTO;
+    int status = 0;
+    for (size_t i = 9; i < 12; ++i) {
+        if (line[i] < '0' || line[i] > '9')
+            return EPROTO;
+        status = status * 10 + (line[i] - '0');
+    }
+    if (line.size() > 12 && line[12] != ' ')
+        return EPROTO;
+    response.status_        = status;
+    response.reason_        = line.size() > 13 ? line.substr(13) : StringPiece();
+    response.version_minor_ = line[7] - '0';
+    response.keep_alive_    = response.version_minor_ >= 1;
+
+    bool has_transfer_encoding = false;
+    size_t pos = line_end + kCrlf.size();
+    while (true) {
+        const size_t end = section.find(kCrlf, pos);
+        if (end == pos)
+            break;
+        const StringPiece header_line = section.substr(pos, end - pos);
+        pos = end + kCrlf.size();
+        if (header_line.front() == ' ' || header_line.front() == '\t')
+            return EPROTO;
+        const size_t colon = header_line.find(':');
+        if (colon == StringPiece::npos || colon == 0)
+            return EPROTO;
+        const StringPiece name  = header_line.substr(0, colon);
+        const StringPiece value = trimHttpSpace(header_line.substr(colon + 1));
+        response.headers_.emplace_back(name, value);
+
+        if (equalsIgnoreCase(name, "content-length")) {
+            size_t length = 0;
+            if (!parseContentLength(value, &length) ||
+                (response.has_content_length_ && length != response.content_length_))
+                return EPROTO;
+            response.has_content_length_ = true;
+            response.content_length_     = length;
+        } else if (equalsIgnoreCase(name, "transfer-encoding")) {
+            has_transfer_encoding = true;
+            // 最后一个编码是chunked时按chunked解码, 否则以连接关闭作为结尾(see rfc7230 3.3.3).
+            const size_t comma = value.rfind(',');
+            response.chunked_ =
+                equalsIgnoreCase(trimHttpSpace(comma == StringPiece::npos ? value : value.substr(comma + 1)),
+                                 "chunked");
+        } else if (equalsIgnoreCase(name, "connection")) {
+            if (hasHttpToken(value, "close"))
+                response.keep_alive_ = false;
+            else if (hasHttpToken(value, "keep-alive"))
+                response.keep_alive_ = true;
+        }
+    }
+    // Transfer-Encoding优先于Content-Length, 但是这样的连接不应该再复用.
+    if (has_transfer_encoding && response.has_content_length_) {
+        response.has_content_length_ = false;
+        response.keep_alive_         = false;
+    }
+    if (response.has_content_length_ && response.content_length_ > max_body_bytes_)
+        return EMSGSIZE;
+    return 0;
+}
+
+HttpClientOptions HttpClientOptions::fromConfig(const String& prefix) {
+    HttpClientOptions options;
+    auto config = BaseMainConfig::getInstance();
+    options.max_header_bytes =
+        config->getIfExists<size_t>(prefix + ".max_header_bytes", options.max_header_bytes);
+    options.max_body_bytes =
+        config->getIfExists<size_t>(prefix + ".max_body_bytes", options.max_body_bytes);
+    options.timeout_ms = config->getIfExists<size_t>(prefix + ".timeout_ms", options.timeout_ms);
+    return options;
+}
+
+HttpClient::HttpClient(HttpClientOptions options, TcpConnectionPool::Ptr pool)
+    : options_{options},
+      pool_{std::move(pool)} {}
+
+int HttpClient::request(StringArg host,
+                        uint16_t port,
+                        const HttpClientRequest& request,
+                        HttpClientResponse& response) {
+    return exchange(host, port, &request, &response, 1) == 1 ? 0 : -1;
+}
+
+int HttpClient::get(StringArg host, uint16_t port, StringPiece target, HttpClientResponse& response) {
+    return request(host, port, HttpClientRequest(HttpMethod::Get, String(target)), response);
+}
+
+size_t HttpClient::pipeline(StringArg host,
+                            uint16_t port,
+                            const std::vector<HttpClientRequest>& requests,
+                            std::vector<HttpClientResponse>& responses) {
+    responses.resize(requests.size());
+    if (requests.empty())
+        return 0;
+    return exchange(host, port, requests.data(), responses.data(), requests.size());
+}
+
+size_t HttpClient::exchange(StringArg host,
+                            uint16_t port,
+                            const HttpClientRequest* requests,
+                            HttpClientResponse* responses,
+                            size_t count) {
+    const size_t deadline_ms = options_.timeout_ms == static_cast<size_t>(-1)
+                                   ? static_cast<size_t>(-1)
+                                   : currentMs() + options_.timeout_ms;
+    const bool idempotent = std::all_of(requests, requests + count, [](const HttpClientRequest& request) {
+        return isIdempotent(request.method);
+    });
+    while (true) {
+        auto handle = pool_->acquire(host, port);
+        if (!handle)
+            return 0;
+        bool received          = false;
+        const size_t completed = roundTrip(handle, host, port, requests, responses, count, deadline_ms, &received);
+        if (completed == count)
+            return count;
+        const int saved_errno = errno;
+        handle.markBroken();
+        // 空闲连接可能在归还以后被对端关闭(isAlive检查之后), 这种情况下请求没有被处理, 可以安全地重试.
+        if (handle.reused() && !received && idempotent && saved_errno != ETIMEDOUT) {
+            LON_LOG_DEBUG(G_logger) << fmt::format(
+                "http client retry on new connection, host:{}:{}, errno:{}", host.str, port, saved_errno);
+            continue;
+        }
+        errno = saved_errno;
+        return completed;
+    }
+}
+
+size_t HttpClient::roundTrip(TcpConnectionPool::Handle& handle,
+                             StringArg host,
+                             uint16_t port,
+                             const HttpClientRequest* requests,
+                             HttpClientResponse* responses,
+                             size_t count,
+                             size_t deadline_ms,
+                             bool* received) {
+    TcpConnection& connection = *handle;
+    const int fd              = connection.getSocket().fd();
+    IOBuffer out;
+    for (size_t i = 0; i < count; ++i) {
+        encodeRequest(host, port, requests[i], out);
+        responses[i].reset();
+    }
+
+    HttpResponseParser parser(options_.max_header_bytes, options_.max_body_bytes);
+    IOBuffer in;
+    size_t completed = 0;
+    *received        = false;
+    while (completed < count) {
+        bool progress = false;
+        if (!out.empty()) {
+            const ssize_t n = connection.writeFrom(out, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (n > 0)
+                progress = true;
+            else if (errno != EAGAIN && errno != EWOULDBLOCK)
+                return completed;
+        }
+
+        const ssize_t n = connection.readInto(in, TcpConnection::kMaxReadBytes, MSG_DONTWAIT);
+        if (n > 0) {
+            progress  = true;
+            *received = true;
+        }
+        while (completed < count && !in.empty()) {
+            const auto result = parser.parse(in, responses[completed], requests[completed].method == HttpMethod::Head);
+            if (result == HttpResponseParser::Result::NeedMore)
+                break;
+            if (result == HttpResponseParser::Result::Error) {
+                errno = parser.error();
+                return completed;
+            }
+            // 对端关闭了连接, 之后的请求不会被处理.
+            if (!responses[completed++].keepAlive() && completed < count) {
+                errno = ECONNRESET;
+                return completed;
+            }
+        }
+        if (completed == count)
+            break;
+        if (n == 0) {
+            if (parser.finish(in, responses[completed]) == HttpResponseParser::Result::Complete &&
+                ++completed == count)
+                break;
+            errno = ECONNRESET;
+            return completed;
+        }
+        if (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK)
+            return completed;
+        if (progress)
+            continue;
+        const int wait_result = out.empty() ? waitUntil(fd, false, deadline_ms)
+                                            : waitUntil(fd, true, deadline_ms, kWritePollMs);
+        if (wait_result == -1)
+            return completed;
+    }
+    // 还有未读取的数据或者响应不是keep-alive时连接不能复用.
+    if (!in.empty() || !parser.idle() || !responses[count - 1].keepAlive())
+        handle.markBroken();
+    return count;
+}
+
+}  // namespace lon::net
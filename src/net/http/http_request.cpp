@@ -0,0 +1,294 @@
+#include "net/http/http_request.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace lon::net {
+
+namespace {
+constexpr StringPiece kMethodNames[kHttpMethodCount] = {
+    "GET", "HEAD", "POST", "PUT", "DELETE", "OPTIONS", "PATCH", "CONNECT", "TRACE"};
+
+constexpr char toLower(char c) noexcept {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+constexpr bool isDigit(char c) noexcept {
+    return c >= '0' && c <= '9';
+}
+
+constexpr StringPiece kCrlf = "\r\n";
+}  // namespace
+
+StringPiece trimHttpSpace(StringPiece value) noexcept {
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t'))
+        value.remove_prefix(1);
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t'))
+        value.remove_suffix(1);
+    return value;
+}
+
+bool hasHttpToken(StringPiece list, StringPiece token) noexcept {
+    while (!list.empty()) {
+        const size_t comma = list.find(',');
+        if (equalsIgnoreCase(trimHttpSpace(list.substr(0, comma)), token))
+            return true;
+        if (comma == StringPiece::npos)
+            break;
+        list.remove_prefix(comma + 1);
+    }
+    return false;
+}
+
+bool parseContentLength(StringPiece value, size_t* length) noexcept {
+    if (value.empty() || value.size() > 18 || !std::all_of(value.begin(), value.end(), isDigit))
+        return false;
+    size_t result = 0;
+    for (char c : value) {
+        result = result * 10 + static_cast<size_t>(c - '0');
+    }
+    *length = result;
+    return true;
+}
+
+StringPiece toString(HttpMethod method) noexcept {
+    const auto index = static_cast<size_t>(method);
+    return index < kHttpMethodCount ? kMethodNames[index] : StringPiece("UNKNOWN");
+}
+
+HttpMethod parseHttpMethod(StringPiece method) noexcept {
+    for (size_t i = 0; i < kHttpMethodCount; ++i) {
+        if (kMethodNames[i] == method)
+            return static_cast<HttpMethod>(i);
+    }
+    return HttpMethod::Unknown;
+}
+
+bool equalsIgnoreCase(StringPiece lhs, StringPiece rhs) noexcept {
+    if (lhs.size() != rhs.size())
+        return false;
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        if (toLower(lhs[i]) != toLower(rhs[i]))
+            return false;
+    }
+    return true;
+}
+
+StringPiece HttpRequest::header(StringPiece name) const noexcept {
+    for (const auto& header : headers_) {
+        if (equalsIgnoreCase(header.first, name))
+            return header.second;
+    }
+    return {};
+}
+
+bool HttpRequest::hasHeader(StringPiece name) const noexcept {
+    return std::any_of(headers_.begin(), headers_.end(), [name](const Header& header) {
+        return equalsIgnoreCase(header.first, name);
+    });
+}
+
+StringPiece HttpRequest::param(StringPiece name) const noexcept {
+    for (const auto& param : params_) {
+        if (param.first == name)
+            return param.second;
+    }
+    return {};
+}
+
+void HttpRequest::reset() noexcept {
+    method_ = HttpMethod::Unknown;
+    method_name_ = {};
+    target_      = {};
+    path_        = {};
+    query_       = {};
+    version_minor_ = 1;
+    headers_.clear();
+    params_.clear();
+    body_.clear();
+    keep_alive_     = true;
+    chunked_        = false;
+    content_length_ = 0;
+    raw_header_.clear();
+    gathered_header_.clear();
+}
+
+void HttpRequestParser::reset() noexcept {
+    state_        = State::Header;
+    scanned_      = 0;
+    remaining_    = 0;
+    error_status_ = 0;
+    chunked_.reset();
+}
+
+HttpRequestParser::Result HttpRequestParser::complete() noexcept {
+    state_       = State::Header;
+    scanned_     = 0;
+    remaining_   = 0;
+    return Result::Complete;
+}
+
+HttpRequestParser::Result HttpRequestParser::fail(int status) noexcept {
+    error_status_ = status;
+    return Result::Error;
+}
+
+HttpRequestParser::Result HttpRequestParser::parse(IOBuffer& buffer, HttpRequest& request) {
+    if (state_ == State::Header) {
+        // 这里的Complete表示请求头已经完整.
+        const Result result = parseHeader(buffer, request);
+        if (result != Result::Complete)
+            return result;
+        if (request.chunked_) {
+            state_ = State::Chunked;
+        } else if (request.content_length_ > 0) {
+            state_     = State::Body;
+            remaining_ = request.content_length_;
+        } else {
+            return complete();
+        }
+    }
+    if (state_ == State::Body) {
+        if (buffer.readableBytes() < remaining_)
+            return Result::NeedMore;
+        buffer.splitTo(remaining_, request.body_);
+        return complete();
+    }
+    switch (chunked_.decode(buffer, request.body_)) {
+        case HttpChunkedDecoder::Result::Complete:
+            return complete();
+        case HttpChunkedDecoder::Result::NeedMore:
+            return Result::NeedMore;
+        case HttpChunkedDecoder::Result::Error:
+            break;
+    }
+    return fail(chunked_.errorStatus());
+}
+
+HttpRequestParser::Result HttpRequestParser::parseHeader(IOBuffer& buffer, HttpRequest& request) {
+    if (scanned_ == 0) {
+        // 忽略请求之前多余的空行(see rfc7230 3.5).
+        char crlf[2];
+        while (buffer.copyTo(crlf, 2) == 2 && crlf[0] == '\r' && crlf[1] == '\n') {
+            buffer.consume(2);
+        }
+    }
+    const ssize_t pos = buffer.find("\r\n\r\n", scanned_);
+    if (pos == -1) {
+        const size_t readable = buffer.readableBytes();
+        if (readable > max_header_bytes_)
+            return fail(431);
+        // 空行可能只收到了一部分.
+        scanned_ = readable >= 3 ? readable - 3 : 0;
+        return Result::NeedMore;
+    }
+    scanned_ = 0;
+    const size_t header_len = static_cast<size_t>(pos) + 4;
+    if (header_len > max_header_bytes_)
+        return fail(431);
+
+    request.reset();
+    StringPiece section;
+    if (buffer.front().size() >= header_len) {
+        buffer.splitTo(header_len, request.raw_header_);
+        section = request.raw_header_.front();
+    } else {
+        request.gathered_header_.resize(header_len);
+        buffer.copyTo(request.gathered_header_.data(), header_len);
+        buffer.consume(header_len);
+        section = request.gathered_header_;
+    }
+    if (const int status = parseHeaderSection(section, request); status != 0)
+        return fail(status);
+    return Result::Complete;
+}
+
+int HttpRequestParser::parseHeaderSection(StringPiece section, HttpRequest& request) const {
+    // 请求行: method SP target SP HTTP/1.x
+    const size_t line_end = section.find(kCrlf);
+    const StringPiece line = section.substr(0, line_end);
+    const size_t method_end = line.find(' ');
+    if (method_end == StringPiece::npos || method_end == 0)
+        return 400;
+    const size_t target_end = line.find(' ', method_end + 1);
+    if (target_end == StringPiece::npos || target_end == method_end + 1)
+        return 400;
+    const StringPiece version = line.substr(target_end + 1);
+    if (version.size() != 8 || version.substr(0, 5) != "HTTP/" || version[6] != '.' ||
+        !isDigit(version[5]) || !isDigit(version[7]))
+        return 400;
+    if (version[5] != '1')
+        return 505;
+    request.version_minor_ = version[7] - '0';
+    request.keep_alive_    = request.version_minor_ >= 1;
+
+    request.method_name_ = line.substr(0, method_end);
+    request.method_      = parseHttpMethod(request.method_name_);
+    if (request.method_ == HttpMethod::Unknown)
+        return 501;
+
+    request.target_ = line.substr(method_end + 1, target_end - method_end - 1);
+    StringPiece path = request.target_;
+    if (path.front() != '/' && path != "*") {
+        // absolute-form(代理请求), 去掉scheme和authority.
+        const size_t scheme = path.find("://");
+        if (scheme == StringPiece::npos)
+            return 400;
+        const size_t slash = path.find('/', scheme + 3);
+        path = slash == StringPiece::npos ? StringPiece("/") : path.substr(slash);
+    }
+    const size_t question = path.find('?');
+    request.path_  = path.substr(0, question);
+    request.query_ = question == StringPiece::npos ? StringPiece() : path.substr(question + 1);
+
+    bool has_content_length = false;
+    bool has_transfer_encoding = false;
+    size_t pos = line_end + kCrlf.size();
+    while (true) {
+        const size_t end = section.find(kCrlf, pos);
+        if (end == pos)
+            break;  // 请求头结尾的空行.
+        const StringPiece header_line = section.substr(pos, end - pos);
+        pos = end + kCrlf.size();
+        // 不支持已经废弃的多行header(obs-fold).
+        if (header_line.front() == ' ' || header_line.front() == '\t')
+            return 400;
+        const size_t colon = header_line.find(':');
+        if (colon == StringPiece::npos || colon == 0)
+            return 400;
+        const StringPiece name = header_line.substr(0, colon);
+        if (name.back() == ' ' || name.back() == '\t')
+            return 400;
+        const StringPiece value = trimHttpSpace(header_line.substr(colon + 1));
+        request.headers_.emplace_back(name, value);
+
+        if (equalsIgnoreCase(name, "content-length")) {
+            size_t length = 0;
+            if (!parseContentLength(value, &length))
+                return 400;
+            if (has_content_length && length != request.content_length_)
+                return 400;
+            has_content_length      = true;
+            request.content_length_ = length;
+        } else if (equalsIgnoreCase(name, "transfer-encoding")) {
+            // 只支持chunked, 不解码其它的编码.
+            if (has_transfer_encoding || !equalsIgnoreCase(value, "chunked"))
+                return 501;
+            has_transfer_encoding = true;
+            request.chunked_      = true;
+        } else if (equalsIgnoreCase(name, "connection")) {
+            if (hasHttpToken(value, "close"))
+                request.keep_alive_ = false;
+            else if (hasHttpToken(value, "keep-alive"))
+                request.keep_alive_ = true;
+        }
+    }
+    // 同时存在时无法确定body的边界(请求走私), 直接拒绝.
+    if (has_content_length && has_transfer_encoding)
+        return 400;
+    if (request.content_length_ > max_body_bytes_)
+        return 413;
+    return 0;
+}
+
+}  // namespace lon::net
@@ -0,0 +1,139 @@
+#include "net/http/http_response.h"
+
+#include <cerrno>
+#include <fmt/format.h>
+
+namespace lon::net {
+
+namespace {
+constexpr size_t kChunkedLength = static_cast<size_t>(-1);
+
+void appendChunkHeader(IOBuffer& out, size_t size) {
+    char line[24];
+    const auto end = fmt::format_to(line, "{:x}\r\n", size);
+    out.append(line, static_cast<size_t>(end - line));
+}
+}  // namespace
+
+StringPiece httpStatusReason(int status) noexcept {
+    switch (status) {
+        case 100: return "Continue";
+        case 101: return "Switching Protocols";
+        case 200: return "OK";
+        case 201: return "Created";
+        case 202: return "Accepted";
+        case 204: return "No Content";
+        case 206: return "Partial Content";
+        case 301: return "Moved Permanently";
+        case 302: return "Found";
+        case 304: return "Not Modified";
+        case 307: return "Temporary Redirect";
+        case 308: return "Permanent Redirect";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 408: return "Request Timeout";
+        case 409: return "Conflict";
+        case 411: return "Length Required";
+        case 413: return "Content Too Large";
+        case 414: return "URI Too Long";
+        case 415: return "Unsupported Media Type";
+        case 429: return "Too Many Requests";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 502: return "Bad Gateway";
+        case 503: return "Service Unavailable";
+        case 504: return "Gateway Timeout";
+        case 505: return "HTTP Version Not Supported";
+        default: return "Unknown";
+    }
+}
+
+void HttpResponse::addHeader(StringPiece name, StringPiece value) {
+    headers_.append(name.data(), name.size());
+    headers_.append(": ", 2);
+    headers_.append(value.data(), value.size());
+    headers_.append("\r\n", 2);
+}
+
+void HttpResponse::writeHeader(size_t content_length) {
+    // 1xx, 204以及304没有body(see rfc7230 3.3.3).
+    const bool body_allowed = status_ >= 200 && status_ != 204 && status_ != 304;
+    fmt::memory_buffer header;
+    const StringPiece reason = httpStatusReason(status_);
+    fmt::format_to(std::back_inserter(header), "HTTP/1.1 {} {}\r\n", status_, reason);
+    header.append(headers_.data(), headers_.data() + headers_.size());
+    if (body_allowed) {
+        if (content_length == kChunkedLength)
+            fmt::format_to(std::back_inserter(header), "Transfer-Encoding: chunked\r\n");
+        else
+            fmt::format_to(std::back_inserter(header), "Content-Length: {}\r\n", content_length);
+    }
+    if (!keep_alive_)
+        fmt::format_to(std::back_inserter(header), "Connection: close\r\n");
+    else if (version_minor_ == 0)
+        fmt::format_to(std::back_inserter(header), "Connection: keep-alive\r\n");
+    fmt::format_to(std::back_inserter(header), "\r\n");
+    connection_.outputBuffer().append(header.data(), header.size());
+    if (!body_allowed)
+        head_request_ = true;  // 之后的body都不发送.
+}
+
+int HttpResponse::writeChunk(StringPiece data) {
+    if (finished_) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!chunkedAllowed()) {
+        body_.append(data);
+        return 0;
+    }
+    IOBuffer& out = connection_.outputBuffer();
+    if (!header_sent_) {
+        writeHeader(kChunkedLength);
+        header_sent_ = true;
+        if (!body_.empty() && !head_request_) {
+            appendChunkHeader(out, body_.readableBytes());
+            out.append(std::move(body_));
+            out.append("\r\n");
+        }
+        body_.clear();
+    }
+    // 空的chunk表示结束, 留给finish.
+    if (data.empty() || head_request_)
+        return connection_.commitOutput();
+    appendChunkHeader(out, data.size());
+    out.append(data);
+    out.append("\r\n");
+    return connection_.commitOutput();
+}
+
+int HttpResponse::finish() {
+    if (finished_)
+        return 0;
+    finished_ = true;
+    if (header_sent_) {
+        IOBuffer& out = connection_.outputBuffer();
+        if (!head_request_) {
+            if (!body_.empty()) {
+                appendChunkHeader(out, body_.readableBytes());
+                out.append(std::move(body_));
+                out.append("\r\n");
+            }
+            out.append("0\r\n\r\n");
+        }
+        body_.clear();
+        return connection_.commitOutput();
+    }
+    writeHeader(body_.readableBytes());
+    if (head_request_) {
+        body_.clear();
+        return connection_.commitOutput();
+    }
+    return connection_.write(std::move(body_));
+}
+
+}  // namespace lon::net
@@ -0,0 +1,168 @@
+#include "net/http/http_router.h"
+
+namespace lon::net {
+
+struct HttpRouter::Node
+{
+    String segment;
+    // 子节点通常很少, 线性查找比hash更快.
+    std::vector<std::unique_ptr<Node>> statics;
+    std::unique_ptr<Node> param;
+    String param_name;
+    std::unique_ptr<Node> wildcard;
+    String wildcard_name;
+    Handler handlers[kHttpMethodCount];
+
+    bool hasHandler() const noexcept {
+        for (const auto& handler : handlers) {
+            if (handler)
+                return true;
+        }
+        return false;
+    }
+};
+
+HttpRouter::HttpRouter() : root_{std::make_unique<Node>()} {}
+
+HttpRouter::~HttpRouter() = default;
+
+HttpRouter::HttpRouter(HttpRouter&&) noexcept = default;
+
+auto HttpRouter::operator=(HttpRouter&&) noexcept -> HttpRouter& = default;
+
+bool HttpRouter::add(HttpMethod method, StringPiece pattern, Handler handler) {
+    if (method == HttpMethod::Unknown || !handler || pattern.empty() || pattern.front() != '/')
+        return false;
+    Node* node          = root_.get();
+    StringPiece remaining = pattern.substr(1);
+    bool at_end           = remaining.empty();
+    while (!at_end) {
+        const size_t slash        = remaining.find('/');
+        const StringPiece segment = remaining.substr(0, slash);
+        at_end    = slash == StringPiece::npos;
+        remaining = at_end ? StringPiece() : remaining.substr(slash + 1);
+
+        if (!segment.empty() && segment.front() == ':') {
+            const StringPiece name = segment.substr(1);
+            if (!node->param) {
+                node->param      = std::make_unique<Node>();
+                node->param_name = String(name);
+            } else if (node->param_name != name) {
+                return false;
+            }
+            node = node->param.get();
+        } else if (!segment.empty() && segment.front() == '*') {
+            const StringPiece name = segment.substr(1);
+            if (!at_end)
+                return false;
+            if (!node->wildcard) {
+                node->wildcard      = std::make_unique<Node>();
+                node->wildcard_name = String(name);
+            } else if (node->wildcard_name != name) {
+                return false;
+            }
+            node = node->wildcard.get();
+        } else {
+            Node* child = nullptr;
+            for (auto& item : node->statics) {
+                if (item->segment == segment) {
+                    child = item.get();
+                    break;
+                }
+            }
+            if (!child) {
+                node->statics.push_back(std::make_unique<Node>());
+                child          = node->statics.back().get();
+                child->segment = String(segment);
+            }
+            node = child;
+        }
+    }
+    auto& slot = node->handlers[static_cast<size_t>(method)];
+    if (slot)
+        return false;
+    slot = std::move(handler);
+    return true;
+}
+
+const HttpRouter::Node* HttpRouter::find(const Node* node,
+                                         StringPiece remaining,
+                                         bool at_end,
+                                         std::vector<HttpRequest::Header>& params) const {
+    if (at_end)
+        return node->hasHandler() ? node : nullptr;
+    const size_t slash        = remaining.find('/');
+    const StringPiece segment = remaining.substr(0, slash);
+    const bool next_at_end    = slash == StringPiece::npos;
+    const StringPiece next    = next_at_end ? StringPiece() : remaining.substr(slash + 1);
+
+    for (const auto& child : node->statics) {
+        if (child->segment == segment) {
+            if (const Node* result = find(child.get(), next, next_at_end, params))
+                return result;
+            break;
+        }
+    }
+    if (node->param && !segment.empty()) {
+        params.emplace_back(node->param_name, segment);
+        if (const Node* result = find(node->param.get(), next, next_at_end, params))
+            return result;
+        params.pop_back();
+    }
+    if (node->wildcard && node->wildcard->hasHandler()) {
+        params.emplace_back(node->wildcard_name, remaining);
+        return node->wildcard.get();
+    }
+    return nullptr;
+}
+
+const HttpRouter::Handler* HttpRouter::match(HttpRequest& request, bool* path_matched) const {
+    request.params_.clear();
+    const StringPiece path = request.path();
+    const Node* node       = nullptr;
+    if (!path.empty() && path.front() == '/')
+        node = find(root_.get(), path.substr(1), path.size() == 1, request.params_);
+    if (path_matched)
+        *path_matched = node != nullptr;
+    if (!node || request.method() == HttpMethod::Unknown)
+        return nullptr;
+    const Handler* handler = &node->handlers[static_cast<size_t>(request.method())];
+    if (!*handler && request.method() == HttpMethod::Head)
+        handler = &node->handlers[static_cast<size_t>(HttpMethod::Get)];
+    return *handler ? handler : nullptr;
+}
+
+void HttpRouter::dispatch(HttpRequest& request, HttpResponse& response) const {
+    bool path_matched = false;
+    if (const Handler* handler = match(request, &path_matched)) {
+        (*handler)(request, response);
+        return;
+    }
+    if (path_matched) {
+        // 错误路径上再查找一次, 生成Allow.
+        std::vector<HttpRequest::Header> params;
+        const Node* node = find(root_.get(), request.path().substr(1), request.path().size() == 1, params);
+        String allow;
+        for (size_t i = 0; i < kHttpMethodCount; ++i) {
+            // 有GET时HEAD也是允许的.
+            const bool allowed = node->handlers[i] ||
+                                 (i == static_cast<size_t>(HttpMethod::Head) &&
+                                  node->handlers[static_cast<size_t>(HttpMethod::Get)]);
+            if (!allowed)
+                continue;
+            if (!allow.empty())
+                allow.append(", ");
+            allow.append(toString(static_cast<HttpMethod>(i)));
+        }
+        response.setStatus(405);
+        response.addHeader("Allow", allow);
+        return;
+    }
+    if (not_found_) {
+        not_found_(request, response);
+        return;
+    }
+    response.setStatus(404);
+}
+
+}  // namespace lon::net
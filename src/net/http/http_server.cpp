@@ -0,0 +1,129 @@
+#include "net/http/http_server.h"
+
+#include "base.h"
+#include "base/chrono_helper.h"
+#include "io/co_io_function.h"
+#include "io/fd_manager.h"
+
+#include <cerrno>
+
+static lon::log::LoggerSlot G_logger{"system"};
+
+namespace lon::net {
+
+namespace {
+/**
+ * @brief 请求不合法或者超时时发送只有状态码的响应, 之后关闭连接.
+ */
+void sendError(TcpConnection& connection, int status) {
+    HttpResponse response(connection, false, false, 1);
+    response.setStatus(status);
+    response.finish();
+}
+}  // namespace
+
+HttpServerOptions HttpServerOptions::fromConfig(const String& prefix) {
+    HttpServerOptions options;
+    auto config = BaseMainConfig::getInstance();
+    options.max_header_bytes =
+        config->getIfExists<size_t>(prefix + ".max_header_bytes", options.max_header_bytes);
+    options.max_body_bytes =
+        config->getIfExists<size_t>(prefix + ".max_body_bytes", options.max_body_bytes);
+    options.header_timeout_ms =
+        config->getIfExists<size_t>(prefix + ".header_timeout_ms", options.header_timeout_ms);
+    options.keepalive_timeout_ms =
+        config->getIfExists<size_t>(prefix + ".keepalive_timeout_ms", options.keepalive_timeout_ms);
+    options.write_timeout_ms =
+        config->getIfExists<size_t>(prefix + ".write_timeout_ms", options.write_timeout_ms);
+    options.max_requests_per_connection = config->getIfExists<size_t>(
+        prefix + ".max_requests_per_connection", options.max_requests_per_connection);
+    return options;
+}
+
+HttpServer::HttpServer(HttpRouter router,
+                       HttpServerOptions options,
+                       std::unique_ptr<io::IOWorkBalancer> balancer)
+    : shared_{std::make_shared<const Shared>(Shared{std::move(router), options})} {
+    server_ = std::make_shared<TcpServer>(
+        [shared = shared_](std::shared_ptr<TcpConnection> connection) {
+            serveConnection(*connection, shared->router, shared->options);
+            connection->getSocket().close();
+        },
+        std::move(balancer));
+}
+
+void HttpServer::serveConnection(TcpConnection& connection,
+                                 const HttpRouter& router,
+                                 const HttpServerOptions& options) {
+    const int fd = connection.getSocket().fd();
+    if (auto context = io::FdManager::getInstance()->getContext(fd))
+        context->writeTimeout = options.write_timeout_ms;
+
+    HttpRequestParser parser(options.max_header_bytes, options.max_body_bytes);
+    HttpRequest request;
+    IOBuffer in;
+    size_t served      = 0;
+    bool in_request    = false;
+    bool continue_sent = false;
+    steady_clock::time_point request_begin;
+    while (true) {
+        const auto result = parser.parse(in, request);
+        if (result == HttpRequestParser::Result::Complete) {
+            ++served;
+            const bool last = options.max_requests_per_connection != 0 &&
+                              served >= options.max_requests_per_connection;
+            HttpResponse response(connection,
+                                  request.method() == HttpMethod::Head,
+                                  request.keepAlive() && !last,
+                                  request.versionMinor());
+            router.dispatch(request, response);
+            // 响应只是放入写队列, 同一批请求的响应在下一次readInto之前合并发送.
+            const int written = response.finish();
+            request.reset();
+            in_request    = false;
+            continue_sent = false;
+            if (written == -1 || !response.keepAlive())
+                break;
+            continue;
+        }
+        if (result == HttpRequestParser::Result::Error) {
+            LON_LOG_DEBUG(G_logger) << fmt::format(
+                "http request error, fd:{}, status:{}", fd, parser.errorStatus());
+            sendError(connection, parser.errorStatus());
+            break;
+        }
+
+        if (!in_request && !(in.empty() && parser.idle())) {
+            in_request    = true;
+            request_begin = steady_clock::now();
+        }
+        if (parser.awaitingBody() && !continue_sent &&
+            equalsIgnoreCase(request.header("Expect"), "100-continue")) {
+            connection.write("HTTP/1.1 100 Continue\r\n\r\n");
+            continue_sent = true;
+        }
+        // 不在recv中挂起, 这样空闲连接和读取到一半的请求可以使用不同的超时.
+        const ssize_t n = connection.readInto(in, TcpConnection::kMaxReadBytes, MSG_DONTWAIT);
+        if (n > 0)
+            continue;
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+            break;
+        size_t timeout_ms = options.keepalive_timeout_ms;
+        if (in_request) {
+            const auto elapsed = static_cast<size_t>(getTimeSpanMs(request_begin, steady_clock::now()));
+            if (elapsed >= options.header_timeout_ms) {
+                sendError(connection, 408);
+                break;
+            }
+            timeout_ms = options.header_timeout_ms - elapsed;
+        }
+        if (io::co_waitEvent(fd, false, timeout_ms) == -1) {
+            if (in_request && errno == ETIMEDOUT)
+                sendError(connection, 408);
+            break;
+        }
+    }
+    connection.flush();
+}
+
+}  // namespace lon::net
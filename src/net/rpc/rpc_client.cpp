@@ -0,0 +1,218 @@
+#include "net/rpc/rpc_client.h"
+
+#include "io/co_io_function.h"
+#include "io/co_waiter.h"
+#include "io/io_manager.h"
+#include "logger.h"
+#include "net/tcp/codec.h"
+#include "net/tcp/connector.h"
+
+#include <cerrno>
+#include <fmt/core.h>
+#include <unordered_map>
+
+static lon::log::LoggerSlot G_logger{"system"};
+
+namespace lon::net {
+
+namespace {
+struct PendingCall
+{
+    io::CoWaiter waiter;
+    IOBuffer response;
+    RpcStatus status = RpcStatus::Disconnected;
+    bool done        = false;
+};
+}  // namespace
+
+struct RpcClient::Channel
+{
+    std::unique_ptr<TcpConnection> connection;
+    Options options;
+    // 还没有发送的请求, 由写协程发送.
+    IOBuffer out;
+    std::unordered_map<uint64_t, PendingCall*> pending;
+    uint64_t next_id = 1;
+    bool closed      = false;
+    io::CoWaiter write_waiter;
+    io::Canceler read_canceler;
+    io::Canceler write_canceler;
+    Stats stats;
+
+    /**
+     * @brief 把响应交给等待中的调用.
+     * @return 帧格式错误时返回false.
+     */
+    bool deliver(IOBuffer& frame);
+
+    /**
+     * @brief 关闭连接并唤醒所有协程, 挂起中的调用返回Disconnected.
+     */
+    void shutdown();
+
+    static void readLoop(const std::shared_ptr<Channel>& channel);
+    static void writeLoop(const std::shared_ptr<Channel>& channel);
+};
+
+bool RpcClient::Channel::deliver(IOBuffer& frame) {
+    RpcHeader header;
+    if (!header.decode(frame) || header.type != RpcHeader::Type::Response)
+        return false;
+    auto iter = pending.find(header.request_id);
+    if (iter == pending.end()) {
+        // 调用已经超时返回.
+        ++stats.late;
+        return true;
+    }
+    PendingCall* call = iter->second;
+    pending.erase(iter);
+    call->status   = header.status;
+    call->response = std::move(frame);
+    call->done     = true;
+    call->waiter.notify();
+    return true;
+}
+
+void RpcClient::Channel::shutdown() {
+    if (closed)
+        return;
+    closed = true;
+    read_canceler.cancel();
+    write_canceler.cancel();
+    write_waiter.notify();
+    auto calls = std::move(pending);
+    pending.clear();
+    for (auto& item : calls) {
+        item.second->done = true;
+        item.second->waiter.notify();
+    }
+    // 读写协程被唤醒以后看到closed直接退出, 不会再使用fd.
+    connection->getSocket().close();
+}
+
+void RpcClient::Channel::readLoop(const std::shared_ptr<Channel>& channel) {
+    TcpConnection& connection = *channel->connection;
+    const int fd              = connection.getSocket().fd();
+    LengthFieldCodec codec(LengthFieldCodec::FieldSize::U32,
+                           LengthFieldCodec::Endian::Big,
+                           channel->options.max_frame_length);
+    IOBuffer in;
+    IOBuffer frame;
+    while (!channel->closed) {
+        const ssize_t n = connection.readInto(in, TcpConnection::kMaxReadBytes, MSG_DONTWAIT);
+        if (n > 0) {
+            FrameCodec::DecodeResult result;
+            while ((result = codec.decode(in, frame)) == FrameCodec::DecodeResult::Frame) {
+                if (!channel->deliver(frame)) {
+                    result = FrameCodec::DecodeResult::Error;
+                    break;
+                }
+            }
+            if (result == FrameCodec::DecodeResult::Error) {
+                LON_LOG_WARN(G_logger) << fmt::format("rpc client bad response frame, fd:{}", fd);
+                break;
+            }
+            continue;
+        }
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+            break;
+        if (io::co_waitEvent(fd, false, static_cast<size_t>(-1), &channel->read_canceler) == -1)
+            break;
+    }
+    channel->shutdown();
+}
+
+void RpcClient::Channel::writeLoop(const std::shared_ptr<Channel>& channel) {
+    TcpConnection& connection = *channel->connection;
+    const int fd              = connection.getSocket().fd();
+    while (!channel->closed) {
+        if (channel->out.empty()) {
+            // 调用方notify以后, 写协程排在同一轮已经就绪的协程之后执行, 这期间发起的调用会合并发送.
+            channel->write_waiter.wait();
+            continue;
+        }
+        const ssize_t n = connection.writeFrom(channel->out, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (n > 0) {
+            ++channel->stats.flushes;
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            channel->shutdown();
+            break;
+        }
+        if (io::co_waitEvent(fd, true, static_cast<size_t>(-1), &channel->write_canceler) == -1)
+            break;
+    }
+}
+
+std::unique_ptr<RpcClient> RpcClient::connect(StringArg host, uint16_t port, Options options) {
+    std::unique_ptr<TcpConnection> connection = nullptr;
+    try {
+        connection = TcpConnector::connect(host, port, options.connect_timeout_ms);
+    } catch (const std::invalid_argument& e) {
+        LON_LOG_WARN(G_logger) << "rpc client resolve failed:" << e.what();
+        errno = EHOSTUNREACH;
+    }
+    if (!connection)
+        return nullptr;
+    return std::make_unique<RpcClient>(std::move(connection), options);
+}
+
+RpcClient::RpcClient(std::unique_ptr<TcpConnection> connection, Options options)
+    : channel_{std::make_shared<Channel>()} {
+    channel_->connection = std::move(connection);
+    channel_->options    = options;
+    channel_->connection->getSocket().setTcpNoDelay(true);
+    auto io_manager = io::IOManager::getThreadLocal();
+    io_manager->addExecutor(std::make_shared<coroutine::Executor>(
+        [channel = channel_]() { Channel::readLoop(channel); }));
+    io_manager->addExecutor(std::make_shared<coroutine::Executor>(
+        [channel = channel_]() { Channel::writeLoop(channel); }));
+}
+
+RpcClient::~RpcClient() {
+    close();
+}
+
+void RpcClient::close() {
+    channel_->shutdown();
+}
+
+bool RpcClient::connected() const noexcept {
+    return !channel_->closed;
+}
+
+size_t RpcClient::pendingCalls() const noexcept {
+    return channel_->pending.size();
+}
+
+auto RpcClient::getStats() const noexcept -> const Stats& {
+    return channel_->stats;
+}
+
+RpcStatus RpcClient::callRaw(uint32_t method_id, IOBuffer&& request, IOBuffer& response, size_t timeout_ms) {
+    // 等待期间client可能被其它协程析构.
+    const auto channel = channel_;
+    if (channel->closed)
+        return RpcStatus::Disconnected;
+    PendingCall call;
+    const uint64_t id = channel->next_id++;
+    encodeRpcFrame(RpcHeader{RpcHeader::Type::Request, RpcStatus::Ok, method_id, id},
+                   std::move(request),
+                   channel->out);
+    channel->pending.emplace(id, &call);
+    ++channel->stats.calls;
+    if (channel->write_waiter.waiting())
+        channel->write_waiter.notify();
+
+    call.waiter.wait(timeout_ms == static_cast<size_t>(-1) ? channel->options.timeout_ms : timeout_ms);
+    if (!call.done) {
+        channel->pending.erase(id);
+        return RpcStatus::DeadlineExceeded;
+    }
+    if (call.status == RpcStatus::Ok)
+        response = std::move(call.response);
+    return call.status;
+}
+
+}  // namespace lon::net
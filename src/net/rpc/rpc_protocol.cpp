@@ -0,0 +1,82 @@
+#include "net/rpc/rpc_protocol.h"
+
+#include <endian.h>
+
+namespace lon::net {
+
+namespace {
+// 小于该长度的body拷贝到out的末尾, 避免每个响应占用一个block以及iovec.
+constexpr size_t kCopyBodyThreshold = IOBuffer::kBlockSize / 4;
+}  // namespace
+
+StringPiece toString(RpcStatus status) noexcept {
+    switch (status) {
+        case RpcStatus::Ok:
+            return "Ok";
+        case RpcStatus::NoMethod:
+            return "NoMethod";
+        case RpcStatus::BadRequest:
+            return "BadRequest";
+        case RpcStatus::HandlerError:
+            return "HandlerError";
+        case RpcStatus::BadResponse:
+            return "BadResponse";
+        case RpcStatus::DeadlineExceeded:
+            return "DeadlineExceeded";
+        case RpcStatus::Disconnected:
+            return "Disconnected";
+    }
+    return "Unknown";
+}
+
+bool RpcHeader::decode(IOBuffer& frame) noexcept {
+    char raw[kSize];
+    if (frame.copyTo(raw, kSize) != kSize)
+        return false;
+    frame.consume(kSize);
+    if (static_cast<uint8_t>(raw[0]) > static_cast<uint8_t>(Type::Response) ||
+        !isWireStatus(static_cast<RpcStatus>(raw[1])))
+        return false;
+    type   = static_cast<Type>(raw[0]);
+    status = static_cast<RpcStatus>(raw[1]);
+    uint32_t method = 0;
+    uint64_t id     = 0;
+    ::memcpy(&method, raw + 4, sizeof(method));
+    ::memcpy(&id, raw + 8, sizeof(id));
+    method_id  = be32toh(method);
+    request_id = be64toh(id);
+    return true;
+}
+
+void encodeRpcFrame(const RpcHeader& header, IOBuffer&& body, IOBuffer& out) {
+    const size_t body_size = body.readableBytes();
+    constexpr size_t kLengthField = RpcHeader::kLengthField;
+    char raw[kLengthField + RpcHeader::kSize] = {};
+    const uint32_t length = htobe32(static_cast<uint32_t>(RpcHeader::kSize + body_size));
+    const uint32_t method = htobe32(header.method_id);
+    const uint64_t id     = htobe64(header.request_id);
+    ::memcpy(raw, &length, sizeof(length));
+    raw[kLengthField]     = static_cast<char>(header.type);
+    raw[kLengthField + 1] = static_cast<char>(header.status);
+    ::memcpy(raw + kLengthField + 4, &method, sizeof(method));
+    ::memcpy(raw + kLengthField + 8, &id, sizeof(id));
+    out.append(raw, sizeof(raw));
+    if (body_size == 0)
+        return;
+    if (body_size < kCopyBodyThreshold) {
+        iovec iov[8];
+        while (!body.empty()) {
+            const size_t count = body.peekIovec(iov, 8);
+            size_t copied      = 0;
+            for (size_t i = 0; i < count; ++i) {
+                out.append(iov[i].iov_base, iov[i].iov_len);
+                copied += iov[i].iov_len;
+            }
+            body.consume(copied);
+        }
+    } else {
+        out.append(std::move(body));
+    }
+}
+
+}  // namespace lon::net
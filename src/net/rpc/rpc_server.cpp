@@ -0,0 +1,61 @@
+#include "net/rpc/rpc_server.h"
+
+#include "logger.h"
+#include "net/tcp/codec.h"
+
+#include <cerrno>
+#include <fmt/core.h>
+
+static lon::log::LoggerSlot G_logger{"system"};
+
+namespace lon::net {
+
+RpcServer::RpcServer(RpcDispatcher dispatcher,
+                     std::unique_ptr<io::IOWorkBalancer> balancer,
+                     size_t max_frame_length)
+    : dispatcher_{std::make_shared<const RpcDispatcher>(std::move(dispatcher))} {
+    server_ = std::make_shared<TcpServer>(
+        [dispatcher = dispatcher_, max_frame_length](std::shared_ptr<TcpConnection> connection) {
+            serveConnection(*connection, *dispatcher, max_frame_length);
+            connection->getSocket().close();
+        },
+        std::move(balancer));
+}
+
+void RpcServer::serveConnection(TcpConnection& connection,
+                                const RpcDispatcher& dispatcher,
+                                size_t max_frame_length) {
+    connection.getSocket().setTcpNoDelay(true);
+    LengthFieldCodec codec(LengthFieldCodec::FieldSize::U32, LengthFieldCodec::Endian::Big, max_frame_length);
+    IOBuffer in;
+    IOBuffer response;
+    const int result = readFrames(connection, codec, in, [&](IOBuffer& frame) {
+        RpcHeader header;
+        if (!header.decode(frame) || header.type != RpcHeader::Type::Request) {
+            errno = EPROTO;
+            return false;
+        }
+        header.type   = RpcHeader::Type::Response;
+        header.status = dispatcher(header.method_id, frame, response);
+        if (UNLIKELY(!isWireStatus(header.status))) {
+            // 客户端会把这样的响应当作帧错误并关闭整个连接.
+            LON_LOG_WARN(G_logger) << fmt::format(
+                "rpc handler returned non-wire status {}, method:{}, reply HandlerError",
+                toString(header.status), header.method_id);
+            header.status = RpcStatus::HandlerError;
+        }
+        if (header.status != RpcStatus::Ok)
+            response.clear();
+        // 响应在下一次读取之前合并发送.
+        encodeRpcFrame(header, std::move(response), connection.outputBuffer());
+        response.clear();
+        return connection.commitOutput() == 0;
+    });
+    if (result != 0) {
+        LON_LOG_DEBUG(G_logger) << fmt::format(
+            "rpc connection closed, fd:{}, errno:{}", connection.getSocket().fd(), errno);
+    }
+    connection.flush();
+}
+
+}  // namespace lon::net
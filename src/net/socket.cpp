@@ -8,7 +8,7 @@
 #include <fmt/core.h>
 #include <netinet/tcp.h>
 
-static auto G_logger = lon::LogManager::getInstance() -> getLogger("system");
+static lon::log::LoggerSlot G_logger{"system"};
 namespace lon::net {
 
 Socket::Socket(int _domain, int _type, int _protocol) {
@@ -31,11 +31,28 @@ std::unique_ptr<TcpConnection> Socket::accept() const {
     if (fd_ == -1 || local_address == nullptr) {
         return nullptr;
     }
-    sa_family_t family          = local_address->getFamily();
-    auto [peer_addr, accept_fd] = sockopt::accept(fd_, family);
-    Socket accept_socket(accept_fd);
-    accept_socket.local_address = local_address;
-    return std::make_unique<TcpConnection>(accept_socket, std::move(peer_addr));
+    InetAddress peer_addr;
+    Socket accept_socket = accept4(peer_addr, 0);
+    LON_ERROR_INVOKE_ASSERT(accept_socket.fd() != -1, accept, fmt::format("sockfd = {}", fd_), G_logger);
+    return std::make_unique<TcpConnection>(accept_socket, peer_addr);
+}
+
+std::unique_ptr<TcpConnection> Socket::accept4(int flags) const {
+    if (fd_ == -1 || local_address == nullptr) {
+        return nullptr;
+    }
+    InetAddress peer_addr;
+    Socket accept_socket = accept4(peer_addr, flags);
+    if (accept_socket.fd() == -1)
+        return nullptr;
+    return std::make_unique<TcpConnection>(accept_socket, peer_addr);
+}
+
+Socket Socket::accept4(InetAddress& peer_addr, int flags) const {
+    Socket accept_socket(sockopt::accept4(fd_, &peer_addr, flags));
+    if (accept_socket.fd_ != -1)
+        accept_socket.local_address = local_address;
+    return accept_socket;
 }
 
 int Socket::listen(int backlog) const {
@@ -44,20 +61,36 @@ int Socket::listen(int backlog) const {
 
 std::unique_ptr<TcpConnection> Socket::connect(
     lon::net::SockAddress::UniquePtr peer_addr) const {
+    return connect(std::move(peer_addr), static_cast<size_t>(-1));
+}
+
+std::unique_ptr<TcpConnection> Socket::connect(
+    lon::net::SockAddress::UniquePtr peer_addr,
+    size_t timeout_ms,
+    io::Canceler* canceler) const {
+    if (!peer_addr)
+        return nullptr;
+    return connect(InetAddress(*peer_addr), timeout_ms, canceler);
+}
+
+std::unique_ptr<TcpConnection> Socket::connect(const InetAddress& peer_addr,
+                                               size_t timeout_ms,
+                                               io::Canceler* canceler) const {
     if (fd_ == -1)
         return nullptr;
-    if (!peer_addr)
+    int ret = sockopt::connect(fd_, peer_addr, timeout_ms, canceler);
+    if (ret == -1) {
+        const int saved_errno = errno;
+        LON_LOG_WARN(G_logger) << fmt::format(
+            "connect failed, fd:{}, err:{}(with {}), peer addr:{}",
+            fd_,
+            std::strerror(saved_errno),
+            saved_errno,
+            peer_addr.toString());
+        errno = saved_errno;
         return nullptr;
-    int ret = ::connect(fd_, peer_addr->getAddr(), peer_addr->getAddrLen());
-    LON_ERROR_INVOKE_ASSERT(ret != -1,
-                            "connect",
-                            fmt::format("fd:{}, err:{}(with {}), peer addr:{}",
-                                        fd_,
-                                        std::strerror(errno),
-                                        errno,
-                                        peer_addr->toString()),
-                            G_logger);
-    return std::make_unique<TcpConnection>(Socket(*this), std::move(peer_addr));
+    }
+    return std::make_unique<TcpConnection>(Socket(*this), peer_addr);
 }
 
 void Socket::shutdownWrite() const {
@@ -66,7 +99,7 @@ void Socket::shutdownWrite() const {
 }
 
 void Socket::setTcpNoDelay(bool on) const {
-    sockopt::setTcpNoDelay(fd_, true);
+    sockopt::setTcpNoDelay(fd_, on);
 }
 
 void Socket::setReuseAddr(bool on) const {
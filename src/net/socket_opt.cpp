@@ -1,10 +1,14 @@
 #include "net/socket_opt.h"
+#include "io/co_io_function.h"
+#include "io/hook.h"
 #include "logger.h"
+#include <fcntl.h>
+#include <poll.h>
 #include <netinet/tcp.h>
 #include <cassert>
 #include <fmt/core.h>
 
-static auto G_logger = lon::LogManager::getInstance()->getLogger("system");
+static lon::log::LoggerSlot G_logger{"system"};
 
 namespace lon::sockopt {
 
@@ -12,6 +16,55 @@ int connect(int sock_fd, const lon::net::SockAddress& sock_address) {
     return ::connect(sock_fd, sock_address.getAddr(), sock_address.getAddrLen());
 }
 
+int connect(int sock_fd,
+            const lon::net::SockAddress& sock_address,
+            size_t timeout_ms,
+            lon::io::Canceler* canceler) {
+    if (timeout_ms == static_cast<size_t>(-1) && !canceler)
+        return connect(sock_fd, sock_address);
+    if (lon::io::isHookEnabled()) {
+        return lon::io::co_connectWithTimeout(sock_fd,
+                                              sock_address.getAddr(),
+                                              sock_address.getAddrLen(),
+                                              timeout_ms,
+                                              canceler);
+    }
+
+    // 非hook线程, 临时设置为非阻塞然后poll等待.
+    const int flags = ::fcntl(sock_fd, F_GETFL, 0);
+    if (!(flags & O_NONBLOCK))
+        ::fcntl(sock_fd, F_SETFL, flags | O_NONBLOCK);
+
+    int ret = connect(sock_fd, sock_address);
+    if (ret == -1 && errno == EINPROGRESS) {
+        pollfd poll_fd{sock_fd, POLLOUT, 0};
+        const int poll_timeout = timeout_ms > static_cast<size_t>(INT32_MAX)
+                                     ? -1
+                                     : static_cast<int>(timeout_ms);
+        int n_ready = 0;
+        do {
+            n_ready = ::poll(&poll_fd, 1, poll_timeout);
+        } while (n_ready == -1 && errno == EINTR);
+
+        if (n_ready == 0) {
+            errno = ETIMEDOUT;
+        } else if (n_ready > 0) {
+            int error     = 0;
+            socklen_t len = sizeof(error);
+            ::getsockopt(sock_fd, SOL_SOCKET, SO_ERROR, &error, &len);
+            ret   = error ? -1 : 0;
+            errno = error;
+        }
+    }
+
+    if (!(flags & O_NONBLOCK)) {
+        const int saved_errno = errno;
+        ::fcntl(sock_fd, F_SETFL, flags);
+        errno = saved_errno;
+    }
+    return ret;
+}
+
 std::pair<lon::net::SockAddress::UniquePtr, int>  accept(int sock_fd) {
     sa_family_t type;
     socklen_t length = sizeof(int);
@@ -21,6 +74,12 @@ std::pair<lon::net::SockAddress::UniquePtr, int>  accept(int sock_fd) {
 }
 
 std::pair<lon::net::SockAddress::UniquePtr, int>  accept(int sock_fd, sa_family_t family) {
+    auto result = accept4(sock_fd, family, 0);
+    LON_ERROR_INVOKE_ASSERT(result.second !=-1, accept, fmt::format("sockfd = {}", sock_fd),G_logger);
+    return result;
+}
+
+std::pair<lon::net::SockAddress::UniquePtr, int> accept4(int sock_fd, sa_family_t family, int flags) {
     lon::net::SockAddress::UniquePtr result = nullptr;
     switch (family) {
     case AF_INET:
@@ -36,11 +95,24 @@ std::pair<lon::net::SockAddress::UniquePtr, int>  accept(int sock_fd, sa_family_
         throw std::invalid_argument(fmt::format("invalid family:{}", family));
     }
     socklen_t len = result->getAddrLen();
-    int ret = ::accept(sock_fd, result->getAddrMutable(), &len);
-    LON_ERROR_INVOKE_ASSERT(ret !=-1, accept, fmt::format("sockfd = {}", sock_fd),G_logger);
+    int ret = ::accept4(sock_fd, result->getAddrMutable(), &len, flags);
+    if (ret != -1 && family == AF_UNIX) {
+        // unix地址是变长的, 对端通常是未命名的地址.
+        static_cast<lon::net::UnixAddress*>(result.get())->setAddrLen(len);
+    }
     return {std::move(result), ret};
 }
 
+int accept4(int sock_fd, lon::net::InetAddress* peer_addr, int flags) {
+    if (!peer_addr)
+        return ::accept4(sock_fd, nullptr, nullptr, flags);
+    socklen_t len = sizeof(sockaddr_storage);
+    int ret = ::accept4(sock_fd, peer_addr->getAddrMutable(), &len, flags);
+    if (ret != -1)
+        peer_addr->setAddrLen(len);
+    return ret;
+}
+
 void shutdownWrite(int sock_fd) {
     int ret = ::shutdown(sock_fd, SHUT_WR);
     LON_ERROR_INVOKE_ASSERT(ret == 0, shutdown, fmt::format("sockfd = {}", sock_fd),G_logger);
@@ -50,6 +122,9 @@ void shutdownWrite(int sock_fd) {
 void setTcpNoDelay(int sock_fd, bool on) {
     int opval = on ? 1 : 0;
     int ret = ::setsockopt(sock_fd, IPPROTO_TCP, TCP_NODELAY, &opval, static_cast<socklen_t>(sizeof(opval)));
+    // unix socket等非tcp的流式socket没有nagle算法, 忽略.
+    if (ret == -1 && errno == EOPNOTSUPP)
+        return;
     LON_ERROR_INVOKE_ASSERT(ret == 0, setsockopt, fmt::format("type tcpnodelay, opt:{}, sockfd = {}", on, sock_fd),G_logger);
 }
 
@@ -131,7 +206,10 @@ ssize_t recvFrom(int sock_fd,
              size_t length,
              lon::net::SockAddress* peer_addr, int flags) {
     socklen_t len = peer_addr->getAddrLen();
-    return ::recvfrom(sock_fd, buffer, length, flags, peer_addr->getAddrMutable(), &len);
+    ssize_t ret = ::recvfrom(sock_fd, buffer, length, flags, peer_addr->getAddrMutable(), &len);
+    if (ret != -1)
+        peer_addr->setAddrLen(len);
+    return ret;
 }
 
 ssize_t recvFrom(int sock_fd,
@@ -144,7 +222,82 @@ ssize_t recvFrom(int sock_fd,
     msg.msg_iovlen = length;
     msg.msg_name = peer_addr->getAddrMutable();
     msg.msg_namelen = peer_addr->getAddrLen();
-    return ::recvmsg(sock_fd, &msg, flags);
+    ssize_t ret = ::recvmsg(sock_fd, &msg, flags);
+    if (ret != -1)
+        peer_addr->setAddrLen(msg.msg_namelen);
+    return ret;
 }
 
-}
\ No newline at end of file
+ssize_t sendFds(int sock_fd, StringPiece message, const int* fds, size_t count, int flags) {
+    if (message.empty() || count == 0 || count > kMaxPassedFds) {
+        errno = EINVAL;
+        return -1;
+    }
+    iovec data{const_cast<char*>(message.data()), message.size()};
+    union {
+        cmsghdr align;
+        char buffer[CMSG_SPACE(sizeof(int) * kMaxPassedFds)];
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov        = &data;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = control.buffer;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * count);
+
+    cmsghdr* header  = CMSG_FIRSTHDR(&msg);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type  = SCM_RIGHTS;
+    header->cmsg_len   = CMSG_LEN(sizeof(int) * count);
+    memcpy(CMSG_DATA(header), fds, sizeof(int) * count);
+    return ::sendmsg(sock_fd, &msg, flags);
+}
+
+ssize_t recvFds(int sock_fd, void* buffer, size_t length, std::vector<int>& fds, int flags) {
+    iovec data{buffer, length};
+    union {
+        cmsghdr align;
+        char buffer[CMSG_SPACE(sizeof(int) * kMaxPassedFds)];
+    } control;
+
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov        = &data;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = control.buffer;
+    msg.msg_controllen = sizeof(control.buffer);
+    const ssize_t ret  = ::recvmsg(sock_fd, &msg, flags | MSG_CMSG_CLOEXEC);
+    if (ret == -1)
+        return -1;
+
+    const size_t first = fds.size();
+    for (cmsghdr* header = CMSG_FIRSTHDR(&msg); header; header = CMSG_NXTHDR(&msg, header)) {
+        if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS)
+            continue;
+        const size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (size_t i = 0; i < count; ++i) {
+            int fd;
+            memcpy(&fd, CMSG_DATA(header) + i * sizeof(int), sizeof(int));
+            fds.push_back(fd);
+        }
+    }
+    if (msg.msg_flags & MSG_CTRUNC) {
+        for (size_t i = first; i < fds.size(); ++i) {
+            ::close(fds[i]);
+        }
+        fds.resize(first);
+        errno = EMSGSIZE;
+        return -1;
+    }
+    if (lon::io::isHookEnabled()) {
+        for (size_t i = first; i < fds.size(); ++i) {
+            // 不是socket的fd(比如文件, 管道)保持原样.
+            lon::io::co_adoptSocket(fds[i]);
+        }
+    }
+    return ret;
+}
+
+}
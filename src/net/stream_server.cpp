@@ -0,0 +1,454 @@
+#include "net/stream_server.h"
+
+#include "io/co_io_function.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+namespace lon::net {
+static lon::log::LoggerSlot G_logger{"system"};
+// 达到AcceptLimits或者accept出现非EAGAIN的错误时, 暂停accept的时间.
+constexpr unsigned kAcceptBackoffMs = 10;
+// accept持续失败时(例如fd耗尽)每个调用处输出日志的最小间隔.
+constexpr int64_t kAcceptLogIntervalMs = 1000;
+
+struct StreamServer::Counters
+{
+    std::atomic<size_t> active{0};
+    std::atomic<size_t> accepted{0};
+    std::atomic<size_t> rejected{0};
+    std::atomic<size_t> accept_paused{0};
+};
+
+namespace {
+/**
+ * @brief 为EMFILE预留的fd, 随accept循环的executor一起释放.
+ */
+struct ReservedFd
+{
+    int fd = -1;
+
+    ReservedFd() { reopen(); }
+    ~ReservedFd() {
+        if (fd != -1)
+            ::close(fd);
+    }
+
+    void reopen() { fd = ::open("/dev/null", O_RDONLY | O_CLOEXEC); }
+};
+
+/**
+ * @brief unix socket的路径地址对应文件系统中的socket文件, 关闭socket以后不会自动删除.
+ * @param stale_only 只删除已经存在的socket文件(上一次运行残留的), 不删除其它类型的文件.
+ */
+void unlinkUnixPath(const SockAddress::SharedPtr& address, bool stale_only) {
+    auto unix_address = dynamic_cast<const UnixAddress*>(address.get());
+    if (!unix_address || unix_address->getPath().empty())
+        return;
+    const String path(unix_address->getPath());
+    struct stat file_stat {};
+    if (stale_only && (::stat(path.c_str(), &file_stat) == -1 || !S_ISSOCK(file_stat.st_mode)))
+        return;
+    ::unlink(path.c_str());
+}
+
+/**
+ * @brief 析构时减少活跃连接数的连接, 以make_shared创建, 不需要自定义deleter的额外分配.
+ */
+struct TrackedConnection : public TcpConnection
+{
+    TrackedConnection(Socket socket,
+                      const InetAddress& peer_addr,
+                      std::shared_ptr<std::atomic<size_t>> _active)
+        : TcpConnection(socket, peer_addr), active{std::move(_active)} {
+    }
+
+    ~TrackedConnection() {
+        active->fetch_sub(1, std::memory_order_relaxed);
+        if (worker_connections)
+            worker_connections->fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    std::shared_ptr<std::atomic<size_t>> active;
+    // 处理该连接的IOManager的连接数, 分配给IOManager以后才设置.
+    std::shared_ptr<std::atomic<size_t>> worker_connections = nullptr;
+};
+
+/**
+ * @brief 把accept循环创建的连接计入worker的连接数.
+ */
+void countOnWorker(TcpConnection& connection,
+                   const std::shared_ptr<std::atomic<size_t>>& worker_connections) {
+    auto& tracked = static_cast<TrackedConnection&>(connection);
+    worker_connections->fetch_add(1, std::memory_order_relaxed);
+    tracked.worker_connections = worker_connections;
+}
+}  // namespace
+
+StreamServer::StreamServer(OnConnectionCallbackType _on_connection,
+                     std::unique_ptr<io::IOWorkBalancer> _balancer)
+    : on_connection_{std::move(_on_connection)},
+      counters_{std::make_shared<Counters>()},
+      balancer_{std::move(_balancer)} {
+    if(balancer_ == nullptr) 
+        balancer_ = std::make_unique<io::SimpleIOBalancer>();
+}
+
+StreamServer::~StreamServer() {
+    if(serving_) {
+        LON_LOG_ERROR(G_logger) << "stream server is being destroy while serving";
+        stopServe();
+    }
+    else {
+        LON_LOG_INFO(G_logger) << "notion: stream server destroying";
+        for (auto& socket : listen_sockets_) {
+            if (socket.fd() == -1)
+                continue;
+            socket.close();
+            unlinkUnixPath(socket.getLocalAddress(), false);
+        }
+    }
+}
+
+auto StreamServer::setSocketIniter(SocketInitCallbackType _socket_initer) -> void {
+    socket_initer_ = std::move(_socket_initer);
+}
+
+bool StreamServer::bind(SockAddress::SharedPtr local_address) {
+    if (listen_sockets_.empty()) {
+        return bindOne(local_address);
+    } else {
+        LON_LOG_ERROR(G_logger) << fmt::format("server has bind socket");
+        return false;
+    }
+}
+
+std::optional<std::vector<SockAddress::SharedPtr>> StreamServer::bind(
+    const std::vector<SockAddress::SharedPtr>& local_addresses) {
+    if (listen_sockets_.empty()) {
+        std::vector<SockAddress::SharedPtr> bind_failed_addresses;
+        for (auto& local_address : local_addresses) {
+            if (bindOne(local_address)) {
+                bind_failed_addresses.push_back(local_address);
+            } else {
+                break;
+            }
+        }
+        if (bind_failed_addresses.empty()) {
+            return std::nullopt;
+        } else {
+            return bind_failed_addresses;
+        }
+    } else {
+        LON_LOG_ERROR(G_logger) << fmt::format("server has bind socket");
+        return local_addresses;
+    }
+    return std::nullopt;
+}
+
+bool StreamServer::addBindAddr(SockAddress::SharedPtr local_address) {
+    return bindOne(local_address);
+}
+
+bool StreamServer::startServe() {
+    if (serving_)
+        return true;
+    serving_ = true;
+
+    auto current_manager = io::IOManager::getThreadLocal();
+    if (workers_.empty()) {
+        for (auto& manager : balancer_->getIOManagers()) {
+            workers_.push_back({manager, std::make_shared<std::atomic<size_t>>(0)});
+        }
+    }
+    bool current_is_shard = false;
+    if (accept_mode_ == AcceptMode::Sharded) {
+        for (auto& manager : balancer_->getIOManagers()) {
+            if (manager == current_manager) {
+                current_is_shard = true;
+            } else {
+                startShard(manager);
+            }
+        }
+    }
+    // 当前线程不在均衡器中时, 当前线程的listen socket同样会被内核分配连接, 照常accept后交给均衡器.
+    for (auto& socket : listen_sockets_) {
+        startAcceptLoop(socket, current_is_shard);
+    }
+    return true;
+}
+
+bool StreamServer::stopServe() {
+    if (!serving_)
+        return true;
+    serving_  = false;
+    auto hold_this = shared_from_this();
+    io::IOManager::getThreadLocal()->addExecutor(
+        std::make_shared<coroutine::Executor>([this, hold_this]() {
+            for (auto& socket : listen_sockets_) {
+                socket.stopRead();
+                socket.close();
+                unlinkUnixPath(socket.getLocalAddress(), false);
+            }
+        }));
+
+    std::lock_guard<std::mutex> lock(shard_mutex_);
+    for (auto& [manager, socket] : shard_sockets_) {
+        // 事件注册在分片线程的IOManager中, 需要在该线程中关闭.
+        manager->addRemoteTask(std::make_shared<coroutine::Executor>(
+            [socket = socket]() mutable {
+                socket.stopRead();
+                socket.close();
+            }));
+    }
+    shard_sockets_.clear();
+    return true;
+}
+
+
+bool StreamServer::bindOne(SockAddress::SharedPtr local_address) {
+    if (accept_mode_ == AcceptMode::Sharded && local_address->getFamily() == AF_UNIX) {
+        LON_LOG_ERROR(G_logger) << fmt::format("unix socket does not support sharded accept, addr:{}",
+                                               local_address->toString());
+        return false;
+    }
+    Socket socket = createListenSocket(local_address);
+    if (socket.fd() == -1)
+        return false;
+    listen_sockets_.push_back(socket);
+    LON_LOG_INFO(G_logger) << fmt::format("server bind addr succeed, addr:{}",
+                                          local_address->toString());
+    return true;
+}
+
+Socket StreamServer::createListenSocket(
+    const SockAddress::SharedPtr& local_address) const {
+    // accept循环需要在EAGAIN时返回, 所以listen socket总是非阻塞的.
+    int fd = ::socket(local_address->getFamily(),
+                      SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                      0);
+    if (fd == -1) {
+        LON_LOG_ERROR(G_logger) << fmt::format("create socket failed");
+        return Socket();
+    }
+    Socket socket(fd);
+    if (accept_mode_ == AcceptMode::Sharded) {
+        socket.setReusePort(true);
+    }
+    if (socket_initer_) {
+        socket_initer_(socket);
+    }
+
+    if (local_address->getFamily() == AF_UNIX) {
+        unlinkUnixPath(local_address, true);
+    }
+
+    if (int bind_ret = socket.bind(local_address); bind_ret == -1) {
+        LON_LOG_ERROR(G_logger)
+            << fmt::format("bind socket failed, addr:{}, errno:{}({})",
+                           local_address->toString(),
+                           std::strerror(errno),
+                           errno);
+        socket.close();
+        return socket;
+    }
+    if (int listen_ret = socket.listen(); listen_ret == -1) {
+        LON_LOG_ERROR(G_logger)
+            << fmt::format("listen failed, addr:{}, errno:{}({})",
+                           local_address->toString(),
+                           std::strerror(errno),
+                           errno);
+        socket.close();
+        return socket;
+    }
+    return socket;
+}
+
+void StreamServer::startAcceptLoop(Socket socket, bool dispatch_local) {
+    // while accepting, hold this.
+    auto hold_this = this->shared_from_this();
+    // dispatch_local时当前线程一定在均衡器中.
+    const Worker* local_worker =
+        dispatch_local ? findWorker(io::IOManager::getThreadLocal().get()) : nullptr;
+    auto reserved_fd = accept_limits_.reserve_fd
+                           ? std::make_shared<ReservedFd>()
+                           : nullptr;
+    io::IOManager::getThreadLocal()->addExecutor(std::make_shared<
+                                                 coroutine::Executor>(
+        [this, hold_this, socket, dispatch_local, local_worker, reserved_fd]() {
+            InetAddress peer_addr;
+            while (serving_) {
+                if (overloaded(local_worker, dispatch_local)) {
+                    counters_->accept_paused.fetch_add(1, std::memory_order_relaxed);
+                    ::usleep(kAcceptBackoffMs * 1000);
+                    continue;
+                }
+
+                Socket accepted = socket.accept4(peer_addr, SOCK_CLOEXEC);
+                if (accepted.fd() != -1) {
+                    auto connection = trackConnection(accepted, peer_addr);
+                    if (dispatch_local) {
+                        if (local_worker)
+                            countOnWorker(*connection, local_worker->connections);
+                        io::IOManager::getThreadLocal()->addExecutor(
+                            std::make_shared<coroutine::Executor>(
+                                [on_connection = on_connection_, connection]() {
+                                    on_connection(connection);
+                                }));
+                    } else {
+                        onAccept(std::move(connection));
+                    }
+                    continue;
+                }
+
+                switch (errno) {
+                    case EAGAIN:
+                        // backlog已经取完, 等待新的连接.
+                        io::co_waitEvent(socket.fd(), false);
+                        break;
+                    case EINTR:
+                        [[fallthrough]];
+                    case ECONNABORTED:
+                        break;
+                    case EBADF:
+                        [[fallthrough]];
+                    case EINVAL:
+                        // listen socket已经关闭.
+                        return;
+                    case EMFILE:
+                        [[fallthrough]];
+                    case ENFILE:
+                        if (reserved_fd && reserved_fd->fd != -1) {
+                            // 用预留的fd取出一个连接并立即关闭, 对端马上得到结果, 而不是在backlog中等待,
+                            // 同时listen socket不再一直可读.
+                            ::close(reserved_fd->fd);
+                            int fd = ::accept4(socket.fd(), nullptr, nullptr, SOCK_CLOEXEC);
+                            const int saved_errno = errno;
+                            if (fd != -1) {
+                                ::close(fd);
+                                counters_->rejected.fetch_add(1, std::memory_order_relaxed);
+                                LON_LOG_EVERY_MS(G_logger, Level::WARN, kAcceptLogIntervalMs) << fmt::format(
+                                    "fd exhausted, reject connection on addr:{}",
+                                    socket.getLocalAddress()->toString());
+                            }
+                            reserved_fd->reopen();
+                            // EMFILE在检查backlog之前返回, 不代表有连接在等待.
+                            if (fd == -1 && saved_errno == EAGAIN)
+                                io::co_waitEvent(socket.fd(), false);
+                            break;
+                        }
+                        [[fallthrough]];
+                    default:
+                        LON_LOG_EVERY_MS(G_logger, Level::WARN, kAcceptLogIntervalMs) << fmt::format(
+                            "accept failed, fd:{}, addr:{}, err:{}(with "
+                            "errno={})",
+                            socket.fd(),
+                            socket.getLocalAddress()->toString(),
+                            std::strerror(errno),
+                            errno);
+                        // 连接仍在backlog中, 稍后重试.
+                        ::usleep(kAcceptBackoffMs * 1000);
+                        break;
+                }
+            }
+        }));
+}
+
+auto StreamServer::findWorker(const io::IOManager* manager) const noexcept -> const Worker* {
+    for (auto& worker : workers_) {
+        if (worker.manager.get() == manager)
+            return &worker;
+    }
+    return nullptr;
+}
+
+auto StreamServer::leastLoadedWorker() const noexcept -> const Worker* {
+    const Worker* least = nullptr;
+    size_t least_count  = static_cast<size_t>(-1);
+    for (auto& worker : workers_) {
+        const size_t count = worker.connections->load(std::memory_order_relaxed);
+        if (count < least_count) {
+            least       = &worker;
+            least_count = count;
+        }
+    }
+    return least;
+}
+
+bool StreamServer::dispatchToWorker(const std::shared_ptr<TcpConnection>& connection,
+                                    coroutine::Executor::Ptr executor) {
+    if (accept_limits_.max_connections_per_thread == static_cast<size_t>(-1))
+        return false;
+    const Worker* worker = leastLoadedWorker();
+    if (!worker)
+        return false;
+    countOnWorker(*connection, worker->connections);
+    if (worker->manager == io::IOManager::getThreadLocal()) {
+        worker->manager->addExecutor(std::move(executor));
+    } else {
+        worker->manager->addRemoteTask(std::move(executor));
+    }
+    return true;
+}
+
+bool StreamServer::overloaded(const Worker* local_worker, bool dispatch_local) const {
+    if (counters_->active.load(std::memory_order_relaxed) >=
+        accept_limits_.max_connections)
+        return true;
+    if (accept_limits_.max_connections_per_thread != static_cast<size_t>(-1)) {
+        // 非本地处理时只要有一个IOManager未达到上限就可以继续accept.
+        const Worker* worker = dispatch_local ? local_worker : leastLoadedWorker();
+        if (worker && worker->connections->load(std::memory_order_relaxed) >=
+                          accept_limits_.max_connections_per_thread)
+            return true;
+    }
+    if (accept_limits_.max_queued_tasks == static_cast<size_t>(-1))
+        return false;
+    const size_t queued =
+        dispatch_local ? io::IOManager::getThreadLocal()->getQueuedTaskCount()
+                       : balancer_->getQueuedTaskCount();
+    return queued > accept_limits_.max_queued_tasks;
+}
+
+std::shared_ptr<TcpConnection> StreamServer::trackConnection(
+    Socket socket, const InetAddress& peer_addr) const {
+    counters_->active.fetch_add(1, std::memory_order_relaxed);
+    counters_->accepted.fetch_add(1, std::memory_order_relaxed);
+    // 连接可能在任意线程中释放, 与counters_共享所有权.
+    return std::make_shared<TrackedConnection>(
+        socket,
+        peer_addr,
+        std::shared_ptr<std::atomic<size_t>>(counters_, &counters_->active));
+}
+
+auto StreamServer::getStats() const noexcept -> Stats {
+    Stats stats;
+    stats.active_connections = counters_->active.load(std::memory_order_relaxed);
+    stats.accepted           = counters_->accepted.load(std::memory_order_relaxed);
+    stats.rejected           = counters_->rejected.load(std::memory_order_relaxed);
+    stats.accept_paused = counters_->accept_paused.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void StreamServer::startShard(const std::shared_ptr<io::IOManager>& manager) {
+    auto hold_this = this->shared_from_this();
+    manager->addRemoteTask(
+        std::make_shared<coroutine::Executor>([this, hold_this, manager]() {
+            for (auto& listen_socket : listen_sockets_) {
+                Socket socket =
+                    createListenSocket(listen_socket.getLocalAddress());
+                if (socket.fd() == -1)
+                    continue;
+                {
+                    std::lock_guard<std::mutex> lock(shard_mutex_);
+                    if (!serving_) {
+                        socket.close();
+                        return;
+                    }
+                    shard_sockets_.emplace_back(manager, socket);
+                }
+                startAcceptLoop(socket, true);
+            }
+        }));
+}
+}  // namespace lon::net
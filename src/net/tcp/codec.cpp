@@ -0,0 +1,191 @@
+#include "net/tcp/codec.h"
+
+#include "logger.h"
+
+#include <algorithm>
+#include <cstring>
+#include <endian.h>
+#include <fmt/core.h>
+
+static lon::log::LoggerSlot G_logger{"system"};
+
+namespace lon::net {
+
+FrameCodec::DecodeResult FixedLengthCodec::decode(IOBuffer& buffer, IOBuffer& frame) {
+    if (buffer.readableBytes() < length_)
+        return DecodeResult::NeedMore;
+    frame.clear();
+    buffer.splitTo(length_, frame);
+    return DecodeResult::Frame;
+}
+
+bool FixedLengthCodec::encode(IOBuffer&& payload, IOBuffer& out) const {
+    if (payload.readableBytes() != length_)
+        return false;
+    out.append(std::move(payload));
+    return true;
+}
+
+bool FixedLengthCodec::encode(StringPiece payload, IOBuffer& out) const {
+    if (payload.size() != length_)
+        return false;
+    out.append(payload);
+    return true;
+}
+
+
+LengthFieldCodec::LengthFieldCodec(FieldSize field_size,
+                                   Endian endian,
+                                   size_t max_frame_length)
+    : field_size_{field_size},
+      endian_{endian},
+      max_frame_length_{field_size == FieldSize::U16
+                            ? std::min<size_t>(max_frame_length, UINT16_MAX)
+                            : std::min<size_t>(max_frame_length, UINT32_MAX)} {
+}
+
+FrameCodec::DecodeResult LengthFieldCodec::decode(IOBuffer& buffer, IOBuffer& frame) {
+    const size_t header_length = headerLength();
+    if (buffer.readableBytes() < header_length)
+        return DecodeResult::NeedMore;
+
+    size_t length = 0;
+    if (field_size_ == FieldSize::U16) {
+        uint16_t field = 0;
+        buffer.copyTo(&field, sizeof(field));
+        length = endian_ == Endian::Big ? be16toh(field) : le16toh(field);
+    } else {
+        uint32_t field = 0;
+        buffer.copyTo(&field, sizeof(field));
+        length = endian_ == Endian::Big ? be32toh(field) : le32toh(field);
+    }
+    if (UNLIKELY(length > max_frame_length_)) {
+        LON_LOG_DEBUG(G_logger) << fmt::format(
+            "frame length {} exceeds the limit {}", length, max_frame_length_);
+        return DecodeResult::Error;
+    }
+    if (buffer.readableBytes() < header_length + length)
+        return DecodeResult::NeedMore;
+    buffer.consume(header_length);
+    frame.clear();
+    buffer.splitTo(length, frame);
+    return DecodeResult::Frame;
+}
+
+void LengthFieldCodec::encodeHeader(size_t length, char* header) const noexcept {
+    if (field_size_ == FieldSize::U16) {
+        const auto value = static_cast<uint16_t>(length);
+        const uint16_t field = endian_ == Endian::Big ? htobe16(value) : htole16(value);
+        std::memcpy(header, &field, sizeof(field));
+    } else {
+        const auto value = static_cast<uint32_t>(length);
+        const uint32_t field = endian_ == Endian::Big ? htobe32(value) : htole32(value);
+        std::memcpy(header, &field, sizeof(field));
+    }
+}
+
+bool LengthFieldCodec::encode(IOBuffer&& payload, IOBuffer& out) const {
+    const size_t length = payload.readableBytes();
+    if (length > max_frame_length_)
+        return false;
+    // 长度头一般可以直接写入payload第一个block的预留空间.
+    char header[sizeof(uint32_t)];
+    encodeHeader(length, header);
+    payload.prepend(header, headerLength());
+    out.append(std::move(payload));
+    return true;
+}
+
+bool LengthFieldCodec::encode(StringPiece payload, IOBuffer& out) const {
+    if (payload.size() > max_frame_length_)
+        return false;
+    char header[sizeof(uint32_t)];
+    encodeHeader(payload.size(), header);
+    out.append(header, headerLength());
+    out.append(payload);
+    return true;
+}
+
+
+DelimiterCodec::DelimiterCodec(String delimiter, size_t max_frame_length)
+    : delimiter_{std::move(delimiter)}, max_frame_length_{max_frame_length} {
+}
+
+FrameCodec::DecodeResult DelimiterCodec::decode(IOBuffer& buffer, IOBuffer& frame) {
+    const size_t readable = buffer.readableBytes();
+    // 换了buffer或者buffer被外部消费过, 之前查找的位置不再有效.
+    if (scanned_buffer_ != &buffer || scanned_ > readable)
+        scanned_ = 0;
+    const ssize_t pos = buffer.find(delimiter_, scanned_);
+    if (pos == -1) {
+        if (readable > max_frame_length_ + delimiter_.size())
+            return DecodeResult::Error;
+        // 分隔符可能只收到了一部分.
+        scanned_        = readable >= delimiter_.size() ? readable - delimiter_.size() + 1 : 0;
+        scanned_buffer_ = &buffer;
+        return DecodeResult::NeedMore;
+    }
+    scanned_        = 0;
+    scanned_buffer_ = nullptr;
+    if (static_cast<size_t>(pos) > max_frame_length_)
+        return DecodeResult::Error;
+    frame.clear();
+    buffer.splitTo(static_cast<size_t>(pos), frame);
+    buffer.consume(delimiter_.size());
+    return DecodeResult::Frame;
+}
+
+bool DelimiterCodec::encode(IOBuffer&& payload, IOBuffer& out) const {
+    if (payload.readableBytes() > max_frame_length_ || payload.find(delimiter_) != -1)
+        return false;
+    out.append(std::move(payload));
+    out.append(delimiter_);
+    return true;
+}
+
+bool DelimiterCodec::encode(StringPiece payload, IOBuffer& out) const {
+    if (payload.size() > max_frame_length_ || payload.find(delimiter_) != StringPiece::npos)
+        return false;
+    out.append(payload);
+    out.append(delimiter_);
+    return true;
+}
+
+
+int readFrames(TcpConnection& connection,
+               FrameCodec& codec,
+               IOBuffer& buffer,
+               const std::function<bool(IOBuffer& frame)>& handler) {
+    IOBuffer frame;
+    while (true) {
+        // 先处理buffer中已有的数据, 上一次停止时可能还有完整的帧.
+        while (true) {
+            const auto result = codec.decode(buffer, frame);
+            if (result == FrameCodec::DecodeResult::NeedMore)
+                break;
+            if (result == FrameCodec::DecodeResult::Error) {
+                errno = EPROTO;
+                return -1;
+            }
+            const bool go_on = handler(frame);
+            frame.clear();
+            if (!go_on)
+                return 1;
+        }
+        const ssize_t n = connection.readInto(buffer);
+        if (n == 0)
+            return 0;
+        if (n == -1)
+            return -1;
+    }
+}
+
+int writeFrame(TcpConnection& connection, const FrameCodec& codec, StringPiece payload) {
+    if (!codec.encode(payload, connection.outputBuffer())) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+    return connection.commitOutput();
+}
+
+}  // namespace lon::net
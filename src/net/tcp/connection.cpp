@@ -1,5 +1,22 @@
 #include "net/tcp/connection.h"
 
+#include "io/co_io_function.h"
+#include "io/fd_manager.h"
+#include "io/hook.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fmt/core.h>
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+
+static lon::log::LoggerSlot G_logger{"system"};
+
 namespace lon::net {
 
 ssize_t TcpConnection::send(const void* buffer, size_t length, int flags) const {
@@ -23,4 +40,297 @@ ssize_t TcpConnection::recv(void* buffer, size_t length, int flags) const {
 ssize_t TcpConnection::recv(iovec* buffers, size_t length, int flags) const {
 	return sockopt::recv(socket_.fd(), buffers, length, flags);
 }
+
+namespace {
+constexpr size_t kMaxIovec  = 64;
+// 每次读取时准备的空间, 从半个block开始, 读满时翻倍, 避免小消息每次都申请多个block.
+constexpr size_t kMinReadChunk = IOBuffer::kBlockSize / 2;
+constexpr size_t kMaxReadChunk = 16 * IOBuffer::kBlockSize;
+// 单次sendfile的最大长度, 内核本身也限制在2GiB以内.
+constexpr size_t kMaxSendFileChunk = 1024 * 1024 * 1024;
+
+size_t writeTimeoutOf(int fd) {
+	auto context = io::FdManager::getInstance()->getContext(fd);
+	return context ? context->writeTimeout : static_cast<size_t>(-1);
+}
+}  // namespace
+
+TcpConnection::~TcpConnection() {
+	if (output_.empty())
+		return;
+	const int saved_errno = errno;
+	if (socket_.fd() != -1) {
+		iovec iov[kMaxIovec];
+		while (!output_.empty()) {
+			const size_t count = output_.peekIovec(iov, kMaxIovec);
+			const ssize_t n    = sockopt::send(socket_.fd(), iov, count, MSG_DONTWAIT | MSG_NOSIGNAL);
+			if (n > 0) {
+				output_.consume(static_cast<size_t>(n));
+			} else if (n == 0 || errno != EINTR) {
+				break;
+			}
+		}
+	}
+	if (!output_.empty()) {
+		LON_LOG_WARN(G_logger) << fmt::format(
+		    "connection destroyed with {} unsent bytes, fd:{}", output_.readableBytes(), socket_.fd());
+	}
+	errno = saved_errno;
+}
+
+ssize_t TcpConnection::readInto(IOBuffer& buffer, size_t max_bytes, int flags) {
+	if (!corked() && !output_.empty() && flush() == -1)
+		return -1;
+	iovec iov[kMaxIovec];
+	size_t total = 0;
+	size_t chunk = kMinReadChunk;
+	while (total < max_bytes) {
+		const size_t count =
+		    buffer.prepareIovec(iov, kMaxIovec, std::min(chunk, max_bytes - total));
+		size_t offered = 0;
+		for (size_t i = 0; i < count; ++i) {
+			offered += iov[i].iov_len;
+		}
+		// 只有一块空间时使用recv, 比recvmsg少一些内核中的开销.
+		const ssize_t n =
+		    count == 1 ? ::recv(socket_.fd(), iov[0].iov_base, iov[0].iov_len, flags)
+		               : sockopt::recv(socket_.fd(), iov, count, flags);
+		if (n > 0) {
+			buffer.commit(static_cast<size_t>(n));
+			total += static_cast<size_t>(n);
+			if (static_cast<size_t>(n) < offered)
+				break;  // 内核缓冲区已经读空.
+			// 之后的读取不再挂起, 没有数据时直接返回.
+			flags |= MSG_DONTWAIT;
+			chunk = std::min(chunk * 2, kMaxReadChunk);
+			continue;
+		}
+		buffer.commit(0);
+		if (n == 0)
+			break;
+		if (errno == EINTR)
+			continue;
+		if (total == 0)
+			return -1;
+		break;
+	}
+	return static_cast<ssize_t>(total);
+}
+
+ssize_t TcpConnection::writeFrom(IOBuffer& buffer, int flags) const {
+	iovec iov[kMaxIovec];
+	size_t total = 0;
+	while (!buffer.empty()) {
+		const size_t count = buffer.peekIovec(iov, kMaxIovec);
+		const ssize_t n =
+		    count == 1 ? ::send(socket_.fd(), iov[0].iov_base, iov[0].iov_len, flags)
+		               : sockopt::send(socket_.fd(), iov, count, flags);
+		if (n >= 0) {
+			buffer.consume(static_cast<size_t>(n));
+			total += static_cast<size_t>(n);
+			continue;
+		}
+		if (errno == EINTR)
+			continue;
+		if (total == 0)
+			return -1;
+		break;
+	}
+	return static_cast<ssize_t>(total);
+}
+
+int TcpConnection::write(const void* data, size_t length) {
+	output_.append(data, length);
+	return commitOutput();
+}
+
+int TcpConnection::write(IOBuffer&& data) {
+	if (data.readableBytes() < IOBuffer::kBlockSize / 4) {
+		// 小块数据拷贝到写队列的末尾, 避免每个响应占用一个block以及iovec.
+		iovec iov[kMaxIovec];
+		const size_t count = data.peekIovec(iov, kMaxIovec);
+		for (size_t i = 0; i < count; ++i) {
+			output_.append(iov[i].iov_base, iov[i].iov_len);
+		}
+		data.clear();
+	} else {
+		output_.append(std::move(data));
+	}
+	return commitOutput();
+}
+
+int TcpConnection::commitOutput() {
+	if (output_.readableBytes() < high_watermark_)
+		return 0;
+	return flushTo(low_watermark_) == -1 ? -1 : 0;
+}
+
+ssize_t TcpConnection::flush() {
+	return flushTo(0);
+}
+
+ssize_t TcpConnection::uncork() {
+	if (cork_depth_ > 0 && --cork_depth_ > 0)
+		return 0;
+	return flush();
+}
+
+ssize_t TcpConnection::flushTo(size_t target) {
+	// hook开启时使用非阻塞发送, 发送缓冲区满时自己挂起等待EPOLLOUT, 以便统计等待次数.
+	const bool can_wait = io::isHookEnabled();
+	const int flags     = MSG_NOSIGNAL | (can_wait ? MSG_DONTWAIT : 0);
+	if (!zerocopy_pending_.empty())
+		reapZeroCopy();
+	iovec iov[kMaxIovec];
+	size_t total     = 0;
+	bool zerocopy_ok = true;
+	while (output_.readableBytes() > target) {
+		const size_t count  = output_.peekIovec(iov, kMaxIovec);
+		const bool zerocopy = zerocopy_ok && zerocopy_threshold_ > 0 &&
+		                      output_.readableBytes() >= zerocopy_threshold_;
+		const int send_flags = zerocopy ? flags | MSG_ZEROCOPY : flags;
+		const ssize_t n =
+		    count == 1 ? ::send(socket_.fd(), iov[0].iov_base, iov[0].iov_len, send_flags)
+		               : sockopt::send(socket_.fd(), iov, count, send_flags);
+		++write_stats_.syscalls;
+		if (n >= 0) {
+			if (zerocopy) {
+				zerocopy_pending_.push_back(
+				    ZeroCopyPending{zerocopy_next_id_++, output_.slice(0, static_cast<size_t>(n))});
+				++write_stats_.zerocopy_sends;
+			}
+			zerocopy_ok = true;
+			output_.consume(static_cast<size_t>(n));
+			total += static_cast<size_t>(n);
+			write_stats_.bytes += static_cast<size_t>(n);
+			continue;
+		}
+		if (errno == EINTR)
+			continue;
+		if (zerocopy && errno == ENOBUFS) {
+			// 锁定的页面超过了optmem限制, 这一次退回到普通发送.
+			reapZeroCopy();
+			zerocopy_ok = false;
+			continue;
+		}
+		if (can_wait && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			++write_stats_.waits;
+			if (io::co_waitEvent(socket_.fd(), true, writeTimeoutOf(socket_.fd())) == -1)
+				return -1;
+			continue;
+		}
+		return -1;
+	}
+	return static_cast<ssize_t>(total);
+}
+
+ssize_t TcpConnection::sendFile(int fd, off_t offset, size_t len) {
+	if (!output_.empty() && flush() == -1)
+		return -1;
+	size_t total = 0;
+	while (total < len) {
+		// hook开启时co_sendfile在发送缓冲区满时挂起协程.
+		const ssize_t n =
+		    ::sendfile(socket_.fd(), fd, &offset, std::min(len - total, kMaxSendFileChunk));
+		if (n > 0) {
+			total += static_cast<size_t>(n);
+			continue;
+		}
+		if (n == 0)
+			break;  // 文件结束.
+		if (errno == EINTR)
+			continue;
+		if (total == 0)
+			return -1;
+		break;
+	}
+	return static_cast<ssize_t>(total);
+}
+
+ssize_t TcpConnection::splice(int pipe_fd, size_t len) {
+	if (!output_.empty() && flush() == -1)
+		return -1;
+	// 管道为空以及发送缓冲区满都返回EAGAIN, hook开启时自己区分并等待对应的事件.
+	const bool can_wait = io::isHookEnabled();
+	const unsigned int flags = SPLICE_F_MOVE | (can_wait ? SPLICE_F_NONBLOCK : 0);
+	auto context = io::FdManager::getInstance()->getContext(socket_.fd());
+	size_t total = 0;
+	while (total < len) {
+		const ssize_t n = ::splice(pipe_fd, nullptr, socket_.fd(), nullptr, len - total, flags);
+		if (n > 0) {
+			total += static_cast<size_t>(n);
+			continue;
+		}
+		if (n == 0)
+			break;  // 管道写端关闭.
+		if (errno == EINTR)
+			continue;
+		if (can_wait && errno == EAGAIN) {
+			int readable = 0;
+			if (::ioctl(pipe_fd, FIONREAD, &readable) == 0 && readable == 0) {
+				if (io::co_waitEvent(pipe_fd, false, static_cast<size_t>(-1)) == 0)
+					continue;
+			} else if (!context || !context->is_user_non_block) {
+				if (io::co_waitEvent(socket_.fd(), true, writeTimeoutOf(socket_.fd())) == 0)
+					continue;
+			}
+		}
+		if (total == 0)
+			return -1;
+		break;
+	}
+	return static_cast<ssize_t>(total);
+}
+
+bool TcpConnection::enableZeroCopy(size_t threshold) {
+	const int on = 1;
+	if (::setsockopt(socket_.fd(), SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(on)) != 0)
+		return false;
+	zerocopy_threshold_ = std::max<size_t>(threshold, 1);
+	return true;
+}
+
+size_t TcpConnection::reapZeroCopy() {
+	size_t completed = 0;
+	char control[CMSG_SPACE(sizeof(sock_extended_err)) * 4];
+	while (!zerocopy_pending_.empty()) {
+		msghdr message{};
+		message.msg_control    = control;
+		message.msg_controllen = sizeof(control);
+		// 错误队列中没有通知时立刻返回EAGAIN.
+		if (::recvmsg(socket_.fd(), &message, MSG_ERRQUEUE | MSG_DONTWAIT) == -1) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+			if (!(cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) &&
+			    !(cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR))
+				continue;
+			sock_extended_err error{};
+			std::memcpy(&error, CMSG_DATA(cmsg), sizeof(error));
+			if (error.ee_origin != SO_EE_ORIGIN_ZEROCOPY || error.ee_errno != 0)
+				continue;
+			// [ee_info, ee_data]是这次完成的序号区间.
+			const uint32_t first = error.ee_info;
+			const uint32_t last  = error.ee_data;
+			if (error.ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+				write_stats_.zerocopy_copied += last - first + 1;
+			while (!zerocopy_pending_.empty() &&
+			       static_cast<int32_t>(zerocopy_pending_.front().id - last) <= 0) {
+				zerocopy_pending_.pop_front();
+				++completed;
+			}
+		}
+	}
+	return completed;
+}
+
+size_t TcpConnection::pendingZeroCopyBytes() const {
+	size_t bytes = 0;
+	for (const auto& pending : zerocopy_pending_) {
+		bytes += pending.data.readableBytes();
+	}
+	return bytes;
 }
+}
\ No newline at end of file
@@ -0,0 +1,231 @@
+#include "net/tcp/connection_pool.h"
+
+#include "base/info.h"
+#include "io/hook.h"
+#include "io/io_manager.h"
+#include "logger.h"
+#include "net/tcp/connector.h"
+
+#include <algorithm>
+#include <fmt/core.h>
+
+static lon::log::LoggerSlot G_logger{"system"};
+
+namespace lon::net {
+
+TcpConnectionPool::Handle::Handle(Handle&& _other) noexcept
+    : pool_{std::move(_other.pool_)},
+      key_{std::move(_other.key_)},
+      connection_{std::move(_other.connection_)},
+      reused_{_other.reused_},
+      broken_{_other.broken_} {
+}
+
+auto TcpConnectionPool::Handle::operator=(Handle&& _other) noexcept -> Handle& {
+    if (this != &_other) {
+        release();
+        pool_       = std::move(_other.pool_);
+        key_        = std::move(_other.key_);
+        connection_ = std::move(_other.connection_);
+        reused_     = _other.reused_;
+        broken_     = _other.broken_;
+    }
+    return *this;
+}
+
+void TcpConnectionPool::Handle::release() {
+    if (!connection_)
+        return;
+    if (auto pool = pool_.lock()) {
+        pool->release(key_, std::move(connection_), !broken_);
+    } else {
+        connection_->getSocket().close();
+        connection_ = nullptr;
+    }
+}
+
+TcpConnectionPool::~TcpConnectionPool() {
+    closeIdle();
+}
+
+TcpConnectionPool::Handle TcpConnectionPool::acquire(StringArg host,
+                                                     uint16_t port) {
+    const String key = fmt::format("{}:{}", host.str, port);
+    // unordered_map的rehash不会使元素的引用失效, 并且HostPool不会被删除.
+    HostPool& host_pool = hosts_[key];
+
+    const size_t deadline =
+        options_.acquire_timeout_ms == static_cast<size_t>(-1)
+            ? static_cast<size_t>(-1)
+            : currentMs() + options_.acquire_timeout_ms;
+
+    while (true) {
+        const size_t now = currentMs();
+        purgeExpired(host_pool, now);
+
+        while (!host_pool.idle.empty()) {
+            auto connection = std::move(host_pool.idle.back().connection);
+            host_pool.idle.pop_back();
+            if (isAlive(*connection)) {
+                ++host_pool.active;
+                return makeHandle(key, std::move(connection), true);
+            }
+            connection->getSocket().close();
+        }
+
+        if (host_pool.active < options_.max_per_host) {
+            // 先占用名额, connect期间其它协程看到的连接数才是准确的.
+            ++host_pool.active;
+            std::unique_ptr<TcpConnection> connection = nullptr;
+            try {
+                connection = TcpConnector::connect(
+                    host, port, options_.connect_timeout_ms);
+            } catch (const std::invalid_argument& e) {
+                LON_LOG_WARN(G_logger) << "connection pool resolve failed:" << e.what();
+                errno = EHOSTUNREACH;
+            }
+            if (!connection) {
+                const int saved_errno = errno;
+                --host_pool.active;
+                wakeWaiter(host_pool);
+                errno = saved_errno;
+                return {};
+            }
+            if (options_.tcp_keep_alive)
+                connection->getSocket().setKeepAlive(true);
+            if (options_.tcp_no_delay)
+                connection->getSocket().setTcpNoDelay(true);
+            return makeHandle(key, std::move(connection), false);
+        }
+
+        // 达到上限, 等待其它连接归还.
+        const size_t remaining =
+            deadline == static_cast<size_t>(-1)
+                ? deadline
+                : (deadline > now ? deadline - now : 0);
+        if (remaining == 0) {
+            errno = ETIMEDOUT;
+            return {};
+        }
+        auto waiter = std::make_shared<io::CoWaiter>();
+        host_pool.waiters.push_back(waiter);
+        if (waiter->wait(remaining) != io::CoWaiter::Result::Notified) {
+            auto iter = std::find(
+                host_pool.waiters.begin(), host_pool.waiters.end(), waiter);
+            if (iter != host_pool.waiters.end())
+                host_pool.waiters.erase(iter);
+            errno = ETIMEDOUT;
+            return {};
+        }
+    }
+}
+
+void TcpConnectionPool::closeIdle() {
+    for (auto& [key, host_pool] : hosts_) {
+        for (auto& idle_connection : host_pool.idle) {
+            idle_connection.connection->getSocket().close();
+        }
+        host_pool.idle.clear();
+    }
+}
+
+size_t TcpConnectionPool::idleCount() const noexcept {
+    size_t count = 0;
+    for (auto& [key, host_pool] : hosts_) {
+        count += host_pool.idle.size();
+    }
+    return count;
+}
+
+size_t TcpConnectionPool::activeCount() const noexcept {
+    size_t count = 0;
+    for (auto& [key, host_pool] : hosts_) {
+        count += host_pool.active;
+    }
+    return count;
+}
+
+TcpConnectionPool::Handle TcpConnectionPool::makeHandle(
+    const String& key, std::unique_ptr<TcpConnection> connection, bool reused) {
+    Handle handle;
+    handle.pool_       = weak_from_this();
+    handle.key_        = key;
+    handle.connection_ = std::move(connection);
+    handle.reused_     = reused;
+    return handle;
+}
+
+void TcpConnectionPool::release(const String& key,
+                                std::unique_ptr<TcpConnection> connection,
+                                bool reusable) {
+    auto iter = hosts_.find(key);
+    if (iter == hosts_.end()) {
+        connection->getSocket().close();
+        return;
+    }
+    HostPool& host_pool = iter->second;
+    --host_pool.active;
+    if (reusable && connection->connected() &&
+        host_pool.idle.size() < options_.max_idle_per_host) {
+        host_pool.idle.push_back({std::move(connection), currentMs()});
+        armSweepTimer();
+    } else {
+        connection->getSocket().close();
+    }
+    wakeWaiter(host_pool);
+}
+
+bool TcpConnectionPool::isAlive(TcpConnection& connection) {
+    char dummy;
+    // 直接使用原始的recv, 避免hook在EAGAIN时挂起协程.
+    ssize_t ret = recv_sys(connection.getSocket().fd(),
+                           &dummy,
+                           sizeof(dummy),
+                           MSG_PEEK | MSG_DONTWAIT);
+    // 0: 对端已关闭, >0: 空闲连接上不应该有数据.
+    return ret == -1 && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+void TcpConnectionPool::purgeExpired(HostPool& host_pool, size_t now_ms) {
+    auto& idle = host_pool.idle;
+    auto expired_end = std::find_if(
+        idle.begin(), idle.end(), [this, now_ms](const IdleConnection& item) {
+            return now_ms - item.idle_since_ms < options_.idle_timeout_ms;
+        });
+    // idle按照归还时间排序, 前面的是最早归还的.
+    for (auto iter = idle.begin(); iter != expired_end; ++iter) {
+        iter->connection->getSocket().close();
+    }
+    idle.erase(idle.begin(), expired_end);
+}
+
+void TcpConnectionPool::wakeWaiter(HostPool& host_pool) {
+    while (!host_pool.waiters.empty()) {
+        auto waiter = std::move(host_pool.waiters.front());
+        host_pool.waiters.pop_front();
+        if (waiter->notify())
+            return;
+    }
+}
+
+void TcpConnectionPool::armSweepTimer() {
+    if (sweep_armed_ || !io::isHookEnabled())
+        return;
+    sweep_armed_ = true;
+    std::weak_ptr<TcpConnectionPool> weak_pool = weak_from_this();
+    io::IOManager::getThreadLocal()->registerTimer(std::make_shared<Timer>(
+        options_.idle_timeout_ms, [weak_pool]() {
+            auto pool = weak_pool.lock();
+            if (!pool)
+                return;
+            pool->sweep_armed_ = false;
+            const size_t now   = currentMs();
+            for (auto& [key, host_pool] : pool->hosts_) {
+                pool->purgeExpired(host_pool, now);
+            }
+            if (pool->idleCount())
+                pool->armSweepTimer();
+        }));
+}
+
+}  // namespace lon::net
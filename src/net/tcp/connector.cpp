@@ -0,0 +1,202 @@
+#include "net/tcp/connector.h"
+
+#include "base/info.h"
+#include "io/co_waiter.h"
+#include "io/hook.h"
+#include "io/io_manager.h"
+#include "logger.h"
+
+#include <fmt/core.h>
+
+static lon::log::LoggerSlot G_logger{"system"};
+
+namespace lon::net {
+
+namespace {
+/**
+ * @brief 一次happy eyeballs连接过程中各个连接尝试共享的状态.
+ */
+struct ConnectRace
+{
+    io::CoWaiter waiter;
+    std::vector<SockAddress::UniquePtr> peer_addrs;
+    std::vector<std::unique_ptr<io::Canceler>> cancelers;
+    std::unique_ptr<TcpConnection> winner = nullptr;
+    size_t running                        = 0;
+    int last_errno                        = 0;
+    bool finished                         = false;  // 发起方已经返回, 之后成功的连接直接关闭.
+};
+
+constexpr size_t kNoDeadline = static_cast<size_t>(-1);
+
+size_t remainingMs(size_t deadline) {
+    if (deadline == kNoDeadline)
+        return kNoDeadline;
+    const size_t now = currentMs();
+    return deadline > now ? deadline - now : 0;
+}
+
+/**
+ * @brief 按照RFC 8305, 以第一个地址的地址族开始交替排列.
+ */
+std::vector<SockAddress::UniquePtr> interleaveFamilies(
+    std::vector<SockAddress::UniquePtr> peer_addrs) {
+    if (peer_addrs.size() <= 2)
+        return peer_addrs;
+    const sa_family_t first_family = peer_addrs.front()->getFamily();
+    std::vector<SockAddress::UniquePtr> first;
+    std::vector<SockAddress::UniquePtr> second;
+    for (auto& addr : peer_addrs) {
+        (addr->getFamily() == first_family ? first : second)
+            .push_back(std::move(addr));
+    }
+
+    std::vector<SockAddress::UniquePtr> result;
+    result.reserve(peer_addrs.size());
+    for (size_t i = 0; i < std::max(first.size(), second.size()); ++i) {
+        if (i < first.size())
+            result.push_back(std::move(first[i]));
+        if (i < second.size())
+            result.push_back(std::move(second[i]));
+    }
+    return result;
+}
+
+/**
+ * @brief 建立socket并连接, 失败时关闭socket并保留errno.
+ */
+std::unique_ptr<TcpConnection> connectOne(SockAddress::UniquePtr peer_addr,
+                                          size_t timeout_ms,
+                                          io::Canceler* canceler) {
+    int fd = ::socket(peer_addr->getFamily(), SOCK_STREAM, 0);
+    if (fd == -1)
+        return nullptr;
+    if (sockopt::connect(fd, *peer_addr, timeout_ms, canceler) == -1) {
+        const int saved_errno = errno;
+        ::close(fd);
+        errno = saved_errno;
+        return nullptr;
+    }
+    return std::make_unique<TcpConnection>(Socket(fd), std::move(peer_addr));
+}
+
+/**
+ * @brief 在当前IOManager中发起第index个地址的连接尝试.
+ */
+void startAttempt(const std::shared_ptr<ConnectRace>& race,
+                  size_t index,
+                  size_t deadline) {
+    auto canceler =
+        race->cancelers.emplace_back(std::make_unique<io::Canceler>()).get();
+    ++race->running;
+    io::IOManager::getThreadLocal()->addExecutor(
+        std::make_shared<coroutine::Executor>([race, index, deadline, canceler]() {
+            auto connection = connectOne(std::move(race->peer_addrs[index]),
+                                         remainingMs(deadline),
+                                         canceler);
+            const int saved_errno = errno;
+            --race->running;
+            if (connection) {
+                if (race->finished || race->winner) {
+                    connection->getSocket().close();
+                    return;
+                }
+                race->winner = std::move(connection);
+            } else if (saved_errno != ECANCELED || race->last_errno == 0) {
+                race->last_errno = saved_errno;
+            }
+            race->waiter.notify();
+        }));
+}
+}  // namespace
+
+std::unique_ptr<TcpConnection> TcpConnector::connect(
+    std::vector<SockAddress::UniquePtr> peer_addrs,
+    size_t timeout_ms,
+    size_t attempt_delay_ms,
+    io::Canceler* canceler) {
+    if (peer_addrs.empty()) {
+        errno = EINVAL;
+        return nullptr;
+    }
+    const size_t deadline =
+        timeout_ms == kNoDeadline ? kNoDeadline : currentMs() + timeout_ms;
+    peer_addrs = interleaveFamilies(std::move(peer_addrs));
+
+    if (!io::isHookEnabled()) {
+        // 没有协程可以挂起, 只能依次尝试.
+        int last_errno = 0;
+        for (auto& peer_addr : peer_addrs) {
+            const size_t remaining = remainingMs(deadline);
+            if (remaining == 0) {
+                last_errno = ETIMEDOUT;
+                break;
+            }
+            auto connection =
+                connectOne(std::move(peer_addr), remaining, canceler);
+            if (connection)
+                return connection;
+            last_errno = errno;
+        }
+        errno = last_errno;
+        return nullptr;
+    }
+
+    auto race        = std::make_shared<ConnectRace>();
+    race->peer_addrs = std::move(peer_addrs);
+    const size_t total = race->peer_addrs.size();
+    size_t next        = 0;
+
+    while (!race->winner) {
+        if (next < total) {
+            startAttempt(race, next++, deadline);
+        } else if (race->running == 0) {
+            break;  // 全部失败.
+        }
+
+        const size_t remaining = remainingMs(deadline);
+        if (remaining == 0) {
+            race->last_errno = ETIMEDOUT;
+            break;
+        }
+        // 还有地址没有尝试时最多等待attempt_delay_ms.
+        const size_t wait_ms =
+            next < total ? std::min(remaining, attempt_delay_ms) : remaining;
+        if (io::CoWaiter::Result::Cancelled ==
+            race->waiter.wait(wait_ms, canceler)) {
+            race->last_errno = ECANCELED;
+            break;
+        }
+    }
+
+    race->finished = true;
+    for (auto& attempt_canceler : race->cancelers) {
+        attempt_canceler->cancel();
+    }
+    if (race->winner)
+        return std::move(race->winner);
+
+    LON_LOG_DEBUG(G_logger) << fmt::format(
+        "connect failed after {} attempts, err:{}(with errno={})",
+        race->cancelers.size(),
+        std::strerror(race->last_errno),
+        race->last_errno);
+    errno = race->last_errno;
+    return nullptr;
+}
+
+std::unique_ptr<TcpConnection> TcpConnector::connect(StringArg host,
+                                                     uint16_t port,
+                                                     size_t timeout_ms,
+                                                     size_t attempt_delay_ms,
+                                                     io::Canceler* canceler) {
+    auto ip_addrs = IPAddress::createAll(host, port);
+    std::vector<SockAddress::UniquePtr> peer_addrs;
+    peer_addrs.reserve(ip_addrs.size());
+    for (auto& addr : ip_addrs) {
+        peer_addrs.push_back(std::move(addr));
+    }
+    return connect(std::move(peer_addrs), timeout_ms, attempt_delay_ms, canceler);
+}
+
+}  // namespace lon::net
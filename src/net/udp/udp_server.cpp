@@ -0,0 +1,227 @@
+#include "net/udp/udp_server.h"
+
+#include "io/co_io_function.h"
+#include "logger.h"
+
+#include <cstring>
+#include <fmt/core.h>
+
+static lon::log::LoggerSlot G_logger{"system"};
+
+namespace lon::net {
+
+struct UdpServer::Counters
+{
+    std::atomic<size_t> received{0};
+    std::atomic<size_t> truncated{0};
+    std::atomic<size_t> sent{0};
+    std::atomic<size_t> dropped{0};
+};
+
+struct UdpServer::Shard
+{
+    std::shared_ptr<io::IOManager> manager;
+    UdpSocket socket;
+    // 只在manager线程中使用, stopServe通过投递任务取消.
+    io::Canceler canceler;
+
+    Shard(std::shared_ptr<io::IOManager> _manager, UdpSocket _socket)
+        : manager{std::move(_manager)}, socket{_socket} {}
+};
+
+bool UdpReplier::send(StringPiece message, const SockAddress& peer_addr) {
+    if (message.size() > batch_.datagramSize())
+        return false;
+    if (batch_.full())
+        flush();
+    return batch_.push(message, &peer_addr);
+}
+
+void UdpReplier::flush() {
+    if (batch_.empty())
+        return;
+    const int ret = socket_.sendBatch(batch_);
+    const size_t sent = ret > 0 ? static_cast<size_t>(ret) : 0;
+    if (sent < batch_.size()) {
+        LON_LOG_DEBUG(G_logger) << fmt::format("udp reply dropped, fd:{}, count:{}, err:{}(with errno={})",
+                                               socket_.fd(),
+                                               batch_.size() - sent,
+                                               std::strerror(errno),
+                                               errno);
+    }
+    sent_ += sent;
+    dropped_ += batch_.size() - sent;
+    batch_.clear();
+}
+
+UdpServer::UdpServer(OnDatagramCallbackType _on_datagram,
+                     std::unique_ptr<io::IOWorkBalancer> _balancer)
+    : on_datagram_{std::move(_on_datagram)},
+      counters_{std::make_shared<Counters>()},
+      balancer_{std::move(_balancer)} {
+    if (balancer_ == nullptr)
+        balancer_ = std::make_unique<io::SimpleIOBalancer>();
+}
+
+UdpServer::~UdpServer() {
+    if (serving_) {
+        LON_LOG_ERROR(G_logger) << "udp server is being destroy while serving";
+        stopServe();
+    } else if (bound_socket_.fd() != -1) {
+        bound_socket_.close();
+    }
+}
+
+bool UdpServer::bind(SockAddress::SharedPtr local_address) {
+    if (local_address_) {
+        LON_LOG_ERROR(G_logger) << "udp server has bind socket";
+        return false;
+    }
+    UdpSocket socket = createSocket(local_address);
+    if (socket.fd() == -1)
+        return false;
+    bound_socket_  = socket;
+    local_address_ = std::move(local_address);
+    LON_LOG_INFO(G_logger) << fmt::format("udp server bind addr succeed, addr:{}", local_address_->toString());
+    return true;
+}
+
+bool UdpServer::startServe() {
+    if (!local_address_) {
+        LON_LOG_ERROR(G_logger) << "udp server start without bind";
+        return false;
+    }
+    if (serving_)
+        return true;
+    serving_ = true;
+
+    auto current_manager = io::IOManager::getThreadLocal();
+    for (auto& manager : balancer_->getIOManagers()) {
+        if (manager != current_manager)
+            startShard(manager);
+    }
+    // 当前线程不在均衡器中时, 当前线程的socket同样会被内核分配数据报, 照常在当前线程中处理.
+    auto shard = std::make_shared<Shard>(current_manager, bound_socket_);
+    {
+        std::lock_guard<std::mutex> lock(shard_mutex_);
+        shards_.push_back(shard);
+    }
+    startReceiveLoop(std::move(shard));
+    return true;
+}
+
+bool UdpServer::stopServe() {
+    if (!serving_)
+        return true;
+    serving_ = false;
+
+    std::lock_guard<std::mutex> lock(shard_mutex_);
+    for (auto& shard : shards_) {
+        // canceler只在shard所在的线程中使用, 接收循环被唤醒以后关闭socket.
+        shard->manager->addRemoteTask(std::make_shared<coroutine::Executor>(
+            [shard]() { shard->canceler.cancel(); }));
+    }
+    shards_.clear();
+    bound_socket_ = UdpSocket(Socket());
+    return true;
+}
+
+auto UdpServer::getStats() const noexcept -> Stats {
+    Stats stats;
+    stats.received  = counters_->received.load(std::memory_order_relaxed);
+    stats.truncated = counters_->truncated.load(std::memory_order_relaxed);
+    stats.sent      = counters_->sent.load(std::memory_order_relaxed);
+    stats.dropped   = counters_->dropped.load(std::memory_order_relaxed);
+    return stats;
+}
+
+UdpSocket UdpServer::createSocket(const SockAddress::SharedPtr& local_address) const {
+    // 接收循环需要在EAGAIN时挂起并且可以被取消, 所以socket总是非阻塞的.
+    int fd = ::socket(local_address->getFamily(), SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        LON_LOG_ERROR(G_logger) << fmt::format("create udp socket failed, err:{}(with errno={})",
+                                               std::strerror(errno),
+                                               errno);
+        return UdpSocket(Socket());
+    }
+    UdpSocket socket{Socket(fd)};
+    socket.getSocket().setReusePort(true);
+    if (options_.recv_buffer_size > 0)
+        socket.getSocket().setOption(SOL_SOCKET, SO_RCVBUF, options_.recv_buffer_size);
+    if (socket_initer_)
+        socket_initer_(socket.getSocket());
+
+    if (socket.bind(local_address) == -1) {
+        LON_LOG_ERROR(G_logger) << fmt::format("bind udp socket failed, addr:{}, err:{}(with errno={})",
+                                               local_address->toString(),
+                                               std::strerror(errno),
+                                               errno);
+        socket.close();
+    }
+    return socket;
+}
+
+void UdpServer::startReceiveLoop(std::shared_ptr<Shard> shard) {
+    auto hold_this = this->shared_from_this();
+    shard->manager->addExecutor(std::make_shared<coroutine::Executor>([this, hold_this, shard]() {
+        DatagramBatch datagrams(options_.batch_size, options_.datagram_size);
+        UdpReplier replier(shard->socket, options_.batch_size, options_.datagram_size);
+        const int fd = shard->socket.fd();
+        while (!shard->canceler.cancelled()) {
+            const int n = shard->socket.recvBatch(datagrams);
+            if (n > 0) {
+                size_t truncated = 0;
+                for (size_t i = 0; i < datagrams.size(); ++i) {
+                    if (datagrams.truncated(i)) {
+                        ++truncated;
+                        continue;
+                    }
+                    on_datagram_(datagrams.get(i), datagrams.getPeer(i), replier);
+                }
+                const size_t sent    = replier.sent();
+                const size_t dropped = replier.dropped();
+                replier.flush();
+                counters_->received.fetch_add(datagrams.size() - truncated, std::memory_order_relaxed);
+                counters_->truncated.fetch_add(truncated, std::memory_order_relaxed);
+                counters_->sent.fetch_add(replier.sent() - sent, std::memory_order_relaxed);
+                counters_->dropped.fetch_add(replier.dropped() - dropped, std::memory_order_relaxed);
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                // 取消时返回-1.
+                if (io::co_waitEvent(fd, false, static_cast<size_t>(-1), &shard->canceler) == -1)
+                    break;
+                continue;
+            }
+            if (errno == EINTR)
+                continue;
+            if (errno == EBADF)
+                break;
+            // 例如之前的回复触发的ICMP错误(ECONNREFUSED), 不影响后续的数据报.
+            LON_LOG_DEBUG(G_logger) << fmt::format(
+                "recvmmsg failed, fd:{}, err:{}(with errno={})", fd, std::strerror(errno), errno);
+        }
+        shard->socket.close();
+    }));
+}
+
+void UdpServer::startShard(const std::shared_ptr<io::IOManager>& manager) {
+    auto hold_this = this->shared_from_this();
+    manager->addRemoteTask(std::make_shared<coroutine::Executor>([this, hold_this, manager]() {
+        UdpSocket socket = createSocket(local_address_);
+        if (socket.fd() == -1)
+            return;
+        auto shard = std::make_shared<Shard>(manager, socket);
+        {
+            std::lock_guard<std::mutex> lock(shard_mutex_);
+            if (!serving_) {
+                shard->socket.close();
+                return;
+            }
+            shards_.push_back(shard);
+        }
+        startReceiveLoop(std::move(shard));
+    }));
+}
+
+}  // namespace lon::net
@@ -0,0 +1,153 @@
+#include "net/udp/udp_socket.h"
+
+#include "logger.h"
+
+#include <cstring>
+#include <fmt/core.h>
+
+static lon::log::LoggerSlot G_logger{"system"};
+
+namespace lon::net {
+
+DatagramBatch::DatagramBatch(size_t capacity, size_t datagram_size)
+    : datagram_size_{datagram_size},
+      buffers_(capacity, nullptr),
+      iovecs_(capacity),
+      addresses_(capacity),
+      msgs_(capacity) {
+    auto pool = BufferPool::getThreadLocal(datagram_size_);
+    for (size_t i = 0; i < capacity; ++i) {
+        buffers_[i] = pool->acquire();
+
+        iovecs_[i].iov_base = buffers_[i];
+        iovecs_[i].iov_len  = 0;
+
+        memset(&msgs_[i], 0, sizeof(mmsghdr));
+        msgs_[i].msg_hdr.msg_iov    = &iovecs_[i];
+        msgs_[i].msg_hdr.msg_iovlen = 1;
+    }
+}
+
+DatagramBatch::~DatagramBatch() {
+    // 析构可能发生在其它线程, 以当前线程的pool为准.
+    auto pool = BufferPool::getThreadLocal(datagram_size_);
+    for (auto buffer : buffers_) {
+        pool->release(buffer);
+    }
+}
+
+bool DatagramBatch::push(StringPiece message, const SockAddress* peer_addr) {
+    if (full() || message.size() > datagram_size_)
+        return false;
+
+    memcpy(buffers_[size_], message.data(), message.size());
+    iovecs_[size_].iov_len = message.size();
+
+    auto& header = msgs_[size_].msg_hdr;
+    if (peer_addr) {
+        addresses_[size_]  = InetAddress(peer_addr->getAddr(), peer_addr->getAddrLen());
+        header.msg_name    = addresses_[size_].getAddrMutable();
+        header.msg_namelen = addresses_[size_].getAddrLen();
+    } else {
+        header.msg_name    = nullptr;
+        header.msg_namelen = 0;
+    }
+    header.msg_flags = 0;
+    ++size_;
+    return true;
+}
+
+void DatagramBatch::prepareRecv() noexcept {
+    size_ = 0;
+    for (size_t i = 0; i < buffers_.size(); ++i) {
+        iovecs_[i].iov_len = datagram_size_;
+
+        auto& header       = msgs_[i].msg_hdr;
+        header.msg_name    = addresses_[i].getAddrMutable();
+        header.msg_namelen = sizeof(sockaddr_storage);
+        header.msg_flags   = 0;
+        msgs_[i].msg_len   = 0;
+    }
+}
+
+void DatagramBatch::finishRecv(size_t count) noexcept {
+    size_ = count;
+    for (size_t i = 0; i < count; ++i) {
+        iovecs_[i].iov_len = std::min<size_t>(msgs_[i].msg_len, datagram_size_);
+        addresses_[i].setAddrLen(msgs_[i].msg_hdr.msg_namelen);
+    }
+}
+
+UdpSocket::UdpSocket(sa_family_t family) : socket_{family, SOCK_DGRAM, 0} {
+}
+
+int UdpSocket::connect(const SockAddress& peer_addr) const {
+    return ::connect(socket_.fd(), peer_addr.getAddr(), peer_addr.getAddrLen());
+}
+
+ssize_t UdpSocket::sendTo(StringPiece message,
+                          const SockAddress* peer_addr,
+                          int flags) const {
+    if (!peer_addr)
+        return ::send(socket_.fd(), message.data(), message.size(), flags);
+    return ::sendto(socket_.fd(),
+                    message.data(),
+                    message.size(),
+                    flags,
+                    peer_addr->getAddr(),
+                    peer_addr->getAddrLen());
+}
+
+ssize_t UdpSocket::recvFrom(void* buffer,
+                            size_t length,
+                            SockAddress* peer_addr,
+                            int flags) const {
+    if (!peer_addr)
+        return ::recv(socket_.fd(), buffer, length, flags);
+    socklen_t len = peer_addr->getAddrLen();
+    ssize_t ret = ::recvfrom(
+        socket_.fd(), buffer, length, flags, peer_addr->getAddrMutable(), &len);
+    if (ret != -1)
+        peer_addr->setAddrLen(len);
+    return ret;
+}
+
+int UdpSocket::sendBatch(DatagramBatch& batch, int flags) const {
+    size_t sent = 0;
+    while (sent < batch.size()) {
+        int ret = ::sendmmsg(socket_.fd(),
+                             batch.msgs_.data() + sent,
+                             static_cast<unsigned>(batch.size() - sent),
+                             flags);
+        if (ret == -1) {
+            if (errno == EINTR)
+                continue;
+            if (sent == 0) {
+                LON_LOG_DEBUG(G_logger) << fmt::format(
+                    "sendmmsg failed, fd:{}, err:{}(with errno={})",
+                    socket_.fd(),
+                    std::strerror(errno),
+                    errno);
+                return -1;
+            }
+            break;
+        }
+        sent += static_cast<size_t>(ret);
+    }
+    return static_cast<int>(sent);
+}
+
+int UdpSocket::recvBatch(DatagramBatch& batch, int flags) const {
+    batch.prepareRecv();
+    // MSG_WAITFORONE: 读到第一个数据报以后不再阻塞, 只取出当前已经就绪的部分.
+    int ret = ::recvmmsg(socket_.fd(),
+                         batch.msgs_.data(),
+                         static_cast<unsigned>(batch.capacity()),
+                         flags | MSG_WAITFORONE,
+                         nullptr);
+    if (ret > 0)
+        batch.finishRecv(static_cast<size_t>(ret));
+    return ret;
+}
+
+}  // namespace lon::net
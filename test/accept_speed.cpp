@@ -0,0 +1,130 @@
+#include "balancer/io/avg_balancer.h"
+#include "base/chrono_helper.h"
+#include "base/print_helper.h"
+#include "io/hook.h"
+#include "io/io_manager.h"
+#include "net/tcp/tcp_server.h"
+
+#include <atomic>
+#include <fmt/core.h>
+#include <future>
+
+// accept速率测试: 多个客户端线程不断建立连接, 服务端accept后立即以RST关闭,
+// 客户端等到连接被关闭才发起下一个连接, 所以耗时反映的是服务端accept+分发的速度.
+// 对比单线程accept后交给均衡器 与 每个IOManager各自SO_REUSEPORT accept(sharded).
+
+using namespace lon::net;
+using namespace lon::io;
+
+constexpr uint16_t base_port     = 22240;
+constexpr size_t connection_count = 20000;
+constexpr size_t client_count     = 4;
+constexpr size_t worker_count     = 2;
+
+// 服务端在进程退出时才析构, 此时均衡器的线程都已经退出.
+static std::vector<TcpServer::Ptr> G_servers;
+
+static void client(uint16_t port, size_t count) {
+    IPV4Address peer("127.0.0.1", port);
+    for (size_t i = 0; i < count; ++i) {
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (::connect(fd, peer.getAddr(), peer.getAddrLen()) == -1) {
+            fmt::print("connect failed:{}\n", std::strerror(errno));
+            ::close(fd);
+            continue;
+        }
+        char buf;
+        ::recv(fd, &buf, sizeof(buf), 0);  // 等待服务端关闭.
+        ::close(fd);
+    }
+}
+
+template <typename BalancerFactory>
+static void runCase(const char* name,
+                    TcpServer::AcceptMode mode,
+                    BalancerFactory balancer_factory,
+                    uint16_t port) {
+    std::atomic<size_t> accepted{0};
+    std::promise<std::shared_ptr<IOManager>> server_manager_promise;
+    std::promise<bool> started_promise;
+
+    std::thread server_thread([&]() {
+        auto server = std::make_shared<TcpServer>(
+            [&accepted](std::shared_ptr<TcpConnection> connection) {
+                linger rst{1, 0};
+                connection->getSocket().setOption(SOL_SOCKET, SO_LINGER, rst);
+                connection->getSocket().close();
+                accepted.fetch_add(1, std::memory_order_relaxed);
+            },
+            balancer_factory());
+        server->setAcceptMode(mode);
+        server->setSocketIniter([](Socket& socket) { socket.setReuseAddr(true); });
+        bool ok = server->bind(std::make_shared<IPV4Address>("127.0.0.1", port));
+        if (ok)
+            server->startServe();
+        G_servers.push_back(server);
+        server_manager_promise.set_value(IOManager::getThreadLocal());
+        started_promise.set_value(ok);
+        IOManager::getThreadLocal()->run();
+    });
+    auto server_manager = server_manager_promise.get_future().get();
+    if (!started_promise.get_future().get()) {
+        fmt::print("{}: bind failed\n", name);
+        server_manager->addRemoteTask(std::make_shared<lon::coroutine::Executor>(
+            []() { IOManager::getThreadLocal()->stop(); }));
+        server_thread.join();
+        return;
+    }
+    // 分片的listen socket在均衡器线程中异步创建.
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    size_t time_span = 0;
+    {
+        lon::measure::GetTimeSpan<> span(&time_span);
+        std::vector<std::thread> clients;
+        for (size_t i = 0; i < client_count; ++i) {
+            clients.emplace_back(client, port, connection_count / client_count);
+        }
+        for (auto& thread : clients) {
+            thread.join();
+        }
+    }
+
+    auto server = G_servers.back();
+    server_manager->addRemoteTask(std::make_shared<lon::coroutine::Executor>(
+        [server]() {
+            server->stopServe();
+            // 关闭任务投递以后再停止均衡器线程.
+            for (auto& manager : server->getBalancer().getIOManagers()) {
+                manager->addRemoteTask(std::make_shared<lon::coroutine::Executor>(
+                    []() { IOManager::getThreadLocal()->stop(); }));
+            }
+            IOManager::getThreadLocal()->stop();
+        }));
+    server_thread.join();
+
+    fmt::print("{:<32}: {:>6} connections in {:>5} ms, {:>8.0f} conn/s\n",
+               name,
+               accepted.load(),
+               time_span,
+               static_cast<double>(accepted.load()) /
+                   static_cast<double>(time_span) * 1000.0);
+}
+
+int main() {
+    printDividing("accept speed");
+    uint16_t port = base_port;
+    runCase("single, same thread",
+            TcpServer::AcceptMode::Single,
+            []() { return std::make_unique<SimpleIOBalancer>(); },
+            port++);
+    runCase(fmt::format("single, {} workers", worker_count).c_str(),
+            TcpServer::AcceptMode::Single,
+            []() { return std::make_unique<SequenceIOBalancer>(worker_count); },
+            port++);
+    runCase(fmt::format("sharded, {} workers", worker_count).c_str(),
+            TcpServer::AcceptMode::Sharded,
+            []() { return std::make_unique<SequenceIOBalancer>(worker_count); },
+            port++);
+    return 0;
+}
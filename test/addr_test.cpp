@@ -2,6 +2,7 @@
 
 #include <gtest/gtest.h>
 #include <string>
+#include <map>
 #include <unordered_set>
 
 #include "net/address.h"
@@ -125,6 +126,58 @@ TEST(SockAddrTest, CheckComparatorBehavior) {
     }
 }
 
+TEST(SockAddrTest, InetAddress) {
+    InetAddress v4("1.2.3.4", 4321);
+    EXPECT_EQ(v4.getFamily(), AF_INET);
+    EXPECT_EQ(v4.getAddrLen(), sizeof(sockaddr_in));
+    EXPECT_EQ(v4.toString(), "1.2.3.4:4321");
+    EXPECT_EQ(v4.getAddressStr(), "1.2.3.4");
+    EXPECT_EQ(v4.getPort(), 4321);
+    EXPECT_EQ(v4, IPV4Address("1.2.3.4", 4321));
+    EXPECT_EQ(InetAddress(IPV4Address("1.2.3.4", 4321)), v4);
+    EXPECT_EQ(InetAddress("1.2.3.4:4321"), v4);
+
+    InetAddress v6("[::1]:80");
+    EXPECT_EQ(v6.getFamily(), AF_INET6);
+    EXPECT_TRUE(v6.isInetFamily());
+    EXPECT_EQ(v6.toString(), "::1:80");
+    EXPECT_EQ(v6, IPV6Address("::1", 80));
+    v6.setPort(81);
+    EXPECT_EQ(v6.getPort(), 81);
+    EXPECT_NE(v6, IPV6Address("::1", 80));
+
+    InetAddress unix_address(UnixAddress("@lon_addr_test"));
+    EXPECT_EQ(unix_address.getFamily(), AF_UNIX);
+    EXPECT_FALSE(unix_address.isInetFamily());
+    EXPECT_EQ(unix_address.toString(), "@lon_addr_test");
+    EXPECT_EQ(unix_address.getPort(), 0);
+
+    EXPECT_EQ(InetAddress().getFamily(), AF_UNSPEC);
+    EXPECT_THROW(InetAddress("localhost", 80), std::invalid_argument);
+    EXPECT_THROW(InetAddress("1.2.3.4:65536"), std::invalid_argument);
+}
+
+TEST(SockAddrTest, InetAddressAsKey) {
+    std::unordered_set<InetAddress> set;
+    std::map<InetAddress, int> map;
+    for (uint16_t port = 1; port <= 100; ++port) {
+        set.insert(InetAddress("127.0.0.1", port));
+        map[InetAddress("::1", port)] = port;
+    }
+    EXPECT_EQ(set.size(), 100u);
+    EXPECT_EQ(set.count(InetAddress("127.0.0.1", 50)), 1u);
+    EXPECT_EQ(set.count(InetAddress("127.0.0.2", 50)), 0u);
+    EXPECT_EQ(std::hash<InetAddress>{}(InetAddress("127.0.0.1", 50)),
+              std::hash<InetAddress>{}(InetAddress(IPV4Address("127.0.0.1", 50))));
+
+    EXPECT_EQ(map.size(), 100u);
+    EXPECT_EQ(map.at(InetAddress("::1", 7)), 7);
+    // 顺序同SockAddress::operator<.
+    EXPECT_TRUE(InetAddress("127.0.0.1", 1) < InetAddress("127.0.0.1", 2));
+    EXPECT_EQ(InetAddress("127.0.0.1", 1) < InetAddress("::1", 1),
+              IPV4Address("127.0.0.1", 1) < IPV6Address("::1", 1));
+}
+
 int main(int argc, char* argv[]) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
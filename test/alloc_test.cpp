@@ -0,0 +1,148 @@
+#include "net/socket.h"
+#include "net/udp/udp_socket.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <new>
+
+// 统计堆分配次数, 验证accept/connect/udp收发路径上的地址不分配堆内存.
+// 替换全局的operator new, 所以单独作为一个测试程序.
+
+using namespace lon;
+using namespace lon::net;
+
+static std::atomic<size_t> G_allocations{0};
+
+void* operator new(size_t size) {
+    G_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+size_t allocations() {
+    return G_allocations.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief 关闭时直接发送RST, 不进入TIME_WAIT, 避免大量连接耗尽本地端口.
+ */
+void closeWithReset(int fd) {
+    linger option{1, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &option, sizeof(option));
+    ::close(fd);
+}
+}  // namespace
+
+TEST(AllocTest, AcceptAndConnect) {
+    constexpr size_t accepts = 100000;
+    const InetAddress server_address("127.0.0.1", 22350);
+    Socket listen_socket(AF_INET, SOCK_STREAM, 0);
+    listen_socket.setReuseAddr(true);
+    ASSERT_EQ(listen_socket.bind(std::make_shared<InetAddress>(server_address)), 0);
+    ASSERT_EQ(listen_socket.listen(), 0);
+
+    size_t accept_allocations  = 0;
+    size_t connect_allocations = 0;
+    for (size_t i = 0; i < accepts; ++i) {
+        const int client = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        ASSERT_NE(client, -1);
+        size_t before = allocations();
+        ASSERT_EQ(sockopt::connect(client, server_address), 0);
+        connect_allocations += allocations() - before;
+
+        InetAddress peer_addr;
+        before          = allocations();
+        Socket accepted = listen_socket.accept4(peer_addr, SOCK_CLOEXEC);
+        accept_allocations += allocations() - before;
+        ASSERT_NE(accepted.fd(), -1);
+        if (i == 0) {
+            InetAddress client_address;
+            socklen_t len = sizeof(sockaddr_storage);
+            ::getsockname(client, client_address.getAddrMutable(), &len);
+            client_address.setAddrLen(len);
+            EXPECT_EQ(peer_addr, client_address);
+            EXPECT_EQ(*accepted.getLocalAddress(), server_address);
+        }
+        closeWithReset(client);
+        accepted.close();
+    }
+    EXPECT_EQ(accept_allocations, 0u);
+    EXPECT_EQ(connect_allocations, 0u);
+    listen_socket.close();
+}
+
+TEST(AllocTest, UdpBatch) {
+    constexpr size_t rounds = 1000;
+    constexpr size_t window = 16;
+    UdpSocket server;
+    ASSERT_EQ(server.bind(std::make_shared<InetAddress>("127.0.0.1", 22351)), 0);
+    UdpSocket client;
+    ASSERT_EQ(client.connect(InetAddress("127.0.0.1", 22351)), 0);
+
+    DatagramBatch requests(window);
+    while (!requests.full()) {
+        requests.push("ping");
+    }
+    DatagramBatch datagrams(window);
+    DatagramBatch replies(window);
+    DatagramBatch received(window);
+
+    size_t total = 0;
+    for (size_t i = 0; i < rounds; ++i) {
+        ASSERT_EQ(client.sendBatch(requests), static_cast<int>(window));
+        const size_t before = allocations();
+        size_t count        = 0;
+        InetAddress last_peer;
+        while (count < window) {
+            const int n = server.recvBatch(datagrams);
+            ASSERT_GT(n, 0);
+            for (size_t j = 0; j < datagrams.size(); ++j) {
+                last_peer = datagrams.getPeer(j);
+                replies.push(datagrams.get(j), &last_peer);
+            }
+            count += static_cast<size_t>(n);
+            server.sendBatch(replies);
+            replies.clear();
+        }
+        total += allocations() - before;
+        EXPECT_EQ(last_peer.getFamily(), AF_INET);
+
+        size_t echoed = 0;
+        while (echoed < window) {
+            const int n = client.recvBatch(received);
+            ASSERT_GT(n, 0);
+            echoed += static_cast<size_t>(n);
+        }
+    }
+    EXPECT_EQ(total, 0u);
+    server.close();
+    client.close();
+}
+
+int main(int argc, char* argv[]) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,167 @@
+#include "base/buffer.h"
+#include "base/io_buffer.h"
+#include "net/tcp/connection.h"
+
+#include <cstring>
+#include <gtest/gtest.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace lon;
+
+namespace {
+String makeData(size_t len) {
+    String data(len, '\0');
+    for (size_t i = 0; i < len; ++i) {
+        data[i] = static_cast<char>('a' + i % 26);
+    }
+    return data;
+}
+}  // namespace
+
+TEST(BufferTest, FixedBuffer) {
+    FixedBuffer<8> buffer;
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_TRUE(buffer.append("hello"));
+    EXPECT_EQ(buffer.avail(), 3);
+    EXPECT_FALSE(buffer.append("world"));
+    EXPECT_EQ(buffer.toString(), "hello");
+    buffer.reset();
+    EXPECT_EQ(buffer.size(), 0);
+    EXPECT_EQ(LargeBuffer::capacity(), kLargeBufferSize);
+}
+
+TEST(BufferTest, AutoBuffer) {
+    AutoBuffer<8> buffer;
+    buffer.append("hello");
+    EXPECT_TRUE(buffer.isInline());
+    buffer.append(" world");
+    EXPECT_FALSE(buffer.isInline());
+    EXPECT_EQ(buffer.toString(), "hello world");
+
+    AutoBuffer<8> moved(std::move(buffer));
+    EXPECT_EQ(moved.toString(), "hello world");
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_TRUE(buffer.isInline());
+
+    AutoBuffer<8> copied(moved);
+    EXPECT_EQ(copied.toString(), "hello world");
+}
+
+TEST(IOBufferTest, AppendAndRead) {
+    IOBuffer buffer;
+    const String data = makeData(IOBuffer::kBlockSize * 3 + 100);
+    buffer.append(data);
+    EXPECT_EQ(buffer.readableBytes(), data.size());
+    EXPECT_EQ(buffer.blockCount(), 4);
+    EXPECT_EQ(buffer.toString(), data);
+
+    String head(10, '\0');
+    EXPECT_EQ(buffer.read(head.data(), head.size()), head.size());
+    EXPECT_EQ(head, data.substr(0, 10));
+    buffer.consume(IOBuffer::kBlockSize);
+    EXPECT_EQ(buffer.toString(), data.substr(10 + IOBuffer::kBlockSize));
+    buffer.consume(data.size());
+    EXPECT_TRUE(buffer.empty());
+    // 保留最后一个block供之后写入.
+    EXPECT_EQ(buffer.blockCount(), 1);
+    buffer.append("next");
+    EXPECT_EQ(buffer.blockCount(), 1);
+    EXPECT_EQ(buffer.writableBytes(), IOBuffer::kBlockSize - IOBuffer::kPrependSize - 4);
+    buffer.clear();
+    EXPECT_EQ(buffer.blockCount(), 0);
+}
+
+TEST(IOBufferTest, Prepend) {
+    IOBuffer buffer;
+    buffer.append("body");
+    const uint32_t len = 4;
+    buffer.prepend(&len, sizeof(len));
+    // 预留空间足够时不需要新的block.
+    EXPECT_EQ(buffer.blockCount(), 1);
+    EXPECT_EQ(buffer.readableBytes(), 8);
+
+    const String big = makeData(IOBuffer::kPrependSize * 2);
+    buffer.prepend(big.data(), big.size());
+    String expected = big + String(reinterpret_cast<const char*>(&len), sizeof(len)) + "body";
+    EXPECT_EQ(buffer.toString(), expected);
+}
+
+TEST(IOBufferTest, SliceAndSplit) {
+    IOBuffer buffer;
+    const String data = makeData(IOBuffer::kBlockSize + 50);
+    buffer.append(data);
+
+    // 第一个block预留了prepend空间, 这里的切片跨越两个block.
+    const size_t offset = IOBuffer::kBlockSize - IOBuffer::kPrependSize - 10;
+    auto view           = buffer.slice(offset, 30);
+    EXPECT_EQ(view.toString(), data.substr(offset, 30));
+    EXPECT_EQ(view.blockCount(), 2);
+    // 共享的block不能写入, 追加的数据在新的block中.
+    EXPECT_EQ(buffer.writableBytes(), 0);
+    buffer.append("tail");
+    EXPECT_EQ(view.toString(), data.substr(offset, 30));
+    EXPECT_EQ(buffer.toString(), data + "tail");
+
+    auto head = buffer.split(100);
+    EXPECT_EQ(head.toString(), data.substr(0, 100));
+    EXPECT_EQ(buffer.toString(), data.substr(100) + "tail");
+
+    head.append(std::move(buffer));
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(head.toString(), data + "tail");
+}
+
+TEST(IOBufferTest, Iovec) {
+    IOBuffer buffer;
+    buffer.append("abc");
+    iovec iov[8];
+    const size_t count = buffer.prepareIovec(iov, 8, IOBuffer::kBlockSize * 2);
+    EXPECT_EQ(count, 3);
+    std::memcpy(iov[0].iov_base, "def", 3);
+    buffer.commit(3);
+    EXPECT_EQ(buffer.toString(), "abcdef");
+    EXPECT_EQ(buffer.blockCount(), 1);
+
+    const size_t peek = buffer.peekIovec(iov, 8);
+    EXPECT_EQ(peek, 1);
+    EXPECT_EQ(String(static_cast<char*>(iov[0].iov_base), iov[0].iov_len), "abcdef");
+}
+
+TEST(IOBufferTest, ConnectionReadWrite) {
+    int fds[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    net::TcpConnection writer(net::Socket(fds[0]), nullptr);
+    net::TcpConnection reader(net::Socket(fds[1]), nullptr);
+
+    const String data = makeData(IOBuffer::kBlockSize * 5 + 7);
+    IOBuffer out;
+    out.append(data);
+    EXPECT_EQ(writer.writeFrom(out), static_cast<ssize_t>(data.size()));
+    EXPECT_TRUE(out.empty());
+
+    IOBuffer in;
+    EXPECT_EQ(reader.readInto(in), static_cast<ssize_t>(data.size()));
+    EXPECT_EQ(in.toString(), data);
+
+    ::close(fds[0]);
+    EXPECT_EQ(reader.readInto(in), 0);
+    ::close(fds[1]);
+}
+
+TEST(IOBufferTest, OutlivesBlockPool) {
+    // thread_local的IOBuffer先于block缓存池构造, 线程退出时在缓存池析构以后才释放block.
+    std::thread thread([]() {
+        thread_local IOBuffer buffer;
+        buffer.append(String(IOBuffer::kBlockSize * 2, 'x'));
+        EXPECT_EQ(buffer.readableBytes(), IOBuffer::kBlockSize * 2);
+    });
+    thread.join();
+}
+
+int main(int argc, char* argv[]) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
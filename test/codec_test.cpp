@@ -0,0 +1,165 @@
+#include "net/tcp/codec.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace lon;
+using namespace lon::net;
+
+TEST(CodecTest, FixedLength) {
+    FixedLengthCodec codec(4);
+    IOBuffer buffer;
+    IOBuffer frame;
+    buffer.append("abcdef");
+    EXPECT_EQ(codec.decode(buffer, frame), FrameCodec::DecodeResult::Frame);
+    EXPECT_EQ(frame.toString(), "abcd");
+    EXPECT_EQ(codec.decode(buffer, frame), FrameCodec::DecodeResult::NeedMore);
+    buffer.append("gh");
+    EXPECT_EQ(codec.decode(buffer, frame), FrameCodec::DecodeResult::Frame);
+    EXPECT_EQ(frame.toString(), "efgh");
+
+    IOBuffer out;
+    EXPECT_FALSE(codec.encode(StringPiece("abc"), out));
+    EXPECT_TRUE(out.empty());
+}
+
+TEST(CodecTest, LengthField) {
+    for (auto field_size : {LengthFieldCodec::FieldSize::U16, LengthFieldCodec::FieldSize::U32}) {
+        for (auto endian : {LengthFieldCodec::Endian::Big, LengthFieldCodec::Endian::Little}) {
+            LengthFieldCodec codec(field_size, endian);
+            IOBuffer stream;
+            EXPECT_TRUE(codec.encode(StringPiece("hello"), stream));
+            EXPECT_TRUE(codec.encode(StringPiece(""), stream));
+            const String big(IOBuffer::kBlockSize * 2, 'x');
+            EXPECT_TRUE(codec.encode(StringPiece(big), stream));
+            EXPECT_EQ(stream.readableBytes(), codec.headerLength() * 3 + 5 + big.size());
+
+            // 逐字节喂给decoder, 模拟tcp把数据拆开.
+            IOBuffer buffer;
+            IOBuffer frame;
+            std::vector<String> frames;
+            char c;
+            while (stream.read(&c, 1) == 1) {
+                buffer.append(&c, 1);
+                while (codec.decode(buffer, frame) == FrameCodec::DecodeResult::Frame) {
+                    frames.push_back(frame.toString());
+                }
+            }
+            ASSERT_EQ(frames.size(), 3);
+            EXPECT_EQ(frames[0], "hello");
+            EXPECT_EQ(frames[1], "");
+            EXPECT_EQ(frames[2], big);
+            EXPECT_TRUE(buffer.empty());
+        }
+    }
+
+    // 大端u16, 长度为0x0102.
+    LengthFieldCodec codec(LengthFieldCodec::FieldSize::U16, LengthFieldCodec::Endian::Big, 16);
+    IOBuffer buffer;
+    IOBuffer frame;
+    buffer.append("\x01\x02", 2);
+    EXPECT_EQ(codec.decode(buffer, frame), FrameCodec::DecodeResult::Error);
+    IOBuffer out;
+    EXPECT_FALSE(codec.encode(StringPiece(String(17, 'x')), out));
+}
+
+TEST(CodecTest, Delimiter) {
+    DelimiterCodec codec("\r\n", 8);
+    IOBuffer buffer;
+    IOBuffer frame;
+    buffer.append("GET\r");
+    EXPECT_EQ(codec.decode(buffer, frame), FrameCodec::DecodeResult::NeedMore);
+    buffer.append("\nHost\r\n\r\nrest");
+    EXPECT_EQ(codec.decode(buffer, frame), FrameCodec::DecodeResult::Frame);
+    EXPECT_EQ(frame.toString(), "GET");
+    EXPECT_EQ(codec.decode(buffer, frame), FrameCodec::DecodeResult::Frame);
+    EXPECT_EQ(frame.toString(), "Host");
+    EXPECT_EQ(codec.decode(buffer, frame), FrameCodec::DecodeResult::Frame);
+    EXPECT_EQ(frame.toString(), "");
+    EXPECT_EQ(codec.decode(buffer, frame), FrameCodec::DecodeResult::NeedMore);
+    EXPECT_EQ(buffer.toString(), "rest");
+
+    buffer.append("toolongline");
+    EXPECT_EQ(codec.decode(buffer, frame), FrameCodec::DecodeResult::Error);
+
+    IOBuffer out;
+    EXPECT_FALSE(codec.encode(StringPiece("a\r\nb"), out));
+    EXPECT_TRUE(codec.encode(StringPiece("ab"), out));
+    EXPECT_EQ(out.toString(), "ab\r\n");
+}
+
+TEST(CodecTest, DelimiterAcrossBlocks) {
+    DelimiterCodec codec("\r\n", IOBuffer::kBlockSize * 4);
+    IOBuffer buffer;
+    IOBuffer frame;
+    // 第一个block有kPrependSize的预留空间, 让分隔符跨越两个block.
+    const String line(IOBuffer::kBlockSize - IOBuffer::kPrependSize - 1, 'a');
+    buffer.append(line);
+    buffer.append("\r\nb\r\n");
+    EXPECT_EQ(buffer.blockCount(), 2);
+    EXPECT_EQ(codec.decode(buffer, frame), FrameCodec::DecodeResult::Frame);
+    EXPECT_EQ(frame.toString(), line);
+    EXPECT_EQ(codec.decode(buffer, frame), FrameCodec::DecodeResult::Frame);
+    EXPECT_EQ(frame.toString(), "b");
+}
+
+TEST(CodecTest, DelimiterOtherBuffer) {
+    DelimiterCodec codec("\r\n", 64);
+    IOBuffer first;
+    IOBuffer frame;
+    first.append("abcdefgh");
+    EXPECT_EQ(codec.decode(first, frame), FrameCodec::DecodeResult::NeedMore);
+
+    // 另一个buffer的分隔符在第一个buffer已经查找过的范围内, 需要从头查找.
+    IOBuffer second;
+    second.append("x\r\nyz");
+    EXPECT_EQ(codec.decode(second, frame), FrameCodec::DecodeResult::Frame);
+    EXPECT_EQ(frame.toString(), "x");
+
+    // 第一个buffer继续追加数据.
+    first.append("i\r\n");
+    EXPECT_EQ(codec.decode(first, frame), FrameCodec::DecodeResult::Frame);
+    EXPECT_EQ(frame.toString(), "abcdefghi");
+}
+
+TEST(CodecTest, ReadFrames) {
+    int fds[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    TcpConnection writer(Socket(fds[0]), nullptr);
+    TcpConnection reader(Socket(fds[1]), nullptr);
+
+    LengthFieldCodec codec;
+    IOBuffer out;
+    for (int i = 0; i < 10; ++i) {
+        codec.encode(StringPiece(std::to_string(i)), out);
+    }
+    EXPECT_GT(writer.writeFrom(out), 0);
+
+    IOBuffer in;
+    std::vector<String> frames;
+    EXPECT_EQ(readFrames(reader, codec, in, [&](IOBuffer& frame) {
+                  frames.push_back(frame.toString());
+                  return frames.size() < 5;
+              }),
+              1);
+    ASSERT_EQ(frames.size(), 5);
+    EXPECT_EQ(frames[4], "4");
+
+    // 剩余的帧保存在in中, 对端关闭后继续处理完再返回0.
+    ::close(fds[0]);
+    EXPECT_EQ(readFrames(reader, codec, in, [&](IOBuffer& frame) {
+                  frames.push_back(frame.toString());
+                  return true;
+              }),
+              0);
+    ASSERT_EQ(frames.size(), 10);
+    EXPECT_EQ(frames[9], "9");
+    ::close(fds[1]);
+}
+
+int main(int argc, char* argv[]) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -48,6 +48,116 @@ TEST(ConnectionTest, TcpMove) {
     }
 }
 
+TEST(ConnectionTest, WriteQueue) {
+    int fds[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    TcpConnection writer(Socket(fds[0]), nullptr);
+    TcpConnection reader(Socket(fds[1]), nullptr);
+
+    // 多次write合并为一次系统调用.
+    EXPECT_EQ(writer.write("hello"), 0);
+    EXPECT_EQ(writer.write(" "), 0);
+    lon::IOBuffer world;
+    world.append("world");
+    EXPECT_EQ(writer.write(std::move(world)), 0);
+    EXPECT_EQ(writer.pendingWriteBytes(), 11);
+    EXPECT_EQ(writer.getWriteStats().syscalls, 0);
+    EXPECT_EQ(writer.flush(), 11);
+    EXPECT_EQ(writer.getWriteStats().syscalls, 1);
+
+    lon::IOBuffer in;
+    EXPECT_EQ(reader.readInto(in), 11);
+    EXPECT_EQ(in.toString(), "hello world");
+
+    // cork期间只有uncork才会发送.
+    writer.cork();
+    writer.cork();
+    EXPECT_EQ(writer.write("ab"), 0);
+    EXPECT_EQ(writer.uncork(), 0);
+    EXPECT_EQ(writer.pendingWriteBytes(), 2);
+    EXPECT_EQ(writer.uncork(), 2);
+    EXPECT_FALSE(writer.corked());
+
+    // 超过高水位时立刻发送.
+    writer.setWriteWatermarks(4, 8);
+    EXPECT_EQ(writer.write("0123456789"), 0);
+    EXPECT_LE(writer.pendingWriteBytes(), 4);
+    EXPECT_TRUE(writer.writable());
+    EXPECT_EQ(writer.getWriteStats().bytes, 23);
+
+    // readInto之前会先flush写队列.
+    EXPECT_EQ(reader.write("pong"), 0);
+    in.clear();
+    EXPECT_EQ(reader.readInto(in), 12);
+    EXPECT_EQ(in.toString(), "ab0123456789");
+    EXPECT_EQ(reader.pendingWriteBytes(), 0);
+    in.clear();
+    EXPECT_EQ(writer.readInto(in), 4);
+    EXPECT_EQ(in.toString(), "pong");
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+TEST(ConnectionTest, SendFileAndSplice) {
+    int fds[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    TcpConnection writer(Socket(fds[0]), nullptr);
+    TcpConnection reader(Socket(fds[1]), nullptr);
+
+    FILE* file = ::tmpfile();
+    ASSERT_NE(file, nullptr);
+    const std::string content = "0123456789abcdef";
+    ASSERT_EQ(::fwrite(content.data(), 1, content.size(), file), content.size());
+    ::fflush(file);
+
+    // 写队列中的数据先于文件发送.
+    EXPECT_EQ(writer.write("head:"), 0);
+    EXPECT_EQ(writer.sendFile(::fileno(file), 10, 4), 4);
+    EXPECT_EQ(writer.pendingWriteBytes(), 0);
+    // 默认发送到文件末尾.
+    EXPECT_EQ(writer.sendFile(::fileno(file), 12), 4);
+
+    int pipe_fds[2];
+    ASSERT_EQ(::pipe(pipe_fds), 0);
+    ASSERT_EQ(::write(pipe_fds[1], "|pipe", 5), 5);
+    ::close(pipe_fds[1]);
+    // 管道写端关闭时返回实际发送的长度.
+    EXPECT_EQ(writer.splice(pipe_fds[0], 100), 5);
+    ::close(pipe_fds[0]);
+
+    lon::IOBuffer in;
+    EXPECT_EQ(reader.readInto(in), 18);
+    EXPECT_EQ(in.toString(), "head:abcdcdef|pipe");
+
+    ::fclose(file);
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+TEST(ConnectionTest, FlushOnDestroy) {
+    int fds[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    TcpConnection reader(Socket(fds[1]), nullptr);
+    {
+        // 写队列中的数据在析构时发送.
+        TcpConnection writer(Socket(fds[0]), nullptr);
+        EXPECT_EQ(writer.write("last response"), 0);
+        EXPECT_EQ(writer.pendingWriteBytes(), 13);
+    }
+    lon::IOBuffer in;
+    EXPECT_EQ(reader.readInto(in), 13);
+    EXPECT_EQ(in.toString(), "last response");
+
+    {
+        // socket已经关闭时只能丢弃.
+        TcpConnection writer(Socket(fds[0]), nullptr);
+        EXPECT_EQ(writer.write("lost"), 0);
+        writer.getSocket().close();
+    }
+    ::close(fds[1]);
+}
+
 //connection的网络相关测试移步../runner/runner_tcp.cpp
 
 int main(int argc, char* argv[]) {
@@ -0,0 +1,316 @@
+#include "base/info.h"
+#include "io/co_io_function.h"
+#include "io/io_manager.h"
+#include "net/stream_server.h"
+#include "net/tcp/connection_pool.h"
+#include "net/tcp/connector.h"
+
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <thread>
+
+using namespace lon;
+using namespace lon::net;
+
+namespace {
+/**
+ * @brief 在一个开启hook的IOManager线程中运行func.
+ */
+void runInIOManager(const std::function<void()>& func) {
+    std::thread thread([&]() {
+        auto io_manager = io::IOManager::getThreadLocal();
+        io_manager->addExecutor(std::make_shared<coroutine::Executor>([&]() {
+            func();
+            io::IOManager::getThreadLocal()->stop();
+        }));
+        io_manager->run();
+    });
+    thread.join();
+}
+
+void spawn(std::function<void()> func) {
+    io::IOManager::getThreadLocal()->addExecutor(
+        std::make_shared<coroutine::Executor>(std::move(func)));
+}
+
+/**
+ * @brief 绑定127.0.0.1的随机端口, backlog小于0时只bind, 连接会被拒绝.
+ */
+int bindLoopback(uint16_t& port, int backlog) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len        = sizeof(addr);
+    EXPECT_EQ(::bind(fd, reinterpret_cast<sockaddr*>(&addr), len), 0);
+    if (backlog >= 0) {
+        EXPECT_EQ(::listen(fd, backlog), 0);
+    }
+    EXPECT_EQ(::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len), 0);
+    port = ntohs(addr.sin_port);
+    return fd;
+}
+
+/**
+ * @brief 从不accept并且accept队列已满的监听socket, 内核会丢弃新的SYN, 连接一直处于进行中.
+ * 需要在hook未开启的线程中创建.
+ */
+class StalledListener
+{
+public:
+    StalledListener() {
+        listen_fd_ = bindLoopback(port_, 0);
+        sockaddr_in addr = toSockaddr();
+        for (int& fd : filler_fds_) {
+            fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+            ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        }
+        // 等待前面的握手完成, 占满accept队列.
+        ::usleep(20 * 1000);
+    }
+
+    ~StalledListener() {
+        for (int fd : filler_fds_) {
+            ::close(fd);
+        }
+        ::close(listen_fd_);
+    }
+
+    uint16_t port() const noexcept { return port_; }
+
+    sockaddr_in toSockaddr() const {
+        sockaddr_in addr{};
+        addr.sin_family      = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port        = htons(port_);
+        return addr;
+    }
+
+private:
+    int listen_fd_ = -1;
+    int filler_fds_[3]{};
+    uint16_t port_ = 0;
+};
+
+std::vector<SockAddress::UniquePtr> loopbackAddrs(std::initializer_list<uint16_t> ports) {
+    std::vector<SockAddress::UniquePtr> addrs;
+    for (uint16_t port : ports) {
+        addrs.push_back(std::make_unique<IPV4Address>("127.0.0.1", port));
+    }
+    return addrs;
+}
+
+String echo(TcpConnection& connection, StringPiece message) {
+    connection.send(message);
+    String reply(message.size(), '\0');
+    size_t received = 0;
+    while (received < reply.size()) {
+        const ssize_t n = connection.recv(&reply[received], reply.size() - received);
+        if (n <= 0)
+            break;
+        received += static_cast<size_t>(n);
+    }
+    reply.resize(received);
+    return reply;
+}
+}  // namespace
+
+TEST(ConnectorTest, ConnectTimeoutAndCancel) {
+    StalledListener stalled;
+    runInIOManager([&]() {
+        const sockaddr_in addr = stalled.toSockaddr();
+        auto peer = reinterpret_cast<const sockaddr*>(&addr);
+
+        int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        size_t start = currentMs();
+        EXPECT_EQ(io::co_connectWithTimeout(fd, peer, sizeof(addr), 100), -1);
+        EXPECT_EQ(errno, ETIMEDOUT);
+        EXPECT_GE(currentMs() - start, 90u);
+        EXPECT_LT(currentMs() - start, 1000u);
+        ::close(fd);
+
+        // 不超时的connect可以被其它协程取消.
+        io::Canceler canceler;
+        spawn([&]() {
+            ::usleep(50 * 1000);
+            canceler.cancel();
+        });
+        fd    = ::socket(AF_INET, SOCK_STREAM, 0);
+        start = currentMs();
+        EXPECT_EQ(io::co_connectWithTimeout(fd, peer, sizeof(addr), static_cast<size_t>(-1), &canceler), -1);
+        EXPECT_EQ(errno, ECANCELED);
+        EXPECT_LT(currentMs() - start, 1000u);
+        ::close(fd);
+
+        // 已经取消的canceler需要reset才能再次使用.
+        fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        EXPECT_EQ(io::co_connectWithTimeout(fd, peer, sizeof(addr), 100, &canceler), -1);
+        EXPECT_EQ(errno, ECANCELED);
+        ::close(fd);
+    });
+}
+
+TEST(ConnectorTest, HappyEyeballs) {
+    StalledListener stalled;
+    uint16_t good_port    = 0;
+    uint16_t refused_port = 0;
+    int good_fd           = bindLoopback(good_port, SOMAXCONN);
+    int refused_fd        = bindLoopback(refused_port, -1);
+
+    runInIOManager([&]() {
+        // 第一个地址没有响应, attempt_delay之后并发尝试第二个地址.
+        size_t start = currentMs();
+        auto connection =
+            TcpConnector::connect(loopbackAddrs({stalled.port(), good_port}), 2000, 50);
+        ASSERT_NE(connection, nullptr);
+        EXPECT_EQ(*connection->getPeerAddr(), IPV4Address("127.0.0.1", good_port));
+        EXPECT_GE(currentMs() - start, 40u);
+        EXPECT_LT(currentMs() - start, 1000u);
+        connection->getSocket().close();
+
+        // 第一个地址失败时立即尝试下一个, 不等待attempt_delay.
+        start      = currentMs();
+        connection = TcpConnector::connect(loopbackAddrs({refused_port, good_port}), 2000, 5000);
+        ASSERT_NE(connection, nullptr);
+        EXPECT_EQ(*connection->getPeerAddr(), IPV4Address("127.0.0.1", good_port));
+        EXPECT_LT(currentMs() - start, 1000u);
+        connection->getSocket().close();
+
+        // 全部失败时返回最后一次失败的原因.
+        connection = TcpConnector::connect(loopbackAddrs({refused_port, refused_port}), 2000, 50);
+        EXPECT_EQ(connection, nullptr);
+        EXPECT_EQ(errno, ECONNREFUSED);
+
+        // 整体超时.
+        start      = currentMs();
+        connection = TcpConnector::connect(loopbackAddrs({stalled.port(), stalled.port()}), 150, 50);
+        EXPECT_EQ(connection, nullptr);
+        EXPECT_EQ(errno, ETIMEDOUT);
+        EXPECT_LT(currentMs() - start, 1000u);
+
+        // 取消整个连接过程.
+        io::Canceler canceler;
+        spawn([&]() {
+            ::usleep(80 * 1000);
+            canceler.cancel();
+        });
+        connection = TcpConnector::connect(
+            loopbackAddrs({stalled.port(), stalled.port()}), static_cast<size_t>(-1), 50, &canceler);
+        EXPECT_EQ(connection, nullptr);
+        EXPECT_EQ(errno, ECANCELED);
+
+        EXPECT_EQ(TcpConnector::connect(std::vector<SockAddress::UniquePtr>{}), nullptr);
+        EXPECT_EQ(errno, EINVAL);
+    });
+    ::close(good_fd);
+    ::close(refused_fd);
+}
+
+TEST(ConnectorTest, ConnectionPool) {
+    constexpr uint16_t port = 22340;
+    runInIOManager([&]() {
+        // 收到"close"时服务端关闭连接, 用于模拟空闲期间对端关闭.
+        auto server = std::make_shared<StreamServer>([](std::shared_ptr<TcpConnection> connection) {
+            char buffer[64];
+            ssize_t n;
+            while ((n = connection->recv(buffer, sizeof(buffer))) > 0) {
+                if (StringPiece(buffer, static_cast<size_t>(n)) == "close")
+                    break;
+                connection->send(buffer, static_cast<size_t>(n));
+            }
+            connection->getSocket().close();
+        });
+        // 服务端主动关闭的连接处于TIME_WAIT, 重复运行时需要SO_REUSEADDR.
+        server->setSocketIniter([](Socket& socket) { socket.setReuseAddr(true); });
+        ASSERT_TRUE(server->bind(std::make_shared<IPV4Address>("127.0.0.1", port)));
+        ASSERT_TRUE(server->startServe());
+
+        TcpConnectionPool::Options options;
+        options.max_per_host       = 1;
+        options.idle_timeout_ms    = 100;
+        options.acquire_timeout_ms = 50;
+        auto pool = std::make_shared<TcpConnectionPool>(options);
+
+        // 复用归还的连接.
+        int first_fd = -1;
+        {
+            auto handle = pool->acquire("127.0.0.1", port);
+            ASSERT_TRUE(handle);
+            EXPECT_FALSE(handle.reused());
+            EXPECT_EQ(echo(*handle, "ping"), "ping");
+            first_fd = handle->getSocket().fd();
+            EXPECT_EQ(pool->activeCount(), 1u);
+        }
+        EXPECT_EQ(pool->activeCount(), 0u);
+        EXPECT_EQ(pool->idleCount(), 1u);
+        {
+            auto handle = pool->acquire("127.0.0.1", port);
+            ASSERT_TRUE(handle);
+            EXPECT_TRUE(handle.reused());
+            EXPECT_EQ(handle->getSocket().fd(), first_fd);
+            EXPECT_EQ(echo(*handle, "pong"), "pong");
+
+            // 达到max_per_host时等待超时.
+            auto timeout_handle = pool->acquire("127.0.0.1", port);
+            EXPECT_FALSE(timeout_handle);
+            EXPECT_EQ(errno, ETIMEDOUT);
+        }
+
+        // 等待中的协程在连接归还时被唤醒并复用该连接.
+        {
+            auto handle = pool->acquire("127.0.0.1", port);
+            ASSERT_TRUE(handle);
+            bool waiter_done = false;
+            spawn([&]() {
+                auto waited = pool->acquire("127.0.0.1", port);
+                EXPECT_TRUE(waited);
+                EXPECT_TRUE(waited.reused());
+                EXPECT_EQ(waited->getSocket().fd(), first_fd);
+                waiter_done = true;
+            });
+            ::usleep(20 * 1000);
+            EXPECT_FALSE(waiter_done);
+            handle.release();
+            ::usleep(20 * 1000);
+            EXPECT_TRUE(waiter_done);
+        }
+        EXPECT_EQ(pool->activeCount(), 0u);
+        EXPECT_EQ(pool->idleCount(), 1u);
+
+        // 空闲期间被对端关闭的连接在复用前被检测出来.
+        {
+            auto handle = pool->acquire("127.0.0.1", port);
+            ASSERT_TRUE(handle);
+            EXPECT_TRUE(handle.reused());
+            handle->send("close");
+        }
+        ::usleep(20 * 1000);
+        {
+            auto handle = pool->acquire("127.0.0.1", port);
+            ASSERT_TRUE(handle);
+            EXPECT_FALSE(handle.reused());
+            EXPECT_EQ(echo(*handle, "fresh"), "fresh");
+        }
+
+        // 空闲超过idle_timeout_ms的连接被定时清理.
+        EXPECT_EQ(pool->idleCount(), 1u);
+        ::usleep(250 * 1000);
+        EXPECT_EQ(pool->idleCount(), 0u);
+        {
+            auto handle = pool->acquire("127.0.0.1", port);
+            ASSERT_TRUE(handle);
+            EXPECT_FALSE(handle.reused());
+            handle.markBroken();
+        }
+        EXPECT_EQ(pool->idleCount(), 0u);
+
+        pool = nullptr;
+        server->stopServe();
+        ::usleep(10 * 1000);
+    });
+}
+
+int main(int argc, char* argv[]) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
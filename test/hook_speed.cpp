@@ -0,0 +1,95 @@
+#include "base/chrono_helper.h"
+#include "base/print_helper.h"
+#include "io/hook.h"
+#include "io/io_manager.h"
+
+#include <fcntl.h>
+#include <fmt/core.h>
+#include <string>
+
+// 对比被hook的io api在不同线程中的额外开销.
+// 写入的是/dev/null, 所以耗时基本都是syscall以及hook层本身.
+// 每种情况都在新线程中跑round_time轮, 取最快的一轮, 减少调度和频率带来的抖动.
+
+constexpr int loop_time  = 2000000;
+constexpr int round_time = 3;
+const char write_buf[]   = "0123456789abcdef";
+
+static int G_fd = -1;
+
+static size_t writeSys() {
+    size_t time_span;
+    {
+        lon::measure::GetTimeSpan<> span(&time_span);
+        for (int i = 0; i < loop_time; ++i) {
+            write_sys(G_fd, write_buf, sizeof(write_buf));
+        }
+    }
+    return time_span;
+}
+
+static size_t writeHooked() {
+    size_t time_span;
+    {
+        lon::measure::GetTimeSpan<> span(&time_span);
+        for (int i = 0; i < loop_time; ++i) {
+            ::write(G_fd, write_buf, sizeof(write_buf));
+        }
+    }
+    return time_span;
+}
+
+/**
+ * @brief 在新线程中执行测试.
+ * @param thread_init 测试前在新线程中执行的初始化.
+ * @param in_executor 是否在IOManager的executor中执行.
+ */
+template <typename InitFunc>
+static void runCase(const char* name,
+                    size_t (*func)(),
+                    InitFunc thread_init,
+                    bool in_executor = false) {
+    size_t best = static_cast<size_t>(-1);
+    for (int round = 0; round < round_time; ++round) {
+        size_t time_span = 0;
+        std::thread thread([&]() {
+            thread_init();
+            if (!in_executor) {
+                time_span = func();
+                return;
+            }
+            auto io_manager = lon::io::IOManager::getThreadLocal();
+            io_manager->addExecutor(
+                std::make_shared<lon::coroutine::Executor>([&]() {
+                    time_span = func();
+                    lon::io::IOManager::getThreadLocal()->stop();
+                }));
+            io_manager->run();
+        });
+        thread.join();
+        best = std::min(best, time_span);
+    }
+    fmt::print("{:<40} {} times in {} ms, {:.1f} ns/call\n",
+               name,
+               loop_time,
+               best,
+               static_cast<double>(best) * 1000 * 1000 / loop_time);
+}
+
+int main() {
+    G_fd = ::open("/dev/null", O_WRONLY);
+
+    printDividing("hook speed");
+    // 主线程开启hook, 模拟一个进程中同时有IOManager线程与普通线程(比如日志的异步flush线程).
+    lon::io::setHookEnabled(true);
+
+    runCase("write_sys", &writeSys, []() {});
+    runCase("hooked write in plain thread", &writeHooked, []() {});
+    runCase("hooked write with hook disabled", &writeHooked, []() {
+        lon::io::setHookEnabled(false);
+    });
+    runCase("hooked write in executor", &writeHooked, []() {}, true);
+
+    ::close(G_fd);
+    return 0;
+}
@@ -0,0 +1,257 @@
+#include "base/chrono_helper.h"
+#include "base/print_helper.h"
+#include "io/io_manager.h"
+#include "net/http/http_client.h"
+#include "net/http/http_server.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <fmt/core.h>
+#include <future>
+#include <strings.h>
+
+// http qps测试: 每个连接一次发送depth个keep-alive的GET请求, 再读取depth个响应, 持续seconds秒.
+// 不带参数时在进程内启动HttpServer并测试几种组合;
+// 带参数时作为单独的压测工具: http_qps <ip> <port> <path> [connections] [depth] [seconds].
+// 压测端只解析Content-Length的响应, 不支持chunked.
+// http client: 客户端换成在另一个IOManager线程中运行的HttpClient, 多个协程共享同一个连接池.
+
+using namespace lon::net;
+
+constexpr uint16_t base_port = 22280;
+
+struct LoadOptions
+{
+    lon::String ip   = "127.0.0.1";
+    uint16_t port    = base_port;
+    lon::String path = "/hello";
+    int connections  = 1;
+    int depth        = 1;
+    int seconds      = 3;
+};
+
+struct LoadResult
+{
+    size_t responses = 0;
+    size_t errors    = 0;  // 非2xx的响应以及出错的连接.
+};
+
+/**
+ * @brief 从in中取出完整的响应, 返回取出的数量, 响应不合法时返回-1.
+ */
+static int consumeResponses(lon::String& in, LoadResult& result) {
+    int count     = 0;
+    size_t offset = 0;
+    while (true) {
+        const size_t header_end = in.find("\r\n\r\n", offset);
+        if (header_end == lon::String::npos)
+            break;
+        if (in.compare(offset, 5, "HTTP/") != 0 || header_end - offset < 12)
+            return -1;
+        const int status       = std::atoi(in.c_str() + offset + 9);
+        size_t content_length  = 0;
+        size_t line            = in.find("\r\n", offset);
+        while (line < header_end) {
+            const size_t next = in.find("\r\n", line + 2);
+            if (::strncasecmp(in.c_str() + line + 2, "content-length:", 15) == 0)
+                content_length = std::strtoul(in.c_str() + line + 17, nullptr, 10);
+            line = next;
+        }
+        const size_t end = header_end + 4 + content_length;
+        if (end > in.size())
+            break;
+        if (status < 200 || status >= 300)
+            ++result.errors;
+        ++result.responses;
+        ++count;
+        offset = end;
+    }
+    in.erase(0, offset);
+    return count;
+}
+
+/**
+ * @brief 单个连接的压测循环, 客户端线程没有开启hook, 使用阻塞的系统调用.
+ */
+static LoadResult runConnection(const LoadOptions& options, lon::steady_clock::time_point deadline) {
+    LoadResult result;
+    Socket socket(::socket(AF_INET, SOCK_STREAM, 0));
+    socket.setTcpNoDelay(true);
+    auto connection = socket.connect(std::make_unique<IPV4Address>(options.ip.c_str(), options.port));
+    if (!connection) {
+        socket.close();
+        ++result.errors;
+        return result;
+    }
+    const int fd = socket.fd();
+    lon::String request;
+    for (int i = 0; i < options.depth; ++i) {
+        request += fmt::format("GET {} HTTP/1.1\r\nHost: {}\r\n\r\n", options.path, options.ip);
+    }
+    lon::String in;
+    char buffer[64 * 1024];
+    while (lon::steady_clock::now() < deadline) {
+        if (::send(fd, request.data(), request.size(), 0) != static_cast<ssize_t>(request.size())) {
+            ++result.errors;
+            break;
+        }
+        int received = 0;
+        while (received < options.depth) {
+            const ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+            if (n <= 0)
+                break;
+            in.append(buffer, static_cast<size_t>(n));
+            const int count = consumeResponses(in, result);
+            if (count == -1)
+                break;
+            received += count;
+        }
+        if (received < options.depth) {
+            ++result.errors;
+            break;
+        }
+    }
+    socket.close();
+    return result;
+}
+
+static LoadResult runLoad(const LoadOptions& options, size_t* time_span) {
+    std::vector<std::future<LoadResult>> futures;
+    {
+        lon::measure::GetTimeSpan<> span(time_span);
+        const auto deadline = lon::steady_clock::now() + std::chrono::seconds(options.seconds);
+        for (int i = 0; i < options.connections; ++i) {
+            futures.push_back(std::async(std::launch::async, runConnection, std::cref(options), deadline));
+        }
+        for (auto& future : futures) {
+            future.wait();
+        }
+    }
+    LoadResult total;
+    for (auto& future : futures) {
+        const LoadResult result = future.get();
+        total.responses += result.responses;
+        total.errors += result.errors;
+    }
+    return total;
+}
+
+static void printResult(const lon::String& name, const LoadResult& result, size_t time_span) {
+    fmt::print("{:<36}: {:>9.0f} requests per second, {} errors\n",
+               name,
+               static_cast<double>(result.responses) / static_cast<double>(std::max<size_t>(time_span, 1)) * 1000.0,
+               result.errors);
+}
+
+/**
+ * @brief 在一个IOManager线程中运行coroutines个协程, 每个协程用HttpClient循环发送请求.
+ */
+static LoadResult runClientLoad(const LoadOptions& options, size_t* time_span) {
+    LoadResult result;
+    std::thread client_thread([&]() {
+        HttpClientOptions client_options;
+        client_options.timeout_ms = 5000;
+        HttpClient client(client_options);
+        const auto deadline = lon::steady_clock::now() + std::chrono::seconds(options.seconds);
+        const auto begin    = lon::steady_clock::now();
+        auto running        = std::make_shared<int>(options.connections);
+        for (int i = 0; i < options.connections; ++i) {
+            lon::io::IOManager::getThreadLocal()->addExecutor(std::make_shared<lon::coroutine::Executor>([&, running]() {
+                std::vector<HttpClientRequest> requests(static_cast<size_t>(options.depth));
+                for (auto& request : requests) {
+                    request.target = options.path;
+                }
+                std::vector<HttpClientResponse> responses;
+                HttpClientResponse response;
+                while (lon::steady_clock::now() < deadline) {
+                    size_t completed = 0;
+                    if (options.depth == 1) {
+                        completed = client.request(options.ip, options.port, requests[0], response) == 0 ? 1 : 0;
+                    } else {
+                        completed = client.pipeline(options.ip, options.port, requests, responses);
+                    }
+                    result.responses += completed;
+                    if (completed != requests.size()) {
+                        ++result.errors;
+                        break;
+                    }
+                }
+                if (--*running == 0) {
+                    *time_span = static_cast<size_t>(lon::getTimeSpanMs(begin, lon::steady_clock::now()));
+                    lon::io::IOManager::getThreadLocal()->stop();
+                }
+            }));
+        }
+        lon::io::IOManager::getThreadLocal()->run();
+    });
+    client_thread.join();
+    return result;
+}
+
+static void runCase(int connections, int depth, uint16_t port, bool use_client) {
+    std::promise<std::shared_ptr<lon::io::IOManager>> server_manager_promise;
+    std::promise<bool> started_promise;
+    std::unique_ptr<HttpServer> server;
+    std::thread server_thread([&]() {
+        HttpRouter router;
+        router.get("/hello", [](HttpRequest&, HttpResponse& response) {
+            response.setContentType("text/plain");
+            response.setBody("hello world");
+        });
+        server = std::make_unique<HttpServer>(std::move(router), HttpServerOptions{});
+        server->getTcpServer().setSocketIniter([](Socket& socket) { socket.setReuseAddr(true); });
+        const bool ok = server->bind(std::make_shared<IPV4Address>("127.0.0.1", port)) && server->startServe();
+        server_manager_promise.set_value(lon::io::IOManager::getThreadLocal());
+        started_promise.set_value(ok);
+        lon::io::IOManager::getThreadLocal()->run();
+    });
+    auto server_manager = server_manager_promise.get_future().get();
+    const auto name     = fmt::format("{}{} connections, depth {}", use_client ? "http client, " : "", connections, depth);
+    if (started_promise.get_future().get()) {
+        LoadOptions options;
+        options.port        = port;
+        options.connections = connections;
+        options.depth       = depth;
+        size_t time_span    = 0;
+        const LoadResult result = use_client ? runClientLoad(options, &time_span) : runLoad(options, &time_span);
+        printResult(name, result, time_span);
+    } else {
+        fmt::print("{}: bind failed\n", name);
+    }
+    server_manager->addRemoteTask(std::make_shared<lon::coroutine::Executor>([&server]() {
+        server->stopServe();
+        server.reset();
+        lon::io::IOManager::getThreadLocal()->stop();
+    }));
+    server_thread.join();
+}
+
+int main(int argc, char* argv[]) {
+    if (argc >= 4) {
+        LoadOptions options;
+        options.ip          = argv[1];
+        options.port        = static_cast<uint16_t>(std::atoi(argv[2]));
+        options.path        = argv[3];
+        options.connections = argc > 4 ? std::max(1, std::atoi(argv[4])) : 1;
+        options.depth       = argc > 5 ? std::max(1, std::atoi(argv[5])) : 1;
+        options.seconds     = argc > 6 ? std::max(1, std::atoi(argv[6])) : options.seconds;
+        size_t time_span    = 0;
+        const LoadResult result = runLoad(options, &time_span);
+        printResult(fmt::format("{}:{}{}", options.ip, options.port, options.path), result, time_span);
+        return 0;
+    }
+    if (argc != 1) {
+        fmt::print("usage: {} [<ip> <port> <path> [connections] [depth] [seconds]]\n", argv[0]);
+        return 1;
+    }
+
+    printDividing("http qps");
+    uint16_t port = base_port;
+    for (auto [connections, depth] : {std::pair{1, 1}, std::pair{1, 16}, std::pair{16, 1}, std::pair{16, 16}}) {
+        runCase(connections, depth, port++, false);
+    }
+    for (auto [connections, depth] : {std::pair{1, 1}, std::pair{1, 16}, std::pair{16, 1}}) {
+        runCase(connections, depth, port++, true);
+    }
+    return 0;
+}
@@ -0,0 +1,432 @@
+#include "io/io_manager.h"
+#include "net/http/http_client.h"
+#include "net/http/http_server.h"
+
+#include <future>
+#include <gtest/gtest.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace lon;
+using namespace lon::net;
+
+namespace {
+using Result = HttpRequestParser::Result;
+
+/**
+ * @brief 在开启hook的IOManager线程中处理socketpair的一端, 处理完成后关闭.
+ */
+std::thread serveInThread(int fd, const HttpRouter& router, HttpServerOptions options) {
+    return std::thread([fd, &router, options]() {
+        io::IOManager::getThreadLocal()->addExecutor(
+            std::make_shared<coroutine::Executor>([fd, &router, options]() {
+                TcpConnection connection(Socket(fd), nullptr);
+                HttpServer::serveConnection(connection, router, options);
+                ::close(fd);
+                io::IOManager::getThreadLocal()->stop();
+            }));
+        io::IOManager::getThreadLocal()->run();
+    });
+}
+
+String readAll(int fd) {
+    String result;
+    char buffer[4096];
+    ssize_t n = 0;
+    while ((n = ::recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        result.append(buffer, static_cast<size_t>(n));
+    }
+    return result;
+}
+}  // namespace
+
+TEST(HttpTest, ParseIncremental) {
+    const String raw =
+        "\r\nPOST /upload?name=a HTTP/1.1\r\n"
+        "Host: localhost\r\n"
+        "content-length: 5\r\n"
+        "X-Empty:\r\n"
+        "\r\n"
+        "hello";
+    HttpRequestParser parser(1024, 1024);
+    HttpRequest request;
+    IOBuffer buffer;
+    // 逐字节喂给parser, 模拟tcp把数据拆开.
+    for (size_t i = 0; i + 1 < raw.size(); ++i) {
+        buffer.append(&raw[i], 1);
+        ASSERT_EQ(parser.parse(buffer, request), Result::NeedMore) << i;
+    }
+    buffer.append(&raw.back(), 1);
+    ASSERT_EQ(parser.parse(buffer, request), Result::Complete);
+    EXPECT_EQ(request.method(), HttpMethod::Post);
+    EXPECT_EQ(request.target(), "/upload?name=a");
+    EXPECT_EQ(request.path(), "/upload");
+    EXPECT_EQ(request.query(), "name=a");
+    EXPECT_EQ(request.versionMinor(), 1);
+    EXPECT_EQ(request.header("HOST"), "localhost");
+    EXPECT_TRUE(request.hasHeader("x-empty"));
+    EXPECT_EQ(request.header("X-Empty"), "");
+    EXPECT_EQ(request.body().toString(), "hello");
+    EXPECT_TRUE(request.keepAlive());
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_TRUE(parser.idle());
+}
+
+TEST(HttpTest, ParsePipelinedAndChunked) {
+    HttpRequestParser parser(1024, 1024);
+    HttpRequest request;
+    IOBuffer buffer;
+    buffer.append(
+        "GET /a HTTP/1.0\r\n\r\n"
+        "PUT /b HTTP/1.1\r\nTransfer-Encoding: chunked\r\nConnection: close\r\n\r\n"
+        "5;ext=1\r\nhello\r\n6\r\n world\r\n0\r\nTrailer: x\r\n\r\n"
+        "GET /c HTTP/1.1\r\n\r\n");
+
+    ASSERT_EQ(parser.parse(buffer, request), Result::Complete);
+    EXPECT_EQ(request.path(), "/a");
+    EXPECT_EQ(request.versionMinor(), 0);
+    EXPECT_FALSE(request.keepAlive());
+
+    ASSERT_EQ(parser.parse(buffer, request), Result::Complete);
+    EXPECT_EQ(request.method(), HttpMethod::Put);
+    EXPECT_TRUE(request.chunked());
+    EXPECT_FALSE(request.keepAlive());
+    EXPECT_EQ(request.body().toString(), "hello world");
+
+    ASSERT_EQ(parser.parse(buffer, request), Result::Complete);
+    EXPECT_EQ(request.path(), "/c");
+    EXPECT_EQ(parser.parse(buffer, request), Result::NeedMore);
+}
+
+TEST(HttpTest, ParseHeaderAcrossBlocks) {
+    HttpRequestParser parser(IOBuffer::kBlockSize * 2, 1024);
+    HttpRequest request;
+    IOBuffer buffer;
+    const String value(IOBuffer::kBlockSize, 'v');
+    buffer.append("GET / HTTP/1.1\r\nX-Long: " + value + "\r\nHost: h\r\n\r\n");
+    EXPECT_GT(buffer.blockCount(), 1);
+    ASSERT_EQ(parser.parse(buffer, request), Result::Complete);
+    EXPECT_EQ(request.header("x-long"), value);
+    EXPECT_EQ(request.header("host"), "h");
+}
+
+TEST(HttpTest, ParseErrors) {
+    struct Case
+    {
+        String raw;
+        int status;
+    };
+    const std::vector<Case> cases = {
+        {"GET /\r\n\r\n", 400},
+        {"GET / HTTP/2.0\r\n\r\n", 505},
+        {"BREW / HTTP/1.1\r\n\r\n", 501},
+        {"GET / HTTP/1.1\r\nBad Name : x\r\n\r\n", 400},
+        {"GET / HTTP/1.1\r\n folded\r\n\r\n", 400},
+        {"POST / HTTP/1.1\r\nContent-Length: 3\r\nTransfer-Encoding: chunked\r\n\r\n", 400},
+        {"POST / HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\n", 400},
+        {"POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n", 501},
+        {"POST / HTTP/1.1\r\nContent-Length: 65\r\n\r\n", 413},
+        {"POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n41\r\n", 413},
+        {"POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n", 400},
+        {"GET / HTTP/1.1\r\nX: " + String(128, 'x') + "\r\n\r\n", 431},
+        {"GET / HTTP/1.1\r\nX: " + String(128, 'x'), 431},
+    };
+    for (const auto& item : cases) {
+        HttpRequestParser parser(128, 64);
+        HttpRequest request;
+        IOBuffer buffer;
+        buffer.append(item.raw);
+        EXPECT_EQ(parser.parse(buffer, request), Result::Error) << item.raw;
+        EXPECT_EQ(parser.errorStatus(), item.status) << item.raw;
+    }
+}
+
+TEST(HttpTest, Router) {
+    HttpRouter router;
+    auto handler = [](const char*) { return [](HttpRequest&, HttpResponse&) {}; };
+    EXPECT_TRUE(router.get("/", handler("root")));
+    EXPECT_TRUE(router.get("/users/me", handler("me")));
+    EXPECT_TRUE(router.get("/users/:id", handler("user")));
+    EXPECT_TRUE(router.get("/users/:id/files/*path", handler("file")));
+    EXPECT_TRUE(router.post("/users/:id", handler("update")));
+    EXPECT_TRUE(router.get("/static/*path", handler("static")));
+    EXPECT_FALSE(router.get("/users/:name", handler("conflict")));
+    EXPECT_FALSE(router.get("/users/me", handler("duplicate")));
+    EXPECT_FALSE(router.get("/a/*rest/b", handler("bad")));
+    EXPECT_FALSE(router.get("no-slash", handler("bad")));
+
+    HttpRequestParser parser(1024, 1024);
+    HttpRequest request;
+    bool path_matched = false;
+    auto route = [&](const char* raw) {
+        IOBuffer buffer;
+        buffer.append(raw);
+        request.reset();
+        EXPECT_EQ(parser.parse(buffer, request), Result::Complete) << raw;
+        return router.match(request, &path_matched) != nullptr;
+    };
+
+    ASSERT_TRUE(route("GET / HTTP/1.1\r\n\r\n"));
+    ASSERT_TRUE(route("GET /users/me HTTP/1.1\r\n\r\n"));
+    EXPECT_TRUE(request.params().empty());
+
+    // HEAD使用GET的路由.
+    ASSERT_TRUE(route("HEAD /users/42?x=1 HTTP/1.1\r\n\r\n"));
+    EXPECT_EQ(request.param("id"), "42");
+
+    // "/users/me"不能继续匹配时回溯到参数段.
+    ASSERT_TRUE(route("GET /users/me/files/a/b.txt HTTP/1.1\r\n\r\n"));
+    EXPECT_EQ(request.param("id"), "me");
+    EXPECT_EQ(request.param("path"), "a/b.txt");
+
+    ASSERT_TRUE(route("GET /static/ HTTP/1.1\r\n\r\n"));
+    EXPECT_EQ(request.params().size(), 1);
+    EXPECT_EQ(request.param("path"), "");
+
+    EXPECT_FALSE(route("GET /nothing HTTP/1.1\r\n\r\n"));
+    EXPECT_FALSE(path_matched);
+    EXPECT_FALSE(route("GET /users//files/x HTTP/1.1\r\n\r\n"));
+
+    EXPECT_FALSE(route("DELETE /users/1 HTTP/1.1\r\n\r\n"));
+    EXPECT_TRUE(path_matched);
+}
+
+TEST(HttpTest, ServeKeepAlivePipelining) {
+    HttpRouter router;
+    router.get("/hello", [](HttpRequest&, HttpResponse& response) { response.setBody("hello"); });
+    router.get("/users/:id", [](HttpRequest& request, HttpResponse& response) {
+        response.setBody(request.param("id"));
+    });
+    router.post("/echo", [](HttpRequest& request, HttpResponse& response) {
+        response.setBody(std::move(request.body()));
+    });
+    router.get("/bye", [](HttpRequest&, HttpResponse& response) {
+        response.writeChunk("by");
+        response.writeChunk("e");
+    });
+
+    int fds[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    auto server = serveInThread(fds[1], router, HttpServerOptions{});
+
+    const String requests =
+        "GET /hello HTTP/1.1\r\nHost: x\r\n\r\n"
+        "GET /users/42 HTTP/1.1\r\n\r\n"
+        "HEAD /hello HTTP/1.1\r\n\r\n"
+        "POST /echo HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n0\r\n\r\n"
+        "GET /missing HTTP/1.1\r\n\r\n"
+        "DELETE /hello HTTP/1.1\r\n\r\n"
+        "GET /bye HTTP/1.1\r\nConnection: close\r\n\r\n"
+        "GET /hello HTTP/1.1\r\n\r\n";  // 连接关闭以后的请求不会被处理.
+    ASSERT_EQ(::send(fds[0], requests.data(), requests.size(), 0), static_cast<ssize_t>(requests.size()));
+    const String responses = readAll(fds[0]);
+    server.join();
+    ::close(fds[0]);
+
+    EXPECT_EQ(responses,
+              "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nhello"
+              "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\n42"
+              "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\n"
+              "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nhello"
+              "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n"
+              "HTTP/1.1 405 Method Not Allowed\r\nAllow: GET, HEAD\r\nContent-Length: 0\r\n\r\n"
+              "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\nConnection: close\r\n\r\n"
+              "2\r\nby\r\n1\r\ne\r\n0\r\n\r\n");
+}
+
+TEST(HttpTest, ServeTimeouts) {
+    HttpRouter router;
+    router.get("/", [](HttpRequest&, HttpResponse& response) { response.setBody("ok"); });
+    HttpServerOptions options;
+    options.header_timeout_ms    = 50;
+    options.keepalive_timeout_ms = 50;
+
+    // 空闲超过keepalive_timeout_ms时直接关闭.
+    int fds[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    auto server = serveInThread(fds[1], router, options);
+    const String request = "GET / HTTP/1.1\r\n\r\n";
+    ::send(fds[0], request.data(), request.size(), 0);
+    EXPECT_EQ(readAll(fds[0]), "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+    server.join();
+    ::close(fds[0]);
+
+    // 请求没有在header_timeout_ms内读完时返回408.
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    server = serveInThread(fds[1], router, options);
+    const String partial = "GET / HTTP/1.1\r\nHost:";
+    ::send(fds[0], partial.data(), partial.size(), 0);
+    EXPECT_EQ(readAll(fds[0]), "HTTP/1.1 408 Request Timeout\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+    server.join();
+    ::close(fds[0]);
+}
+
+TEST(HttpTest, ParseResponse) {
+    const String raw =
+        "HTTP/1.1 100 Continue\r\n\r\n"
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/plain\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "\r\n"
+        "3\r\nabc\r\n0\r\n\r\n"
+        "HTTP/1.1 204 No Content\r\nConnection: close\r\n\r\n";
+    HttpResponseParser parser(1024, 1024);
+    HttpClientResponse response;
+    IOBuffer buffer;
+    for (size_t i = 0; i < raw.size(); ++i) {
+        buffer.append(&raw[i], 1);
+        if (parser.parse(buffer, response, false) == HttpResponseParser::Result::Complete)
+            break;
+    }
+    EXPECT_EQ(response.status(), 200);
+    EXPECT_EQ(response.reason(), "OK");
+    EXPECT_EQ(response.header("content-type"), "text/plain");
+    EXPECT_TRUE(response.chunked());
+    EXPECT_EQ(response.body().toString(), "abc");
+    EXPECT_TRUE(response.keepAlive());
+    EXPECT_TRUE(parser.idle());
+
+    buffer.append(raw.substr(raw.find("HTTP/1.1 204")));
+    ASSERT_EQ(parser.parse(buffer, response, false), HttpResponseParser::Result::Complete);
+    EXPECT_EQ(response.status(), 204);
+    EXPECT_FALSE(response.keepAlive());
+    EXPECT_TRUE(response.body().empty());
+
+    // HEAD的响应即使有Content-Length也没有body.
+    buffer.append("HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\n");
+    ASSERT_EQ(parser.parse(buffer, response, true), HttpResponseParser::Result::Complete);
+    EXPECT_TRUE(buffer.empty());
+
+    // 没有长度时读到连接关闭为止.
+    buffer.append("HTTP/1.0 200 OK\r\n\r\nhello ");
+    ASSERT_EQ(parser.parse(buffer, response, false), HttpResponseParser::Result::NeedMore);
+    EXPECT_FALSE(response.keepAlive());
+    buffer.append("world");
+    ASSERT_EQ(parser.parse(buffer, response, false), HttpResponseParser::Result::NeedMore);
+    ASSERT_EQ(parser.finish(buffer, response), HttpResponseParser::Result::Complete);
+    EXPECT_EQ(response.body().toString(), "hello world");
+
+    const std::vector<std::pair<String, int>> errors = {
+        {"HTTP/2 200 OK\r\n\r\n", EPROTO},
+        {"HTTP/1.1 2x0 OK\r\n\r\n", EPROTO},
+        {"HTTP/1.1 200 OK\r\nContent-Length: x\r\n\r\n", EPROTO},
+        {"HTTP/1.1 200 OK\r\nContent-Length: 2048\r\n\r\n", EMSGSIZE},
+        {"HTTP/1.1 200 OK\r\nX: " + String(2048, 'x'), EMSGSIZE},
+    };
+    for (const auto& [raw_response, error] : errors) {
+        HttpResponseParser error_parser(1024, 1024);
+        IOBuffer error_buffer;
+        error_buffer.append(raw_response);
+        EXPECT_EQ(error_parser.parse(error_buffer, response, false), HttpResponseParser::Result::Error)
+            << raw_response;
+        EXPECT_EQ(error_parser.error(), error) << raw_response;
+    }
+}
+
+TEST(HttpTest, ClientAgainstServer) {
+    constexpr uint16_t port = 22290;
+    HttpRouter router;
+    router.get("/hello", [](HttpRequest&, HttpResponse& response) { response.setBody("hello"); });
+    router.post("/echo", [](HttpRequest& request, HttpResponse& response) {
+        response.setBody(std::move(request.body()));
+    });
+    router.get("/stream", [](HttpRequest&, HttpResponse& response) {
+        response.writeChunk("part1,");
+        response.writeChunk("part2");
+    });
+    router.get("/close", [](HttpRequest&, HttpResponse& response) {
+        response.setKeepAlive(false);
+        response.setBody("bye");
+    });
+    router.get("/slow", [](HttpRequest&, HttpResponse& response) {
+        ::usleep(200 * 1000);
+        response.setBody("late");
+    });
+
+    std::promise<void> finished;
+    std::thread thread([&]() {
+        auto io_manager = io::IOManager::getThreadLocal();
+        HttpServer server(std::move(router), HttpServerOptions{});
+        server.getTcpServer().setSocketIniter([](Socket& socket) { socket.setReuseAddr(true); });
+        EXPECT_TRUE(server.bind(std::make_shared<IPV4Address>("127.0.0.1", port)));
+        EXPECT_TRUE(server.startServe());
+        // ASSERT失败时提前返回, 之后仍然需要停止IOManager.
+        auto run_client = [&]() {
+            HttpClientOptions options;
+            options.timeout_ms = 1000;
+            HttpClient client(options);
+            HttpClientResponse response;
+
+            ASSERT_EQ(client.get("127.0.0.1", port, "/hello", response), 0);
+            EXPECT_EQ(response.status(), 200);
+            EXPECT_EQ(response.body().toString(), "hello");
+            EXPECT_EQ(client.getPool().idleCount(), 1);
+
+            // 复用同一个连接.
+            HttpClientRequest post(HttpMethod::Post, "/echo");
+            post.body.append("payload");
+            ASSERT_EQ(client.request("127.0.0.1", port, post, response), 0);
+            EXPECT_EQ(response.body().toString(), "payload");
+            EXPECT_EQ(server.getTcpServer().getStats().accepted, 1);
+
+            ASSERT_EQ(client.get("127.0.0.1", port, "/stream", response), 0);
+            EXPECT_TRUE(response.chunked());
+            EXPECT_EQ(response.body().toString(), "part1,part2");
+
+            ASSERT_EQ(client.request("127.0.0.1", port, HttpClientRequest(HttpMethod::Head, "/hello"), response), 0);
+            EXPECT_EQ(response.header("content-length"), "5");
+            EXPECT_TRUE(response.body().empty());
+
+            ASSERT_EQ(client.get("127.0.0.1", port, "/missing", response), 0);
+            EXPECT_EQ(response.status(), 404);
+
+            std::vector<HttpClientRequest> requests;
+            for (int i = 0; i < 8; ++i) {
+                requests.emplace_back(HttpMethod::Post, "/echo");
+                requests.back().body.append(std::to_string(i));
+            }
+            std::vector<HttpClientResponse> responses;
+            ASSERT_EQ(client.pipeline("127.0.0.1", port, requests, responses), requests.size());
+            for (size_t i = 0; i < responses.size(); ++i) {
+                EXPECT_EQ(responses[i].body().toString(), std::to_string(i));
+            }
+            EXPECT_EQ(server.getTcpServer().getStats().accepted, 1);
+
+            // 不可以keep-alive的连接不会归还到连接池.
+            ASSERT_EQ(client.get("127.0.0.1", port, "/close", response), 0);
+            EXPECT_EQ(response.body().toString(), "bye");
+            EXPECT_FALSE(response.keepAlive());
+            EXPECT_EQ(client.getPool().idleCount(), 0);
+
+            // 服务端关闭连接之后的请求不会被处理.
+            requests.clear();
+            requests.emplace_back(HttpMethod::Get, "/close");
+            requests.emplace_back(HttpMethod::Get, "/hello");
+            EXPECT_EQ(client.pipeline("127.0.0.1", port, requests, responses), 1);
+            EXPECT_EQ(errno, ECONNRESET);
+
+            options.timeout_ms = 50;
+            HttpClient impatient(options);
+            EXPECT_EQ(impatient.get("127.0.0.1", port, "/slow", response), -1);
+            EXPECT_EQ(errno, ETIMEDOUT);
+
+            EXPECT_EQ(client.get("127.0.0.1", 1, "/", response), -1);
+        };
+        io_manager->addExecutor(std::make_shared<coroutine::Executor>([&]() {
+            run_client();
+            server.stopServe();
+            io::IOManager::getThreadLocal()->stop();
+            finished.set_value();
+        }));
+        io_manager->run();
+    });
+    EXPECT_EQ(finished.get_future().wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    thread.join();
+}
+
+int main(int argc, char* argv[]) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,102 @@
+#include "base/timer.h"
+#include "io/io_manager.h"
+
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace lon;
+
+namespace {
+/**
+ * @brief 在一个开启hook的IOManager线程中运行func.
+ */
+void runInIOManager(const std::function<void()>& func) {
+    std::thread thread([&]() {
+        auto io_manager = io::IOManager::getThreadLocal();
+        io_manager->addExecutor(std::make_shared<coroutine::Executor>([&]() {
+            func();
+            io::IOManager::getThreadLocal()->stop();
+        }));
+        io_manager->run();
+    });
+    thread.join();
+}
+
+Timer::Ptr makeTimer(Timer::MsStampType target_timestamp) {
+    auto timer      = std::make_shared<Timer>(target_timestamp);
+    timer->callback = []() {};
+    return timer;
+}
+}  // namespace
+
+TEST(TimerManagerTest, RemoveTimerWithSameDeadline) {
+    TimerManager manager;
+    const Timer::MsStampType deadline = currentMs() + 1000;
+    auto first  = makeTimer(deadline);
+    auto second = makeTimer(deadline);
+    auto third  = makeTimer(deadline);
+    manager.addTimer(first);
+    manager.addTimer(second);
+    manager.addTimer(third);
+
+    // 删除的是指针相同的定时器, 而不是相同时间戳的第一个.
+    manager.removeTimer(second);
+    Timer::Ptr timer;
+    ASSERT_TRUE(manager.takeFirstIfExpired(timer, deadline));
+    EXPECT_EQ(timer, first);
+
+    // 已经取出的定时器不在集合中, 删除不影响其它定时器.
+    manager.removeTimer(first);
+    manager.removeTimer(second);
+    ASSERT_TRUE(manager.takeFirstIfExpired(timer, deadline));
+    EXPECT_EQ(timer, third);
+    EXPECT_FALSE(manager.takeFirstIfExpired(timer, deadline));
+}
+
+TEST(IOManagerTest, RemoveOneEvent) {
+    int fds[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    runInIOManager([&]() {
+        auto io_manager  = io::IOManager::getThreadLocal();
+        bool read_fired  = false;
+        bool write_fired = false;
+        using EventType  = io::IOManager::EventType;
+        io_manager->registerEvent(
+            fds[0], EventType::Read, std::make_shared<coroutine::Executor>([&]() { read_fired = true; }));
+        io_manager->registerEvent(
+            fds[0], EventType::Write, std::make_shared<coroutine::Executor>([&]() { write_fired = true; }));
+
+        // 只删除写事件, 读事件保持注册.
+        io_manager->removeEvent(fds[0], EventType::Write);
+        EXPECT_TRUE(io_manager->hasEvent(fds[0], EventType::Read));
+        EXPECT_FALSE(io_manager->hasEvent(fds[0], EventType::Write));
+
+        ASSERT_EQ(::send(fds[1], "x", 1, MSG_DONTWAIT), 1);
+        ::usleep(10 * 1000);
+        EXPECT_TRUE(read_fired);
+        EXPECT_FALSE(write_fired);
+
+        // 只注册了读事件时对端关闭(EPOLLHUP), 只唤醒读事件的协程.
+        read_fired = false;
+        io_manager->registerEvent(
+            fds[0], EventType::Read, std::make_shared<coroutine::Executor>([&]() { read_fired = true; }));
+        ::close(fds[1]);
+        ::usleep(10 * 1000);
+        EXPECT_TRUE(read_fired);
+        EXPECT_FALSE(write_fired);
+        EXPECT_FALSE(io_manager->hasEvent(fds[0], EventType::Read));
+
+        io_manager->registerEvent(
+            fds[0], EventType::Read, std::make_shared<coroutine::Executor>([]() {}));
+        io_manager->removeEvent(fds[0], EventType::Read);
+        EXPECT_FALSE(io_manager->hasEvent(fds[0], EventType::Read));
+    });
+    ::close(fds[0]);
+}
+
+int main(int argc, char* argv[]) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
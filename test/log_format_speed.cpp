@@ -0,0 +1,127 @@
+#include "base/chrono_helper.h"
+#include "base/print_helper.h"
+#include "logging/LogSStream.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fmt/core.h>
+
+using namespace lon;
+
+// LogSStream中数字格式化的微基准, 与修改前的实现(逐位除法+reverse, sprintf("%f"))以及snprintf对比.
+
+constexpr int loop_time = 10000000;
+
+static size_t G_sink = 0;
+
+/**
+ * @brief 修改前LogSStream中的整数格式化.
+ */
+template<typename T>
+size_t oldConvert(char buf[], T value) {
+    static const char digits[] = "9876543210123456789";
+    static const char* zero    = digits + 9;
+    T i                        = value;
+    char* p                    = buf;
+    do {
+        int lsd = static_cast<int>(i % 10);
+        i /= 10;
+        *p++ = zero[lsd];
+    } while (i != 0);
+    if (value < 0) {
+        *p++ = '-';
+    }
+    *p = '\0';
+    std::reverse(buf, p);
+    return static_cast<size_t>(p - buf);
+}
+
+template<class Func>
+void run(const char* name, Func&& func) {
+    size_t time_span;
+    {
+        lon::measure::GetTimeSpan gettimespan(&time_span);
+        for (int i = 0; i < loop_time; ++i) {
+            G_sink += func(i);
+        }
+    }
+    fmt::print("{:<28} {} times in {} ms, {:.1f} ns/op\n",
+               name,
+               loop_time,
+               time_span,
+               static_cast<double>(time_span) * 1000000 / loop_time);
+}
+
+int64_t intValue(int i) {
+    // 1~13位, 正负交替.
+    return (i & 1 ? -1 : 1) * static_cast<int64_t>(i) * 7919;
+}
+
+double doubleValue(int i) {
+    return i * 0.37;
+}
+
+int main() {
+    printDividing("baseline");
+    run("LogSStream frame + char", [](int i) {
+        log::LogSStream stream;
+        stream << 'x';
+        return stream.size();
+    });
+
+    printDividing("int64");
+    run("old(divide + reverse)", [](int i) {
+        char buf[32];
+        return oldConvert(buf, intValue(i));
+    });
+    run("snprintf(%ld)", [](int i) {
+        char buf[32];
+        return static_cast<size_t>(snprintf(buf, sizeof(buf), "%ld", intValue(i)));
+    });
+    run("LogSStream", [](int i) {
+        log::LogSStream stream;
+        stream << intValue(i);
+        return stream.size();
+    });
+
+    printDividing("double");
+    run("old sprintf(%f)", [](int i) {
+        char buf[512];
+        return static_cast<size_t>(sprintf(buf, "%f", doubleValue(i)));
+    });
+    run("snprintf(%g)", [](int i) {
+        char buf[32];
+        return static_cast<size_t>(snprintf(buf, sizeof(buf), "%g", doubleValue(i)));
+    });
+    run("LogSStream(to_chars)", [](int i) {
+        log::LogSStream stream;
+        stream << doubleValue(i);
+        return stream.size();
+    });
+
+    printDividing("hex/pointer");
+    run("snprintf(%lX)", [](int i) {
+        char buf[32];
+        return static_cast<size_t>(snprintf(buf, sizeof(buf), "%lX", static_cast<uint64_t>(intValue(i))));
+    });
+    run("LogSStream Hex", [](int i) {
+        log::LogSStream stream;
+        stream << log::Hex(static_cast<uint64_t>(intValue(i)));
+        return stream.size();
+    });
+    run("LogSStream pointer", [](int i) {
+        log::LogSStream stream;
+        stream << &G_sink + i;
+        return stream.size();
+    });
+
+    printDividing("mixed message");
+    run("LogSStream", [](int i) {
+        log::LogSStream stream;
+        stream << "request " << intValue(i) << " cost " << doubleValue(i) << " ms";
+        return stream.size();
+    });
+
+    fmt::print("sink: {}\n", G_sink);
+    return 0;
+}
@@ -1,6 +1,8 @@
 #include "base/chrono_helper.h"
 #include "base/print_helper.h"
 #include "logger.h"
+#include "logging/binary_log.h"
+#include "logging/log_pattern.h"
 #include "logging/logger_flusher.h"
 
 
@@ -8,6 +10,7 @@
 #include <fmt/format.h>
 #include <regex>
 #include <string>
+#include <thread>
 
 using namespace lon;
 
@@ -185,6 +188,263 @@ void runWithoutFormatFlusher() {
     std::this_thread::sleep_for(std::chrono::seconds(2));
 }
 
+/**
+ * @brief 只有日期和消息体, 没有flusher, 主要测量格式化日期的开销.
+ */
+void runDateWithoutFlusher(const char* name, const char* pattern) {
+    auto logger = std::make_shared<Logger>(log_name);
+    logger->setFormatters(pattern);
+
+    size_t time_span;
+    {
+        lon::measure::GetTimeSpan gettimespan(&time_span);
+        for (int i = 0; i < loop_time; ++i) {
+            LON_LOG_INFO(logger) << write_str;
+        }
+    }
+
+    fmt::print("\n");
+    printDividing(name);
+    fmt::print("pattern: {}\n", pattern);
+    fmt::print("write {} times in {} ms, {} time/s\n",
+               loop_time,
+               time_span,
+               loop_time / static_cast<double>(time_span) * 1000);
+}
+
+struct DefaultPattern
+{
+    static constexpr StringPiece value = "%d{%Y-%m-%d %H:%M:%S}%T%t%T%E%T[%p]%T[%c]%T<%f:%l>%T%m%n";
+};
+
+/**
+ * @brief 默认logger的pattern, 没有flusher, 比较运行时解析的formatters与编译期展开的格式化函数.
+ */
+void runCompiledPattern() {
+    fmt::print("\n");
+    printDividing("runtime/compiled pattern without flusher speed");
+    fmt::print("pattern: {}\n", DefaultPattern::value);
+    for (bool compiled : {false, true}) {
+        auto logger = std::make_shared<Logger>(log_name);
+        if (compiled)
+            log::setFormatters<DefaultPattern>(*logger);
+        else
+            logger->setFormatters(String(DefaultPattern::value));
+
+        size_t time_span;
+        {
+            lon::measure::GetTimeSpan gettimespan(&time_span);
+            for (int i = 0; i < loop_time; ++i) {
+                LON_LOG_INFO(logger) << write_str;
+            }
+        }
+        fmt::print("{:<9} write {} times in {} ms, {} time/s\n",
+                   compiled ? "compiled" : "runtime",
+                   loop_time,
+                   time_span,
+                   loop_time / static_cast<double>(time_span) * 1000);
+    }
+}
+
+/**
+ * @brief 同样的消息(一个整数, 一个浮点数, 一个字符串)分别以文本(log_format)和二进制日志输出,
+ * 统计调用线程上每条日志的平均耗时, 文件写入在RingFileFlusher的后台线程中.
+ */
+void runBinary() {
+    fmt::print("\n");
+    printDividing("text/binary log latency");
+    auto report = [](const char* name, size_t time_span) {
+        fmt::print("{:<26} {} times in {} ms, {:.1f} ns/call\n",
+                   name,
+                   loop_time,
+                   time_span,
+                   static_cast<double>(time_span) * 1000000 / loop_time);
+    };
+    for (bool with_flusher : {false, true}) {
+        auto text_logger = std::make_shared<Logger>(log_name);
+        text_logger->setFormatters(log_format);
+        auto binary_logger = std::make_shared<Logger>(log_name);
+        if (with_flusher) {
+            text_logger->addOneFlusher(std::make_unique<log::RingFileFlusher>("/tmp/text.log"));
+            binary_logger->addOneFlusher(std::make_unique<log::RingFileFlusher>("/tmp/binary.log"));
+        }
+
+        size_t time_span;
+        {
+            lon::measure::GetTimeSpan gettimespan(&time_span);
+            for (int i = 0; i < loop_time; ++i) {
+                LON_LOG_INFO(text_logger) << "request " << i << " cost " << i * 0.25 << " ms from "
+                                          << "127.0.0.1";
+            }
+        }
+        report(with_flusher ? "text, ring flusher" : "text, no flusher", time_span);
+        {
+            lon::measure::GetTimeSpan gettimespan(&time_span);
+            for (int i = 0; i < loop_time; ++i) {
+                LON_BLOG_INFO(binary_logger, "request {} cost {} ms from {}", i, i * 0.25, "127.0.0.1");
+            }
+        }
+        report(with_flusher ? "binary, ring flusher" : "binary, no flusher", time_span);
+    }
+}
+
+/**
+ * @brief 被限流抑制的日志的开销, 与低于logger级别的日志对比.
+ */
+void runSuppressed() {
+    fmt::print("\n");
+    printDividing("suppressed log cost");
+    auto report = [](const char* name, size_t time_span) {
+        fmt::print("{:<26} {} times in {} ms, {:.1f} ns/call\n",
+                   name,
+                   loop_time,
+                   time_span,
+                   static_cast<double>(time_span) * 1000000 / loop_time);
+    };
+    auto logger = std::make_shared<Logger>(log_name);
+    logger->setFormatters(log_format);
+    size_t time_span;
+    logger->setLevel(Level::WARN);
+    {
+        lon::measure::GetTimeSpan gettimespan(&time_span);
+        for (int i = 0; i < loop_time; ++i) {
+            LON_LOG_INFO(logger) << "request " << i;
+        }
+    }
+    report("below level", time_span);
+    logger->setLevel(Level::DEBUG);
+    {
+        lon::measure::GetTimeSpan gettimespan(&time_span);
+        for (int i = 0; i < loop_time; ++i) {
+            LON_LOG_FIRST_N(logger, Level::INFO, 0) << "request " << i;
+        }
+    }
+    report("LON_LOG_FIRST_N", time_span);
+    {
+        lon::measure::GetTimeSpan gettimespan(&time_span);
+        for (int i = 0; i < loop_time; ++i) {
+            LON_LOG_EVERY_N(logger, Level::INFO, loop_time * 2) << "request " << i;
+        }
+    }
+    report("LON_LOG_EVERY_N", time_span);
+    {
+        lon::measure::GetTimeSpan gettimespan(&time_span);
+        for (int i = 0; i < loop_time; ++i) {
+            LON_LOG_EVERY_MS(logger, Level::INFO, 1000000) << "request " << i;
+        }
+    }
+    report("LON_LOG_EVERY_MS", time_span);
+    logger->setRateLimit(1, 1);
+    {
+        lon::measure::GetTimeSpan gettimespan(&time_span);
+        for (int i = 0; i < loop_time; ++i) {
+            LON_LOG_INFO(logger) << "request " << i;
+        }
+    }
+    report("logger token bucket", time_span);
+}
+
+/**
+ * @brief 低于级别(被禁用)的日志的开销.
+ */
+void runDisabled() {
+    fmt::print("\n");
+    printDividing("disabled log cost");
+    // 单次只有几个周期, 循环更多次以免被ms精度的计时淹没.
+    static constexpr int disabled_loop_time = loop_time * 100;
+    auto report = [](const char* name, size_t time_span) {
+        fmt::print("{:<26} {} times in {} ms, {:.2f} ns/call\n",
+                   name,
+                   disabled_loop_time,
+                   time_span,
+                   static_cast<double>(time_span) * 1000000 / disabled_loop_time);
+    };
+    auto manager = LogManager::getInstance();
+    auto system  = manager->getLogger("system");
+    const Level saved         = system->getLevel();
+    const Level saved_default = manager->getDefault()->getLevel();
+    static log::LoggerSlot slot{"system"};
+    system->setLevel(Level::ERROR);
+    manager->getDefault()->setLevel(Level::ERROR);
+
+    size_t time_span;
+    {
+        lon::measure::GetTimeSpan gettimespan(&time_span);
+        for (int i = 0; i < disabled_loop_time; ++i) {
+            LON_LOG_INFO(system) << "request " << i;
+        }
+    }
+    report("Logger::ptr", time_span);
+    {
+        lon::measure::GetTimeSpan gettimespan(&time_span);
+        for (int i = 0; i < disabled_loop_time; ++i) {
+            LON_LOG_INFO(slot) << "request " << i;
+        }
+    }
+    report("LoggerSlot", time_span);
+    {
+        lon::measure::GetTimeSpan gettimespan(&time_span);
+        for (int i = 0; i < disabled_loop_time; ++i) {
+            LON_LOG_DEFAULT_INFO() << "request " << i;
+        }
+    }
+    report("LON_LOG_DEFAULT_INFO", time_span);
+    system->setLevel(saved);
+    manager->getDefault()->setLevel(saved_default);
+}
+
+/**
+ * @brief 多个生产者线程写同一个logger, 每个线程写lines_per_thread行,
+ * 统计生产者全部结束的时间, 以及包括析构flusher(写出剩余日志)在内的时间.
+ */
+template<class MakeFlusher>
+void runMultiThread(const char* name, MakeFlusher make_flusher) {
+    constexpr int lines_per_thread = 200000;
+    for (int producers : {1, 2, 4, 8}) {
+        auto logger = std::make_shared<Logger>(log_name);
+        logger->addOneFlusher(make_flusher());
+        logger->setFormatters(log_format);
+        const auto begin = lon::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (int i = 0; i < producers; ++i) {
+            threads.emplace_back([&logger]() {
+                for (int j = 0; j < lines_per_thread; ++j) {
+                    LON_LOG_INFO(logger) << write_str;
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        const auto produced = lon::steady_clock::now();
+        logger.reset();
+        const auto drained = lon::steady_clock::now();
+
+        const double lines      = static_cast<double>(lines_per_thread) * producers;
+        const double produce_ms = std::max<double>(static_cast<double>(lon::getTimeSpanMs(begin, produced)), 1);
+        const double drain_ms   = std::max<double>(static_cast<double>(lon::getTimeSpanMs(begin, drained)), 1);
+        fmt::print("{:<18} {} producers: {:>9.0f} lines/s, producers done in {} ms, drained in {} ms\n",
+                   name,
+                   producers,
+                   lines / produce_ms * 1000,
+                   produce_ms,
+                   drain_ms);
+    }
+}
+
+void runMultiThreadCases() {
+    fmt::print("\n");
+    printDividing("multi thread log speed");
+    runMultiThread("protected log", []() {
+        return std::make_unique<log::ProtectedFileFlusher>("/tmp/protected_mt.log");
+    });
+    runMultiThread("ring log", []() {
+        return std::make_unique<log::RingFileFlusher>("/tmp/ring_mt.log");
+    });
+    runMultiThread("double buffer log", []() {
+        return std::make_unique<log::DoubleBufferFileFlusher>("/tmp/double_buffer_mt.log");
+    });
+}
 
 int main() {
     calculateLength();
@@ -193,5 +453,12 @@ int main() {
     runStr();
     runSimpleWithoutFormat();
     runWithoutFormatFlusher();
+    runDateWithoutFlusher("date log without flusher speed", "%d{%Y-%m-%d %H:%M:%S} %m");
+    runDateWithoutFlusher("date(ms) log without flusher speed", "%d{%Y-%m-%d %H:%M:%S.%3N} %m");
+    runCompiledPattern();
+    runBinary();
+    runSuppressed();
+    runDisabled();
+    runMultiThreadCases();
     return 0;
 }
\ No newline at end of file
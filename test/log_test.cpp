@@ -1,10 +1,21 @@
+#include "cmake_defination.h"
 #include "logger.h"
+#include "logging/binary_log.h"
+#include "logging/log_pattern.h"
 #include "logging/logger_flusher.h"
 
 
+#include <dirent.h>
+#include <fstream>
+#include <limits>
 #include <regex>
 #include <string>
+#include <thread>
 #include <gtest/gtest.h>
+#include <fmt/core.h>
+#if LON_LOG_COMPRESSION
+#include <zlib.h>
+#endif
 
 using namespace lon;
 const char* logger_name = "Test";
@@ -138,6 +149,918 @@ TEST(LogTest, LogFormat) {
                  ss.str().c_str());
 }
 
+namespace {
+struct UserType
+{
+    int value;
+};
+
+std::ostream& operator<<(std::ostream& os, const UserType& user) {
+    return os << "user(" << user.value << ")";
+}
+}  // namespace
+
+TEST(LogTest, LogMessagePosition) {
+    DECLEAR_LOGGER
+    // 消息体在中间, 并且出现两次.
+    logger->setFormatters("[%p] %m|%m%n");
+    LON_LOG_INFO(logger) << "a" << 1 << ' ' << UserType{2};
+    EXPECT_EQ(string_flusher->log, "[INFO] a1 user(2)|a1 user(2)\r\n");
+    string_flusher->log.clear();
+
+    // 没有%m时丢弃消息体.
+    logger->setFormatters("[%p]%n");
+    LON_LOG_WARN(logger) << "dropped";
+    EXPECT_EQ(string_flusher->log, "[WARN]\r\n");
+    string_flusher->log.clear();
+
+    // 没有设置formatter时日志为空.
+    auto empty_logger  = std::make_shared<Logger>("empty");
+    auto empty_flusher = new log::StringFlusher;
+    empty_logger->addOneFlusher(std::unique_ptr<log::Flusher>(empty_flusher));
+    LON_LOG_INFO(empty_logger) << "nothing";
+    EXPECT_TRUE(empty_flusher->log.empty());
+}
+
+TEST(LogTest, LogSStreamFormat) {
+    auto format = [](auto value) {
+        log::LogSStream stream;
+        stream << value;
+        return stream.str();
+    };
+    for (int64_t value : {int64_t{0}, int64_t{-1}, int64_t{9}, int64_t{10}, int64_t{99}, int64_t{100},
+                          int64_t{-12345}, int64_t{10000}, std::numeric_limits<int64_t>::min(),
+                          std::numeric_limits<int64_t>::max()}) {
+        EXPECT_EQ(format(value), std::to_string(value));
+    }
+    EXPECT_EQ(format(std::numeric_limits<uint64_t>::max()), "18446744073709551615");
+    EXPECT_EQ(format(int8_t{-128}), "-128");
+    EXPECT_EQ(format(true), "1");
+    // 最短的可以精确还原的表示.
+    EXPECT_EQ(format(1.5), "1.5");
+    EXPECT_EQ(format(0.1), "0.1");
+    EXPECT_EQ(format(0.1f), "0.1");
+    EXPECT_EQ(format(-3.0), "-3");
+    EXPECT_EQ(format(1e300), "1e+300");
+    EXPECT_EQ(format(log::Hex(255)), "FF");
+    EXPECT_EQ(format(log::Hex(0)), "0");
+    int value = 0;
+    EXPECT_EQ(format(&value), fmt::format("0x{:X}", reinterpret_cast<uintptr_t>(&value)));
+    char text[] = "text";
+    EXPECT_EQ(format(static_cast<char*>(text)), "text");
+}
+
+TEST(LogTest, LogSStreamOverflow) {
+    DECLEAR_LOGGER
+    // 超过默认的缓冲时扩展, 扩展之前的content仍然有效.
+    logger->setFormatters("%m|%m%n");
+    const String large(log::LogBufferMaxLen * 3, 'x');
+    LON_LOG_INFO(logger) << large << 1;
+    EXPECT_EQ(string_flusher->log, large + "1|" + large + "1\r\n");
+    string_flusher->log.clear();
+
+    // 超过上限时截断, 保留截断标记以及%m之后的部分.
+    logger->setFormatters("[%p]%m%n");
+    const String huge(log::LogBufferLimit, 'y');
+    LON_LOG_INFO(logger) << huge << 1;
+    const String& log = string_flusher->log;
+    EXPECT_LE(log.size(), static_cast<size_t>(log::LogBufferLimit));
+    EXPECT_EQ(log.substr(0, 7), "[INFO]y");
+    EXPECT_EQ(log.substr(log.size() - 16), String(log::LogTruncatedMarker) + "\r\n");
+    string_flusher->log.clear();
+
+    // 之后的日志恢复正常.
+    LON_LOG_INFO(logger) << "after";
+    EXPECT_EQ(string_flusher->log, "[INFO]after\r\n");
+}
+
+TEST(LogTest, LogNested) {
+    DECLEAR_LOGGER
+    logger->setFormatters("<%m>%n");
+    // 格式化参数时又输出了日志, 两条日志在同一个线程局部缓冲上嵌套.
+    auto inner = [&logger]() {
+        LON_LOG_INFO(logger) << "inner";
+        return 2;
+    };
+    LON_LOG_INFO(logger) << "outer " << 1 << ' ' << inner() << " end";
+    EXPECT_EQ(string_flusher->log, "<inner>\r\n<outer 1 2 end>\r\n");
+    string_flusher->log.clear();
+
+    // 外层已经截断时嵌套的日志仍然完整, 结束以后外层的写入继续被丢弃.
+    const String huge(log::LogBufferLimit, 'y');
+    LON_LOG_INFO(logger) << huge << inner() << " end";
+    const String& log = string_flusher->log;
+    ASSERT_GT(log.size(), 9u);
+    EXPECT_EQ(log.substr(0, 11), "<inner>\r\n<y");
+    EXPECT_EQ(log.substr(log.size() - 17), String(log::LogTruncatedMarker) + ">\r\n");
+}
+
+TEST(LogTest, LogDateTime) {
+    DECLEAR_LOGGER
+    logger->setFormatters("%d{%H:%M:%S.%3N}|%d{%S.%6N %Y}%n");
+    auto expected = [](time_t second, const char* format, const char* fraction) {
+        struct tm tm;
+        localtime_r(&second, &tm);
+        char buf[64];
+        strftime(buf, sizeof(buf), format, &tm);
+        return fmt::format(buf, fraction);
+    };
+    const time_t now = time(nullptr);
+    // 同一秒内的两条日志使用缓存, 下一秒重新格式化.
+    for (auto [second, nanosecond] : {std::pair<time_t, long>{now, 5000000},
+                                      {now, 123456789},
+                                      {now + 1, 999999}}) {
+        const timespec time{second, nanosecond};
+        {
+            LogWrapper w(logger, LogEvent("test.cc", 1, Level::INFO, 0, 0, 0, time));
+        }
+        const String millisecond = fmt::format("{:03}", nanosecond / 1000000);
+        const String microsecond = fmt::format("{:06}", nanosecond / 1000);
+        EXPECT_EQ(string_flusher->log,
+                  expected(second, "%H:%M:%S.{0}|", millisecond.c_str()) +
+                      expected(second, "%S.{0} %Y\r\n", microsecond.c_str()));
+        string_flusher->log.clear();
+    }
+
+    // 使用coarse时钟, 与CLOCK_REALTIME相差不超过一个tick.
+    const timespec coarse = log::coarseNow();
+    timespec real{};
+    clock_gettime(CLOCK_REALTIME, &real);
+    const int64_t diff_ns = (real.tv_sec - coarse.tv_sec) * 1000000000 + (real.tv_nsec - coarse.tv_nsec);
+    EXPECT_GE(diff_ns, -1000000);
+    EXPECT_LT(diff_ns, 100000000);
+}
+
+TEST(LogTest, LogDateTimeSharedCache) {
+    // 三个logger交替输出, 其中两个pattern相同(共享缓存项), 每条日志都应该使用自己的pattern.
+    std::vector<std::pair<Logger::ptr, log::StringFlusher*>> loggers;
+    for (const char* pattern : {"%d{%H:%M:%S}%n", "%d{%Y-%m-%d %H:%M}%n", "%d{%H:%M:%S}%n"}) {
+        auto logger         = std::make_shared<Logger>(logger_name);
+        auto string_flusher = new log::StringFlusher;
+        logger->addOneFlusher(std::unique_ptr<log::Flusher>(string_flusher));
+        logger->setFormatters(pattern);
+        loggers.emplace_back(logger, string_flusher);
+    }
+    auto expected = [](time_t second, const char* format) {
+        struct tm tm;
+        localtime_r(&second, &tm);
+        char buf[64];
+        strftime(buf, sizeof(buf), format, &tm);
+        return String(buf) + "\r\n";
+    };
+    const time_t now = time(nullptr);
+    for (time_t second : {now, now, now + 60, now + 60}) {
+        for (size_t i = 0; i < loggers.size(); ++i) {
+            auto& [logger, string_flusher] = loggers[i];
+            {
+                LogWrapper w(logger, LogEvent("test.cc", 1, Level::INFO, 0, 0, 0, timespec{second, 0}));
+            }
+            EXPECT_EQ(string_flusher->log, expected(second, i == 1 ? "%Y-%m-%d %H:%M" : "%H:%M:%S"));
+            string_flusher->log.clear();
+        }
+    }
+}
+
+namespace {
+struct DefaultPattern
+{
+    static constexpr StringPiece value = "%d{%Y-%m-%d %H:%M:%S}%T%t%T%E%T[%p]%T[%c]%T<%f:%l>%T%m%n";
+};
+
+struct TwoMessagePattern
+{
+    static constexpr StringPiece value = "%d{%S.%6N}[%pxyz] %m|%m (%r)%n";
+};
+
+struct NoMessagePattern
+{
+    static constexpr StringPiece value = "%d{}[%p]%n";
+};
+
+struct EscapePattern
+{
+    static constexpr StringPiece value = "100%% %m%%";
+};
+
+/**
+ * @brief 使用同一个event分别以运行时和编译期的pattern输出一条日志.
+ */
+template<class Pattern>
+void expectSameAsRuntime() {
+    DECLEAR_LOGGER
+    const LogEvent event("test.cc", 42, Level::WARN, 7, 3, 5, timespec{1700000000, 123456789});
+    logger->setFormatters(String(Pattern::value));
+    {
+        LogWrapper w(logger, event);
+        w.stream << "msg " << 1;
+    }
+    const String runtime = string_flusher->log;
+    string_flusher->log.clear();
+
+    log::setFormatters<Pattern>(*logger);
+    {
+        LogWrapper w(logger, event);
+        w.stream << "msg " << 1;
+    }
+    EXPECT_EQ(string_flusher->log, runtime) << Pattern::value;
+}
+}  // namespace
+
+TEST(LogTest, LogCompiledPattern) {
+    static_assert(log::pattern::CompiledPattern<DefaultPattern>::has_message);
+    static_assert(!log::pattern::CompiledPattern<NoMessagePattern>::has_message);
+    expectSameAsRuntime<DefaultPattern>();
+    expectSameAsRuntime<TwoMessagePattern>();
+    expectSameAsRuntime<NoMessagePattern>();
+    expectSameAsRuntime<EscapePattern>();
+
+    DECLEAR_LOGGER
+    log::setFormatters<EscapePattern>(*logger);
+    LON_LOG_INFO(logger) << "a";
+    EXPECT_EQ(string_flusher->log, "100% a%");
+    string_flusher->log.clear();
+
+    // 重新设置运行时的pattern以后不再使用编译期的格式化.
+    logger->setFormatters("[%p]%m");
+    LON_LOG_INFO(logger) << "b";
+    EXPECT_EQ(string_flusher->log, "[INFO]b");
+}
+
+TEST(LogTest, BinaryLog) {
+    DECLEAR_LOGGER
+    const String name = "name";
+    auto write        = [&](int i) {
+        LON_BLOG_WARN(logger, "{} {} {:.2f} {} {} {}|{}", i, 42u, 1.5, true, 'c', name, StringPiece("piece"));
+    };
+    write(1);
+    const String first = string_flusher->log;
+    string_flusher->log.clear();
+    write(2);
+    const String second = string_flusher->log;
+    LON_BLOG_INFO(logger, "no args");
+    const String third = string_flusher->log.substr(second.size());
+    // 同一个logger只写出一次Site记录.
+    EXPECT_LT(second.size(), first.size());
+
+    auto output         = std::make_shared<Logger>("output");
+    auto output_flusher = new log::StringFlusher;
+    output->addOneFlusher(std::unique_ptr<log::Flusher>(output_flusher));
+    output->setFormatters("[%p]%T<%l>%T%t%T%m%n");
+    log::BinaryLogDecoder decoder(output);
+    // 第二条记录在定义site的记录之前, 模拟不同线程的环先被写出.
+    EXPECT_EQ(decoder.decode(second + first + third), 3u);
+    EXPECT_EQ(decoder.getErrors(), 0u);
+    const std::regex expected(
+        "\\[WARN\\]\t<\\d+>\t\\d+\t2 42 1.50 true c name\\|piece\r\n"
+        "\\[WARN\\]\t<\\d+>\t\\d+\t1 42 1.50 true c name\\|piece\r\n"
+        "\\[INFO\\]\t<\\d+>\t\\d+\tno args\r\n");
+    EXPECT_TRUE(std::regex_match(output_flusher->log, expected)) << output_flusher->log;
+
+    // 末尾不完整的记录.
+    output_flusher->log.clear();
+    EXPECT_EQ(decoder.decode(first.substr(0, first.size() - 1)), 0u);
+    EXPECT_EQ(decoder.getErrors(), 1u);
+
+    // 超过栈上缓冲的记录.
+    string_flusher->log.clear();
+    const String large(1000, 'x');
+    LON_BLOG_ERROR(logger, "{}", large);
+    output_flusher->log.clear();
+    EXPECT_EQ(decoder.decode(string_flusher->log), 1u);
+    EXPECT_NE(output_flusher->log.find(large), String::npos);
+}
+
+namespace {
+String binarySite(uint64_t id, StringPiece file, int line, Level level, StringPiece format) {
+    const size_t size = log::binary::kRecordHeaderSize + sizeof(uint64_t) + sizeof(int32_t) +
+                        sizeof(uint8_t) + sizeof(uint16_t) * 2 + file.size() + format.size();
+    String record(size, '\0');
+    char* buf = record.data();
+    log::binary::put(buf, static_cast<uint32_t>(size));
+    log::binary::put(buf, log::BinaryRecordType::Site);
+    log::binary::put(buf, id);
+    log::binary::put(buf, static_cast<int32_t>(line));
+    log::binary::put(buf, static_cast<uint8_t>(level));
+    log::binary::put(buf, static_cast<uint16_t>(file.size()));
+    std::memcpy(buf, file.data(), file.size());
+    buf += file.size();
+    log::binary::put(buf, static_cast<uint16_t>(format.size()));
+    std::memcpy(buf, format.data(), format.size());
+    return record;
+}
+
+String binaryEvent(uint64_t id, int64_t value) {
+    const size_t size = log::binary::kEventHeaderSize + log::binary::argSize(value);
+    String record(size, '\0');
+    char* buf = record.data();
+    log::binary::put(buf, static_cast<uint32_t>(size));
+    log::binary::put(buf, log::BinaryRecordType::Event);
+    log::binary::put(buf, id);
+    log::binary::put(buf, int64_t{0});
+    log::binary::put(buf, uint32_t{0});
+    log::binary::put(buf, uint32_t{1});
+    log::binary::put(buf, uint8_t{1});
+    log::binary::putArg(buf, value);
+    return record;
+}
+}  // namespace
+
+TEST(LogTest, BinaryLogMultipleRuns) {
+    // 同一个进程内的site共享epoch, 序号不同.
+    static const log::LogSite first{__FILE__, __LINE__, Level::INFO, "first"};
+    static const log::LogSite second{__FILE__, __LINE__, Level::INFO, "second"};
+    EXPECT_EQ(first.id >> 32, second.id >> 32);
+    EXPECT_NE(first.id, second.id);
+
+    // 两次运行追加到同一个文件, 进程内的序号相同, epoch不同; 第二次运行的event在site之前.
+    const uint64_t run1 = 0x1111111100000000ULL | 1;
+    const uint64_t run2 = 0x2222222200000000ULL | 1;
+    const String data   = binarySite(run1, "a.cpp", 1, Level::INFO, "run1 {}") + binaryEvent(run1, 1) +
+                        binaryEvent(run2, 2) + binarySite(run2, "b.cpp", 2, Level::WARN, "run2 {}");
+
+    auto output         = std::make_shared<Logger>("output");
+    auto output_flusher = new log::StringFlusher;
+    output->addOneFlusher(std::unique_ptr<log::Flusher>(output_flusher));
+    output->setFormatters("[%p]%f:%l %m%n");
+    log::BinaryLogDecoder decoder(output);
+    EXPECT_EQ(decoder.decode(data), 2u);
+    EXPECT_EQ(decoder.getErrors(), 0u);
+    EXPECT_EQ(output_flusher->log, "[INFO]a.cpp:1 run1 1\r\n[WARN]b.cpp:2 run2 2\r\n");
+
+    // 以不同内容重新定义已有的site计为错误, 保留第一次的定义.
+    output_flusher->log.clear();
+    EXPECT_EQ(decoder.decode(binarySite(run1, "c.cpp", 3, Level::ERROR, "other {}") + binaryEvent(run1, 3)),
+              1u);
+    EXPECT_EQ(decoder.getErrors(), 1u);
+    EXPECT_EQ(output_flusher->log, "[INFO]a.cpp:1 run1 3\r\n");
+}
+
+namespace {
+size_t countLines(const String& log) {
+    return static_cast<size_t>(std::count(log.begin(), log.end(), '\n'));
+}
+}  // namespace
+
+TEST(LogTest, LogSampled) {
+    DECLEAR_LOGGER
+    logger->setFormatters("%m%n");
+    for (int i = 0; i < 10; ++i) {
+        LON_LOG_EVERY_N(logger, Level::INFO, 4) << i;
+    }
+    EXPECT_EQ(string_flusher->log, "0\r\n[suppressed 3] 4\r\n[suppressed 3] 8\r\n");
+    string_flusher->log.clear();
+
+    // n为0时不抑制.
+    for (int i = 0; i < 3; ++i) {
+        LON_LOG_EVERY_N(logger, Level::INFO, 0) << i;
+    }
+    EXPECT_EQ(string_flusher->log, "0\r\n1\r\n2\r\n");
+    string_flusher->log.clear();
+
+    for (int i = 0; i < 10; ++i) {
+        LON_LOG_FIRST_N(logger, Level::INFO, 3) << i;
+    }
+    EXPECT_EQ(string_flusher->log, "0\r\n1\r\n2\r\n");
+    string_flusher->log.clear();
+
+    // 低于logger级别的日志不计数.
+    logger->setLevel(Level::WARN);
+    auto every_ms = [&](Level level, int i) { LON_LOG_EVERY_MS(logger, level, 20) << i; };
+    for (int i = 0; i < 100; ++i) {
+        every_ms(Level::INFO, i);
+    }
+    EXPECT_TRUE(string_flusher->log.empty());
+    for (int i = 0; i < 100; ++i) {
+        every_ms(Level::WARN, i);
+    }
+    EXPECT_EQ(string_flusher->log, "0\r\n");
+    string_flusher->log.clear();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    every_ms(Level::WARN, 100);
+    EXPECT_EQ(string_flusher->log, "[suppressed 99] 100\r\n");
+}
+
+TEST(LogTest, LogRateLimit) {
+    DECLEAR_LOGGER
+    logger->setFormatters("%m%n");
+    logger->setRateLimit(1, 5);
+    for (int i = 0; i < 100; ++i) {
+        LON_LOG_INFO(logger) << i;
+    }
+    // 每秒补充一条, 循环期间最多多出一条.
+    const size_t lines = countLines(string_flusher->log);
+    EXPECT_GE(lines, 5u);
+    EXPECT_LE(lines, 6u);
+    EXPECT_EQ(logger->getSuppressed(), 100 - lines);
+
+    // 关闭限流以后, 下一条日志报告被抑制的条数.
+    string_flusher->log.clear();
+    logger->setRateLimit(0, 0);
+    LON_LOG_INFO(logger) << "resumed";
+    EXPECT_EQ(string_flusher->log, fmt::format("[suppressed {}] resumed\r\n", 100 - lines));
+    string_flusher->log.clear();
+    LON_LOG_INFO(logger) << "next";
+    EXPECT_EQ(string_flusher->log, "next\r\n");
+
+    // 通过采样但被令牌桶抑制的日志只计算一次.
+    logger->setRateLimit(1, 1);
+    const uint64_t suppressed = logger->getSuppressed();
+    auto every_two            = [&](int i) { LON_LOG_EVERY_N(logger, Level::INFO, 2) << i; };
+    string_flusher->log.clear();
+    for (int i = 0; i < 6; ++i) {
+        every_two(i);
+    }
+    EXPECT_EQ(string_flusher->log, "0\r\n");
+    EXPECT_EQ(logger->getSuppressed(), suppressed + 2);
+    logger->setRateLimit(0, 0);
+    string_flusher->log.clear();
+    every_two(6);
+    EXPECT_EQ(string_flusher->log, "[suppressed 5] 6\r\n");
+
+    // 二进制日志同样受限.
+    logger->setRateLimit(1, 1);
+    string_flusher->log.clear();
+    LON_BLOG_INFO(logger, "first");
+    const size_t size = string_flusher->log.size();
+    LON_BLOG_INFO(logger, "dropped");
+    EXPECT_EQ(string_flusher->log.size(), size);
+    EXPECT_EQ(logger->getSuppressed(), suppressed + 3);
+}
+
+TEST(LogTest, LoggerSlotLevel) {
+    auto manager = LogManager::getInstance();
+    // 不存在的名字返回默认logger.
+    EXPECT_EQ(manager->getLogger("no_such_logger"), manager->getDefault());
+
+    auto system = manager->getLogger("system");
+    const Level saved = system->getLevel();
+    log::LoggerSlot net_slot{"system", "/repo/src/net/foo.cpp"};
+    log::LoggerSlot module_slot{"test_module"};
+    EXPECT_EQ(&*module_slot, manager->getDefault().get());
+    EXPECT_EQ(StringPiece(module_slot.getFile()).substr(StringPiece(module_slot.getFile()).rfind('/') + 1),
+              "log_test.cpp");
+
+    // 没有覆盖时跟随logger的级别.
+    system->setLevel(Level::ERROR);
+    EXPECT_EQ(net_slot.getLevel(), Level::ERROR);
+    EXPECT_FALSE(log::enabled(net_slot, Level::WARN));
+    EXPECT_TRUE(log::enabled(net_slot, Level::ERROR));
+
+    // 文件覆盖优先于模块覆盖, 只匹配完整的路径分量.
+    manager->setModuleLevel("system", Level::WARN);
+    EXPECT_EQ(net_slot.getLevel(), Level::WARN);
+    manager->setFileLevel("oo.cpp", Level::DEBUG);
+    EXPECT_EQ(net_slot.getLevel(), Level::WARN);
+    manager->setFileLevel("net/foo.cpp", Level::INFO);
+    EXPECT_EQ(net_slot.getLevel(), Level::INFO);
+    manager->setModuleLevel("test_module", Level::FATAL);
+    EXPECT_EQ(module_slot.getLevel(), Level::FATAL);
+    manager->clearLevelOverrides();
+    EXPECT_EQ(net_slot.getLevel(), Level::ERROR);
+    EXPECT_EQ(module_slot.getLevel(), manager->getDefault()->getLevel());
+
+    // 从配置文件重新加载.
+    const char* filename = "/tmp/log_test_levels.json";
+    {
+        std::ofstream out(filename);
+        out << R"({"logs": [{"name": "system", "level": "info"}],
+                  "log_levels": {"modules": {"test_module": "error"},
+                                 "files": {"src/net/foo.cpp": "debug", "bad.cpp": "nope"}}})";
+    }
+    EXPECT_TRUE(manager->reloadLevels(filename));
+    EXPECT_EQ(system->getLevel(), Level::INFO);
+    EXPECT_EQ(net_slot.getLevel(), Level::DEBUG);
+    EXPECT_EQ(module_slot.getLevel(), Level::ERROR);
+    EXPECT_FALSE(manager->reloadLevels("/tmp/log_test_no_such_file.json"));
+    EXPECT_EQ(net_slot.getLevel(), Level::DEBUG);
+
+    // 信号触发重新加载.
+    {
+        std::ofstream out(filename);
+        out << R"({"logs": [{"name": "system", "level": "warn"}]})";
+    }
+    manager->installReloadSignal(SIGUSR2, filename);
+    ::raise(SIGUSR2);
+    for (int i = 0; i < 100 && net_slot.getLevel() != Level::WARN; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(net_slot.getLevel(), Level::WARN);
+    EXPECT_EQ(module_slot.getLevel(), manager->getDefault()->getLevel());
+
+    ::signal(SIGUSR2, SIG_DFL);
+    ::unlink(filename);
+    system->setLevel(saved);
+}
+
+TEST(LogTest, LogRing) {
+    log::LogRing ring(64);
+    EXPECT_EQ(ring.capacity(), 64u);
+    String consumed;
+    auto consume = [&]() {
+        return ring.consume([&](const char* data, size_t length) { consumed.append(data, length); });
+    };
+    // 每次写入40字节, 从第二次开始跨越环的末尾.
+    for (int i = 0; i < 10; ++i) {
+        const String line = fmt::format("{:0>39}\n", i);
+        ASSERT_TRUE(ring.tryWrite(line));
+        EXPECT_FALSE(ring.tryWrite(line));
+        EXPECT_EQ(ring.size(), 40u);
+        EXPECT_EQ(consume(), 40u);
+        EXPECT_EQ(consumed, line);
+        consumed.clear();
+    }
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ(consume(), 0u);
+    EXPECT_FALSE(ring.tryWrite(String(65, 'x')));
+}
+
+namespace {
+std::vector<String> readLines(const String& filename) {
+    std::vector<String> lines;
+    std::ifstream file(filename);
+    for (String line; std::getline(file, line);) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+}  // namespace
+
+TEST(LogTest, RingFileFlusher) {
+    constexpr int producers = 4;
+    constexpr int lines     = 20000;
+    const String filename   = fmt::format("/tmp/lon_ring_flusher_{}.log", ::getpid());
+    ::unlink(filename.c_str());
+    {
+        // 环较小, 生产者需要等待后台线程.
+        log::RingFileFlusher flusher(filename.c_str(), 4096);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < producers; ++i) {
+            threads.emplace_back([&flusher, i]() {
+                for (int j = 0; j < lines; ++j) {
+                    flusher.flush(fmt::format("{} {}\n", i, j));
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        EXPECT_EQ(flusher.getDropped(), 0u);
+    }
+    // 同一个线程的日志保持顺序并且完整.
+    std::vector<int> next(producers, 0);
+    for (auto& line : readLines(filename)) {
+        int producer = -1;
+        int seq      = -1;
+        ASSERT_EQ(::sscanf(line.c_str(), "%d %d", &producer, &seq), 2) << line;
+        ASSERT_TRUE(producer >= 0 && producer < producers);
+        ASSERT_EQ(seq, next[static_cast<size_t>(producer)]++);
+    }
+    for (int count : next) {
+        EXPECT_EQ(count, lines);
+    }
+    ::unlink(filename.c_str());
+}
+
+TEST(LogTest, RingFileFlusherOverflow) {
+    constexpr size_t total = 10000;
+    const String line      = fmt::format("{:0>39}\n", 0);
+    for (auto policy : {log::RingOverflowPolicy::Drop, log::RingOverflowPolicy::Count}) {
+        const String filename = fmt::format("/tmp/lon_ring_flusher_overflow_{}.log", ::getpid());
+        ::unlink(filename.c_str());
+        size_t dropped = 0;
+        {
+            // 环中最多放下一行.
+            log::RingFileFlusher flusher(filename.c_str(), 64, policy);
+            for (size_t i = 0; i < total; ++i) {
+                flusher.flush(line);
+            }
+            flusher.flush(String(128, 'x'));
+            dropped = flusher.getDropped();
+        }
+        EXPECT_GE(dropped, 1u);
+        size_t written  = 0;
+        size_t reported = 0;
+        for (auto& item : readLines(filename)) {
+            size_t count = 0;
+            if (::sscanf(item.c_str(), "[ring flusher] %zu log lines dropped", &count) == 1) {
+                reported += count;
+            } else {
+                EXPECT_EQ(item + "\n", line);
+                ++written;
+            }
+        }
+        EXPECT_EQ(written + dropped, total + 1);
+        EXPECT_EQ(reported, policy == log::RingOverflowPolicy::Count ? dropped : 0u);
+        ::unlink(filename.c_str());
+    }
+}
+
+TEST(LogTest, DoubleBufferFileFlusher) {
+    constexpr int producers = 4;
+    constexpr int lines     = 20000;
+    const String filename   = fmt::format("/tmp/lon_double_buffer_{}.log", ::getpid());
+    ::unlink(filename.c_str());
+    {
+        // 缓冲较小, 频繁交换缓冲.
+        log::DoubleBufferFlusherOptions options;
+        options.buffer_size         = 4096;
+        options.max_pending_buffers = static_cast<size_t>(-1);
+        log::DoubleBufferFileFlusher flusher(filename.c_str(), options);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < producers; ++i) {
+            threads.emplace_back([&flusher, i]() {
+                for (int j = 0; j < lines; ++j) {
+                    flusher.flush(fmt::format("{} {}\n", i, j));
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        // 超过缓冲大小的日志.
+        flusher.flush(String(5000, 'x') + "\n");
+    }
+    std::vector<int> next(producers, 0);
+    size_t large = 0;
+    for (auto& line : readLines(filename)) {
+        if (line[0] == 'x') {
+            EXPECT_EQ(line.size(), 5000u);
+            ++large;
+            continue;
+        }
+        int producer = -1;
+        int seq      = -1;
+        ASSERT_EQ(::sscanf(line.c_str(), "%d %d", &producer, &seq), 2) << line;
+        ASSERT_TRUE(producer >= 0 && producer < producers);
+        ASSERT_EQ(seq, next[static_cast<size_t>(producer)]++);
+    }
+    EXPECT_EQ(large, 1u);
+    for (int count : next) {
+        EXPECT_EQ(count, lines);
+    }
+    ::unlink(filename.c_str());
+}
+
+TEST(LogTest, DoubleBufferMinPending) {
+    const String filename = fmt::format("/tmp/lon_double_buffer_min_{}.log", ::getpid());
+    ::unlink(filename.c_str());
+    {
+        // 积压上限小于2时按2处理, 丢弃时保留的缓冲都是有效的.
+        log::DoubleBufferFlusherOptions options;
+        options.buffer_size         = 256;
+        options.max_pending_buffers = 0;
+        log::DoubleBufferFileFlusher flusher(filename.c_str(), options);
+        for (int i = 0; i < 20000; ++i) {
+            flusher.flush(fmt::format("{}\n", i));
+        }
+    }
+    for (auto& line : readLines(filename)) {
+        int seq = -1;
+        size_t dropped = 0;
+        EXPECT_TRUE(::sscanf(line.c_str(), "%d", &seq) == 1 ||
+                    ::sscanf(line.c_str(), "[double buffer flusher] %zu log buffers dropped", &dropped) == 1)
+            << line;
+    }
+    ::unlink(filename.c_str());
+}
+
+TEST(LogTest, DoubleBufferTimedFlush) {
+    const String filename = fmt::format("/tmp/lon_double_buffer_timed_{}.log", ::getpid());
+    ::unlink(filename.c_str());
+    log::DoubleBufferFlusherOptions options;
+    options.flush_interval_ms = 20;
+    options.fdatasync         = true;
+    log::DoubleBufferFileFlusher flusher(filename.c_str(), options);
+    flusher.flush("timed flush\n");
+    // 缓冲没有写满, 按照时间写出.
+    std::vector<String> lines;
+    for (int i = 0; i < 100 && lines.empty(); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        lines = readLines(filename);
+    }
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_EQ(lines[0], "timed flush");
+    EXPECT_EQ(flusher.size(), 0u);
+    ::unlink(filename.c_str());
+}
+
+TEST(LogTest, AsyncFileLogFlusherPattern) {
+    const String filename = fmt::format("/tmp/lon_async_flusher_{}.log", ::getpid());
+    ::unlink(filename.c_str());
+    {
+        // 以pattern构造时同样启动后台线程.
+        log::AsyncFileLogFlusher flusher(String("/tmp/lon_async_flusher_%P.log"));
+        flusher.flush("async\n");
+    }
+    auto lines = readLines(filename);
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_EQ(lines[0], "async");
+    ::unlink(filename.c_str());
+}
+
+namespace {
+/**
+ * @brief 目录中以prefix开头的文件, 切换出的文件按照序号排序, 当前文件在最后.
+ */
+std::vector<String> rotatedFiles(const String& dirname, const String& prefix) {
+    std::vector<std::pair<long, String>> files;
+    if (DIR* dir = ::opendir(dirname.c_str())) {
+        while (dirent* entry = ::readdir(dir)) {
+            const String name = entry->d_name;
+            if (name == "." || name == ".." || name.compare(0, prefix.size(), prefix) != 0)
+                continue;
+            long index = std::numeric_limits<long>::max();
+            if (name.size() > prefix.size()) {
+                const auto last = name.rfind('.', name.size() - (name.back() == 'z' ? 4 : 1));
+                index           = std::stol(name.substr(last + 1));
+            }
+            files.emplace_back(index, dirname + "/" + name);
+        }
+        ::closedir(dir);
+    }
+    std::sort(files.begin(), files.end());
+    std::vector<String> result;
+    for (auto& file : files) {
+        result.push_back(file.second);
+    }
+    return result;
+}
+
+void removeDir(const String& dirname) {
+    for (auto& file : rotatedFiles(dirname, "app.log")) {
+        ::unlink(file.c_str());
+    }
+    ::rmdir(dirname.c_str());
+}
+
+size_t fileSize(const String& filename) {
+    struct stat file_stat {};
+    return ::stat(filename.c_str(), &file_stat) == 0 ? static_cast<size_t>(file_stat.st_size) : 0;
+}
+
+template<class MakeFlusher>
+void checkRotationUnderLogging(const String& dirname, size_t max_file_size, MakeFlusher make_flusher) {
+    constexpr int producers = 4;
+    constexpr int lines     = 5000;
+    removeDir(dirname);
+    {
+        auto flusher = make_flusher(dirname + "/app.log");
+        std::vector<std::thread> threads;
+        for (int i = 0; i < producers; ++i) {
+            threads.emplace_back([&flusher, i]() {
+                for (int j = 0; j < lines; ++j) {
+                    flusher->flush(fmt::format("{} {:0>32}\n", i, j));
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+    // 按照切换的顺序拼接所有文件, 每个线程的日志完整并且有序, 没有被拆开的行.
+    auto files = rotatedFiles(dirname, "app.log");
+    ASSERT_GT(files.size(), 2u);
+    EXPECT_EQ(files.back(), dirname + "/app.log");
+    std::vector<int> next(producers, 0);
+    for (auto& file : files) {
+        if (max_file_size > 0) {
+            EXPECT_LE(fileSize(file), max_file_size) << file;
+        }
+        for (auto& line : readLines(file)) {
+            int producer = -1;
+            int seq      = -1;
+            ASSERT_EQ(::sscanf(line.c_str(), "%d %d", &producer, &seq), 2) << line;
+            ASSERT_EQ(line.size(), 34u);
+            ASSERT_TRUE(producer >= 0 && producer < producers);
+            ASSERT_EQ(seq, next[static_cast<size_t>(producer)]++);
+        }
+    }
+    for (int count : next) {
+        EXPECT_EQ(count, lines);
+    }
+    removeDir(dirname);
+}
+}  // namespace
+
+TEST(LogTest, RotateTime) {
+    struct tm tm {};
+    tm.tm_year  = 2026 - 1900;
+    tm.tm_mon   = 9;
+    tm.tm_mday  = 21;  // 周三.
+    tm.tm_hour  = 13;
+    tm.tm_min   = 25;
+    tm.tm_sec   = 40;
+    tm.tm_isdst = -1;
+    const time_t now = ::mktime(&tm);
+    auto at = [](int mon, int mday, int hour) {
+        struct tm expected {};
+        expected.tm_year  = 2026 - 1900;
+        expected.tm_mon   = mon;
+        expected.tm_mday  = mday;
+        expected.tm_hour  = hour;
+        expected.tm_isdst = -1;
+        return ::mktime(&expected);
+    };
+    using log::FlushFrequency;
+    using log::LogRotator;
+    EXPECT_EQ(LogRotator::nextRotateTime(now, FlushFrequency::Hour), at(9, 21, 14));
+    EXPECT_EQ(LogRotator::nextRotateTime(now, FlushFrequency::HalfDay), at(9, 22, 0));
+    EXPECT_EQ(LogRotator::nextRotateTime(at(9, 21, 11), FlushFrequency::HalfDay), at(9, 21, 12));
+    EXPECT_EQ(LogRotator::nextRotateTime(now, FlushFrequency::Day), at(9, 22, 0));
+    EXPECT_EQ(LogRotator::nextRotateTime(now, FlushFrequency::Week), at(9, 26, 0));
+    EXPECT_EQ(LogRotator::nextRotateTime(at(9, 26, 0), FlushFrequency::Week), at(10, 2, 0));
+    EXPECT_EQ(LogRotator::nextRotateTime(now, FlushFrequency::Month), at(10, 1, 0));
+    EXPECT_EQ(LogRotator::nextRotateTime(now, FlushFrequency::Never), std::numeric_limits<time_t>::max());
+
+    // 文件名中没有时间, 旧文件被重命名.
+    const String dirname = fmt::format("/tmp/lon_rotate_time_{}", ::getpid());
+    removeDir(dirname);
+    ASSERT_EQ(createDir(dirname.c_str()), 0);
+    log::LogRotationOptions options;
+    options.frequency = FlushFrequency::Hour;
+    LogRotator rotator(LogFilenameData{dirname + "/app.log", {}, {}}, options);
+    WritableFile file(dirname + "/app.log");
+    rotator.attach(file, now);
+    file.append("before\n");
+    rotator.written(7);
+    EXPECT_FALSE(rotator.shouldRotate(1024, now));
+    EXPECT_TRUE(rotator.shouldRotate(0, at(9, 21, 14)));
+    rotator.rotate(file, at(9, 21, 14));
+    file.append("after\n");
+    file.flush();
+    EXPECT_EQ(rotator.getRotations(), 1u);
+    EXPECT_FALSE(rotator.shouldRotate(0, at(9, 21, 14)));
+    EXPECT_EQ(readLines(dirname + "/app.log.20261021-140000.0"), std::vector<String>{"before"});
+    EXPECT_EQ(readLines(dirname + "/app.log"), std::vector<String>{"after"});
+    removeDir(dirname);
+}
+
+TEST(LogTest, RotateSizeUnderConcurrentLogging) {
+    log::LogRotationOptions rotation;
+    rotation.max_file_size = 16 * 1024;
+    // 一个环中积压的日志作为一个批次写入, 文件大小可能超过max_file_size.
+    checkRotationUnderLogging(fmt::format("/tmp/lon_rotate_ring_{}", ::getpid()), 0, [&](const String& filename) {
+        return std::make_unique<log::RingFileFlusher>(
+            filename.c_str(), 4096, log::RingOverflowPolicy::Block, rotation);
+    });
+    checkRotationUnderLogging(fmt::format("/tmp/lon_rotate_double_{}", ::getpid()),
+                              rotation.max_file_size,
+                              [&](const String& filename) {
+                                  log::DoubleBufferFlusherOptions options;
+                                  options.buffer_size         = 4096;
+                                  options.max_pending_buffers = static_cast<size_t>(-1);
+                                  options.rotation            = rotation;
+                                  return std::make_unique<log::DoubleBufferFileFlusher>(filename.c_str(), options);
+                              });
+}
+
+TEST(LogTest, RotateRetention) {
+    const String dirname = fmt::format("/tmp/lon_rotate_retention_{}", ::getpid());
+    removeDir(dirname);
+    {
+        log::DoubleBufferFlusherOptions options;
+        options.buffer_size             = 1024;
+        options.max_pending_buffers     = static_cast<size_t>(-1);
+        options.rotation.max_file_size = 4096;
+        options.rotation.max_files     = 2;
+        options.rotation.compress      = true;
+        log::DoubleBufferFileFlusher flusher((dirname + "/app.log").c_str(), options);
+        for (int i = 0; i < 1000; ++i) {
+            flusher.flush(fmt::format("{:0>99}\n", i));
+        }
+    }
+    // 析构时等待压缩完成.
+    auto files = rotatedFiles(dirname, "app.log");
+    ASSERT_EQ(files.size(), 3u);
+    EXPECT_EQ(files.back(), dirname + "/app.log");
+    std::vector<String> lines;
+#if LON_LOG_COMPRESSION
+    for (size_t i = 0; i < 2; ++i) {
+        ASSERT_EQ(files[i].substr(files[i].size() - 3), ".gz");
+        gzFile gz = ::gzopen(files[i].c_str(), "rb");
+        ASSERT_NE(gz, nullptr);
+        char buffer[128];
+        while (::gzgets(gz, buffer, sizeof(buffer)) != nullptr) {
+            lines.emplace_back(buffer, std::strlen(buffer) - 1);
+        }
+        ::gzclose(gz);
+    }
+#else
+    for (size_t i = 0; i < 2; ++i) {
+        auto file_lines = readLines(files[i]);
+        lines.insert(lines.end(), file_lines.begin(), file_lines.end());
+    }
+#endif
+    auto current = readLines(files.back());
+    lines.insert(lines.end(), current.begin(), current.end());
+    // 保留最后的日志.
+    ASSERT_FALSE(lines.empty());
+    EXPECT_EQ(lines.back(), fmt::format("{:0>99}", 999));
+    for (size_t i = 1; i < lines.size(); ++i) {
+        EXPECT_EQ(std::stoi(lines[i]), std::stoi(lines[i - 1]) + 1);
+    }
+    removeDir(dirname);
+}
 
 int main(int argc, char* argv[]) {
     ::testing::InitGoogleTest(&argc, argv);
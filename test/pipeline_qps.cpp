@@ -0,0 +1,126 @@
+#include "base/chrono_helper.h"
+#include "base/print_helper.h"
+#include "io/hook.h"
+#include "io/io_manager.h"
+#include "net/tcp/codec.h"
+#include "net/tcp/connection.h"
+
+#include <array>
+#include <fmt/core.h>
+#include <future>
+
+// pipeline qps测试: 客户端一次发送depth个请求(4字节), 再读取depth个响应(u16长度头 + 数据).
+// 服务端每个请求产生一个小响应, 对比每个响应直接send 与 放入写队列在下一次读取之前合并发送.
+
+using namespace lon::net;
+
+constexpr uint16_t base_port = 22250;
+constexpr int query_time     = 200000;
+std::array<const char*, 10> query_result = {
+    "111",
+    "222",
+    "3333",
+    "44",
+    "55555",
+    "66666666",
+    "7777777",
+    "8",
+    "999999999",
+    "00000"
+};
+
+struct ServerResult
+{
+    size_t responses = 0;
+    size_t syscalls  = 0;
+};
+
+static ServerResult serve(TcpConnection& connection, bool use_queue) {
+    FixedLengthCodec request_codec(sizeof(int32_t));
+    LengthFieldCodec response_codec(LengthFieldCodec::FieldSize::U16);
+    lon::IOBuffer in;
+    lon::IOBuffer encoded;
+    ServerResult result;
+    lon::net::readFrames(connection, request_codec, in, [&](lon::IOBuffer& frame) {
+        int32_t query = 0;
+        frame.copyTo(&query, sizeof(query));
+        const lon::StringPiece response = query_result[query % query_result.size()];
+        if (use_queue) {
+            writeFrame(connection, response_codec, response);
+        } else {
+            response_codec.encode(response, encoded);
+            connection.writeFrom(encoded);
+            ++result.syscalls;
+        }
+        ++result.responses;
+        return true;
+    });
+    if (use_queue)
+        result.syscalls = connection.getWriteStats().syscalls;
+    return result;
+}
+
+static void runCase(const char* name, bool use_queue, int depth, uint16_t port) {
+    std::promise<bool> listening;
+    std::promise<ServerResult> served;
+    std::thread server_thread([&]() {
+        lon::io::IOManager::getThreadLocal()->addExecutor(
+            std::make_shared<lon::coroutine::Executor>([&]() {
+                Socket socket(::socket(AF_INET, SOCK_STREAM, 0));
+                socket.setReuseAddr(true);
+                socket.bind(std::make_shared<IPV4Address>("127.0.0.1", port));
+                socket.listen();
+                listening.set_value(true);
+                auto connection = socket.accept();
+                connection->getSocket().setTcpNoDelay(true);
+                served.set_value(serve(*connection, use_queue));
+                connection->getSocket().close();
+                socket.close();
+                lon::io::IOManager::getThreadLocal()->stop();
+            }));
+        lon::io::IOManager::getThreadLocal()->run();
+    });
+    listening.get_future().get();
+
+    // 客户端线程没有开启hook, 使用阻塞的系统调用.
+    Socket socket(::socket(AF_INET, SOCK_STREAM, 0));
+    socket.setTcpNoDelay(true);
+    auto connection = socket.connect(std::make_unique<IPV4Address>("127.0.0.1", port));
+    FixedLengthCodec request_codec(sizeof(int32_t));
+    LengthFieldCodec response_codec(LengthFieldCodec::FieldSize::U16);
+    lon::IOBuffer out;
+    lon::IOBuffer in;
+    size_t time_span = 0;
+    {
+        lon::measure::GetTimeSpan<> span(&time_span);
+        for (int i = 0; i < query_time; i += depth) {
+            for (int j = 0; j < depth; ++j) {
+                const int32_t query = i + j;
+                request_codec.encode(lon::StringPiece(reinterpret_cast<const char*>(&query), sizeof(query)), out);
+            }
+            connection->writeFrom(out);
+            int received = 0;
+            lon::net::readFrames(*connection, response_codec, in, [&](lon::IOBuffer&) {
+                return ++received < depth;
+            });
+        }
+    }
+    connection->getSocket().close();
+    const ServerResult result = served.get_future().get();
+    server_thread.join();
+
+    fmt::print("{:<24}: {:>9.0f} query per second, {:.3f} syscalls per response\n",
+               name,
+               static_cast<double>(query_time) / static_cast<double>(time_span) * 1000.0,
+               static_cast<double>(result.syscalls) / static_cast<double>(result.responses));
+}
+
+int main() {
+    printDividing("pipeline qps");
+    uint16_t port = base_port;
+    for (int depth : {1, 16}) {
+        runCase(fmt::format("write queue, depth {}", depth).c_str(), true, depth, port++);
+        runCase(fmt::format("send, depth {}", depth).c_str(), false, depth, port++);
+    }
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include "base/chrono_helper.h"
+#include "base/print_helper.h"
+#include "io/io_manager.h"
+#include "net/rpc/rpc_client.h"
+#include "net/rpc/rpc_server.h"
+
+#include <algorithm>
+#include <fmt/core.h>
+#include <future>
+
+// rpc qps测试: server和client分别运行在两个IOManager线程中, client在同一个连接上用concurrency个协程
+// 循环调用echo方法, 持续seconds秒, 统计每秒调用数, 调用延迟的p50/p99以及每次发送合并的调用数.
+
+using namespace lon::net;
+
+constexpr uint16_t base_port = 22310;
+constexpr int seconds        = 3;
+
+using EchoMethod = RpcMethod<rpcMethodId("bench.Echo"), lon::String, lon::String>;
+
+struct LoadResult
+{
+    size_t calls     = 0;
+    size_t errors    = 0;
+    size_t flushes   = 0;
+    size_t time_span = 0;
+    std::vector<uint32_t> latency_us;
+};
+
+static LoadResult runClientLoad(uint16_t port, int concurrency) {
+    LoadResult result;
+    std::thread client_thread([&]() {
+        auto client = RpcClient::connect("127.0.0.1", port);
+        if (!client) {
+            ++result.errors;
+            return;
+        }
+        const auto begin    = lon::steady_clock::now();
+        const auto deadline = begin + std::chrono::seconds(seconds);
+        auto running        = std::make_shared<int>(concurrency);
+        for (int i = 0; i < concurrency; ++i) {
+            lon::io::IOManager::getThreadLocal()->addExecutor(std::make_shared<lon::coroutine::Executor>([&, running]() {
+                const lon::String request(32, 'x');
+                lon::String response;
+                while (true) {
+                    const auto start = lon::steady_clock::now();
+                    if (start >= deadline)
+                        break;
+                    if (client->call<EchoMethod>(request, response) != RpcStatus::Ok ||
+                        response.size() != request.size()) {
+                        ++result.errors;
+                        break;
+                    }
+                    const auto end = lon::steady_clock::now();
+                    result.latency_us.push_back(static_cast<uint32_t>(
+                        std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()));
+                }
+                if (--*running == 0) {
+                    result.time_span = static_cast<size_t>(lon::getTimeSpanMs(begin, lon::steady_clock::now()));
+                    result.calls     = client->getStats().calls;
+                    result.flushes   = client->getStats().flushes;
+                    client->close();
+                    lon::io::IOManager::getThreadLocal()->stop();
+                }
+            }));
+        }
+        lon::io::IOManager::getThreadLocal()->run();
+    });
+    client_thread.join();
+    return result;
+}
+
+static void printResult(int concurrency, LoadResult& result) {
+    const auto name = fmt::format("echo, concurrency {}", concurrency);
+    if (result.latency_us.empty()) {
+        fmt::print("{:<24}: failed, {} errors\n", name, result.errors);
+        return;
+    }
+    std::sort(result.latency_us.begin(), result.latency_us.end());
+    const auto percentile = [&](double p) {
+        return result.latency_us[static_cast<size_t>(static_cast<double>(result.latency_us.size() - 1) * p)];
+    };
+    fmt::print("{:<24}: {:>9.0f} calls per second, p50 {:>6} us, p99 {:>6} us, {:>6.1f} calls per flush, {} errors\n",
+               name,
+               static_cast<double>(result.latency_us.size()) /
+                   static_cast<double>(std::max<size_t>(result.time_span, 1)) * 1000.0,
+               percentile(0.5),
+               percentile(0.99),
+               static_cast<double>(result.calls) / static_cast<double>(std::max<size_t>(result.flushes, 1)),
+               result.errors);
+}
+
+static void runCase(int concurrency, uint16_t port) {
+    std::promise<std::shared_ptr<lon::io::IOManager>> server_manager_promise;
+    std::promise<bool> started_promise;
+    std::unique_ptr<RpcServer> server;
+    std::thread server_thread([&]() {
+        server = std::make_unique<RpcServer>(makeRpcDispatcher(rpcHandler<EchoMethod>(
+            [](lon::String& request, lon::String& response) { response = std::move(request); })));
+        server->getTcpServer().setSocketIniter([](Socket& socket) { socket.setReuseAddr(true); });
+        const bool ok = server->bind(std::make_shared<IPV4Address>("127.0.0.1", port)) && server->startServe();
+        server_manager_promise.set_value(lon::io::IOManager::getThreadLocal());
+        started_promise.set_value(ok);
+        lon::io::IOManager::getThreadLocal()->run();
+    });
+    auto server_manager = server_manager_promise.get_future().get();
+    if (started_promise.get_future().get()) {
+        LoadResult result = runClientLoad(port, concurrency);
+        printResult(concurrency, result);
+    } else {
+        fmt::print("concurrency {}: bind failed\n", concurrency);
+    }
+    server_manager->addRemoteTask(std::make_shared<lon::coroutine::Executor>([&server]() {
+        server->stopServe();
+        server.reset();
+        lon::io::IOManager::getThreadLocal()->stop();
+    }));
+    server_thread.join();
+}
+
+int main() {
+    printDividing("rpc qps");
+    uint16_t port = base_port;
+    for (int concurrency : {1, 64, 1024}) {
+        runCase(concurrency, port++);
+    }
+    return 0;
+}
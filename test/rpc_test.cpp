@@ -0,0 +1,162 @@
+#include "io/co_waiter.h"
+#include "io/io_manager.h"
+#include "net/rpc/rpc_client.h"
+#include "net/rpc/rpc_server.h"
+
+#include <future>
+#include <gtest/gtest.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace lon;
+using namespace lon::net;
+
+namespace {
+struct AddRequest
+{
+    int32_t a;
+    int32_t b;
+};
+
+using EchoMethod  = RpcMethod<rpcMethodId("test.Echo"), String, String>;
+using AddMethod   = RpcMethod<rpcMethodId("test.Add"), AddRequest, int32_t>;
+using FailMethod  = RpcMethod<rpcMethodId("test.Fail"), int32_t, int32_t>;
+using SlowMethod  = RpcMethod<rpcMethodId("test.Slow"), int32_t, int32_t>;
+using OtherMethod = RpcMethod<rpcMethodId("test.Other"), int32_t, int32_t>;
+using LocalMethod = RpcMethod<rpcMethodId("test.Local"), int32_t, int32_t>;
+
+static_assert(rpcMethodId("test.Echo") != rpcMethodId("test.Add"));
+
+RpcDispatcher makeTestDispatcher() {
+    return makeRpcDispatcher(
+        rpcHandler<EchoMethod>([](String& request, String& response) { response = std::move(request); }),
+        rpcHandler<AddMethod>([](AddRequest& request, int32_t& response) { response = request.a + request.b; }),
+        rpcHandler<FailMethod>([](int32_t&, int32_t&) { return RpcStatus::HandlerError; }),
+        rpcHandler<LocalMethod>([](int32_t&, int32_t&) { return RpcStatus::DeadlineExceeded; }),
+        rpcHandler<SlowMethod>([](int32_t& request, int32_t& response) {
+            ::usleep(static_cast<useconds_t>(request) * 1000);
+            response = request;
+        }));
+}
+}  // namespace
+
+TEST(RpcTest, FrameAndDispatch) {
+    IOBuffer frames;
+    IOBuffer body;
+    body.append("hello");
+    encodeRpcFrame(RpcHeader{RpcHeader::Type::Request, RpcStatus::Ok, EchoMethod::kId, 42}, std::move(body), frames);
+    ASSERT_EQ(frames.readableBytes(), RpcHeader::kLengthField + RpcHeader::kSize + 5);
+
+    frames.consume(RpcHeader::kLengthField);
+    RpcHeader header;
+    ASSERT_TRUE(header.decode(frames));
+    EXPECT_EQ(header.type, RpcHeader::Type::Request);
+    EXPECT_EQ(header.method_id, EchoMethod::kId);
+    EXPECT_EQ(header.request_id, 42u);
+
+    auto dispatcher = makeTestDispatcher();
+    IOBuffer response;
+    EXPECT_EQ(dispatcher(header.method_id, frames, response), RpcStatus::Ok);
+    EXPECT_EQ(response.toString(), "hello");
+
+    IOBuffer request;
+    response.clear();
+    EXPECT_EQ(dispatcher(OtherMethod::kId, request, response), RpcStatus::NoMethod);
+    request.append("short");
+    EXPECT_EQ(dispatcher(AddMethod::kId, request, response), RpcStatus::BadRequest);
+    EXPECT_TRUE(response.empty());
+
+    IOBuffer bad;
+    bad.append(String(RpcHeader::kSize, '\x7f'));
+    EXPECT_FALSE(header.decode(bad));
+}
+
+TEST(RpcTest, ClientServer) {
+    constexpr uint16_t port = 22300;
+    std::promise<void> finished;
+    std::thread thread([&]() {
+        auto io_manager = io::IOManager::getThreadLocal();
+        RpcServer server(makeTestDispatcher());
+        server.getTcpServer().setSocketIniter([](Socket& socket) { socket.setReuseAddr(true); });
+        EXPECT_TRUE(server.bind(std::make_shared<IPV4Address>("127.0.0.1", port)));
+        EXPECT_TRUE(server.startServe());
+
+        // ASSERT失败时提前返回, 之后仍然需要停止IOManager.
+        auto run_client = [&]() {
+            auto client = RpcClient::connect("127.0.0.1", port);
+            ASSERT_NE(client, nullptr);
+
+            String echo;
+            ASSERT_EQ(client->call<EchoMethod>("ping", echo), RpcStatus::Ok);
+            EXPECT_EQ(echo, "ping");
+
+            int32_t sum = 0;
+            ASSERT_EQ(client->call<AddMethod>(AddRequest{20, 22}, sum), RpcStatus::Ok);
+            EXPECT_EQ(sum, 42);
+
+            int32_t ignored = 0;
+            EXPECT_EQ(client->call<FailMethod>(1, ignored), RpcStatus::HandlerError);
+            EXPECT_EQ(client->call<OtherMethod>(1, ignored), RpcStatus::NoMethod);
+
+            // 处理函数返回只属于客户端的状态时回复HandlerError, 连接上的其它调用不受影响.
+            EXPECT_EQ(client->call<LocalMethod>(1, ignored), RpcStatus::HandlerError);
+            EXPECT_TRUE(client->connected());
+            ASSERT_EQ(client->call<EchoMethod>("still", echo), RpcStatus::Ok);
+            EXPECT_EQ(echo, "still");
+
+            // 大的body不拷贝, 跨越多个block.
+            const String large(IOBuffer::kBlockSize * 3 + 7, 'x');
+            ASSERT_EQ(client->call<EchoMethod>(large, echo), RpcStatus::Ok);
+            EXPECT_EQ(echo, large);
+
+            // 超时以后到达的响应被丢弃, 连接仍然可用.
+            EXPECT_EQ(client->call<SlowMethod>(100, ignored, 20), RpcStatus::DeadlineExceeded);
+            ASSERT_EQ(client->call<AddMethod>(AddRequest{1, 2}, sum), RpcStatus::Ok);
+            EXPECT_EQ(sum, 3);
+            EXPECT_EQ(client->getStats().late, 1u);
+
+            // 同一个连接上的并发调用, 同一轮调度中发起的调用合并发送.
+            constexpr int kConcurrency = 64;
+            const size_t flushes_before = client->getStats().flushes;
+            auto done                   = std::make_shared<io::CoWaiter>();
+            int remaining               = kConcurrency;
+            int succeeded               = 0;
+            for (int i = 0; i < kConcurrency; ++i) {
+                io::IOManager::getThreadLocal()->addExecutor(std::make_shared<coroutine::Executor>([&, i]() {
+                    int32_t result = 0;
+                    if (client->call<AddMethod>(AddRequest{i, i}, result) == RpcStatus::Ok && result == 2 * i)
+                        ++succeeded;
+                    if (--remaining == 0)
+                        done->notify();
+                }));
+            }
+            done->wait();
+            EXPECT_EQ(succeeded, kConcurrency);
+            EXPECT_LT(client->getStats().flushes - flushes_before, static_cast<size_t>(kConcurrency));
+            EXPECT_EQ(client->pendingCalls(), 0u);
+
+            // 关闭时挂起中的调用返回Disconnected.
+            io::IOManager::getThreadLocal()->addExecutor(
+                std::make_shared<coroutine::Executor>([&]() { client->close(); }));
+            EXPECT_EQ(client->call<SlowMethod>(50, ignored), RpcStatus::Disconnected);
+            EXPECT_FALSE(client->connected());
+            EXPECT_EQ(client->call<EchoMethod>("x", echo), RpcStatus::Disconnected);
+
+            EXPECT_EQ(RpcClient::connect("127.0.0.1", 1), nullptr);
+        };
+        io_manager->addExecutor(std::make_shared<coroutine::Executor>([&]() {
+            run_client();
+            server.stopServe();
+            io::IOManager::getThreadLocal()->stop();
+            finished.set_value();
+        }));
+        io_manager->run();
+    });
+    EXPECT_EQ(finished.get_future().wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    thread.join();
+}
+
+int main(int argc, char* argv[]) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,193 @@
+#include "base/chrono_helper.h"
+#include "base/print_helper.h"
+#include "io/hook.h"
+#include "io/io_manager.h"
+#include "net/tcp/connection.h"
+
+#include <csignal>
+#include <fcntl.h>
+#include <fmt/core.h>
+#include <future>
+#include <vector>
+
+// 大文件发送吞吐测试: 服务端把同一个文件发送多次, 客户端读取并丢弃.
+// 对比read + send, sendfile, 经过管道的splice, 以及从内存发送时写队列的普通拷贝与MSG_ZEROCOPY.
+
+using namespace lon::net;
+
+constexpr uint16_t base_port   = 22270;
+constexpr size_t file_size     = 64 * 1024 * 1024;
+constexpr int rounds           = 8;
+constexpr size_t total_bytes   = file_size * rounds;
+constexpr size_t read_chunk    = 64 * 1024;
+constexpr size_t memory_chunk  = 1024 * 1024;
+constexpr const char* file_path = "/tmp/lon_sendfile_speed.dat";
+
+enum class Mode
+{
+    ReadSend,
+    SendFile,
+    Splice,
+    WriteQueue,
+    ZeroCopy
+};
+
+static bool sendAll(TcpConnection& connection, const char* data, size_t len) {
+    while (len > 0) {
+        const ssize_t n = connection.send(data, len, MSG_NOSIGNAL);
+        if (n <= 0)
+            return false;
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static void serveReadSend(TcpConnection& connection, int file_fd) {
+    std::vector<char> buffer(read_chunk);
+    for (int i = 0; i < rounds; ++i) {
+        for (off_t offset = 0; static_cast<size_t>(offset) < file_size;) {
+            const ssize_t n = ::pread(file_fd, buffer.data(), buffer.size(), offset);
+            if (n <= 0 || !sendAll(connection, buffer.data(), static_cast<size_t>(n)))
+                return;
+            offset += n;
+        }
+    }
+}
+
+static void serveSplice(TcpConnection& connection, int file_fd) {
+    int pipe_fds[2];
+    if (::pipe(pipe_fds) != 0)
+        return;
+    for (int i = 0; i < rounds; ++i) {
+        loff_t offset = 0;
+        while (static_cast<size_t>(offset) < file_size) {
+            // 普通文件到管道不会阻塞, 每次最多填满管道.
+            const ssize_t n = ::splice(file_fd, &offset, pipe_fds[1], nullptr, read_chunk, SPLICE_F_MOVE);
+            if (n <= 0 || connection.splice(pipe_fds[0], static_cast<size_t>(n)) != n)
+                break;
+        }
+    }
+    ::close(pipe_fds[0]);
+    ::close(pipe_fds[1]);
+}
+
+static void serveMemory(TcpConnection& connection, const lon::IOBuffer& payload) {
+    for (size_t sent = 0; sent < total_bytes; sent += memory_chunk) {
+        // slice与payload共享block, 写队列直接发送这些block.
+        if (connection.write(payload.slice(0, memory_chunk)) == -1)
+            return;
+    }
+    connection.flush();
+}
+
+static void serve(TcpConnection& connection, Mode mode, int file_fd, const lon::IOBuffer& payload) {
+    switch (mode) {
+        case Mode::ReadSend:
+            serveReadSend(connection, file_fd);
+            break;
+        case Mode::SendFile:
+            for (int i = 0; i < rounds; ++i) {
+                connection.sendFile(file_fd, 0, file_size);
+            }
+            break;
+        case Mode::Splice:
+            serveSplice(connection, file_fd);
+            break;
+        case Mode::WriteQueue:
+            serveMemory(connection, payload);
+            break;
+        case Mode::ZeroCopy:
+            if (!connection.enableZeroCopy())
+                fmt::print("SO_ZEROCOPY not supported, fall back to copy\n");
+            serveMemory(connection, payload);
+            break;
+    }
+}
+
+static void runCase(const char* name, Mode mode, int file_fd, const lon::IOBuffer& payload, uint16_t port) {
+    std::promise<bool> listening;
+    std::promise<TcpConnection::WriteStats> served;
+    std::thread server_thread([&]() {
+        lon::io::IOManager::getThreadLocal()->addExecutor(
+            std::make_shared<lon::coroutine::Executor>([&]() {
+                Socket socket(::socket(AF_INET, SOCK_STREAM, 0));
+                socket.setReuseAddr(true);
+                socket.bind(std::make_shared<IPV4Address>("127.0.0.1", port));
+                socket.listen();
+                listening.set_value(true);
+                auto connection = socket.accept();
+                serve(*connection, mode, file_fd, payload);
+                // 等待客户端读完再关闭, 避免丢弃还没有完成的zerocopy发送.
+                char c;
+                connection->recv(&c, 1);
+                connection->reapZeroCopy();
+                served.set_value(connection->getWriteStats());
+                connection->getSocket().close();
+                socket.close();
+                lon::io::IOManager::getThreadLocal()->stop();
+            }));
+        lon::io::IOManager::getThreadLocal()->run();
+    });
+    listening.get_future().get();
+
+    // 客户端线程没有开启hook, 使用阻塞的系统调用.
+    Socket socket(::socket(AF_INET, SOCK_STREAM, 0));
+    auto connection = socket.connect(std::make_unique<IPV4Address>("127.0.0.1", port));
+    std::vector<char> buffer(256 * 1024);
+    size_t received  = 0;
+    size_t time_span = 0;
+    {
+        lon::measure::GetTimeSpan<> span(&time_span);
+        while (received < total_bytes) {
+            const ssize_t n = connection->recv(buffer.data(), buffer.size());
+            if (n <= 0)
+                break;
+            received += static_cast<size_t>(n);
+        }
+    }
+    connection->getSocket().close();
+    const TcpConnection::WriteStats stats = served.get_future().get();
+    server_thread.join();
+
+    fmt::print("{:<24}: {:>9.1f} MiB/s",
+               name,
+               static_cast<double>(received) / lon::data::M / (static_cast<double>(time_span) / 1000.0));
+    if (mode == Mode::ZeroCopy)
+        fmt::print(", zerocopy sends {}, copied {}", stats.zerocopy_sends, stats.zerocopy_copied);
+    fmt::print("\n");
+}
+
+int main() {
+    ::signal(SIGPIPE, SIG_IGN);
+    printDividing("sendfile speed");
+
+    std::vector<char> chunk(memory_chunk);
+    for (size_t i = 0; i < chunk.size(); ++i) {
+        chunk[i] = "0123456789ABCDEF"[i % 16];
+    }
+    lon::IOBuffer payload;
+    payload.append(chunk.data(), chunk.size());
+    int file_fd = ::open(file_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (file_fd == -1) {
+        fmt::print("open {} failed\n", file_path);
+        return 1;
+    }
+    for (size_t written = 0; written < file_size; written += memory_chunk) {
+        if (::write(file_fd, chunk.data(), chunk.size()) != static_cast<ssize_t>(memory_chunk)) {
+            fmt::print("write {} failed\n", file_path);
+            return 1;
+        }
+    }
+
+    uint16_t port = base_port;
+    runCase("read + send", Mode::ReadSend, file_fd, payload, port++);
+    runCase("sendfile", Mode::SendFile, file_fd, payload, port++);
+    runCase("splice", Mode::Splice, file_fd, payload, port++);
+    runCase("write queue", Mode::WriteQueue, file_fd, payload, port++);
+    runCase("write queue + zerocopy", Mode::ZeroCopy, file_fd, payload, port++);
+
+    ::close(file_fd);
+    ::unlink(file_path);
+    return 0;
+}
@@ -0,0 +1,327 @@
+#include "balancer/io/avg_balancer.h"
+#include "io/io_manager.h"
+#include "net/stream_server.h"
+
+#include <atomic>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <netinet/in.h>
+#include <set>
+#include <sys/resource.h>
+#include <thread>
+
+using namespace lon;
+using namespace lon::net;
+
+namespace {
+/**
+ * @brief 在一个开启hook的IOManager线程中运行func.
+ */
+void runInIOManager(const std::function<void()>& func) {
+    std::thread thread([&]() {
+        auto io_manager = io::IOManager::getThreadLocal();
+        io_manager->addExecutor(std::make_shared<coroutine::Executor>([&]() {
+            func();
+            io::IOManager::getThreadLocal()->stop();
+        }));
+        io_manager->run();
+    });
+    thread.join();
+}
+
+/**
+ * @brief 停止均衡器的IOManager, 之后析构server时join均衡器的线程.
+ */
+void stopBalancer(StreamServer& server) {
+    for (auto& manager : server.getBalancer().getIOManagers()) {
+        manager->addRemoteTask(std::make_shared<coroutine::Executor>([]() { io::IOManager::getThreadLocal()->stop(); }));
+    }
+}
+
+void reuseAddr(Socket& socket) {
+    socket.setReuseAddr(true);
+}
+
+/**
+ * @brief 连接127.0.0.1:port, 返回fd, 连接完成只代表进入了backlog, 不代表server已经accept.
+ */
+int connectLoopback(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port        = htons(port);
+    EXPECT_EQ(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    return fd;
+}
+
+size_t cpuMs() {
+    rusage usage{};
+    ::getrusage(RUSAGE_SELF, &usage);
+    return static_cast<size_t>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000 +
+           static_cast<size_t>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+}
+}  // namespace
+
+TEST(StreamServerTest, MaxConnections) {
+    constexpr uint16_t port = 22350;
+    std::vector<std::shared_ptr<TcpConnection>> held;
+    auto server = std::make_shared<StreamServer>([&](std::shared_ptr<TcpConnection> connection) {
+        held.push_back(std::move(connection));
+    });
+    runInIOManager([&]() {
+        StreamServer::AcceptLimits limits;
+        limits.max_connections = 2;
+        server->setAcceptLimits(limits);
+        server->setSocketIniter(reuseAddr);
+        ASSERT_TRUE(server->bind(std::make_shared<IPV4Address>("127.0.0.1", port)));
+        ASSERT_TRUE(server->startServe());
+
+        std::vector<int> clients;
+        for (int i = 0; i < 3; ++i) {
+            clients.push_back(connectLoopback(port));
+        }
+        ::usleep(50 * 1000);
+        // 达到上限后第三个连接留在backlog中.
+        auto stats = server->getStats();
+        EXPECT_EQ(stats.accepted, 2u);
+        EXPECT_EQ(stats.active_connections, 2u);
+        EXPECT_GT(stats.accept_paused, 0u);
+
+        // 连接按照TcpConnection的生命周期计数, 释放以后恢复accept.
+        held.clear();
+        ::usleep(50 * 1000);
+        stats = server->getStats();
+        EXPECT_EQ(stats.accepted, 3u);
+        EXPECT_EQ(stats.active_connections, 1u);
+        EXPECT_EQ(held.size(), 1u);
+        held.clear();
+        EXPECT_EQ(server->getStats().active_connections, 0u);
+
+        for (int fd : clients) {
+            ::close(fd);
+        }
+        server->stopServe();
+        ::usleep(10 * 1000);
+    });
+}
+
+TEST(StreamServerTest, MaxConnectionsPerThread) {
+    constexpr uint16_t port = 22351;
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    std::vector<std::shared_ptr<TcpConnection>> held;
+    auto server = std::make_shared<StreamServer>(
+        [&](std::shared_ptr<TcpConnection> connection) {
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.insert(std::this_thread::get_id());
+            held.push_back(std::move(connection));
+        },
+        std::make_unique<io::SequenceIOBalancer>(2));
+    runInIOManager([&]() {
+        StreamServer::AcceptLimits limits;
+        limits.max_connections_per_thread = 1;
+        server->setAcceptLimits(limits);
+        server->setSocketIniter(reuseAddr);
+        ASSERT_TRUE(server->bind(std::make_shared<IPV4Address>("127.0.0.1", port)));
+        ASSERT_TRUE(server->startServe());
+
+        std::vector<int> clients;
+        for (int i = 0; i < 3; ++i) {
+            clients.push_back(connectLoopback(port));
+        }
+        ::usleep(100 * 1000);
+        // 限制的是每个处理连接的IOManager, 两个线程各处理一个连接.
+        EXPECT_EQ(server->getStats().accepted, 2u);
+        EXPECT_GT(server->getStats().accept_paused, 0u);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            EXPECT_EQ(threads.size(), 2u);
+            held.clear();
+        }
+        ::usleep(100 * 1000);
+        EXPECT_EQ(server->getStats().accepted, 3u);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            held.clear();
+        }
+
+        for (int fd : clients) {
+            ::close(fd);
+        }
+        server->stopServe();
+        ::usleep(10 * 1000);
+    });
+    stopBalancer(*server);
+    server.reset();
+}
+
+TEST(StreamServerTest, MaxQueuedTasks) {
+    constexpr uint16_t port = 22352;
+    std::atomic<bool> release{false};
+    std::atomic<size_t> handled{0};
+    auto server = std::make_shared<StreamServer>(
+        [&](std::shared_ptr<TcpConnection>) {
+            // 第一个连接阻塞处理线程, 之后的连接在队列中等待.
+            if (handled.fetch_add(1) == 0) {
+                while (!release.load()) {
+                    std::this_thread::yield();
+                }
+            }
+        },
+        std::make_unique<io::SequenceIOBalancer>(1));
+    runInIOManager([&]() {
+        StreamServer::AcceptLimits limits;
+        limits.max_queued_tasks = 0;
+        server->setAcceptLimits(limits);
+        server->setSocketIniter(reuseAddr);
+        ASSERT_TRUE(server->bind(std::make_shared<IPV4Address>("127.0.0.1", port)));
+        ASSERT_TRUE(server->startServe());
+
+        std::vector<int> clients;
+        for (int i = 0; i < 3; ++i) {
+            clients.push_back(connectLoopback(port));
+        }
+        ::usleep(100 * 1000);
+        EXPECT_EQ(server->getStats().accepted, 2u);
+        EXPECT_GT(server->getStats().accept_paused, 0u);
+
+        release = true;
+        ::usleep(100 * 1000);
+        EXPECT_EQ(server->getStats().accepted, 3u);
+        EXPECT_EQ(handled.load(), 3u);
+
+        for (int fd : clients) {
+            ::close(fd);
+        }
+        server->stopServe();
+        ::usleep(10 * 1000);
+    });
+    stopBalancer(*server);
+    server.reset();
+}
+
+TEST(StreamServerTest, RejectWhenFdExhausted) {
+    constexpr uint16_t port = 22353;
+    std::atomic<size_t> handled{0};
+    auto server = std::make_shared<StreamServer>([&](std::shared_ptr<TcpConnection>) { ++handled; });
+    runInIOManager([&]() {
+        server->setSocketIniter(reuseAddr);
+        ASSERT_TRUE(server->bind(std::make_shared<IPV4Address>("127.0.0.1", port)));
+        ASSERT_TRUE(server->startServe());
+
+        // 先创建客户端的socket, 之后用完进程的fd.
+        std::vector<int> clients;
+        for (int i = 0; i < 3; ++i) {
+            clients.push_back(::socket(AF_INET, SOCK_STREAM, 0));
+        }
+        rlimit old_limit{};
+        ASSERT_EQ(::getrlimit(RLIMIT_NOFILE, &old_limit), 0);
+        rlimit limit = old_limit;
+        limit.rlim_cur = std::min<rlim_t>(old_limit.rlim_cur, 1024);
+        ASSERT_EQ(::setrlimit(RLIMIT_NOFILE, &limit), 0);
+        std::vector<int> fillers;
+        for (int fd; (fd = ::open("/dev/null", O_RDONLY | O_CLOEXEC)) != -1;) {
+            fillers.push_back(fd);
+        }
+        EXPECT_EQ(errno, EMFILE);
+
+        sockaddr_in addr{};
+        addr.sin_family      = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port        = htons(port);
+        for (int fd : clients) {
+            EXPECT_EQ(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+        }
+        ::usleep(50 * 1000);
+        // 用预留的fd取出连接并立即关闭, 客户端马上得到结果.
+        EXPECT_EQ(server->getStats().rejected, 3u);
+        EXPECT_EQ(server->getStats().accepted, 0u);
+        for (int fd : clients) {
+            char byte;
+            EXPECT_LE(::recv(fd, &byte, 1, 0), 0);
+        }
+
+        // backlog取完以后挂起等待, 而不是一直重试accept.
+        const size_t cpu_before = cpuMs();
+        ::usleep(200 * 1000);
+        EXPECT_LT(cpuMs() - cpu_before, 100u);
+
+        for (int fd : fillers) {
+            ::close(fd);
+        }
+        ASSERT_EQ(::setrlimit(RLIMIT_NOFILE, &old_limit), 0);
+        for (int fd : clients) {
+            ::close(fd);
+        }
+
+        // fd恢复以后正常accept.
+        int fd = connectLoopback(port);
+        ::usleep(50 * 1000);
+        EXPECT_EQ(server->getStats().accepted, 1u);
+        EXPECT_EQ(handled.load(), 1u);
+        ::close(fd);
+
+        server->stopServe();
+        ::usleep(10 * 1000);
+    });
+}
+
+TEST(StreamServerTest, Sharded) {
+    constexpr uint16_t port = 22354;
+    constexpr size_t kClients = 16;
+    std::atomic<size_t> served{0};
+    auto server = std::make_shared<StreamServer>(
+        [&](std::shared_ptr<TcpConnection> connection) {
+            char buffer[64];
+            const ssize_t n = connection->recv(buffer, sizeof(buffer));
+            if (n > 0 && connection->send(buffer, static_cast<size_t>(n)) == n)
+                ++served;
+            connection->getSocket().close();
+        },
+        std::make_unique<io::SequenceIOBalancer>(2));
+    runInIOManager([&]() {
+        server->setAcceptMode(StreamServer::AcceptMode::Sharded);
+        server->setSocketIniter(reuseAddr);
+        ASSERT_TRUE(server->bind(std::make_shared<IPV4Address>("127.0.0.1", port)));
+        ASSERT_TRUE(server->startServe());
+        // 等待分片线程中的listen socket创建完成.
+        ::usleep(100 * 1000);
+
+        for (size_t i = 0; i < kClients; ++i) {
+            int fd = connectLoopback(port);
+            const String message = std::to_string(i);
+            EXPECT_EQ(::send(fd, message.data(), message.size(), 0), static_cast<ssize_t>(message.size()));
+            char buffer[64];
+            const ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+            EXPECT_EQ(StringPiece(buffer, n > 0 ? static_cast<size_t>(n) : 0), message);
+            ::close(fd);
+        }
+        ::usleep(20 * 1000);
+        EXPECT_EQ(served.load(), kClients);
+        EXPECT_EQ(server->getStats().accepted, kClients);
+
+        // 全部分片的listen socket都关闭以后, 内核不再有可以分配连接的socket.
+        EXPECT_TRUE(server->stopServe());
+        ::usleep(50 * 1000);
+        sockaddr_in addr{};
+        addr.sin_family      = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port        = htons(port);
+        for (size_t i = 0; i < kClients; ++i) {
+            int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+            EXPECT_EQ(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), -1);
+            EXPECT_EQ(errno, ECONNREFUSED);
+            ::close(fd);
+        }
+        EXPECT_EQ(server->getStats().accepted, kClients);
+    });
+    stopBalancer(*server);
+    server.reset();
+}
+
+int main(int argc, char* argv[]) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -1,6 +1,7 @@
 #include "base/chrono_helper.h"
 #include "io/hook.h"
 #include "io/io_manager.h"
+#include "net/tcp/codec.h"
 #include "net/tcp/connection.h"
 #include "net/tcp/tcp_server.h"
 
@@ -8,6 +9,8 @@
 #include <fmt/os.h>
 
 static bool async = true;
+// 使用原始的recv/send而不是codec, 用于对比codec的开销.
+static bool raw = false;
 
 struct SessionMessage
 {
@@ -26,6 +29,66 @@ constexpr int number = 81920;
 constexpr int message_length = 1000;
 constexpr double total_mb = 1.0 * (message_length + sizeof(int32_t)) * number / lon::data::M;
 
+/**
+ * @brief 读取len字节, tcp可能把数据拆开, 所以需要循环读取.
+ */
+bool recvAll(lon::net::TcpConnection& connection, void* buffer, size_t len) {
+    auto data = static_cast<char*>(buffer);
+    while (len > 0) {
+        ssize_t n = connection.recv(data, len);
+        if (n <= 0)
+            return false;
+        data += n;
+        len -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+void clientRaw(lon::net::TcpConnection& connection) {
+    const int total_len = static_cast<int>(sizeof(int32_t) + message_length);
+    PayloadMessage* payload = static_cast<PayloadMessage*>(::malloc(total_len));
+    assert(payload);
+    payload->length = ::htonl(message_length);
+    for (int i = 0; i < message_length; ++i) {
+        payload->data[i] = "0123456789ABCDEF"[i % 16];
+    }
+    for (int i = 0; i < number; ++i) {
+        [[maybe_unused]] ssize_t n_w = connection.send(payload, total_len, 0);
+        assert(n_w == total_len);
+
+        int ack = 0;
+        [[maybe_unused]] bool ok = recvAll(connection, &ack, sizeof(ack));
+        assert(ok);
+        assert(::ntohl(ack) == message_length);
+    }
+    ::free(payload);
+}
+
+void clientCodec(lon::net::TcpConnection& connection) {
+    lon::String payload(message_length, '\0');
+    for (int i = 0; i < message_length; ++i) {
+        payload[i] = "0123456789ABCDEF"[i % 16];
+    }
+    lon::net::LengthFieldCodec payload_codec;
+    lon::net::FixedLengthCodec ack_codec(sizeof(int32_t));
+    lon::IOBuffer out;
+    lon::IOBuffer in;
+    for (int i = 0; i < number; ++i) {
+        payload_codec.encode(payload, out);
+        [[maybe_unused]] ssize_t n_w = connection.writeFrom(out);
+        assert(n_w == message_length + sizeof(int32_t));
+
+        [[maybe_unused]] int result =
+            lon::net::readFrames(connection, ack_codec, in, [](lon::IOBuffer& frame) {
+                int32_t ack = 0;
+                frame.copyTo(&ack, sizeof(ack));
+                assert(::ntohl(ack) == message_length);
+                return false;
+            });
+        assert(result == 1);
+    }
+}
+
 void client() {
     int sockfd = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
     lon::net::Socket socket(sockfd);
@@ -40,81 +103,103 @@ void client() {
         fmt::print("write session message failed\n");
     }
 
-    const int total_len = static_cast<int>(sizeof(int32_t) + message_length);
-    PayloadMessage* payload = static_cast<PayloadMessage*>(::malloc(total_len));
-    assert(payload);
-    payload->length = ::htonl(message_length);
-    for (int i = 0; i < message_length; ++i) {
-        payload->data[i] = "0123456789ABCDEF"[i % 16];
-    }
     {
         lon::measure::GetTimeSpan<> SpanMeasure(&time_span);
-        for(int i = 0; i < number; ++i) {
-            [[maybe_unused]] ssize_t n_w = connection->send(payload, total_len, 0);
-            assert(n_w == total_len);
-
-            int ack = 0;
-            [[maybe_unused]] ssize_t n_r = connection->recv(&ack, sizeof(ack), 0);
-            ack = ::ntohl(ack);
-            assert(n_r == sizeof(ack));
-            assert(ack == message_length);
-        }
+        if (raw)
+            clientRaw(*connection);
+        else
+            clientCodec(*connection);
     }
-    ::free(payload);
     ::close(sockfd);
     double seconds = static_cast<double>(time_span) / 1000.0;
     fmt::print("{:.3f} seconds, {:.3f} Mib/s\n", seconds, total_mb / seconds);
-    // connection->send();
     if (async)
         lon::io::IOManager::getThreadLocal()->stop();
 }
 
-void server() {
-    int sockfd = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-    lon::net::Socket socket(sockfd);
-    socket.bind(std::make_shared<lon::net::IPV4Address>("127.0.0.1", port));
-    socket.setReuseAddr(true);
-    socket.listen();
-    auto connection = socket.accept();
-
-    struct SessionMessage sessionMessage = { 0, 0 };
-    if (connection->recv(&sessionMessage, sizeof(sessionMessage), 0) != sizeof(sessionMessage))
-    {
-        fmt::print("read SessionMessage\n");
-        exit(1);
-    }
-
-    sessionMessage.number = ntohl(sessionMessage.number);
-    sessionMessage.length = ntohl(sessionMessage.length);
-    printf("receive number = %d\nreceive length = %d\n",
-        sessionMessage.number, sessionMessage.length);
-    const int total_len = static_cast<int>(sizeof(int32_t) + sessionMessage.length);
+void serverRaw(lon::net::TcpConnection& connection, const SessionMessage& session_message) {
+    const int total_len = static_cast<int>(sizeof(int32_t) + session_message.length);
     PayloadMessage* payload = static_cast<PayloadMessage*>(::malloc(total_len));
     assert(payload);
 
-    for (int i = 0; i < sessionMessage.number; ++i)
+    for (int i = 0; i < session_message.number; ++i)
     {
         payload->length = 0;
-        if (connection->recv(&payload->length, sizeof(payload->length)) != sizeof(payload->length))
+        if (!recvAll(connection, &payload->length, sizeof(payload->length)))
         {
             fmt::print("read length\n");
             exit(1);
         }
         payload->length = ntohl(payload->length);
-        assert(payload->length == sessionMessage.length);
-        if (connection->recv(payload->data, payload->length) != payload->length) //这里直接用的recv, 所以如果超过mtu, tcp将数据包拆开会出错(client会回到rst).
+        assert(payload->length == session_message.length);
+        if (!recvAll(connection, payload->data, payload->length))
         {
             fmt::print("read payload data\n");
             exit(1);
         }
         int32_t ack = htonl(payload->length);
-        if (connection->send(&ack, sizeof(ack)) != sizeof(ack))
+        if (connection.send(&ack, sizeof(ack)) != sizeof(ack))
         {
             fmt::print("write ack\n");
             exit(1);
         }
     }
     ::free(payload);
+}
+
+void serverCodec(lon::net::TcpConnection& connection,
+                 const SessionMessage& session_message,
+                 lon::IOBuffer& in) {
+    lon::net::LengthFieldCodec payload_codec;
+    lon::IOBuffer out;
+    int received = 0;
+    int result   = lon::net::readFrames(
+        connection, payload_codec, in, [&](lon::IOBuffer& frame) {
+            assert(frame.readableBytes() == static_cast<size_t>(session_message.length));
+            int32_t ack = htonl(static_cast<int32_t>(frame.readableBytes()));
+            out.append(&ack, sizeof(ack));
+            if (connection.writeFrom(out) != sizeof(ack)) {
+                fmt::print("write ack\n");
+                exit(1);
+            }
+            return ++received < session_message.number;
+        });
+    if (result != 1) {
+        fmt::print("read payload, received {}\n", received);
+        exit(1);
+    }
+}
+
+void server() {
+    int sockfd = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    lon::net::Socket socket(sockfd);
+    socket.setReuseAddr(true);
+    socket.bind(std::make_shared<lon::net::IPV4Address>("127.0.0.1", port));
+    socket.listen();
+    auto connection = socket.accept();
+
+    // session message使用固定长度的帧, 和后面的payload共享读缓冲.
+    lon::IOBuffer in;
+    lon::net::FixedLengthCodec session_codec(sizeof(SessionMessage));
+    struct SessionMessage session_message = { 0, 0 };
+    if (raw ? !recvAll(*connection, &session_message, sizeof(session_message))
+            : lon::net::readFrames(*connection, session_codec, in, [&](lon::IOBuffer& frame) {
+                  frame.copyTo(&session_message, sizeof(session_message));
+                  return false;
+              }) != 1)
+    {
+        fmt::print("read SessionMessage\n");
+        exit(1);
+    }
+
+    session_message.number = ntohl(session_message.number);
+    session_message.length = ntohl(session_message.length);
+    printf("receive number = %d\nreceive length = %d\n",
+        session_message.number, session_message.length);
+    if (raw)
+        serverRaw(*connection, session_message);
+    else
+        serverCodec(*connection, session_message, in);
     ::close(sockfd);
     if(async)
         lon::io::IOManager::getThreadLocal()->stop();
@@ -123,12 +208,19 @@ void server() {
 int main(int argc, char** argv) {
     auto printUsage = []()
     {
-        fmt::print("usage: ttcp [-a/-s](a for async, s for sync) [-s/-c](s for server, c for client");
+        fmt::print("usage: ttcp [-a/-s](a for async, s for sync) [-s/-c](s for server, c for client) [-r](raw recv/send, without codec)");
     };
-    if (argc != 3) {
+    if (argc != 3 && argc != 4) {
         printUsage();
         return -1;
     }
+    if (argc == 4) {
+        if (strcmp(argv[3], "-r") != 0) {
+            printUsage();
+            return -1;
+        }
+        raw = true;
+    }
 
     if (strcmp(argv[1], "-a") == 0) {
         async = true;
@@ -162,4 +254,4 @@ int main(int argc, char** argv) {
         printUsage();
         return -1;
     }
-}
\ No newline at end of file
+}
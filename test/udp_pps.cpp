@@ -0,0 +1,131 @@
+#include "balancer/io/avg_balancer.h"
+#include "base/chrono_helper.h"
+#include "base/print_helper.h"
+#include "io/io_manager.h"
+#include "net/udp/udp_server.h"
+
+#include <fmt/core.h>
+#include <future>
+
+// udp server pps测试: UdpServer回显数据报, 客户端在另一个IOManager线程中用clients个协程(各自一个connect的socket)
+// 每次发送window个数据报, 再接收window个回复, 持续seconds秒, 统计每秒回复的数据报数.
+// 回复在200ms内没有收齐时计为丢失, 继续下一轮.
+
+using namespace lon::net;
+
+constexpr uint16_t base_port  = 22330;
+constexpr int seconds         = 3;
+constexpr int clients         = 4;
+constexpr size_t payload_size = 64;
+
+struct LoadResult
+{
+    size_t replies   = 0;
+    size_t lost      = 0;
+    size_t time_span = 0;
+};
+
+static LoadResult runClientLoad(uint16_t port, size_t window) {
+    LoadResult result;
+    std::thread client_thread([&]() {
+        const auto begin    = lon::steady_clock::now();
+        const auto deadline = begin + std::chrono::seconds(seconds);
+        auto running        = std::make_shared<int>(clients);
+        for (int i = 0; i < clients; ++i) {
+            lon::io::IOManager::getThreadLocal()->addExecutor(std::make_shared<lon::coroutine::Executor>([&, running]() {
+                UdpSocket socket;
+                timeval timeout{0, 200 * 1000};
+                socket.getSocket().setOption(SOL_SOCKET, SO_RCVTIMEO, timeout);
+                socket.connect(IPV4Address("127.0.0.1", port));
+                const lon::String payload(payload_size, 'x');
+                DatagramBatch requests(window);
+                while (!requests.full()) {
+                    requests.push(payload);
+                }
+                DatagramBatch replies(window);
+                while (lon::steady_clock::now() < deadline) {
+                    socket.sendBatch(requests);
+                    size_t received = 0;
+                    while (received < window) {
+                        const int n = socket.recvBatch(replies);
+                        if (n <= 0)
+                            break;
+                        received += static_cast<size_t>(n);
+                    }
+                    result.replies += received;
+                    result.lost += window - received;
+                }
+                socket.close();
+                if (--*running == 0) {
+                    result.time_span = static_cast<size_t>(lon::getTimeSpanMs(begin, lon::steady_clock::now()));
+                    lon::io::IOManager::getThreadLocal()->stop();
+                }
+            }));
+        }
+        lon::io::IOManager::getThreadLocal()->run();
+    });
+    client_thread.join();
+    return result;
+}
+
+static void runCase(size_t batch_size, size_t window, size_t shards, uint16_t port) {
+    std::promise<std::shared_ptr<lon::io::IOManager>> server_manager_promise;
+    std::promise<bool> started_promise;
+    UdpServer::Ptr server;
+    std::thread server_thread([&]() {
+        // 只有1个分片时均衡器没有线程, 只在当前线程接收.
+        std::unique_ptr<lon::io::IOWorkBalancer> balancer = nullptr;
+        if (shards > 1)
+            balancer = std::make_unique<lon::io::SequenceIOBalancer>(shards - 1);
+        server = std::make_shared<UdpServer>(
+            [](lon::StringPiece message, const SockAddress& peer, UdpReplier& replier) { replier.send(message, peer); },
+            std::move(balancer));
+        UdpServer::Options options;
+        options.batch_size       = batch_size;
+        options.recv_buffer_size = 4 * 1024 * 1024;
+        server->setOptions(options);
+        const bool ok = server->bind(std::make_shared<IPV4Address>("127.0.0.1", port)) && server->startServe();
+        server_manager_promise.set_value(lon::io::IOManager::getThreadLocal());
+        started_promise.set_value(ok);
+        lon::io::IOManager::getThreadLocal()->run();
+    });
+    auto server_manager = server_manager_promise.get_future().get();
+    const auto name     = fmt::format("batch {}, window {}, {} shards", batch_size, window, shards);
+    if (started_promise.get_future().get()) {
+        // 等待分片线程中的socket创建完成.
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        const LoadResult result = runClientLoad(port, window);
+        fmt::print("{:<32}: {:>9.0f} datagrams per second, lost {}\n",
+                   name,
+                   static_cast<double>(result.replies) /
+                       static_cast<double>(std::max<size_t>(result.time_span, 1)) * 1000.0,
+                   result.lost);
+    } else {
+        fmt::print("{}: bind failed\n", name);
+    }
+    server_manager->addRemoteTask(std::make_shared<lon::coroutine::Executor>([&server]() {
+        server->stopServe();
+        // 等待各个线程中的接收循环被取消, 之后再停止均衡器线程.
+        ::usleep(20 * 1000);
+        for (auto& manager : server->getBalancer().getIOManagers()) {
+            if (manager != lon::io::IOManager::getThreadLocal()) {
+                manager->addRemoteTask(std::make_shared<lon::coroutine::Executor>(
+                    []() { lon::io::IOManager::getThreadLocal()->stop(); }));
+            }
+        }
+        lon::io::IOManager::getThreadLocal()->stop();
+    }));
+    server_thread.join();
+    // 析构时join均衡器的线程.
+    server.reset();
+}
+
+int main() {
+    printDividing("udp pps");
+    uint16_t port = base_port;
+    for (auto [batch_size, window] : {std::pair<size_t, size_t>{1, 1}, {64, 1}, {1, 64}, {64, 64}}) {
+        runCase(batch_size, window, 1, port++);
+    }
+    runCase(64, 64, 2, port++);
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include "base/print_helper.h"
+#include "io/hook.h"
+#include "io/io_manager.h"
+#include "net/udp/udp_socket.h"
+
+#include <atomic>
+#include <chrono>
+#include <fmt/core.h>
+#include <string>
+
+// udp吞吐测试: 单个数据报(sendto/recvfrom) 与 批量(sendmmsg/recvmmsg) 对比.
+// 发送端和接收端各自在一个IOManager线程中, 接收端在200ms没有数据以后结束.
+// 发送速度可能超过接收速度, 所以同时给出丢包率, 吞吐以接收端为准.
+
+using namespace std::chrono;
+
+constexpr uint16_t base_port      = 22230;
+constexpr size_t datagram_count   = 500000;
+constexpr size_t batch_size       = 64;
+constexpr int recv_buffer_size    = 8 * 1024 * 1024;
+constexpr long recv_idle_timeout  = 200;
+
+struct CaseResult
+{
+    double send_seconds = 0;
+    double recv_seconds = 0;
+    size_t received     = 0;
+};
+
+static void runInIOManager(std::function<void()> func) {
+    auto io_manager = lon::io::IOManager::getThreadLocal();
+    io_manager->addExecutor(std::make_shared<lon::coroutine::Executor>([&]() {
+        func();
+        lon::io::IOManager::getThreadLocal()->stop();
+    }));
+    io_manager->run();
+}
+
+static void receiver(uint16_t port,
+                     size_t payload_size,
+                     bool batch,
+                     CaseResult& result,
+                     std::atomic<bool>& ready) {
+    lon::net::UdpSocket socket;
+    socket.getSocket().setOption(SOL_SOCKET, SO_RCVBUF, recv_buffer_size);
+    timeval timeout{0, recv_idle_timeout * 1000};
+    socket.getSocket().setOption(SOL_SOCKET, SO_RCVTIMEO, timeout);
+    socket.bind(std::make_shared<lon::net::IPV4Address>("127.0.0.1", port));
+    ready = true;
+
+    steady_clock::time_point first;
+    steady_clock::time_point last;
+    size_t received = 0;
+    if (batch) {
+        lon::net::DatagramBatch datagrams(batch_size);
+        while (true) {
+            int n = socket.recvBatch(datagrams);
+            if (n <= 0)
+                break;
+            last = steady_clock::now();
+            if (received == 0)
+                first = last;
+            received += static_cast<size_t>(n);
+        }
+    } else {
+        char buffer[lon::net::DatagramBatch::kDefaultDatagramSize];
+        while (true) {
+            ssize_t n = socket.recvFrom(buffer, sizeof(buffer), nullptr);
+            if (n <= 0)
+                break;
+            last = steady_clock::now();
+            if (received == 0)
+                first = last;
+            ++received;
+        }
+    }
+    socket.close();
+    result.received     = received;
+    result.recv_seconds = duration<double>(last - first).count();
+    (void)payload_size;
+}
+
+static void sender(uint16_t port,
+                   size_t payload_size,
+                   bool batch,
+                   CaseResult& result) {
+    lon::net::UdpSocket socket;
+    lon::net::IPV4Address peer("127.0.0.1", port);
+    socket.connect(peer);
+    std::string payload(payload_size, 'x');
+
+    auto begin = steady_clock::now();
+    if (batch) {
+        lon::net::DatagramBatch datagrams(batch_size);
+        for (size_t sent = 0; sent < datagram_count; sent += datagrams.size()) {
+            datagrams.clear();
+            while (!datagrams.full() && sent + datagrams.size() < datagram_count) {
+                datagrams.push(payload);
+            }
+            socket.sendBatch(datagrams);
+        }
+    } else {
+        for (size_t i = 0; i < datagram_count; ++i) {
+            socket.sendTo(payload, nullptr);
+        }
+    }
+    result.send_seconds = duration<double>(steady_clock::now() - begin).count();
+    socket.close();
+}
+
+static void runCase(const char* name, size_t payload_size, bool batch, uint16_t port) {
+    CaseResult result;
+    std::atomic<bool> ready{false};
+    std::thread recv_thread([&]() {
+        runInIOManager([&]() { receiver(port, payload_size, batch, result, ready); });
+    });
+    while (!ready) {
+        std::this_thread::yield();
+    }
+    std::thread send_thread([&]() {
+        runInIOManager([&]() { sender(port, payload_size, batch, result); });
+    });
+    send_thread.join();
+    recv_thread.join();
+
+    double recv_pps = static_cast<double>(result.received) / result.recv_seconds;
+    fmt::print(
+        "{:<24} payload {:>4}B: send {:>10.0f} pps, recv {:>10.0f} pps {:>8.3f} "
+        "Mib/s, loss {:.2f}%\n",
+        name,
+        payload_size,
+        static_cast<double>(datagram_count) / result.send_seconds,
+        recv_pps,
+        recv_pps * static_cast<double>(payload_size) / lon::data::M,
+        100.0 * static_cast<double>(datagram_count - result.received) /
+            static_cast<double>(datagram_count));
+}
+
+int main() {
+    printDividing("udp speed");
+    uint16_t port = base_port;
+    for (size_t payload_size : {64, 1400}) {
+        runCase("sendto/recvfrom", payload_size, false, port++);
+        runCase("sendmmsg/recvmmsg", payload_size, true, port++);
+    }
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include "balancer/io/avg_balancer.h"
+#include "io/io_manager.h"
+#include "net/udp/udp_server.h"
+
+#include <algorithm>
+#include <atomic>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <set>
+#include <thread>
+
+using namespace lon;
+using namespace lon::net;
+
+namespace {
+/**
+ * @brief 在一个开启hook的IOManager线程中运行func.
+ */
+void runInIOManager(const std::function<void()>& func) {
+    std::thread thread([&]() {
+        auto io_manager = io::IOManager::getThreadLocal();
+        io_manager->addExecutor(std::make_shared<coroutine::Executor>([&]() {
+            func();
+            io::IOManager::getThreadLocal()->stop();
+        }));
+        io_manager->run();
+    });
+    thread.join();
+}
+
+/**
+ * @brief 用一个新的socket发送count个数据报, 接收回复直到收齐或者超时, 返回收到的回复.
+ */
+std::vector<String> echoRound(uint16_t port, size_t count, size_t payload_size = 16) {
+    UdpSocket client;
+    timeval timeout{0, 200 * 1000};
+    client.getSocket().setOption(SOL_SOCKET, SO_RCVTIMEO, timeout);
+    IPV4Address server_address("127.0.0.1", port);
+    EXPECT_EQ(client.connect(server_address), 0);
+
+    DatagramBatch requests(count, std::max(payload_size, DatagramBatch::kDefaultDatagramSize));
+    for (size_t i = 0; i < count; ++i) {
+        String payload = std::to_string(i);
+        payload.resize(payload_size, '.');
+        requests.push(payload);
+    }
+    EXPECT_EQ(client.sendBatch(requests), static_cast<int>(count));
+
+    std::vector<String> replies;
+    DatagramBatch datagrams(count);
+    while (replies.size() < count) {
+        if (client.recvBatch(datagrams) <= 0)
+            break;
+        for (size_t i = 0; i < datagrams.size(); ++i) {
+            replies.emplace_back(datagrams.get(i));
+        }
+    }
+    client.close();
+    return replies;
+}
+}  // namespace
+
+TEST(UdpTest, EchoServer) {
+    constexpr uint16_t port = 22320;
+    runInIOManager([&]() {
+        String last_peer;
+        auto server = std::make_shared<UdpServer>([&](StringPiece message, const SockAddress& peer, UdpReplier& replier) {
+            last_peer = peer.toString();
+            EXPECT_TRUE(replier.send(message, peer));
+        });
+        UdpServer::Options options;
+        options.batch_size    = 8;
+        options.datagram_size = 256;
+        server->setOptions(options);
+        ASSERT_TRUE(server->bind(std::make_shared<IPV4Address>("127.0.0.1", port)));
+        EXPECT_FALSE(server->bind(std::make_shared<IPV4Address>("127.0.0.1", port + 1)));
+        ASSERT_TRUE(server->startServe());
+
+        // 多于batch_size的数据报分多次接收, 回复也分多次发送.
+        auto replies = echoRound(port, 20);
+        ASSERT_EQ(replies.size(), 20u);
+        std::sort(replies.begin(), replies.end());
+        EXPECT_EQ(replies[0], "0...............");
+        EXPECT_EQ(last_peer.rfind("127.0.0.1:", 0), 0u);
+
+        // 超过datagram_size的数据报被截断, 丢弃而不交给处理函数.
+        EXPECT_TRUE(echoRound(port, 1, 512).empty());
+
+        const auto stats = server->getStats();
+        EXPECT_EQ(stats.received, 20u);
+        EXPECT_EQ(stats.truncated, 1u);
+        EXPECT_EQ(stats.sent, 20u);
+        EXPECT_EQ(stats.dropped, 0u);
+        EXPECT_TRUE(server->stopServe());
+        // 等待接收循环被取消并关闭socket.
+        ::usleep(10 * 1000);
+    });
+}
+
+TEST(UdpTest, ShardedServer) {
+    constexpr uint16_t port = 22321;
+    std::atomic<size_t> received{0};
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    auto server = std::make_shared<UdpServer>(
+        [&](StringPiece message, const SockAddress& peer, UdpReplier& replier) {
+            ++received;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.insert(std::this_thread::get_id());
+            }
+            replier.send(message, peer);
+        },
+        std::make_unique<io::SequenceIOBalancer>(2));
+    runInIOManager([&]() {
+        ASSERT_TRUE(server->bind(std::make_shared<IPV4Address>("127.0.0.1", port)));
+        ASSERT_TRUE(server->startServe());
+        // 等待分片线程中的socket创建完成.
+        ::usleep(100 * 1000);
+
+        // 内核按照四元组选择socket, 每个客户端socket的数据报都由同一个线程处理.
+        size_t replies = 0;
+        for (int i = 0; i < 16; ++i) {
+            replies += echoRound(port, 4).size();
+        }
+        EXPECT_EQ(replies, 64u);
+        EXPECT_TRUE(server->stopServe());
+        ::usleep(50 * 1000);
+    });
+    EXPECT_EQ(received.load(), 64u);
+    // 调用线程以及均衡器的2个线程各自持有一个socket.
+    EXPECT_GE(threads.size(), 2u);
+    for (auto& manager : server->getBalancer().getIOManagers()) {
+        manager->addRemoteTask(std::make_shared<coroutine::Executor>([]() { io::IOManager::getThreadLocal()->stop(); }));
+    }
+    // 接收循环已经结束, 析构时join均衡器的线程.
+    server.reset();
+}
+
+int main(int argc, char* argv[]) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,120 @@
+#include "base/print_helper.h"
+#include "io/io_manager.h"
+#include "net/stream_server.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fmt/core.h>
+#include <future>
+
+// unix socket与loopback tcp的延迟对比: StreamServer在一个IOManager线程中回显,
+// 客户端线程(未开启hook, 阻塞的系统调用)在一个连接上依次发送payload并等待回显, 统计往返延迟.
+
+using namespace std::chrono;
+using namespace lon::net;
+
+constexpr uint16_t base_port = 22340;
+constexpr size_t round_trips = 100000;
+
+struct LatencyResult
+{
+    double seconds = 0;
+    std::vector<uint32_t> latency_ns;
+};
+
+static LatencyResult runClient(const SockAddress& address, size_t payload_size) {
+    LatencyResult result;
+    Socket socket(address.getFamily(), SOCK_STREAM, 0);
+    // unix socket上被忽略.
+    socket.setTcpNoDelay(true);
+    SockAddress::UniquePtr peer = nullptr;
+    if (address.getFamily() == AF_UNIX) {
+        peer = std::make_unique<UnixAddress>(address.toString());
+    } else {
+        peer = std::make_unique<IPV4Address>(address.toString());
+    }
+    auto connection = socket.connect(std::move(peer));
+    if (!connection) {
+        socket.close();
+        return result;
+    }
+    const lon::String request(payload_size, 'x');
+    lon::String reply(payload_size, '\0');
+    result.latency_ns.reserve(round_trips);
+    const auto begin = steady_clock::now();
+    for (size_t i = 0; i < round_trips; ++i) {
+        const auto start = steady_clock::now();
+        if (connection->send(request) != static_cast<ssize_t>(request.size()))
+            break;
+        size_t received = 0;
+        while (received < reply.size()) {
+            const ssize_t n = connection->recv(&reply[received], reply.size() - received);
+            if (n <= 0)
+                break;
+            received += static_cast<size_t>(n);
+        }
+        if (received < reply.size())
+            break;
+        result.latency_ns.push_back(
+            static_cast<uint32_t>(duration_cast<nanoseconds>(steady_clock::now() - start).count()));
+    }
+    result.seconds = duration<double>(steady_clock::now() - begin).count();
+    connection->getSocket().close();
+    return result;
+}
+
+static void runCase(const char* name, SockAddress::SharedPtr address, size_t payload_size) {
+    std::promise<std::shared_ptr<lon::io::IOManager>> server_manager_promise;
+    std::promise<bool> started_promise;
+    StreamServer::Ptr server;
+    std::thread server_thread([&]() {
+        server = std::make_shared<StreamServer>([](std::shared_ptr<TcpConnection> connection) {
+            connection->getSocket().setTcpNoDelay(true);
+            char buffer[16 * 1024];
+            ssize_t n;
+            while ((n = connection->recv(buffer, sizeof(buffer))) > 0) {
+                if (connection->send(buffer, static_cast<size_t>(n)) != n)
+                    break;
+            }
+            connection->getSocket().close();
+        });
+        server->setSocketIniter([](Socket& socket) { socket.setReuseAddr(true); });
+        const bool ok = server->bind(address) && server->startServe();
+        server_manager_promise.set_value(lon::io::IOManager::getThreadLocal());
+        started_promise.set_value(ok);
+        lon::io::IOManager::getThreadLocal()->run();
+    });
+    auto server_manager = server_manager_promise.get_future().get();
+    const auto case_name = fmt::format("{}, payload {}B", name, payload_size);
+    if (started_promise.get_future().get()) {
+        LatencyResult result = runClient(*address, payload_size);
+        auto& latency        = result.latency_ns;
+        if (latency.empty()) {
+            fmt::print("{:<28}: failed\n", case_name);
+        } else {
+            std::sort(latency.begin(), latency.end());
+            fmt::print("{:<28}: {:>8.0f} round trips per second, p50 {:>6.1f} us, p99 {:>6.1f} us\n",
+                       case_name,
+                       static_cast<double>(latency.size()) / result.seconds,
+                       latency[latency.size() / 2] / 1000.0,
+                       latency[(latency.size() - 1) * 99 / 100] / 1000.0);
+        }
+    } else {
+        fmt::print("{}: bind failed\n", case_name);
+    }
+    server_manager->addRemoteTask(std::make_shared<lon::coroutine::Executor>([&server]() {
+        server->stopServe();
+        lon::io::IOManager::getThreadLocal()->stop();
+    }));
+    server_thread.join();
+}
+
+int main() {
+    printDividing("uds latency");
+    uint16_t port = base_port;
+    for (size_t payload_size : {64, 4096}) {
+        runCase("tcp loopback", std::make_shared<IPV4Address>("127.0.0.1", port++), payload_size);
+        runCase("unix socket", std::make_shared<UnixAddress>(fmt::format("@lon_uds_latency_{}", ::getpid())), payload_size);
+    }
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include "io/fd_manager.h"
+#include "io/io_manager.h"
+#include "net/stream_server.h"
+
+#include <cstddef>
+#include <fmt/core.h>
+#include <gtest/gtest.h>
+#include <sys/stat.h>
+#include <thread>
+
+using namespace lon;
+using namespace lon::net;
+
+namespace {
+void runInIOManager(const std::function<void()>& func) {
+    std::thread thread([&]() {
+        auto io_manager = io::IOManager::getThreadLocal();
+        io_manager->addExecutor(std::make_shared<coroutine::Executor>([&]() {
+            func();
+            io::IOManager::getThreadLocal()->stop();
+        }));
+        io_manager->run();
+    });
+    thread.join();
+}
+
+bool pathExists(const String& path) {
+    struct stat file_stat {};
+    return ::stat(path.c_str(), &file_stat) == 0;
+}
+
+String echoOnce(const SockAddress& address, StringPiece message) {
+    Socket socket(AF_UNIX, SOCK_STREAM, 0);
+    auto connection = socket.connect(std::make_unique<UnixAddress>(address.toString()));
+    if (!connection) {
+        socket.close();
+        return {};
+    }
+    // unix socket上忽略TCP_NODELAY.
+    connection->getSocket().setTcpNoDelay(true);
+    connection->send(message);
+    String reply(message.size(), '\0');
+    size_t received = 0;
+    while (received < reply.size()) {
+        const ssize_t n = connection->recv(&reply[received], reply.size() - received);
+        if (n <= 0)
+            break;
+        received += static_cast<size_t>(n);
+    }
+    reply.resize(received);
+    connection->getSocket().close();
+    return reply;
+}
+}  // namespace
+
+TEST(UnixTest, Address) {
+    UnixAddress path_address("/tmp/lon_unix_test.sock");
+    EXPECT_EQ(path_address.getFamily(), AF_UNIX);
+    EXPECT_FALSE(path_address.isAbstract());
+    EXPECT_EQ(path_address.toString(), "/tmp/lon_unix_test.sock");
+    EXPECT_EQ(path_address.getPath(), "/tmp/lon_unix_test.sock");
+    EXPECT_EQ(path_address.getAddrLen(), offsetof(sockaddr_un, sun_path) + 24);
+
+    UnixAddress abstract_address("@lon_unix_test");
+    EXPECT_TRUE(abstract_address.isAbstract());
+    EXPECT_EQ(abstract_address.toString(), "@lon_unix_test");
+    EXPECT_TRUE(abstract_address.getPath().empty());
+    EXPECT_EQ(abstract_address.getAddrLen(), offsetof(sockaddr_un, sun_path) + 14);
+    EXPECT_NE(abstract_address, UnixAddress("@lon_unix_test2"));
+    EXPECT_EQ(abstract_address, UnixAddress("@lon_unix_test"));
+
+    EXPECT_EQ(UnixAddress().toString(), "unnamed");
+    EXPECT_THROW(UnixAddress(""), std::invalid_argument);
+    EXPECT_THROW(UnixAddress(String(sizeof(sockaddr_un::sun_path), 'x')), std::invalid_argument);
+}
+
+TEST(UnixTest, StreamServer) {
+    const String path     = fmt::format("/tmp/lon_unix_test_{}.sock", ::getpid());
+    const String abstract = fmt::format("@lon_unix_test_{}", ::getpid());
+    {
+        // 上一次运行残留的socket文件.
+        Socket stale(AF_UNIX, SOCK_STREAM, 0);
+        ASSERT_EQ(stale.bind(std::make_shared<UnixAddress>(path)), 0);
+        stale.close();
+        ASSERT_TRUE(pathExists(path));
+    }
+    runInIOManager([&]() {
+        auto server = std::make_shared<StreamServer>([](std::shared_ptr<TcpConnection> connection) {
+            EXPECT_EQ(connection->getPeerAddr()->toString(), "unnamed");
+            char buffer[64];
+            ssize_t n;
+            while ((n = connection->recv(buffer, sizeof(buffer))) > 0) {
+                connection->send(buffer, static_cast<size_t>(n));
+            }
+            connection->getSocket().close();
+        });
+        ASSERT_TRUE(server->bind(std::make_shared<UnixAddress>(path)));
+        ASSERT_TRUE(server->addBindAddr(std::make_shared<UnixAddress>(abstract)));
+        ASSERT_TRUE(server->startServe());
+
+        EXPECT_EQ(echoOnce(UnixAddress(path), "hello path"), "hello path");
+        EXPECT_EQ(echoOnce(UnixAddress(abstract), "hello abstract"), "hello abstract");
+        EXPECT_EQ(server->getStats().accepted, 2u);
+
+        server->stopServe();
+        ::usleep(10 * 1000);
+        EXPECT_FALSE(pathExists(path));
+
+        auto sharded = std::make_shared<StreamServer>([](std::shared_ptr<TcpConnection>) {});
+        sharded->setAcceptMode(StreamServer::AcceptMode::Sharded);
+        EXPECT_FALSE(sharded->bind(std::make_shared<UnixAddress>(abstract)));
+    });
+}
+
+TEST(UnixTest, PassFd) {
+    int control[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, control), 0);
+    Socket sender(control[0]);
+    Socket receiver(control[1]);
+
+    // 非socket的fd.
+    int pipe_fds[2];
+    ASSERT_EQ(::pipe(pipe_fds), 0);
+    EXPECT_EQ(sender.sendFds("p", &pipe_fds[1], 1), 1);
+    ::close(pipe_fds[1]);
+    std::vector<int> fds;
+    char tag = 0;
+    ASSERT_EQ(receiver.recvFds(&tag, 1, fds), 1);
+    EXPECT_EQ(tag, 'p');
+    ASSERT_EQ(fds.size(), 1u);
+    EXPECT_EQ(::write(fds[0], "fd", 2), 2);
+    ::close(fds[0]);
+    char buffer[2];
+    EXPECT_EQ(::read(pipe_fds[0], buffer, sizeof(buffer)), 2);
+    EXPECT_EQ(StringPiece(buffer, 2), "fd");
+    ::close(pipe_fds[0]);
+
+    EXPECT_EQ(sender.sendFds("", &pipe_fds[0], 1), -1);
+    EXPECT_EQ(errno, EINVAL);
+
+    // 在hook开启的线程中接收的socket被登记, recv挂起协程而不是阻塞线程.
+    int connection_pair[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, connection_pair), 0);
+    EXPECT_EQ(sender.sendFds("c", &connection_pair[1], 1), 1);
+    ::close(connection_pair[1]);
+    runInIOManager([&]() {
+        std::vector<int> received;
+        ASSERT_EQ(receiver.recvFds(&tag, 1, received), 1);
+        ASSERT_EQ(received.size(), 1u);
+        EXPECT_NE(io::FdManager::getInstance()->getContext(received[0]), nullptr);
+
+        io::IOManager::getThreadLocal()->addExecutor(std::make_shared<coroutine::Executor>([&]() {
+            ::usleep(10 * 1000);
+            EXPECT_EQ(::write(connection_pair[0], "x", 1), 1);
+        }));
+        char byte = 0;
+        EXPECT_EQ(::recv(received[0], &byte, 1, 0), 1);
+        EXPECT_EQ(byte, 'x');
+        ::close(received[0]);
+    });
+    ::close(connection_pair[0]);
+    sender.close();
+    receiver.close();
+}
+
+int main(int argc, char* argv[]) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}